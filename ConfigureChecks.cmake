@@ -1,6 +1,8 @@
 # test for some functions and struct members that are missing on a particular system
 include(CheckFunctionExists)
 include(CheckStructHasMember)
+include(CheckIncludeFiles)
+include(CheckSymbolExists)
 
 # libstreams/lib/mailinputstream.cpp
 check_function_exists("strcasestr" HAVE_STRCASESTR)
@@ -10,5 +12,12 @@ check_function_exists("strlwr" HAVE_STRLWR)
 check_function_exists("localtime_r" HAVE_LOCALTIME_R)
 # libstreamanalyzer/lib/analyzerloader.cpp, libstreamanalyzer/lib/fieldpropertiesdb.cpp
 check_struct_has_member("struct dirent" "d_type" "dirent.h" HAVE_DIRENT_D_TYPE)
+# libstreamanalyzer/lib/filelister.cpp
+check_symbol_exists("SYS_getdents64" "sys/syscall.h" HAVE_GETDENTS64)
+check_include_files("linux/fs.h;linux/fiemap.h" HAVE_LINUX_FIEMAP_H)
+# libstreamanalyzer/lib/dirwatcher.cpp
+check_include_files("sys/inotify.h" HAVE_SYS_INOTIFY_H)
+# libstreamanalyzer/lib/analysisresultcache.cpp
+check_struct_has_member("struct stat" "st_mtim" "sys/stat.h" HAVE_STAT_ST_MTIM)
 
 add_definitions(-DHAVE_CONFIG_H)
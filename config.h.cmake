@@ -10,6 +10,10 @@
 #cmakedefine HAVE_STRLWR
 #cmakedefine HAVE_LOCALTIME_R
 #cmakedefine HAVE_DIRENT_D_TYPE
+#cmakedefine HAVE_GETDENTS64
+#cmakedefine HAVE_LINUX_FIEMAP_H
+#cmakedefine HAVE_SYS_INOTIFY_H
+#cmakedefine HAVE_STAT_ST_MTIM
 
 //////////////////////////////
 //support large files
@@ -46,6 +46,8 @@ class StreamEndAnalyzer;
  **/
 class STRIGI_EXPORT AnalysisResult {
 friend class StreamAnalyzerPrivate;
+friend class AnalysisResultCache;
+friend class AsyncIndexWriter;
 private:
     class Private;
     Private* const p;
@@ -67,6 +69,10 @@ private:
      * This is useful for determining the filetype of the parent.
      */
     void setEndAnalyzer(const StreamEndAnalyzer*);
+    /**
+     * @brief Retrieve the analyzer that analyzes this result.
+     */
+    StreamAnalyzer& analyzer() const;
 public:
     /**
      * @brief Create a new AnalysisResult object that will be written to the index.
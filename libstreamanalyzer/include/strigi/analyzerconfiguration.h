@@ -68,6 +68,19 @@ enum FieldType {
     Tokenized  = 0x0040 /**< If the field contains text, it
                              should be tokenized. */
 };
+/**
+ * @brief The order in which the entries of a directory are analyzed.
+ *
+ * On rotational and network disks, reading files in the order in which
+ * they are stored saves seeks when the files are not in the cache.
+ */
+enum FileOrder {
+    ReaddirOrder /**< The order in which the directory lists them. */,
+    InodeOrder   /**< Sorted by inode number. */,
+    ExtentOrder  /**< Sorted by the position of the first block of the file
+                      on disk, as reported by FIEMAP. Where FIEMAP is not
+                      available, this is the same as InodeOrder. */
+};
 private:
     AnalyzerConfigurationPrivate* const p;
 public:
@@ -183,6 +196,20 @@ public:
      */
     virtual bool indexMore() const {return true;}
     bool indexArchiveContents() const;
+    /**
+     * @brief The order in which the entries of a directory are analyzed.
+     *
+     * The directory lister sorts each batch of entries in this order. The
+     * default is ReaddirOrder.
+     */
+    FileOrder fileOrder() const;
+    /**
+     * @brief Set the order in which the entries of a directory are
+     * analyzed.
+     *
+     * See fileOrder() for more details.
+     */
+    void setFileOrder(FileOrder order);
     /**
      * @brief Allows end analyzer to check whether they should continue
      * adding text fragments to the index.
@@ -0,0 +1,103 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_ASYNCINDEXWRITER_H
+#define STRIGI_ASYNCINDEXWRITER_H
+
+#include <strigi/indexwriter.h>
+
+namespace Strigi {
+
+/**
+ * An IndexWriter that passes documents to another IndexWriter from a
+ * thread of its own.
+ *
+ * The calls for a document and its embedded documents are recorded in a
+ * buffer that belongs to the document. When the document is finished, the
+ * buffer is put in a queue and the analyzing thread continues with the
+ * next document. The writer thread replays the documents in the order in
+ * which they were finished, so the other writer gets all calls from one
+ * thread and the time it spends on formatting and output does not hold up
+ * the analysis. When too many bytes are queued, the analyzing threads wait
+ * until the writer thread has caught up.
+ *
+ * commit(), deleteEntries(), deleteAllEntries(), optimize() and
+ * releaseWriterData() first wait until the documents that were finished
+ * before them have been written. Each StreamAnalyzer that uses this writer
+ * releases it when it is deleted, so the documents do not outlive the
+ * analyzer that made them.
+ */
+class STRIGI_EXPORT AsyncIndexWriter : public IndexWriter {
+public:
+    class Private;
+private:
+    Private* const p;
+
+    static void replay(IndexWriter& writer, const std::string& events);
+protected:
+    void startAnalysis(const AnalysisResult*);
+    void addText(const AnalysisResult*, const char* text, int32_t length);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        const std::string& value);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        const unsigned char* data, uint32_t size);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        int32_t value);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        uint32_t value);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        double value);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        const std::string& name, const std::string& value);
+    void finishAnalysis(const AnalysisResult*);
+    void addTriplet(const std::string& subject,
+        const std::string& predicate, const std::string& object);
+public:
+    /**
+     * @param writer the writer that gets the documents
+     * @param maxQueued the number of bytes of recorded documents that may
+     * wait for the writer thread; a larger document is queued on its own
+     */
+    explicit AsyncIndexWriter(IndexWriter& writer,
+        size_t maxQueued = 16*1024*1024);
+    /**
+     * Write the documents that are still queued and stop the writer thread.
+     */
+    ~AsyncIndexWriter();
+    /**
+     * Wait until the documents that have been finished so far are written.
+     */
+    void flush();
+    void commit();
+    void deleteEntries(const std::vector<std::string>& entries);
+    void deleteAllEntries();
+    /**
+     * @return the number of documents in the cache of the other writer and
+     * in the queue
+     */
+    int itemsInCache();
+    void optimize();
+    void initWriterData(const FieldRegister& fieldRegister);
+    void releaseWriterData(const FieldRegister& fieldRegister);
+};
+
+}
+
+#endif
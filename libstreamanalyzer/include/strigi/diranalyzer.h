@@ -36,6 +36,20 @@ public:
     virtual bool continueAnalysis() = 0;
 };
 
+/**
+ * Is told when DirAnalyzer has committed the index.
+ */
+class STRIGI_EXPORT CommitListener {
+public:
+    virtual ~CommitListener() {}
+    /**
+     * Called after each commit. The documents that were analyzed before
+     * the commit can be found now, so readers can be refreshed. The calls
+     * come from the analyzing threads, but only one at a time.
+     */
+    virtual void committed() = 0;
+};
+
 class STRIGI_EXPORT DirAnalyzer {
 public:
     class Private;
@@ -47,10 +61,57 @@ public:
     int analyzeDir(const std::string& dir, int nthreads = 2,
         AnalysisCaller* caller = 0,
         const std::string& lastToSkip = std::string());
+    /**
+     * Save the state of the crawl of analyzeDir() to @p file every
+     * @p interval seconds. Before the state is saved, the index is
+     * committed. The file is removed when the crawl is complete. A crawl
+     * that was interrupted can be continued with resumeDir().
+     */
+    void setCheckpoint(const std::string& file, int interval = 60);
+    /**
+     * Commit the index during a crawl after @p maxDocs documents, after
+     * files with @p maxBytes bytes or @p maxSeconds seconds after the last
+     * commit, whichever comes first, so the results of a long crawl can be
+     * searched before it is complete. A limit of 0 is not used. The thread
+     * that finishes the document that reaches a limit commits; the other
+     * threads keep analyzing.
+     */
+    void setCommitPolicy(int maxDocs, int64_t maxBytes = 0,
+        int maxSeconds = 0);
+    /**
+     * Tell @p listener about each commit, or nobody if it is 0.
+     */
+    void setCommitListener(CommitListener* listener);
+    /**
+     * Continue the crawl that was saved in the checkpoint file. Only the
+     * directories that had not been analyzed completely are read.
+     * @return 0 on success or -1 if the checkpoint could not be read
+     */
+    int resumeDir(int nthreads = 2, AnalysisCaller* caller = 0);
+    /**
+     * Keep the results of the analysis of files in @p dir, so that files
+     * that have not changed since the last run, and files with the same
+     * contents as a file that was analyzed before, are not analyzed again.
+     * Unchanged files are recognized by their device, inode, size and
+     * modification time and are not opened. This makes repeated runs with
+     * index writers that cannot be queried, such as the XML writer, fast.
+     * At most @p maxSize bytes are used; the results that were used least
+     * recently are removed first.
+     */
+    void setResultCache(const std::string& dir, int64_t maxSize);
     int updateDir(const std::string& dir, int nthreads = 2,
         AnalysisCaller* caller = 0);
     int updateDirs(const std::vector<std::string>& dirs, int nthreads = 2,
         AnalysisCaller* caller = 0);
+    /**
+     * Keep the index up to date for @p dirs until @p caller stops the
+     * analysis. After an initial updateDirs(), the directories are watched
+     * for changes and only the changed entries are analyzed or deleted.
+     * If the system drops change events, a full updateDirs() is done.
+     * @return 0 on success or -1 if the directories cannot be watched
+     */
+    int watchDirs(const std::vector<std::string>& dirs, int nthreads = 2,
+        AnalysisCaller* caller = 0);
 };
 
 }
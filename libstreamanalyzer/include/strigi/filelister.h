@@ -78,6 +78,11 @@ public:
     DirLister(const Strigi::AnalyzerConfiguration* ic=0);
     ~DirLister();
 
+    /**
+     * Add a directory to the listing. Directories are identified by their
+     * device and inode, so a directory that is reached more than once, e.g.
+     * through a bind mount, is only listed the first time.
+     */
     void startListing(const std::string& dir);
     void stopListing();
 
@@ -87,6 +92,35 @@ public:
      */
     int nextDir(std::string& path,
         std::vector<std::pair<std::string, struct stat> >& dirs);
+    /**
+     * Thread-safe function for getting the entries of the directories in
+     * batches of at most 4096 entries. Large directories are read in
+     * several calls, so memory use stays bounded. The batches of one
+     * directory can be handed to different threads; the same path is
+     * returned with each of them. Do not mix calls to nextDir() and
+     * nextDirBatch() in one listing.
+     * @return 0 when no error occurred or -1 if an error occurred
+     */
+    int nextDirBatch(std::string& path,
+        std::vector<std::pair<std::string, struct stat> >& dirs);
+
+    /**
+     * Save the directories that still have to be listed to @p file.
+     * Directories that were listed partially by nextDirBatch() are stored
+     * with the position up to which they were read. Call this only when
+     * no thread is in nextDir() or nextDirBatch() and all entries that were
+     * returned have been handled.
+     * @return the number of directories that were saved or -1 if an error
+     *         occurred
+     */
+    int saveState(const std::string& file);
+    /**
+     * Continue a listing that was saved with saveState(). The saved
+     * directories are added to the listing; the directories that had been
+     * listed completely are not read again.
+     * @return 0 when no error occurred or -1 if an error occurred
+     */
+    int restoreState(const std::string& file);
 
     void skipTillAfter(const std::string& lastToSkip);
 };
@@ -0,0 +1,63 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_SEGMENTINDEXMANAGER_H
+#define STRIGI_SEGMENTINDEXMANAGER_H
+
+#include <strigi/strigiconfig.h>
+#include <strigi/indexmanager.h>
+#include <string>
+
+namespace Strigi {
+
+/**
+ * An index that is stored in a local directory and needs no other
+ * services.
+ *
+ * The index consists of segments that are written once. Each segment has
+ * a dictionary of the terms of all fields, the documents that contain each
+ * term and the values of the fields of each document. New documents are
+ * kept in memory until IndexWriter::commit() is called. Deleted documents
+ * are marked in a bitmap per segment and removed when segments are merged.
+ *
+ * The reader and the writer may be used from several threads at once. A
+ * directory may be read by several processes, but only one process may
+ * write to it. The writer is made when indexWriter() is first called; it
+ * takes a lock on the file write.lock in the directory, so a process that
+ * only reads never changes the files of the index.
+ **/
+class STRIGI_EXPORT SegmentIndexManager : public IndexManager {
+private:
+    class Private;
+    Private* const p;
+public:
+    /**
+     * Open the index in @p dir. The directory is created if it does not
+     * exist.
+     **/
+    explicit SegmentIndexManager(const std::string& dir);
+    ~SegmentIndexManager();
+    IndexReader* indexReader();
+    IndexWriter* indexWriter();
+};
+
+}
+
+#endif
@@ -46,6 +46,21 @@ class STRIGI_EXPORT StreamEventAnalyzerFactory
         : public StreamAnalyzerFactory {
 public:
     virtual StreamEventAnalyzer* newInstance() const = 0;
+    /**
+     * Decide from the first bytes of a stream whether analyzers made by this
+     * factory can do anything with it. The check is done once per stream,
+     * before any data is passed on. An analyzer for which it returns false
+     * does not see any data of the stream. The mimetype of the stream is
+     * not known yet at this point.
+     * The default implementation accepts every stream.
+     * \param header the first bytes of the stream, usually 1024
+     * \param headersize the number of bytes in \p header
+     * \param result the result for the stream, e.g. to look at the filename
+     */
+    virtual bool checkHeader(const char* /*header*/, int32_t /*headersize*/,
+            const AnalysisResult& /*result*/) const {
+        return true;
+    }
 };
 
 }
@@ -143,6 +143,20 @@ public:
      * \return pointer to the new analyzer instance
      */
     virtual StreamSaxAnalyzer* newInstance() const = 0;
+    /**
+     * Decide from the first bytes of a stream whether analyzers made by this
+     * factory can do anything with it. The check is done once per stream.
+     * When no SAX analyzer accepts a stream, the stream is not parsed at
+     * all. The mimetype of the stream is already known when this is called.
+     * The default implementation accepts streams that look like XML: after
+     * an optional byte order mark and whitespace, the first character must
+     * be '<'.
+     * \param header the first bytes of the stream, usually 1024
+     * \param headersize the number of bytes in \p header
+     * \param result the result for the stream
+     */
+    virtual bool checkHeader(const char* header, int32_t headersize,
+            const AnalysisResult& result) const;
 };
 
 }
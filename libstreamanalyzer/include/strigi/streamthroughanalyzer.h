@@ -26,6 +26,7 @@
 namespace Strigi {
 
 class AnalysisResult;
+class DataEventHandler;
 template <class T> class StreamBase;
 typedef StreamBase<char> InputStream;
 
@@ -64,6 +65,17 @@ public:
      * Return the name of this throughanalyzer.
      **/
     virtual const char* name() const = 0;
+    /**
+     * Return the handler that should receive the data of the stream that was
+     * passed to the last call of connectInputStream(), or 0 if this analyzer
+     * does not need the data or wraps the stream itself.
+     *
+     * Analyzers that return a handler should return the stream unchanged
+     * from connectInputStream(). The StreamAnalyzer then reads every buffer
+     * only once and hands it to the handlers of all through analyzers in a
+     * single pass.
+     **/
+    virtual DataEventHandler* dataEventHandler() { return 0; }
 };
 
 /**
@@ -291,6 +291,10 @@ void
 AnalysisResult::setEndAnalyzer(const StreamEndAnalyzer* ea) {
     p->m_endanalyzer = ea;
 }
+StreamAnalyzer&
+AnalysisResult::analyzer() const {
+    return p->m_indexer;
+}
 std::string
 AnalysisResult::extension() const {
     std::string::size_type p1 = p->m_name.rfind('.');
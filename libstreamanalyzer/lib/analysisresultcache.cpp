@@ -0,0 +1,801 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "analysisresultcache.h"
+#include "eventanalyzers/SHA1.h"
+#include <strigi/analysisresult.h>
+#include <strigi/fieldtypes.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+using namespace Strigi;
+
+namespace {
+/**
+ * The size of the blocks at the start and the end of a file that are used
+ * for the fingerprint.
+ **/
+const int64_t blockSize = 65536;
+/**
+ * Files smaller than this are analyzed faster than their result can be
+ * looked up.
+ **/
+const int64_t minFileSize = 16384;
+/**
+ * The start of each entry. It changes when the format changes.
+ **/
+const char magic[] = "strigi-result-cache 1\n";
+const size_t magicSize = sizeof(magic) - 1;
+const size_t digestSize = 20;
+/**
+ * The start of the names of the files that are being written. Names that
+ * start with '.' are not taken for entries.
+ **/
+const char tempPrefix[] = ".new";
+const size_t tempPrefixSize = sizeof(tempPrefix) - 1;
+/**
+ * The number of links that were made, for the names of the temporary
+ * links.
+ **/
+std::atomic<unsigned int> linkCount(0);
+
+const std::string hasHashFieldName(
+    "http://www.semanticdesktop.org/ontologies/2007/03/22/nfo#hasHash");
+const std::string hashValueName(
+    "http://www.semanticdesktop.org/ontologies/2007/03/22/nfo#hashValue");
+const std::string fileDataObject(
+    "http://www.semanticdesktop.org/ontologies/2007/03/22/nfo#FileDataObject");
+
+/**
+ * The kinds of events in an entry. Each event is followed by the depth of
+ * the result it applies to, except for triplets.
+ **/
+enum Event {
+    StartEvent = 'S', FinishEvent = 'F', TextEvent = 'T',
+    StringEvent = 's', BinaryEvent = 'b', Int32Event = 'i',
+    Uint32Event = 'u', DoubleEvent = 'd', NameValueEvent = 'n',
+    TripletEvent = 'R', EncodingEvent = 'e', MimeTypeEvent = 'm'
+};
+
+void
+put(std::string& out, const void* data, size_t size) {
+    out.append((const char*)data, size);
+}
+void
+putString(std::string& out, const char* data, uint32_t size) {
+    put(out, &size, sizeof(size));
+    out.append(data, size);
+}
+void
+putString(std::string& out, const std::string& s) {
+    putString(out, s.c_str(), (uint32_t)s.length());
+}
+/**
+ * Check if @p s was made by AnalysisResult::newAnonymousUri().
+ **/
+bool
+isAnonymousUri(const std::string& s) {
+    if (s.length() != 6 || s[0] != ':') {
+        return false;
+    }
+    for (size_t i = 1; i < 6; ++i) {
+        if (s[i] < 'a' || s[i] > 'z') {
+            return false;
+        }
+    }
+    return true;
+}
+/**
+ * Store a string that may refer to the file. Strings that start with the
+ * path of the file are stored relative to it, so they can be moved to
+ * another path. Anonymous uris are marked, so they can be replaced by new
+ * ones.
+ **/
+void
+putUri(std::string& out, const std::string& root, const std::string& s) {
+    if (isAnonymousUri(s)) {
+        out.append(1, '2');
+        putString(out, s);
+        return;
+    }
+    bool relative = root.length() && s.compare(0, root.length(), root) == 0;
+    out.append(1, (relative) ?'1' :'0');
+    putString(out, s.c_str() + ((relative) ?root.length() :0),
+        (uint32_t)(s.length() - ((relative) ?root.length() :0)));
+}
+
+/**
+ * Reads the fields of an entry; get() returns false when the entry is too
+ * short.
+ **/
+class Reader {
+private:
+    const std::string& data;
+    size_t pos;
+public:
+    Reader(const std::string& d, size_t p) :data(d), pos(p) {}
+    bool atEnd() const { return pos == data.length(); }
+    bool get(void* out, size_t size) {
+        if (data.length() - pos < size) {
+            return false;
+        }
+        memcpy(out, data.c_str() + pos, size);
+        pos += size;
+        return true;
+    }
+    bool getString(std::string& out) {
+        uint32_t size;
+        if (!get(&size, sizeof(size)) || data.length() - pos < size) {
+            return false;
+        }
+        out.assign(data, pos, size);
+        pos += size;
+        return true;
+    }
+    /**
+     * Read a string stored with putUri(). Anonymous uris are replaced by
+     * new uris for @p result, if it is not 0.
+     **/
+    bool getUri(const std::string& root, AnalysisResult* result,
+            std::map<std::string, std::string>& anonymous,
+            std::string& out) {
+        char kind;
+        std::string s;
+        if (!get(&kind, 1) || !getString(s)) {
+            return false;
+        }
+        if (kind == '2') {
+            if (result) {
+                std::string& uri = anonymous[s];
+                if (uri.empty()) {
+                    uri = result->newAnonymousUri();
+                }
+                out.assign(uri);
+            } else {
+                out.assign(s);
+            }
+        } else {
+            out.assign((kind == '1') ?root :std::string());
+            out.append(s);
+        }
+        return true;
+    }
+};
+
+/**
+ * Compute the SHA-1 digest of the file at @p path.
+ **/
+bool
+fileDigest(const std::string& path, unsigned char* digest) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    CSHA1 sha1;
+    std::vector<unsigned char> buffer(blockSize);
+    ssize_t n;
+    while ((n = read(fd, &buffer[0], buffer.size())) > 0) {
+        sha1.Update(&buffer[0], (UINT_32)n);
+    }
+    close(fd);
+    if (n < 0) {
+        return false;
+    }
+    sha1.Final();
+    sha1.GetHash(digest);
+    return true;
+}
+
+std::string
+toHex(const unsigned char* digest) {
+    char hex[2 * digestSize + 1];
+    for (size_t i = 0; i < digestSize; ++i) {
+        sprintf(hex + 2 * i, "%02x", digest[i]);
+    }
+    return hex;
+}
+char
+hexValue(char c) {
+    return (char)((c <= '9') ?c - '0' :(c | 0x20) - 'a' + 10);
+}
+}
+
+AnalysisResultCache::Recorder::Recorder(IndexWriter& w,
+        const FieldRegister& fr, const std::string& path)
+        :writer(w), fieldRegister(fr), root(path), writing(0) {
+}
+void
+AnalysisResultCache::Recorder::startAnalysis(const AnalysisResult* ar) {
+    writer.startAnalysis(ar);
+    const char depth = (char)ar->depth();
+    if (depth > 0) {
+        // store the path of embedded files relative to their parent
+        data.append(1, (char)StartEvent);
+        data.append(1, depth);
+        putString(data, ar->path().substr(ar->parent()->path().length() + 1));
+        int64_t mtime = ar->mTime();
+        put(data, &mtime, sizeof(mtime));
+    }
+}
+void
+AnalysisResultCache::Recorder::addText(const AnalysisResult* ar,
+        const char* text, int32_t length) {
+    writer.addText(ar, text, length);
+    data.append(1, (char)TextEvent);
+    data.append(1, (char)ar->depth());
+    putString(data, text, length);
+}
+void
+AnalysisResultCache::Recorder::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, const std::string& value) {
+    writer.addValue(ar, field, value);
+    // AnalysisResult writes these values itself when it is finished; they
+    // start with the path
+    if (field == fieldRegister.pathField) {
+        writing = ar;
+        return;
+    }
+    if (writing == ar) {
+        if (field == fieldRegister.parentLocationField
+                || field == fieldRegister.filenameField
+                || (ar->depth() == 0 && field == fieldRegister.typeField
+                    && value == fileDataObject)) {
+            return;
+        }
+        // the encoding and the mime type are kept in the result
+        if (field == fieldRegister.encodingField
+                || field == fieldRegister.mimetypeField) {
+            data.append(1, (char)((field == fieldRegister.encodingField)
+                ?EncodingEvent :MimeTypeEvent));
+            data.append(1, (char)ar->depth());
+            putString(data, value);
+            return;
+        }
+    }
+    if (ar->depth() == 0 && field->key() == hasHashFieldName) {
+        hashUri = value;
+    }
+    data.append(1, (char)StringEvent);
+    data.append(1, (char)ar->depth());
+    putString(data, field->key());
+    putUri(data, root, value);
+}
+void
+AnalysisResultCache::Recorder::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, const unsigned char* d, uint32_t size) {
+    writer.addValue(ar, field, d, size);
+    data.append(1, (char)BinaryEvent);
+    data.append(1, (char)ar->depth());
+    putString(data, field->key());
+    putString(data, (const char*)d, size);
+}
+void
+AnalysisResultCache::Recorder::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, int32_t value) {
+    writer.addValue(ar, field, value);
+    data.append(1, (char)Int32Event);
+    data.append(1, (char)ar->depth());
+    putString(data, field->key());
+    put(data, &value, sizeof(value));
+}
+void
+AnalysisResultCache::Recorder::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, uint32_t value) {
+    writer.addValue(ar, field, value);
+    if (writing == ar && field == fieldRegister.mtimeField) {
+        return;
+    }
+    data.append(1, (char)Uint32Event);
+    data.append(1, (char)ar->depth());
+    putString(data, field->key());
+    put(data, &value, sizeof(value));
+}
+void
+AnalysisResultCache::Recorder::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, double value) {
+    writer.addValue(ar, field, value);
+    data.append(1, (char)DoubleEvent);
+    data.append(1, (char)ar->depth());
+    putString(data, field->key());
+    put(data, &value, sizeof(value));
+}
+void
+AnalysisResultCache::Recorder::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, const std::string& name,
+        const std::string& value) {
+    writer.addValue(ar, field, name, value);
+    data.append(1, (char)NameValueEvent);
+    data.append(1, (char)ar->depth());
+    putString(data, field->key());
+    putString(data, name);
+    putString(data, value);
+}
+void
+AnalysisResultCache::Recorder::finishAnalysis(const AnalysisResult* ar) {
+    writer.finishAnalysis(ar);
+    // the next result may get the same address
+    writing = 0;
+    if (ar->depth() > 0) {
+        data.append(1, (char)FinishEvent);
+        data.append(1, (char)ar->depth());
+    }
+}
+void
+AnalysisResultCache::Recorder::addTriplet(const std::string& subject,
+        const std::string& predicate, const std::string& object) {
+    writer.addTriplet(subject, predicate, object);
+    // the digest of the file comes for free if it was computed
+    if (predicate == hashValueName && subject == hashUri
+            && object.length() == 2 * digestSize) {
+        digest.resize(digestSize);
+        for (size_t i = 0; i < digestSize; ++i) {
+            digest[i] = (char)(hexValue(object[2*i]) << 4
+                | hexValue(object[2*i+1]));
+        }
+    }
+    data.append(1, (char)TripletEvent);
+    putUri(data, root, subject);
+    putUri(data, root, predicate);
+    putUri(data, root, object);
+}
+
+AnalysisResultCache::AnalysisResultCache(const std::string& d,
+        int64_t max, const FieldRegister& fr)
+        :dir(d), maxSize(max), fieldRegister(fr), size(-1),
+        evicting(false) {
+    mkdir(dir.c_str(), 0700);
+}
+std::string
+AnalysisResultCache::entryPath(const std::string& key) const {
+    // spread the entries over 256 subdirectories
+    std::string path(dir);
+    path.append("/");
+    path.append(key, 0, 2);
+    path.append("/");
+    path.append(key, 2, std::string::npos);
+    return path;
+}
+bool
+AnalysisResultCache::fingerprint(const std::string& path, int64_t filesize,
+        std::string& key) const {
+    if (filesize < minFileSize) {
+        return false;
+    }
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    CSHA1 sha1;
+    sha1.Update((const UINT_8*)&filesize, sizeof(filesize));
+    std::vector<unsigned char> buffer(blockSize);
+    // hash the first and the last block, or the whole file if it is small
+    const bool small = filesize <= 2 * blockSize;
+    const int64_t offsets[2] = {0, filesize - blockSize};
+    const size_t sizes[2] = {(size_t)((small) ?filesize :blockSize),
+        (size_t)blockSize};
+    bool ok = true;
+    for (int i = 0; ok && i < ((small) ?1 :2); ++i) {
+        const size_t n = sizes[i];
+        buffer.resize(n);
+        ok = pread(fd, &buffer[0], n, offsets[i]) == (ssize_t)n;
+        if (ok) {
+            sha1.Update(&buffer[0], (UINT_32)n);
+        }
+    }
+    close(fd);
+    if (!ok) {
+        return false;
+    }
+    sha1.Final();
+    unsigned char digest[digestSize];
+    sha1.GetHash(digest);
+    key = toHex(digest);
+    return true;
+}
+/**
+ * Read the entry at @p epath and check that it is meant for a file of
+ * @p filesize bytes.
+ **/
+bool
+AnalysisResultCache::readEntry(const std::string& epath, int64_t filesize,
+        std::string& entry) const {
+    FILE* f = fopen(epath.c_str(), "rb");
+    if (f == 0) {
+        return false;
+    }
+    entry.clear();
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        entry.append(buffer, n);
+    }
+    fclose(f);
+    int64_t entrysize;
+    if (entry.length() < magicSize + sizeof(entrysize) + digestSize
+            || entry.compare(0, magicSize, magic) != 0) {
+        return false;
+    }
+    memcpy(&entrysize, entry.c_str() + magicSize, sizeof(entrysize));
+    return entrysize == filesize;
+}
+bool
+AnalysisResultCache::lookup(const std::string& key, const std::string& path,
+        int64_t filesize, std::string& entry) const {
+    const std::string epath(entryPath(key));
+    if (!readEntry(epath, filesize, entry)) {
+        return false;
+    }
+    // the fingerprint covers only part of large files, so the contents
+    // are compared via their digest
+    if (filesize > 2 * blockSize) {
+        unsigned char digest[digestSize];
+        if (!fileDigest(path, digest) || memcmp(digest,
+                entry.c_str() + magicSize + sizeof(int64_t), digestSize)) {
+            return false;
+        }
+    }
+    // only use entries of which all fields are known
+    if (!decode(entry, 0, 0)) {
+        return false;
+    }
+    // mark the entry as recently used
+    utime(epath.c_str(), 0);
+    return true;
+}
+std::string
+AnalysisResultCache::statKey(const struct stat& s) {
+    CSHA1 sha1;
+    // a file that is changed twice within a second may keep its size and
+    // mtime in seconds, so the nanoseconds and the ctime are used too
+#ifdef HAVE_STAT_ST_MTIM
+    const uint64_t id[7] = {(uint64_t)s.st_dev, (uint64_t)s.st_ino,
+        (uint64_t)s.st_size, (uint64_t)s.st_mtim.tv_sec,
+        (uint64_t)s.st_mtim.tv_nsec, (uint64_t)s.st_ctim.tv_sec,
+        (uint64_t)s.st_ctim.tv_nsec};
+#else
+    const uint64_t id[5] = {(uint64_t)s.st_dev, (uint64_t)s.st_ino,
+        (uint64_t)s.st_size, (uint64_t)s.st_mtime, (uint64_t)s.st_ctime};
+#endif
+    sha1.Update((const UINT_8*)id, sizeof(id));
+    sha1.Final();
+    unsigned char digest[digestSize];
+    sha1.GetHash(digest);
+    return toHex(digest);
+}
+bool
+AnalysisResultCache::lookupUnchanged(const std::string& key, int64_t filesize,
+        std::string& entry) const {
+    const std::string epath(entryPath(key));
+    if (!readEntry(epath, filesize, entry) || !decode(entry, 0, 0)) {
+        return false;
+    }
+    utime(epath.c_str(), 0);
+    return true;
+}
+void
+AnalysisResultCache::link(const std::string& key, const std::string& statkey) {
+    const std::string epath(entryPath(key));
+    const std::string spath(entryPath(statkey));
+    const std::string subdir(spath.substr(0, spath.rfind('/')));
+    // the link gets a name of its own, because other threads and processes
+    // may link the same entry at the same time
+    char name[64];
+    snprintf(name, sizeof(name), "/%s%ld-%u", tempPrefix, (long)getpid(),
+        ++linkCount);
+    const std::string tmp(subdir + name);
+    if (::link(epath.c_str(), tmp.c_str()) != 0) {
+        mkdir(subdir.c_str(), 0700);
+        if (::link(epath.c_str(), tmp.c_str()) != 0) {
+            return;
+        }
+    }
+    if (rename(tmp.c_str(), spath.c_str()) != 0) {
+        unlink(tmp.c_str());
+    }
+}
+void
+AnalysisResultCache::replay(const std::string& entry, AnalysisResult& result,
+        IndexWriter& writer) const {
+    decode(entry, &result, &writer);
+}
+/**
+ * Read the events of @p entry. If @p result is not 0, they are written to
+ * @p writer for @p result and its embedded files.
+ * @return true if the entry is valid
+ **/
+bool
+AnalysisResultCache::decode(const std::string& entry, AnalysisResult* result,
+        IndexWriter* writer) const {
+    const std::map<std::string, RegisteredField*>& fields
+        = fieldRegister.fields();
+    Reader in(entry, magicSize + sizeof(int64_t) + digestSize);
+    // the open results, one per depth
+    std::vector<AnalysisResult*> open;
+    if (result) {
+        open.push_back(result);
+    }
+    const std::string root((result) ?result->path() :std::string());
+    std::map<std::string, std::string> anonymous;
+    bool ok = true;
+    std::string a, b, c;
+    while (ok && !in.atEnd()) {
+        char event;
+        char depth = 0;
+        ok = in.get(&event, 1);
+        if (ok && event != TripletEvent) {
+            ok = in.get(&depth, 1) && depth >= 0;
+        }
+        const RegisteredField* field = 0;
+        if (ok && event != StartEvent && event != FinishEvent
+                && event != TextEvent && event != TripletEvent
+                && event != EncodingEvent && event != MimeTypeEvent) {
+            std::map<std::string, RegisteredField*>::const_iterator i;
+            ok = in.getString(a) && (i = fields.find(a)) != fields.end();
+            if (ok) {
+                field = i->second;
+            }
+        }
+        if (!ok) {
+            break;
+        }
+        AnalysisResult* target = (result && (size_t)depth < open.size())
+            ?open[depth] :0;
+        if (result && event != StartEvent && event != TripletEvent
+                && target == 0) {
+            return false;
+        }
+        switch (event) {
+        case StartEvent: {
+            int64_t mtime;
+            ok = in.getString(a) && in.get(&mtime, sizeof(mtime)) && depth > 0;
+            if (ok && result) {
+                if ((size_t)depth != open.size()) {
+                    return false;
+                }
+                std::string path(open.back()->path());
+                path.append("/");
+                path.append(a);
+                const char* name = path.c_str() + path.rfind('/') + 1;
+                open.push_back(new AnalysisResult(path, name, (time_t)mtime,
+                    *open.back()));
+            }
+            break;
+        }
+        case FinishEvent:
+            if (result) {
+                if ((size_t)depth + 1 != open.size() || depth == 0) {
+                    return false;
+                }
+                delete open.back();
+                open.pop_back();
+            }
+            break;
+        case TextEvent:
+            ok = in.getString(b);
+            if (ok && result) {
+                writer->addText(target, b.c_str(), (int32_t)b.length());
+            }
+            break;
+        case StringEvent:
+            ok = in.getUri(root, result, anonymous, b);
+            if (ok && result) {
+                writer->addValue(target, field, b);
+            }
+            break;
+        case BinaryEvent:
+            ok = in.getString(b);
+            if (ok && result) {
+                writer->addValue(target, field,
+                    (const unsigned char*)b.c_str(), (uint32_t)b.length());
+            }
+            break;
+        case Int32Event: {
+            int32_t v;
+            ok = in.get(&v, sizeof(v));
+            if (ok && result) {
+                writer->addValue(target, field, v);
+            }
+            break;
+        }
+        case Uint32Event: {
+            uint32_t v;
+            ok = in.get(&v, sizeof(v));
+            if (ok && result) {
+                writer->addValue(target, field, v);
+            }
+            break;
+        }
+        case DoubleEvent: {
+            double v;
+            ok = in.get(&v, sizeof(v));
+            if (ok && result) {
+                writer->addValue(target, field, v);
+            }
+            break;
+        }
+        case EncodingEvent:
+            ok = in.getString(b);
+            if (ok && result) {
+                target->setEncoding(b.c_str());
+            }
+            break;
+        case MimeTypeEvent:
+            ok = in.getString(b);
+            if (ok && result) {
+                target->setMimeType(b);
+            }
+            break;
+        case NameValueEvent:
+            ok = in.getString(b) && in.getString(c);
+            if (ok && result) {
+                writer->addValue(target, field, b, c);
+            }
+            break;
+        case TripletEvent: {
+            std::string s;
+            ok = in.getUri(root, result, anonymous, s)
+                && in.getUri(root, result, anonymous, b)
+                && in.getUri(root, result, anonymous, c);
+            if (ok && result) {
+                writer->addTriplet(s, b, c);
+            }
+            break;
+        }
+        default:
+            ok = false;
+        }
+    }
+    // close the embedded results that are still open
+    while (open.size() > 1) {
+        delete open.back();
+        open.pop_back();
+    }
+    return ok;
+}
+void
+AnalysisResultCache::store(const std::string& key, const std::string& path,
+        int64_t filesize, const Recorder& recorder) {
+    unsigned char digest[digestSize];
+    memset(digest, 0, digestSize);
+    if (filesize > 2 * blockSize) {
+        if (recorder.digest.length() == digestSize) {
+            memcpy(digest, recorder.digest.c_str(), digestSize);
+        } else if (!fileDigest(path, digest)) {
+            return;
+        }
+    }
+    const std::string epath(entryPath(key));
+    const std::string subdir(epath.substr(0, epath.rfind('/')));
+    // each store writes to a file of its own, because other threads and
+    // processes may store the same content at the same time
+    std::string tmp(subdir + "/" + tempPrefix + "XXXXXX");
+    int fd = mkstemp(&tmp[0]);
+    if (fd == -1) {
+        // create the subdirectory for this entry
+        mkdir(subdir.c_str(), 0700);
+        tmp.assign(subdir + "/" + tempPrefix + "XXXXXX");
+        fd = mkstemp(&tmp[0]);
+        if (fd == -1) {
+            return;
+        }
+    }
+    FILE* f = fdopen(fd, "wb");
+    if (f == 0) {
+        close(fd);
+        unlink(tmp.c_str());
+        return;
+    }
+    bool ok = fwrite(magic, 1, magicSize, f) == magicSize
+        && fwrite(&filesize, sizeof(filesize), 1, f) == 1
+        && fwrite(digest, 1, digestSize, f) == digestSize
+        && fwrite(recorder.data.c_str(), 1, recorder.data.length(), f)
+            == recorder.data.length();
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), epath.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (size >= 0) {
+            size += (int64_t)(magicSize + sizeof(filesize) + digestSize
+                + recorder.data.length());
+        }
+        if (evicting || (size >= 0 && size <= maxSize)) {
+            return;
+        }
+        // the entries that are stored during the count are added to it
+        evicting = true;
+        size = 0;
+    }
+    evict();
+}
+/**
+ * Count the size of the cache and remove the least recently used entries
+ * if it is too large. The directory is read without the lock, so the
+ * other threads can go on; only one thread evicts at a time.
+ **/
+void
+AnalysisResultCache::evict() {
+    std::vector<std::pair<time_t, std::pair<int64_t, std::string> > > entries;
+    int64_t total = 0;
+    // temporary files that are this old were left by a crash
+    const time_t stale = time(0) - 3600;
+    DIR* d = opendir(dir.c_str());
+    struct dirent* sub;
+    struct stat s;
+    while (d && (sub = readdir(d)) != 0) {
+        if (sub->d_name[0] == '.') {
+            continue;
+        }
+        const std::string subdir(dir + '/' + sub->d_name);
+        DIR* sd = opendir(subdir.c_str());
+        if (sd == 0) {
+            continue;
+        }
+        struct dirent* e;
+        while ((e = readdir(sd)) != 0) {
+            const std::string path(subdir + '/' + e->d_name);
+            if (e->d_name[0] != '.' && stat(path.c_str(), &s) == 0) {
+                // entries with several keys are hard links; each name
+                // counts for a part of the size
+                const int64_t esize = s.st_size / s.st_nlink;
+                total += esize;
+                entries.push_back(std::make_pair(s.st_mtime,
+                    std::make_pair(esize, path)));
+            } else if (strncmp(e->d_name, tempPrefix, tempPrefixSize) == 0
+                    && lstat(path.c_str(), &s) == 0 && s.st_mtime < stale) {
+                unlink(path.c_str());
+            }
+        }
+        closedir(sd);
+    }
+    if (d) {
+        closedir(d);
+    }
+    if (total > maxSize) {
+        // remove the oldest entries until the cache is a bit below its
+        // maximum
+        std::sort(entries.begin(), entries.end());
+        const int64_t target = maxSize - maxSize / 10;
+        for (size_t i = 0; i < entries.size() && total > target; ++i) {
+            if (unlink(entries[i].second.second.c_str()) == 0) {
+                total -= entries[i].second.first;
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    size += total;
+    evicting = false;
+}
@@ -0,0 +1,160 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_ANALYSISRESULTCACHE_H
+#define STRIGI_ANALYSISRESULTCACHE_H
+
+#include <strigi/indexwriter.h>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+
+namespace Strigi {
+
+class AnalysisResult;
+class FieldRegister;
+
+/**
+ * A cache on disk with the results of the analysis of files, keyed by the
+ * content of the files.
+ *
+ * The key of a file is a fingerprint of its size and its first and last
+ * blocks. For files that are larger than these blocks, the cache also
+ * stores the SHA-1 digest of the complete file, which is checked before a
+ * result is used. When the cache grows beyond its maximal size, the entries
+ * that were used least recently are removed.
+ *
+ * Results can also be found under a key made from the device, inode, size
+ * and modification time of a file. Such a result is used without reading
+ * the file at all.
+ **/
+class AnalysisResultCache {
+public:
+    /**
+     * An IndexWriter that passes everything to another IndexWriter and
+     * records what is written for one file and its embedded files.
+     **/
+    class Recorder : public IndexWriter {
+    friend class AnalysisResultCache;
+    private:
+        IndexWriter& writer;
+        const FieldRegister& fieldRegister;
+        const std::string root;
+        std::string data;
+        std::string hashUri;
+        std::string digest;
+        // the result that is writing its own values
+        const AnalysisResult* writing;
+    protected:
+        void startAnalysis(const AnalysisResult*);
+        void addText(const AnalysisResult*, const char* text, int32_t length);
+        void addValue(const AnalysisResult*, const RegisteredField* field,
+            const std::string& value);
+        void addValue(const AnalysisResult*, const RegisteredField* field,
+            const unsigned char* data, uint32_t size);
+        void addValue(const AnalysisResult*, const RegisteredField* field,
+            int32_t value);
+        void addValue(const AnalysisResult*, const RegisteredField* field,
+            uint32_t value);
+        void addValue(const AnalysisResult*, const RegisteredField* field,
+            double value);
+        void addValue(const AnalysisResult*, const RegisteredField* field,
+            const std::string& name, const std::string& value);
+        void finishAnalysis(const AnalysisResult*);
+        void addTriplet(const std::string& subject,
+            const std::string& predicate, const std::string& object);
+    public:
+        Recorder(IndexWriter& w, const FieldRegister& fr,
+            const std::string& path);
+        void commit() { writer.commit(); }
+        void deleteEntries(const std::vector<std::string>& entries) {
+            writer.deleteEntries(entries);
+        }
+        void deleteAllEntries() { writer.deleteAllEntries(); }
+    };
+
+    /**
+     * @param dir the directory in which the results are stored
+     * @param maxSize the maximal number of bytes to use in @p dir
+     **/
+    AnalysisResultCache(const std::string& dir, int64_t maxSize,
+        const FieldRegister& fieldRegister);
+    /**
+     * Compute the key for the file at @p path. Files that are too small to
+     * be worth caching get no key.
+     * @return true if @p key was set
+     **/
+    bool fingerprint(const std::string& path, int64_t size,
+        std::string& key) const;
+    /**
+     * Look up the stored result for the file at @p path.
+     * @return true if a usable result was found and put in @p entry
+     **/
+    bool lookup(const std::string& key, const std::string& path,
+        int64_t size, std::string& entry) const;
+    /**
+     * Compute the key for a file that has not changed since its result was
+     * stored.
+     **/
+    static std::string statKey(const struct stat& s);
+    /**
+     * Look up the stored result under a key from statKey(). The file
+     * itself is not read.
+     * @return true if a usable result was found and put in @p entry
+     **/
+    bool lookupUnchanged(const std::string& key, int64_t size,
+        std::string& entry) const;
+    /**
+     * Make the result stored under @p key available under @p statkey too.
+     **/
+    void link(const std::string& key, const std::string& statkey);
+    /**
+     * Write the result in @p entry to @p result, which must be a new
+     * top-level result, and its embedded files.
+     **/
+    void replay(const std::string& entry, AnalysisResult& result,
+        IndexWriter& writer) const;
+    /**
+     * Store what @p recorder has recorded under @p key.
+     **/
+    void store(const std::string& key, const std::string& path, int64_t size,
+        const Recorder& recorder);
+private:
+    const std::string dir;
+    const int64_t maxSize;
+    const FieldRegister& fieldRegister;
+    std::mutex mutex;
+    // an estimate of the number of bytes in the cache, which is counted
+    // again when it grows too large, or -1 if it has not been counted yet
+    int64_t size;
+    // true while a thread counts the size and removes old entries
+    bool evicting;
+
+    std::string entryPath(const std::string& key) const;
+    bool readEntry(const std::string& epath, int64_t size,
+        std::string& entry) const;
+    bool decode(const std::string& entry, AnalysisResult* result,
+        IndexWriter* writer) const;
+    void evict();
+};
+
+}
+
+#endif
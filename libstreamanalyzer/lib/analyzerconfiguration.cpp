@@ -56,9 +56,11 @@ public:
     FieldRegister m_fieldregister;
 
     bool indexArchiveContents;
+    AnalyzerConfiguration::FileOrder fileOrder;
 
     AnalyzerConfigurationPrivate()
-        : indexArchiveContents( true ) {
+        : indexArchiveContents( true ),
+          fileOrder(AnalyzerConfiguration::ReaddirOrder) {
     }
 };
 
@@ -115,6 +117,14 @@ void
 AnalyzerConfiguration::setIndexArchiveContents( bool b ) {
     p->indexArchiveContents = b;
 }
+AnalyzerConfiguration::FileOrder
+AnalyzerConfiguration::fileOrder() const {
+    return p->fileOrder;
+}
+void
+AnalyzerConfiguration::setFileOrder(FileOrder order) {
+    p->fileOrder = order;
+}
 bool
 AnalyzerConfiguration::indexDir(const char* path, const char* filename) const {
     std::vector<AnalyzerConfigurationPrivate::Pattern>::const_iterator i;
@@ -0,0 +1,577 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "asyncindexwriter.h"
+#include "strigi_thread.h"
+#include <strigi/analysisresult.h>
+#include <strigi/analyzerconfiguration.h>
+#include <strigi/fieldtypes.h>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+
+using namespace Strigi;
+
+namespace {
+const std::string fileDataObject(
+    "http://www.semanticdesktop.org/ontologies/2007/03/22/nfo#FileDataObject");
+
+/**
+ * The kinds of calls in the buffer of a document. Each event is followed
+ * by the depth of the result it applies to, except for triplets, and the
+ * values by the address of their field.
+ **/
+enum Event {
+    StartEvent = 'S', FinishEvent = 'F', TextEvent = 'T',
+    StringEvent = 's', BinaryEvent = 'b', Int32Event = 'i',
+    Uint32Event = 'u', DoubleEvent = 'd', NameValueEvent = 'n',
+    TripletEvent = 'R', EncodingEvent = 'e', MimeTypeEvent = 'm'
+};
+
+void
+put(std::string& out, const void* data, size_t size) {
+    out.append((const char*)data, size);
+}
+void
+putString(std::string& out, const char* data, uint32_t size) {
+    put(out, &size, sizeof(size));
+    out.append(data, size);
+}
+void
+putString(std::string& out, const std::string& s) {
+    putString(out, s.c_str(), (uint32_t)s.length());
+}
+
+/**
+ * The calls for a top-level result and its embedded results.
+ **/
+class Document {
+public:
+    std::string events;
+    // the result that is writing its own values
+    const AnalysisResult* writing;
+    // the document that the same thread was recording before this one
+    Document* outer;
+
+    Document() :writing(0), outer(0) {}
+    void add(Event event, const AnalysisResult* ar) {
+        events.append(1, (char)event);
+        events.append(1, (char)ar->depth());
+    }
+    void add(Event event, const AnalysisResult* ar,
+            const RegisteredField* field) {
+        add(event, ar);
+        put(events, &field, sizeof(field));
+    }
+};
+Document*
+document(const AnalysisResult* ar) {
+    return static_cast<Document*>(ar->writerData());
+}
+
+/**
+ * Reads the buffer of a document; get() returns false at its end.
+ **/
+class Reader {
+private:
+    const std::string& data;
+    size_t pos;
+public:
+    explicit Reader(const std::string& d) :data(d), pos(0) {}
+    bool get(void* out, size_t size) {
+        if (data.length() - pos < size) {
+            return false;
+        }
+        memcpy(out, data.c_str() + pos, size);
+        pos += size;
+        return true;
+    }
+    bool getString(std::string& out) {
+        uint32_t size;
+        if (!get(&size, sizeof(size)) || data.length() - pos < size) {
+            return false;
+        }
+        out.assign(data, pos, size);
+        pos += size;
+        return true;
+    }
+};
+}
+
+class AsyncIndexWriter::Private {
+public:
+    IndexWriter& writer;
+    const size_t maxQueued;
+    std::mutex mutex;
+    // signalled when a document is queued or when the thread should stop
+    std::condition_variable queueChanged;
+    // signalled when a document is taken from the queue or written
+    std::condition_variable documentWritten;
+    std::deque<std::string> queue;
+    size_t queuedBytes;
+    // the number of documents that were queued and that were written
+    uint64_t queued;
+    uint64_t written;
+    bool stopping;
+    // the document that each analyzing thread is recording
+    std::map<STRIGI_THREAD_TYPE, Document*> current;
+    // held while the writer is used
+    std::mutex writerMutex;
+    STRIGI_THREAD_TYPE thread;
+
+    Private(IndexWriter& w, size_t max) :writer(w), maxQueued(max),
+        queuedBytes(0), queued(0), written(0), stopping(false) {}
+    void push(std::string& events);
+    void run();
+    void flush();
+};
+
+extern "C" // Linkage for functions passed to pthread_create matters
+{
+void*
+writeDocumentsInThread(void* d) {
+    static_cast<AsyncIndexWriter::Private*>(d)->run();
+    STRIGI_THREAD_EXIT(0);
+    return 0; // Return bogus value
+}
+}
+
+/**
+ * Queue the document in @p events, waiting while the queue is full. A
+ * document that does not fit in an empty queue is queued anyway.
+ **/
+void
+AsyncIndexWriter::Private::push(std::string& events) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (queuedBytes && queuedBytes + events.length() > maxQueued) {
+        documentWritten.wait(lock);
+    }
+    queuedBytes += events.length();
+    queue.push_back(std::string());
+    queue.back().swap(events);
+    ++queued;
+    lock.unlock();
+    queueChanged.notify_one();
+}
+void
+AsyncIndexWriter::Private::run() {
+    std::string events;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        while (queue.empty() && !stopping) {
+            queueChanged.wait(lock);
+        }
+        // the documents that are still queued are written before stopping
+        if (queue.empty()) {
+            break;
+        }
+        events.swap(queue.front());
+        queue.pop_front();
+        queuedBytes -= events.length();
+        lock.unlock();
+        documentWritten.notify_all();
+        {
+            std::lock_guard<std::mutex> writerLock(writerMutex);
+            replay(writer, events);
+        }
+        events.clear();
+        lock.lock();
+        ++written;
+        documentWritten.notify_all();
+    }
+}
+void
+AsyncIndexWriter::Private::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    // documents that are queued after this call are not waited for
+    const uint64_t target = queued;
+    while (written < target) {
+        documentWritten.wait(lock);
+    }
+}
+
+AsyncIndexWriter::AsyncIndexWriter(IndexWriter& writer, size_t maxQueued)
+        :p(new Private(writer, maxQueued)) {
+    STRIGI_THREAD_CREATE(&p->thread, writeDocumentsInThread, p);
+}
+AsyncIndexWriter::~AsyncIndexWriter() {
+    {
+        std::lock_guard<std::mutex> lock(p->mutex);
+        p->stopping = true;
+    }
+    p->queueChanged.notify_one();
+    STRIGI_THREAD_JOIN(p->thread);
+    // documents that were never finished are not written
+    std::map<STRIGI_THREAD_TYPE, Document*>::const_iterator i;
+    for (i = p->current.begin(); i != p->current.end(); ++i) {
+        for (Document* d = i->second; d; ) {
+            Document* outer = d->outer;
+            delete d;
+            d = outer;
+        }
+    }
+    delete p;
+}
+void
+AsyncIndexWriter::startAnalysis(const AnalysisResult* ar) {
+    int64_t mtime = ar->mTime();
+    if (ar->depth() > 0) {
+        // embedded results are recorded in the document of their parent
+        Document* d = document(ar->parent());
+        ar->setWriterData(d);
+        d->add(StartEvent, ar);
+        put(d->events, &mtime, sizeof(mtime));
+        putString(d->events, ar->path());
+        return;
+    }
+    Document* d = new Document();
+    d->add(StartEvent, ar);
+    StreamAnalyzer* analyzer = &ar->analyzer();
+    put(d->events, &analyzer, sizeof(analyzer));
+    put(d->events, &mtime, sizeof(mtime));
+    putString(d->events, ar->path());
+    putString(d->events, ar->parentPath());
+    ar->setWriterData(d);
+    // triplets are added to the document of the thread that adds them
+    std::lock_guard<std::mutex> lock(p->mutex);
+    Document*& c = p->current[STRIGI_THREAD_SELF()];
+    d->outer = c;
+    c = d;
+}
+void
+AsyncIndexWriter::addText(const AnalysisResult* ar, const char* text,
+        int32_t length) {
+    Document* d = document(ar);
+    d->add(TextEvent, ar);
+    putString(d->events, text, length);
+}
+void
+AsyncIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, const std::string& value) {
+    Document* d = document(ar);
+    const FieldRegister& fr = ar->config().fieldRegister();
+    // AnalysisResult writes these values itself when it is finished, also
+    // when it is replayed; they start with the path
+    if (field == fr.pathField) {
+        d->writing = ar;
+        return;
+    }
+    if (d->writing == ar) {
+        if (field == fr.parentLocationField || field == fr.filenameField
+                || (ar->depth() == 0 && field == fr.typeField
+                    && value == fileDataObject)) {
+            return;
+        }
+        // the encoding and the mime type are kept in the result
+        if (field == fr.encodingField || field == fr.mimetypeField) {
+            d->add((field == fr.encodingField)
+                ?EncodingEvent :MimeTypeEvent, ar);
+            putString(d->events, value);
+            return;
+        }
+    }
+    d->add(StringEvent, ar, field);
+    putString(d->events, value);
+}
+void
+AsyncIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, const unsigned char* data,
+        uint32_t size) {
+    Document* d = document(ar);
+    d->add(BinaryEvent, ar, field);
+    putString(d->events, (const char*)data, size);
+}
+void
+AsyncIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, int32_t value) {
+    Document* d = document(ar);
+    d->add(Int32Event, ar, field);
+    put(d->events, &value, sizeof(value));
+}
+void
+AsyncIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, uint32_t value) {
+    Document* d = document(ar);
+    if (d->writing == ar
+            && field == ar->config().fieldRegister().mtimeField) {
+        return;
+    }
+    d->add(Uint32Event, ar, field);
+    put(d->events, &value, sizeof(value));
+}
+void
+AsyncIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, double value) {
+    Document* d = document(ar);
+    d->add(DoubleEvent, ar, field);
+    put(d->events, &value, sizeof(value));
+}
+void
+AsyncIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, const std::string& name,
+        const std::string& value) {
+    Document* d = document(ar);
+    d->add(NameValueEvent, ar, field);
+    putString(d->events, name);
+    putString(d->events, value);
+}
+void
+AsyncIndexWriter::finishAnalysis(const AnalysisResult* ar) {
+    Document* d = document(ar);
+    // the next result may get the same address
+    d->writing = 0;
+    d->add(FinishEvent, ar);
+    if (ar->depth() > 0) {
+        return;
+    }
+    ar->setWriterData(0);
+    {
+        std::lock_guard<std::mutex> lock(p->mutex);
+        std::map<STRIGI_THREAD_TYPE, Document*>::iterator i
+            = p->current.find(STRIGI_THREAD_SELF());
+        if (i != p->current.end() && i->second == d) {
+            if (d->outer) {
+                i->second = d->outer;
+            } else {
+                p->current.erase(i);
+            }
+        }
+    }
+    p->push(d->events);
+    delete d;
+}
+void
+AsyncIndexWriter::addTriplet(const std::string& subject,
+        const std::string& predicate, const std::string& object) {
+    Document* d = 0;
+    {
+        std::lock_guard<std::mutex> lock(p->mutex);
+        std::map<STRIGI_THREAD_TYPE, Document*>::const_iterator i
+            = p->current.find(STRIGI_THREAD_SELF());
+        if (i != p->current.end()) {
+            d = i->second;
+        }
+    }
+    std::string events;
+    std::string& out = (d) ?d->events :events;
+    out.append(1, (char)TripletEvent);
+    putString(out, subject);
+    putString(out, predicate);
+    putString(out, object);
+    // a triplet outside of a document is queued on its own
+    if (d == 0) {
+        p->push(events);
+    }
+}
+/**
+ * Make the calls in @p events on @p writer with new results that are like
+ * the recorded ones.
+ **/
+void
+AsyncIndexWriter::replay(IndexWriter& writer, const std::string& events) {
+    Reader in(events);
+    // the open results, one per depth
+    std::vector<AnalysisResult*> open;
+    bool ok = true;
+    std::string a, b, c;
+    char event;
+    while (ok && in.get(&event, 1)) {
+        if (event == TripletEvent) {
+            ok = in.getString(a) && in.getString(b) && in.getString(c);
+            if (ok) {
+                writer.addTriplet(a, b, c);
+            }
+            continue;
+        }
+        char depth;
+        ok = in.get(&depth, 1) && depth >= 0;
+        if (!ok) {
+            break;
+        }
+        if (event == StartEvent) {
+            int64_t mtime;
+            if (depth == 0) {
+                StreamAnalyzer* analyzer;
+                ok = open.empty() && in.get(&analyzer, sizeof(analyzer))
+                    && in.get(&mtime, sizeof(mtime)) && in.getString(a)
+                    && in.getString(b);
+                if (ok) {
+                    open.push_back(new AnalysisResult(a, (time_t)mtime,
+                        writer, *analyzer, b));
+                }
+            } else {
+                ok = (size_t)depth == open.size()
+                    && in.get(&mtime, sizeof(mtime)) && in.getString(a);
+                if (ok) {
+                    const char* name = a.c_str() + a.rfind('/') + 1;
+                    open.push_back(new AnalysisResult(a, name,
+                        (time_t)mtime, *open.back()));
+                }
+            }
+            continue;
+        }
+        if ((size_t)depth >= open.size()) {
+            break;
+        }
+        AnalysisResult* target = open[depth];
+        const RegisteredField* field = 0;
+        if (event != FinishEvent && event != TextEvent
+                && event != EncodingEvent && event != MimeTypeEvent) {
+            ok = in.get(&field, sizeof(field));
+            if (!ok) {
+                break;
+            }
+        }
+        switch (event) {
+        case FinishEvent:
+            ok = (size_t)depth + 1 == open.size();
+            if (ok) {
+                delete open.back();
+                open.pop_back();
+            }
+            break;
+        case TextEvent:
+            ok = in.getString(b);
+            if (ok) {
+                writer.addText(target, b.c_str(), (int32_t)b.length());
+            }
+            break;
+        case StringEvent:
+            ok = in.getString(b);
+            if (ok) {
+                writer.addValue(target, field, b);
+            }
+            break;
+        case BinaryEvent:
+            ok = in.getString(b);
+            if (ok) {
+                writer.addValue(target, field,
+                    (const unsigned char*)b.c_str(), (uint32_t)b.length());
+            }
+            break;
+        case Int32Event: {
+            int32_t v;
+            ok = in.get(&v, sizeof(v));
+            if (ok) {
+                writer.addValue(target, field, v);
+            }
+            break;
+        }
+        case Uint32Event: {
+            uint32_t v;
+            ok = in.get(&v, sizeof(v));
+            if (ok) {
+                writer.addValue(target, field, v);
+            }
+            break;
+        }
+        case DoubleEvent: {
+            double v;
+            ok = in.get(&v, sizeof(v));
+            if (ok) {
+                writer.addValue(target, field, v);
+            }
+            break;
+        }
+        case EncodingEvent:
+            ok = in.getString(b);
+            if (ok) {
+                target->setEncoding(b.c_str());
+            }
+            break;
+        case MimeTypeEvent:
+            ok = in.getString(b);
+            if (ok) {
+                target->setMimeType(b);
+            }
+            break;
+        case NameValueEvent:
+            ok = in.getString(b) && in.getString(c);
+            if (ok) {
+                writer.addValue(target, field, b, c);
+            }
+            break;
+        default:
+            ok = false;
+        }
+    }
+    // close the results that are still open
+    while (open.size()) {
+        delete open.back();
+        open.pop_back();
+    }
+}
+void
+AsyncIndexWriter::flush() {
+    p->flush();
+}
+void
+AsyncIndexWriter::commit() {
+    p->flush();
+    std::lock_guard<std::mutex> lock(p->writerMutex);
+    p->writer.commit();
+}
+void
+AsyncIndexWriter::deleteEntries(const std::vector<std::string>& entries) {
+    p->flush();
+    std::lock_guard<std::mutex> lock(p->writerMutex);
+    p->writer.deleteEntries(entries);
+}
+void
+AsyncIndexWriter::deleteAllEntries() {
+    p->flush();
+    std::lock_guard<std::mutex> lock(p->writerMutex);
+    p->writer.deleteAllEntries();
+}
+int
+AsyncIndexWriter::itemsInCache() {
+    size_t queued;
+    {
+        std::lock_guard<std::mutex> lock(p->mutex);
+        queued = p->queue.size();
+    }
+    std::lock_guard<std::mutex> lock(p->writerMutex);
+    return p->writer.itemsInCache() + (int)queued;
+}
+void
+AsyncIndexWriter::optimize() {
+    p->flush();
+    std::lock_guard<std::mutex> lock(p->writerMutex);
+    p->writer.optimize();
+}
+void
+AsyncIndexWriter::initWriterData(const FieldRegister& fieldRegister) {
+    // the fields carry the data of the other writer
+    std::lock_guard<std::mutex> lock(p->writerMutex);
+    p->writer.initWriterData(fieldRegister);
+}
+void
+AsyncIndexWriter::releaseWriterData(const FieldRegister& fieldRegister) {
+    // the queued documents may use the fields and the analyzer
+    p->flush();
+    std::lock_guard<std::mutex> lock(p->writerMutex);
+    p->writer.releaseWriterData(fieldRegister);
+}
@@ -17,6 +17,10 @@
  * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
  * Boston, MA 02110-1301, USA.
  */
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
 #include <strigi/diranalyzer.h>
 #include <strigi/indexwriter.h>
 #include <strigi/indexmanager.h>
@@ -26,9 +30,18 @@
 #include <strigi/analyzerconfiguration.h>
 #include <strigi/strigi_thread.h>
 #include <strigi/fileinputstream.h>
+#include <strigi/fieldtypes.h>
+#include "analysisresultcache.h"
+#include "dirwatcher.h"
 #include <map>
+#include <set>
+#include <mutex>
+#include <condition_variable>
 #include <iostream>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <ctime>
 
 using namespace Strigi;
 
@@ -39,20 +52,87 @@ public:
     AnalyzerConfiguration& config;
     StreamAnalyzer analyzer;
     AnalysisCaller* caller;
+    // the first path that was seen for each file with more than one link
+    std::mutex linksMutex;
+    std::map<std::pair<dev_t, ino_t>, std::string> links;
+    const RegisteredField* hardLinkField;
+    // the state of the crawl is saved to checkpointFile every
+    // checkpointInterval seconds; to do so, the threads that are analyzing
+    // wait between two batches until all of them have finished their batch
+    std::string checkpointFile;
+    int checkpointInterval;
+    std::mutex checkpointMutex;
+    std::condition_variable checkpointWritten;
+    time_t lastCheckpoint;
+    int running;
+    int paused;
+    unsigned int checkpoints;
+    // true if a thread stopped before handling all entries of its batch
+    bool interrupted;
+    // the changed entries that are analyzed in watchDirs()
+    std::mutex entriesMutex;
+    std::vector<std::pair<std::string, struct stat> > entries;
+    size_t nextEntry;
+    // the results of files that were analyzed before, or 0
+    AnalysisResultCache* cache;
+    // during a crawl, the index is committed after commitDocs documents,
+    // commitBytes bytes or commitSeconds seconds by the thread that
+    // finishes the document that reaches the limit; 0 turns a limit off
+    int commitDocs;
+    int64_t commitBytes;
+    int commitSeconds;
+    CommitListener* commitListener;
+    std::mutex commitMutex;
+    int pendingDocs;
+    int64_t pendingBytes;
+    time_t lastCommit;
+    bool committing;
 
     Private(IndexManager& m, AnalyzerConfiguration& c)
-            :dirlister(&c), manager(m), config(c), analyzer(c) {
+            :dirlister(&c), manager(m), config(c), analyzer(c),
+             checkpointInterval(60), running(0), paused(0), checkpoints(0),
+             interrupted(false), nextEntry(0), cache(0), commitDocs(0),
+             commitBytes(0), commitSeconds(0), commitListener(0),
+             pendingDocs(0), pendingBytes(0), lastCommit(time(0)),
+             committing(false) {
+        // register the field before the writer prepares its data for the
+        // registered fields
+        hardLinkField = c.fieldRegister().registerField(
+            "http://strigi.sf.net/ontologies/0.9#hardLinkOf");
         analyzer.setIndexWriter(*manager.indexWriter());
     }
     ~Private() {
+        delete cache;
     }
     int analyzeDir(const std::string& dir, int nthreads, AnalysisCaller* caller,
         const std::string& lastToSkip);
+    int resumeDir(int nthreads, AnalysisCaller* caller);
+    int analyzeListing(int nthreads);
     int updateDirs(const std::vector<std::string>& dir, int nthreads,
         AnalysisCaller* caller);
     void analyze(StreamAnalyzer*);
+    void checkpoint();
+    void leave(bool complete);
+    void checkpointIfAllPaused();
+    void writeCheckpoint();
+    void commit();
+    void documentDone(const struct stat& s);
     void update(StreamAnalyzer*);
-    int analyzeFile(const std::string& path, time_t mtime, bool realfile);
+    int watchDirs(const std::vector<std::string>& dirs, int nthreads,
+        AnalysisCaller* caller);
+    void handleChanges(const std::set<std::string>& changed,
+        DirWatcher& watcher, std::vector<StreamAnalyzer*>& analyzers);
+    void deleteTree(const std::string& path,
+        std::vector<std::string>& toDelete);
+    void analyzeEntries(StreamAnalyzer*);
+    int analyzeFile(StreamAnalyzer& a, const std::string& path,
+        const struct stat& s, const std::string& parent);
+    int indexFile(StreamAnalyzer& a, const std::string& path,
+        const struct stat& s, const std::string& parent);
+    int analyzeCached(StreamAnalyzer& a, const std::string& path,
+        const struct stat& s, const std::string& parent);
+    bool firstLink(const std::string& path, const struct stat& s,
+        std::string& first);
 };
 
 struct DA {
@@ -78,6 +158,14 @@ updateInThread(void* d) {
     STRIGI_THREAD_EXIT(0);
     return 0; // Return bogus value
 }
+void*
+analyzeEntriesInThread(void* d) {
+    DA* a = static_cast<DA*>(d);
+    a->diranalyzer->analyzeEntries(a->streamanalyzer);
+    delete a;
+    STRIGI_THREAD_EXIT(0);
+    return 0; // Return bogus value
+}
 }
 
 DirAnalyzer::DirAnalyzer(IndexManager& manager, AnalyzerConfiguration& conf)
@@ -86,51 +174,255 @@ DirAnalyzer::DirAnalyzer(IndexManager& manager, AnalyzerConfiguration& conf)
 DirAnalyzer::~DirAnalyzer() {
     delete p;
 }
+/**
+ * Check if the file is seen for the first time. Files with one link are
+ * always new; for other files, the first path under which they were seen is
+ * remembered and returned in @p first.
+ **/
+bool
+DirAnalyzer::Private::firstLink(const std::string& path, const struct stat& s,
+        std::string& first) {
+    if (s.st_nlink < 2) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(linksMutex);
+    std::pair<std::map<std::pair<dev_t, ino_t>, std::string>::iterator, bool>
+        i = links.insert(std::make_pair(std::make_pair(s.st_dev, s.st_ino),
+            path));
+    if (i.second) {
+        return true;
+    }
+    first.assign(i.first->second);
+    return false;
+}
 int
-DirAnalyzer::Private::analyzeFile(const std::string& path, time_t mtime,
-        bool realfile) {
-    AnalysisResult analysisresult(path, mtime, *manager.indexWriter(),
-        analyzer, "");
-    if (realfile) {
-        InputStream* file = FileInputStream::open(path.c_str());
+DirAnalyzer::Private::analyzeFile(StreamAnalyzer& a, const std::string& path,
+        const struct stat& s, const std::string& parent) {
+    const int r = indexFile(a, path, s, parent);
+    documentDone(s);
+    return r;
+}
+int
+DirAnalyzer::Private::indexFile(StreamAnalyzer& a, const std::string& path,
+        const struct stat& s, const std::string& parent) {
+    if (S_ISREG(s.st_mode)) {
+        // a hard link to a file that was analyzed already only gets a
+        // record that points to the analyzed path
+        std::string first;
+        if (!firstLink(path, s, first)) {
+            AnalysisResult analysisresult(path, s.st_mtime,
+                *manager.indexWriter(), a, parent);
+            analysisresult.addValue(hardLinkField, first);
+            return 0;
+        }
+        if (cache) {
+            return analyzeCached(a, path, s, parent);
+        }
+        AnalysisResult analysisresult(path, s.st_mtime, *manager.indexWriter(),
+            a, parent);
+        InputStream* file = FileInputStream::open(path.c_str(), s.st_size);
         int r = analysisresult.index(file);
         delete file;
         return r;
-    } else {
-        return analysisresult.index(0);
     }
+    AnalysisResult analysisresult(path, s.st_mtime, *manager.indexWriter(),
+        a, parent);
+    return analysisresult.index(0);
+}
+/**
+ * Analyze a file with the help of the result cache. If the file has not
+ * changed since it was analyzed, or if a file with the same contents was
+ * analyzed before, the stored result is written for this path. Otherwise
+ * the file is analyzed and the result is stored in the cache.
+ **/
+int
+DirAnalyzer::Private::analyzeCached(StreamAnalyzer& a,
+        const std::string& path, const struct stat& s,
+        const std::string& parent) {
+    const std::string statkey(AnalysisResultCache::statKey(s));
+    std::string key;
+    std::string entry;
+    bool found = cache->lookupUnchanged(statkey, s.st_size, entry);
+    const bool keyed = !found && cache->fingerprint(path, s.st_size, key);
+    if (keyed && cache->lookup(key, path, s.st_size, entry)) {
+        cache->link(key, statkey);
+        found = true;
+    }
+    if (found) {
+        AnalysisResult analysisresult(path, s.st_mtime, *manager.indexWriter(),
+            a, parent);
+        cache->replay(entry, analysisresult, *manager.indexWriter());
+        return 0;
+    }
+    AnalysisResultCache::Recorder recorder(*manager.indexWriter(),
+        config.fieldRegister(), path);
+    int r;
+    {
+        AnalysisResult analysisresult(path, s.st_mtime, recorder, a, parent);
+        InputStream* file = FileInputStream::open(path.c_str(), s.st_size);
+        r = analysisresult.index(file);
+        delete file;
+    }
+    // a result that was cut short is not stored
+    if (r == 0 && config.indexMore()) {
+        if (keyed) {
+            cache->store(key, path, s.st_size, recorder);
+            cache->link(key, statkey);
+        } else {
+            cache->store(statkey, path, s.st_size, recorder);
+        }
+    }
+    return r;
 }
 void
 DirAnalyzer::Private::analyze(StreamAnalyzer* analyzer) {
-    IndexWriter& indexWriter = *manager.indexWriter();
+    bool complete = true;
     try {
         std::string parentpath;
         std::vector<std::pair<std::string, struct stat> > dirfiles;
-        int r = dirlister.nextDir(parentpath, dirfiles);
-
+        // the caller is asked before a batch is taken from the lister, so
+        // a batch that was taken is always analyzed or the checkpoint
+        // knows that it was not
+        int r = 0;
         while (r == 0 && (caller == 0 || caller->continueAnalysis())) {
+            r = dirlister.nextDirBatch(parentpath, dirfiles);
+            if (r != 0) {
+                break;
+            }
             std::vector<std::pair<std::string, struct stat> >::const_iterator end
                 = dirfiles.end();
             for (std::vector<std::pair<std::string, struct stat> >::const_iterator i
                     = dirfiles.begin(); i != end; ++i) {
-                const std::string& filepath(i->first);
-                struct stat s = i->second;
-                AnalysisResult analysisresult(filepath, s.st_mtime,
-                    indexWriter, *analyzer, parentpath);
-                if (S_ISREG(s.st_mode)) {
-                    InputStream* file = FileInputStream::open(filepath.c_str());
-                    analysisresult.index(file);
-                    delete file;
-                } else {
-                    analysisresult.index(0);
+                analyzeFile(*analyzer, i->first, i->second, parentpath);
+                if (!config.indexMore()) {
+                    complete = i + 1 == end;
+                    r = -1;
+                    break;
                 }
-                if (!config.indexMore()) return;
             }
-            r = dirlister.nextDir(parentpath, dirfiles);
+            if (r == 0) {
+                checkpoint();
+            }
         }
     } catch(...) {
+        complete = false;
         fprintf(stderr, "Unknown error\n");
     }
+    leave(complete);
+}
+/**
+ * Called by the analyzing threads between two batches. When a checkpoint is
+ * due, the threads wait here until the last one has arrived. That one
+ * writes the checkpoint while no entries are being handled.
+ **/
+void
+DirAnalyzer::Private::checkpoint() {
+    if (checkpointFile.empty()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(checkpointMutex);
+    if (paused == 0 && time(0) - lastCheckpoint < checkpointInterval) {
+        return;
+    }
+    ++paused;
+    const unsigned int c = checkpoints;
+    checkpointIfAllPaused();
+    while (c == checkpoints) {
+        checkpointWritten.wait(lock);
+    }
+}
+/**
+ * Called by the analyzing threads when they stop. @p complete is false if
+ * the thread did not handle all entries of its last batch; no checkpoints
+ * are written after that, because they would skip these entries.
+ **/
+void
+DirAnalyzer::Private::leave(bool complete) {
+    if (checkpointFile.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(checkpointMutex);
+    --running;
+    if (!complete) {
+        interrupted = true;
+    }
+    checkpointIfAllPaused();
+}
+/**
+ * Write the checkpoint when all running threads are waiting for it and
+ * wake them up. Must be called with checkpointMutex held.
+ **/
+void
+DirAnalyzer::Private::checkpointIfAllPaused() {
+    if (paused == 0 || paused != running) {
+        return;
+    }
+    if (!interrupted) {
+        writeCheckpoint();
+    }
+    paused = 0;
+    ++checkpoints;
+    lastCheckpoint = time(0);
+    checkpointWritten.notify_all();
+}
+/**
+ * Commit the index and save the directories that still have to be
+ * analyzed. If there are none, the checkpoint file is removed.
+ **/
+void
+DirAnalyzer::Private::writeCheckpoint() {
+    commit();
+    if (dirlister.saveState(checkpointFile) == 0) {
+        unlink(checkpointFile.c_str());
+    }
+}
+/**
+ * Commit the index and tell the listener.
+ **/
+void
+DirAnalyzer::Private::commit() {
+    {
+        std::lock_guard<std::mutex> lock(commitMutex);
+        pendingDocs = 0;
+        pendingBytes = 0;
+    }
+    manager.indexWriter()->commit();
+    {
+        std::lock_guard<std::mutex> lock(commitMutex);
+        lastCommit = time(0);
+    }
+    if (commitListener) {
+        commitListener->committed();
+    }
+}
+/**
+ * Called by the analyzing threads after each entry. If the entry reaches a
+ * limit of the commit policy and no other thread is committing, the index
+ * is committed. The documents of the other threads are not finished, so
+ * they are not part of the commit.
+ **/
+void
+DirAnalyzer::Private::documentDone(const struct stat& s) {
+    if (commitDocs == 0 && commitBytes == 0 && commitSeconds == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(commitMutex);
+        ++pendingDocs;
+        if (S_ISREG(s.st_mode)) {
+            pendingBytes += s.st_size;
+        }
+        const bool due = (commitDocs && pendingDocs >= commitDocs)
+            || (commitBytes && pendingBytes >= commitBytes)
+            || (commitSeconds && time(0) - lastCommit >= commitSeconds);
+        if (!due || committing) {
+            return;
+        }
+        committing = true;
+    }
+    commit();
+    std::lock_guard<std::mutex> lock(commitMutex);
+    committing = false;
 }
 void
 DirAnalyzer::Private::update(StreamAnalyzer* analyzer) {
@@ -187,15 +479,7 @@ DirAnalyzer::Private::update(StreamAnalyzer* analyzer) {
                 = toIndex.end();
             for (std::vector<std::pair<std::string, struct stat> >::const_iterator i
                     = toIndex.begin(); i != fend; ++i) {
-                AnalysisResult analysisresult(i->first, i->second.st_mtime,
-                    *manager.indexWriter(), *analyzer, path);
-                if (S_ISREG(i->second.st_mode)) {
-                    InputStream* file = FileInputStream::open(i->first.c_str());
-                    analysisresult.index(file);
-                    delete file;
-                } else {
-                    analysisresult.index(0);
-                }
+                analyzeFile(*analyzer, i->first, i->second, path);
             }
             toDelete.clear();
             toIndex.clear();
@@ -210,6 +494,31 @@ DirAnalyzer::analyzeDir(const std::string& dir, int nthreads, AnalysisCaller* c,
         const std::string& lastToSkip) {
     return p->analyzeDir(dir, nthreads, c, lastToSkip);
 }
+void
+DirAnalyzer::setCheckpoint(const std::string& file, int interval) {
+    p->checkpointFile.assign(file);
+    p->checkpointInterval = interval;
+}
+void
+DirAnalyzer::setCommitPolicy(int maxDocs, int64_t maxBytes, int maxSeconds) {
+    p->commitDocs = (maxDocs > 0) ?maxDocs :0;
+    p->commitBytes = (maxBytes > 0) ?maxBytes :0;
+    p->commitSeconds = (maxSeconds > 0) ?maxSeconds :0;
+}
+void
+DirAnalyzer::setCommitListener(CommitListener* listener) {
+    p->commitListener = listener;
+}
+int
+DirAnalyzer::resumeDir(int nthreads, AnalysisCaller* caller) {
+    return p->resumeDir(nthreads, caller);
+}
+void
+DirAnalyzer::setResultCache(const std::string& dir, int64_t maxSize) {
+    delete p->cache;
+    p->cache = new AnalysisResultCache(dir, maxSize,
+        p->config.fieldRegister());
+}
 namespace {
 std::string
 removeTrailingSlash(const std::string& path) {
@@ -234,21 +543,42 @@ DirAnalyzer::Private::analyzeDir(const std::string& dir, int nthreads,
     } else {
         retval = stat(path.c_str(), &s);
     }
-    time_t mtime = (retval == -1) ?0 :s.st_mtime;
-    bool isfile = (retval == -1) ?false :S_ISREG(s.st_mode);
-    bool isdir = (retval == -1) ?false :S_ISDIR(s.st_mode);
-    retval = analyzeFile(path, mtime, isfile);
+    if (retval == -1) {
+        memset(&s, 0, sizeof(s));
+    }
+    bool isdir = S_ISDIR(s.st_mode);
+    links.clear();
+    retval = analyzeFile(analyzer, path, s, "");
     // if the path does not point to a directory, return
     if (!isdir) {
-        manager.indexWriter()->commit();
+        commit();
         return retval;
     }
     dirlister.startListing(path);
     if (lastToSkip.length()) {
         dirlister.skipTillAfter(lastToSkip);
     }
-
+    return analyzeListing(nthreads);
+}
+int
+DirAnalyzer::Private::resumeDir(int nthreads, AnalysisCaller* c) {
+    caller = c;
+    links.clear();
+    if (checkpointFile.empty() || dirlister.restoreState(checkpointFile)) {
+        return -1;
+    }
+    return analyzeListing(nthreads);
+}
+/**
+ * Analyze the entries from dirlister with @p nthreads threads.
+ **/
+int
+DirAnalyzer::Private::analyzeListing(int nthreads) {
     if (nthreads < 1) nthreads = 1;
+    running = nthreads;
+    paused = 0;
+    interrupted = false;
+    lastCheckpoint = time(0);
     std::vector<StreamAnalyzer*> analyzers(nthreads);
     analyzers[0] = &analyzer;
     for (int i=1; i<nthreads; ++i) {
@@ -268,7 +598,13 @@ DirAnalyzer::Private::analyzeDir(const std::string& dir, int nthreads,
         STRIGI_THREAD_JOIN(threads[i-1]);
         delete analyzers[i];
     }
-    manager.indexWriter()->commit();
+    if (checkpointFile.size() && !interrupted) {
+        // all returned entries have been handled, so the crawl can continue
+        // from the current state
+        writeCheckpoint();
+    } else {
+        commit();
+    }
     return 0;
 }
 int
@@ -283,6 +619,7 @@ DirAnalyzer::Private::updateDirs(const std::vector<std::string>& dirs, int nthre
     IndexReader* reader = manager.indexReader();
     if (reader == 0) return -1;
     caller = c;
+    links.clear();
 
     // create the streamanalyzers
     if (nthreads < 1) nthreads = 1;
@@ -325,7 +662,7 @@ DirAnalyzer::Private::updateDirs(const std::vector<std::string>& dirs, int nthre
         ++it;
     }
     dbfiles.clear();*/
-    manager.indexWriter()->commit();
+    commit();
 
     return 0;
 }
@@ -334,3 +671,169 @@ DirAnalyzer::updateDirs(const std::vector<std::string>& dirs, int nthreads,
         AnalysisCaller* caller) {
     return p->updateDirs(dirs, nthreads, caller);
 }
+int
+DirAnalyzer::watchDirs(const std::vector<std::string>& dirs, int nthreads,
+        AnalysisCaller* caller) {
+    return p->watchDirs(dirs, nthreads, caller);
+}
+int
+DirAnalyzer::Private::watchDirs(const std::vector<std::string>& dirs,
+        int nthreads, AnalysisCaller* c) {
+    IndexReader* reader = manager.indexReader();
+    if (reader == 0) return -1;
+    DirWatcher watcher(&config);
+    if (!watcher.isValid()) return -1;
+
+    // watch the directories before the index is updated, so no change is
+    // missed in between
+    std::vector<std::string> roots;
+    for (std::vector<std::string>::const_iterator d = dirs.begin();
+            d != dirs.end(); ++d) {
+        roots.push_back(removeTrailingSlash(*d));
+        watcher.addTree(roots.back(), 0);
+    }
+    updateDirs(roots, nthreads, c);
+
+    if (nthreads < 1) nthreads = 1;
+    std::vector<StreamAnalyzer*> analyzers(nthreads);
+    analyzers[0] = &analyzer;
+    for (int i=1; i<nthreads; ++i) {
+        analyzers[i] = new StreamAnalyzer(config);
+        analyzers[i]->setIndexWriter(*manager.indexWriter());
+    }
+    std::set<std::string> changed;
+    int r = 0;
+    while (caller == 0 || caller->continueAnalysis()) {
+        bool overflow = false;
+        changed.clear();
+        r = watcher.collect(1000, 200, changed, overflow);
+        if (r < 0) {
+            break;
+        }
+        if (overflow) {
+            // events were lost, so the trees are compared with the index
+            watcher.clear();
+            for (std::vector<std::string>::const_iterator d = roots.begin();
+                    d != roots.end(); ++d) {
+                watcher.addTree(*d, 0);
+            }
+            updateDirs(roots, nthreads, c);
+        } else if (r > 0) {
+            handleChanges(changed, watcher, analyzers);
+        }
+    }
+    for (int i=1; i<nthreads; i++) {
+        delete analyzers[i];
+    }
+    return (r < 0) ?-1 :0;
+}
+/**
+ * Bring the index up to date for the paths that were reported as changed.
+ **/
+void
+DirAnalyzer::Private::handleChanges(const std::set<std::string>& changed,
+        DirWatcher& watcher, std::vector<StreamAnalyzer*>& analyzers) {
+    IndexReader* reader = manager.indexReader();
+    std::vector<std::pair<std::string, struct stat> > existing;
+    std::vector<std::string> toDelete;
+    struct stat s;
+    // handle the removed paths first: a directory that was moved within the
+    // tree keeps its watch until its old path is removed
+    for (std::set<std::string>::const_iterator i = changed.begin();
+            i != changed.end(); ++i) {
+        if (lstat(i->c_str(), &s) == 0) {
+            existing.push_back(std::make_pair(*i, s));
+        } else {
+            watcher.removeTree(*i);
+            deleteTree(*i, toDelete);
+        }
+    }
+    entries.clear();
+    for (std::vector<std::pair<std::string, struct stat> >::const_iterator i
+            = existing.begin(); i != existing.end(); ++i) {
+        const std::string& path = i->first;
+        const char* name = path.c_str() + path.rfind('/') + 1;
+        const bool isdir = S_ISDIR(i->second.st_mode);
+        if ((isdir) ?!config.indexDir(path.c_str(), name)
+                :!config.indexFile(path.c_str(), name)) {
+            continue;
+        }
+        if (isdir && !watcher.isWatched(path)) {
+            // a new directory: all of its entries are new too
+            entries.push_back(*i);
+            watcher.addTree(path, &entries);
+        } else if (!isdir) {
+            // the file was reported, so it changed even if its mtime, which
+            // has a resolution of seconds, did not; as in update(), the old
+            // version is deleted first and a changed directory is left as
+            // it is
+            if (reader->mTime(path) != -1) {
+                toDelete.push_back(path);
+            }
+            entries.push_back(*i);
+        }
+    }
+    if (toDelete.size()) {
+        manager.indexWriter()->deleteEntries(toDelete);
+    }
+
+    // analyze the entries with all threads
+    links.clear();
+    nextEntry = 0;
+    const int nthreads = (int)analyzers.size();
+    std::vector<STRIGI_THREAD_TYPE> threads(nthreads-1);
+    for (int i=1; i<nthreads; i++) {
+        DA* da = new DA();
+        da->diranalyzer = this;
+        da->streamanalyzer = analyzers[i];
+        STRIGI_THREAD_CREATE(&threads[i-1], analyzeEntriesInThread, da);
+    }
+    analyzeEntries(analyzers[0]);
+    for (int i=1; i<nthreads; i++) {
+        STRIGI_THREAD_JOIN(threads[i-1]);
+    }
+    entries.clear();
+    commit();
+}
+/**
+ * Add @p path and all entries below it in the index to @p toDelete.
+ **/
+void
+DirAnalyzer::Private::deleteTree(const std::string& path,
+        std::vector<std::string>& toDelete) {
+    IndexReader* reader = manager.indexReader();
+    std::vector<std::string> todo(1, path);
+    std::map<std::string, time_t> children;
+    while (todo.size()) {
+        std::string parent;
+        parent.swap(todo.back());
+        todo.pop_back();
+        reader->getChildren(parent, children);
+        for (std::map<std::string, time_t>::const_iterator i
+                = children.begin(); i != children.end(); ++i) {
+            todo.push_back(i->first);
+        }
+        children.clear();
+        toDelete.push_back(parent);
+    }
+}
+void
+DirAnalyzer::Private::analyzeEntries(StreamAnalyzer* a) {
+    try {
+        for (;;) {
+            size_t i;
+            {
+                std::lock_guard<std::mutex> lock(entriesMutex);
+                if (nextEntry >= entries.size()) {
+                    break;
+                }
+                i = nextEntry++;
+            }
+            const std::string& path = entries[i].first;
+            analyzeFile(*a, path, entries[i].second,
+                path.substr(0, path.rfind('/')));
+        }
+    } catch(...) {
+        fprintf(stderr, "Unknown error\n");
+    }
+}
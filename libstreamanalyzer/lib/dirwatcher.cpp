@@ -0,0 +1,245 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "dirwatcher.h"
+#include <strigi/filelister.h>
+#include <map>
+#include <errno.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+using namespace Strigi;
+
+namespace {
+#ifdef HAVE_SYS_INOTIFY_H
+const uint32_t watchMask = IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE
+    | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF
+    | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+#endif
+/**
+ * The maximal number of changed paths that collect() gathers before it
+ * returns, even if changes are still coming in.
+ **/
+const size_t maxChanges = 65536;
+}
+
+class DirWatcher::Private {
+public:
+    int fd;
+    const AnalyzerConfiguration* const config;
+    // the watched directories by watch descriptor and by path
+    std::map<int, std::string> paths;
+    std::map<std::string, int> wds;
+
+    Private(const AnalyzerConfiguration* c) :config(c) {
+#ifdef HAVE_SYS_INOTIFY_H
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else
+        fd = -1;
+#endif
+    }
+    ~Private() {
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+    void watch(const std::string& dir);
+    void forget(int wd);
+    int readEvents(std::set<std::string>& changed, bool& overflow);
+};
+
+DirWatcher::DirWatcher(const AnalyzerConfiguration* config)
+        :p(new Private(config)) {
+}
+DirWatcher::~DirWatcher() {
+    delete p;
+}
+bool
+DirWatcher::isValid() const {
+    return p->fd != -1;
+}
+void
+DirWatcher::Private::watch(const std::string& dir) {
+#ifdef HAVE_SYS_INOTIFY_H
+    int wd = inotify_add_watch(fd, (dir.size()) ?dir.c_str() :"/", watchMask);
+    // a directory that is reachable via two paths gets the same descriptor;
+    // it is reported under the first path
+    if (wd != -1 && paths.find(wd) == paths.end()) {
+        paths[wd] = dir;
+        wds[dir] = wd;
+    }
+#else
+    (void)dir;
+#endif
+}
+void
+DirWatcher::Private::forget(int wd) {
+    std::map<int, std::string>::iterator i = paths.find(wd);
+    if (i != paths.end()) {
+        wds.erase(i->second);
+        paths.erase(i);
+    }
+}
+void
+DirWatcher::addTree(const std::string& dir,
+        std::vector<std::pair<std::string, struct stat> >* entries) {
+    if (p->fd == -1) {
+        return;
+    }
+    p->watch(dir);
+    // each subdirectory is watched before it is listed, so no new entries
+    // are missed
+    DirLister lister(p->config);
+    lister.startListing(dir);
+    std::string path;
+    std::vector<std::pair<std::string, struct stat> > dirs;
+    while (lister.nextDir(path, dirs) == 0) {
+        std::vector<std::pair<std::string, struct stat> >::const_iterator i;
+        for (i = dirs.begin(); i != dirs.end(); ++i) {
+            if (S_ISDIR(i->second.st_mode)) {
+                p->watch(i->first);
+            }
+        }
+        if (entries) {
+            entries->insert(entries->end(), dirs.begin(), dirs.end());
+        }
+    }
+}
+void
+DirWatcher::removeTree(const std::string& dir) {
+    std::map<std::string, int>::iterator i = p->wds.find(dir);
+    if (i != p->wds.end()) {
+#ifdef HAVE_SYS_INOTIFY_H
+        inotify_rm_watch(p->fd, i->second);
+#endif
+        p->forget(i->second);
+    }
+    const std::string prefix(dir + '/');
+    i = p->wds.lower_bound(prefix);
+    while (i != p->wds.end() && i->first.compare(0, prefix.length(), prefix)
+            == 0) {
+#ifdef HAVE_SYS_INOTIFY_H
+        inotify_rm_watch(p->fd, i->second);
+#endif
+        p->paths.erase(i->second);
+        p->wds.erase(i++);
+    }
+}
+void
+DirWatcher::clear() {
+#ifdef HAVE_SYS_INOTIFY_H
+    std::map<int, std::string>::const_iterator i;
+    for (i = p->paths.begin(); i != p->paths.end(); ++i) {
+        inotify_rm_watch(p->fd, i->first);
+    }
+#endif
+    p->paths.clear();
+    p->wds.clear();
+}
+bool
+DirWatcher::isWatched(const std::string& dir) const {
+    return p->wds.find(dir) != p->wds.end();
+}
+/**
+ * Read the pending events and add the paths they refer to to @p changed.
+ * @return the number of events or -1 if an error occurred
+ **/
+int
+DirWatcher::Private::readEvents(std::set<std::string>& changed,
+        bool& overflow) {
+#ifdef HAVE_SYS_INOTIFY_H
+    char buffer[65536]
+        __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    int n = 0;
+    for (;;) {
+        ssize_t size = read(fd, buffer, sizeof(buffer));
+        if (size == -1) {
+            return (errno == EAGAIN || errno == EINTR) ?n :-1;
+        }
+        const char* pos = buffer;
+        const char* end = buffer + size;
+        while (pos < end) {
+            const struct inotify_event* event
+                = (const struct inotify_event*)pos;
+            pos += sizeof(struct inotify_event) + event->len;
+            ++n;
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            std::map<int, std::string>::const_iterator i
+                = paths.find(event->wd);
+            if (i == paths.end()) {
+                continue;
+            }
+            if (event->len) {
+                changed.insert(i->second + '/' + event->name);
+            } else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                changed.insert(i->second);
+            }
+            if (event->mask & IN_IGNORED) {
+                forget(event->wd);
+            }
+        }
+    }
+#else
+    (void)changed;
+    (void)overflow;
+    return -1;
+#endif
+}
+int
+DirWatcher::collect(int timeout, int settle, std::set<std::string>& changed,
+        bool& overflow) {
+#ifdef HAVE_SYS_INOTIFY_H
+    if (p->fd == -1) {
+        return -1;
+    }
+    struct pollfd pfd;
+    pfd.fd = p->fd;
+    pfd.events = POLLIN;
+    int r = poll(&pfd, 1, timeout);
+    if (r <= 0) {
+        return (r == 0 || errno == EINTR) ?0 :-1;
+    }
+    // gather events until the file system has been quiet for a while, so
+    // a file that is written in several steps is analyzed once
+    do {
+        if (p->readEvents(changed, overflow) < 0) {
+            return -1;
+        }
+    } while (!overflow && changed.size() < maxChanges
+        && poll(&pfd, 1, settle) > 0);
+    return (changed.size() || overflow) ?1 :0;
+#else
+    (void)timeout;
+    (void)settle;
+    (void)changed;
+    (void)overflow;
+    return -1;
+#endif
+}
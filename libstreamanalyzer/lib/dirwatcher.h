@@ -0,0 +1,87 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_DIRWATCHER_H
+#define STRIGI_DIRWATCHER_H
+
+#include <set>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+namespace Strigi {
+
+class AnalyzerConfiguration;
+
+/**
+ * Watches directory trees for changes with inotify.
+ *
+ * The events are coalesced into a set of paths that have changed. A path
+ * in the set may have been created, modified or removed; the caller checks
+ * which of these by calling stat().
+ **/
+class DirWatcher {
+private:
+    class Private;
+    Private* const p;
+public:
+    explicit DirWatcher(const AnalyzerConfiguration* config);
+    ~DirWatcher();
+    /**
+     * @return true if changes can be watched on this system
+     **/
+    bool isValid() const;
+    /**
+     * Watch @p dir and all its subdirectories that pass the filters of the
+     * configuration. If @p entries is not 0, the entries that were found
+     * in the subdirectories are appended to it.
+     **/
+    void addTree(const std::string& dir,
+        std::vector<std::pair<std::string, struct stat> >* entries);
+    /**
+     * Stop watching @p dir and its subdirectories.
+     **/
+    void removeTree(const std::string& dir);
+    /**
+     * Stop watching all directories.
+     **/
+    void clear();
+    /**
+     * @return true if @p dir is being watched
+     **/
+    bool isWatched(const std::string& dir) const;
+    /**
+     * Wait at most @p timeout milliseconds for changes. When a change
+     * arrives, changes are collected until there has been no change for
+     * @p settle milliseconds.
+     *
+     * @param changed the set to which the changed paths are added
+     * @param overflow set to true if events were lost; the watched trees
+     *        have to be compared with the index to find the changes
+     * @return 1 if changes were collected, 0 if there were none and -1 if
+     *         an error occurred
+     **/
+    int collect(int timeout, int settle, std::set<std::string>& changed,
+        bool& overflow);
+};
+
+}
+
+#endif
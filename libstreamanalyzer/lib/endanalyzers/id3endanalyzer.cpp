@@ -654,11 +654,19 @@ ID3EndAnalyzer::analyze(Strigi::AnalysisResult& indexable, Strigi::InputStream*
     int64_t insize;
     if ( (insize = in->size()) > (128+nread)) {
 
-        // read the tag and check signature
-        int64_t nskip = insize-128-nread;
-        if (nskip == in->skip(nskip))
-        if (in->read(buf, 128, 128)==128)
-        if (!strncmp("TAG", buf, 3)) {
+        // read the tag and check signature; streams that cannot read at a
+        // position are skipped to the tag
+        char tag[128];
+        bool have_tag = in->readAt(insize-128, tag, 128) == 128;
+        if (!have_tag) {
+            int64_t nskip = insize-128-nread;
+            if (nskip == in->skip(nskip) && in->read(buf, 128, 128)==128) {
+                memcpy(tag, buf, 128);
+                have_tag = true;
+            }
+        }
+        buf = tag;
+        if (have_tag && !strncmp("TAG", buf, 3)) {
 
             found_tag = true;
             
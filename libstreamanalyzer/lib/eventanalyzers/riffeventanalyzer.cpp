@@ -339,3 +339,8 @@ RiffEventAnalyzerFactory::registerFields(Strigi::FieldRegister& reg) {
     addField(videoCodecField);
     addField(audioCodecField);
 }
+bool
+RiffEventAnalyzerFactory::checkHeader(const char* header, int32_t headersize,
+        const Strigi::AnalysisResult& /*result*/) const {
+    return headersize >= 4 && strncmp(header, "RIFF", 4) == 0;
+}
@@ -93,6 +93,8 @@ private:
     const Strigi::RegisteredField* sampleRateField;
     const Strigi::RegisteredField* channelsField;
     void registerFields(Strigi::FieldRegister&);
+    bool checkHeader(const char* header, int32_t headersize,
+        const Strigi::AnalysisResult& result) const;
     Strigi::StreamEventAnalyzer* newInstance() const {
         return new RiffEventAnalyzer(this);
     }
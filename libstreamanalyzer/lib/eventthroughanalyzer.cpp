@@ -28,9 +28,6 @@
 using namespace Strigi;
 
 EventThroughAnalyzer::~EventThroughAnalyzer() {
-    if (datastream) {
-        delete datastream;
-    }
     std::vector<StreamEventAnalyzer*>::iterator e;
     for (e = event.begin(); e != event.end(); ++e) {
         delete *e;
@@ -42,31 +39,51 @@ EventThroughAnalyzer::setIndexable(AnalysisResult* r) {
 }
 InputStream*
 EventThroughAnalyzer::connectInputStream(InputStream* in) {
+    ready = true;
+    checked = false;
     if (!in) return in;
-    if (datastream) {
-        delete datastream;
-        datastream = 0;
-    }
     if (event.size()) {
-        datastream = new DataEventInputStream(in, *this);
+        // the data is passed to handleData() by the StreamAnalyzer
         ready = false;
         std::vector<StreamEventAnalyzer*>::iterator i;
         for (i = event.begin(); i != event.end(); ++i) {
             (*i)->startAnalysis(result);
         }
     }
-    return (datastream) ?datastream :in;
+    return in;
 }
 bool
 EventThroughAnalyzer::isReadyWithStream() {
     return ready;
 }
+DataEventHandler*
+EventThroughAnalyzer::dataEventHandler() {
+    return (ready) ?0 :this;
+}
+void
+EventThroughAnalyzer::selectAnalyzers(const char* header, uint32_t headersize) {
+    // analyzers that reject the header are still ended in handleEnd(), but
+    // they get no data
+    active.clear();
+    for (uint i = 0; i < event.size(); ++i) {
+        if (i >= factories.size()
+                || factories[i]->checkHeader(header, (int32_t)headersize,
+                    *result)) {
+            active.push_back(event[i]);
+        }
+    }
+}
 bool
 EventThroughAnalyzer::handleData(const char* data, uint32_t size) {
     if (ready) return false;
+    if (!checked) {
+        // the first block of data is the header of the stream
+        selectAnalyzers(data, size);
+        checked = true;
+    }
     std::vector<StreamEventAnalyzer*>::iterator i;
     bool more = false;
-    for (i = event.begin(); i != event.end(); ++i) {
+    for (i = active.begin(); i != active.end(); ++i) {
         (*i)->handleData(data, size);
         more = more || !(*i)->isReadyWithStream();
         //if (!(*i)->isReadyWithStream()) {
@@ -78,9 +95,10 @@ EventThroughAnalyzer::handleData(const char* data, uint32_t size) {
 }
 void
 EventThroughAnalyzer::handleEnd() {
+    // handleEnd() is only called when the end of the stream has been reached
     std::vector<StreamEventAnalyzer*>::iterator i;
     for (i = event.begin(); i != event.end(); ++i) {
-        (*i)->endAnalysis(datastream->status() == Eof);
+        (*i)->endAnalysis(true);
     }
 }
 StreamThroughAnalyzer*
@@ -95,14 +113,15 @@ EventThroughAnalyzerFactory::newInstance() const {
     for (sa = saxfactories.begin(); sa != saxfactories.end(); ++sa) {
         sax.push_back((*sa)->newInstance());
     }
-    event.push_back(new SaxEventAnalyzer(sax));
+    event.push_back(new SaxEventAnalyzer(sax, saxfactories));
     std::vector<StreamLineAnalyzer*> line;
     std::vector<StreamLineAnalyzerFactory*>::iterator la;
     for (la = linefactories.begin(); la != linefactories.end(); ++la) {
         line.push_back((*la)->newInstance());
     }
-    event.push_back(new LineEventAnalyzer(line));
-    StreamThroughAnalyzer* sta = new EventThroughAnalyzer(event);
+    event.push_back(new LineEventAnalyzer(line, linefactories));
+    StreamThroughAnalyzer* sta = new EventThroughAnalyzer(event,
+        eventfactories);
     return sta;
 }
 void
@@ -39,19 +39,26 @@ class EventThroughAnalyzer : public StreamThroughAnalyzer,
         public DataEventHandler {
 private:
     std::vector<StreamEventAnalyzer*> event;
-    DataEventInputStream* datastream;
+    // the factories of the first analyzers in 'event'
+    const std::vector<StreamEventAnalyzerFactory*> factories;
+    // the analyzers that accepted the header of the current stream
+    std::vector<StreamEventAnalyzer*> active;
     AnalysisResult* result;
     bool ready;
+    bool checked;
 
     void setIndexable(AnalysisResult*);
     InputStream* connectInputStream(InputStream* in);
     bool isReadyWithStream();
+    DataEventHandler* dataEventHandler();
     bool handleData(const char* data, uint32_t size);
     void handleEnd();
+    void selectAnalyzers(const char* header, uint32_t headersize);
     const char* name() const { return "EventThroughAnalyzer"; }
 public:
-    EventThroughAnalyzer(std::vector<StreamEventAnalyzer*>& e)
-            : event(e), datastream(0), result(0), ready(true){}
+    EventThroughAnalyzer(std::vector<StreamEventAnalyzer*>& e,
+                const std::vector<StreamEventAnalyzerFactory*>& f)
+            : event(e), factories(f), result(0), ready(true), checked(false){}
     ~EventThroughAnalyzer();
 };
 class EventThroughAnalyzerFactory : public StreamThroughAnalyzerFactory {
@@ -19,142 +19,289 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
 #include <strigi/filelister.h>
 #include <strigi/strigiconfig.h>
 #include <strigi/analyzerconfiguration.h>
 #include <mutex>
-#include <set>
+#include <condition_variable>
 #include <list>
+#include <set>
+#include <vector>
 #include <iostream>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <errno.h>
+#ifdef HAVE_GETDENTS64
+#include <sys/syscall.h>
+#endif
+#ifdef HAVE_LINUX_FIEMAP_H
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+#endif
+#include <algorithm>
 
 using namespace Strigi;
 
+namespace {
+/**
+ * The device and inode number that identify a directory. Directories that are
+ * reached a second time, via a bind mount or a loop, are not listed again.
+ **/
+typedef std::pair<dev_t, ino_t> DirId;
+
+#ifdef HAVE_GETDENTS64
+/**
+ * The record layout returned by the getdents64 system call.
+ **/
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+#endif
+/**
+ * Reads the entries of a directory that was opened relative to its parent.
+ * With getdents64, the entries are read in large blocks; otherwise readdir()
+ * is used.
+ **/
+class DirectoryReader {
+private:
+#ifdef HAVE_GETDENTS64
+    std::vector<char> buffer;
+    int bufpos;
+    int bufend;
+#else
+    DIR* dir;
+#endif
+public:
+    int fd;
+
+    DirectoryReader() :fd(-1) {
+#ifdef HAVE_GETDENTS64
+        bufpos = bufend = 0;
+#else
+        dir = 0;
+#endif
+    }
+    bool open(int parentfd, const char* name) {
+        fd = openat(parentfd, name,
+            O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd == -1) {
+            return false;
+        }
+#ifdef HAVE_GETDENTS64
+        if (buffer.size() == 0) {
+            buffer.resize(32768);
+        }
+        bufpos = bufend = 0;
+#else
+        dir = fdopendir(fd);
+        if (dir == 0) {
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+#endif
+        return true;
+    }
+    void close() {
+#ifdef HAVE_GETDENTS64
+        if (fd != -1) {
+            ::close(fd);
+        }
+#else
+        if (dir) {
+            // closes fd too
+            closedir(dir);
+            dir = 0;
+        }
+#endif
+        fd = -1;
+    }
+    /**
+     * Return the name of the next entry or 0 if there are no more entries.
+     * type is set to the DT_ value of the entry or to 0 if it is not known.
+     **/
+    const char* next(unsigned char& type) {
+#ifdef HAVE_GETDENTS64
+        if (bufpos >= bufend) {
+            long n = syscall(SYS_getdents64, fd, &buffer[0], buffer.size());
+            if (n <= 0) {
+                return 0;
+            }
+            bufpos = 0;
+            bufend = (int)n;
+        }
+        const linux_dirent64* entry
+            = (const linux_dirent64*)(&buffer[0] + bufpos);
+        bufpos += entry->d_reclen;
+        type = entry->d_type;
+        return entry->d_name;
+#else
+        struct dirent* entry = readdir(dir);
+        if (entry == 0) {
+            return 0;
+        }
+#ifdef HAVE_DIRENT_D_TYPE
+        type = entry->d_type;
+#else
+        type = 0;
+#endif
+        return entry->d_name;
+#endif
+    }
+};
+}
+
 class FileLister::Private {
 public:
-    char path[10000];
+    /**
+     * A directory that is being listed and the length of its path,
+     * including the trailing '/'.
+     **/
+    struct Level {
+        DirectoryReader reader;
+        std::string::size_type length;
+    };
+    std::string path;
     std::mutex mutex;
-    DIR** dirs;
-    DIR** dirsEnd;
-    DIR** curDir;
-    std::string::size_type* len;
-    std::string::size_type* lenEnd;
-    std::string::size_type* curLen;
+    // the stack of open directories; only the first 'depth' are in use, the
+    // others are kept so their buffers can be reused
+    std::vector<Level> levels;
+    size_t depth;
+    // the directories that have been opened since startListing()
+    std::set<DirId> visited;
     time_t mtime;
-    struct dirent* subdir;
     struct stat dirstat;
-    std::set<std::string> listedDirs;
     const AnalyzerConfiguration* const config;
 
-    Private(const AnalyzerConfiguration* ic);
+    Private(const AnalyzerConfiguration* ic) :depth(0), config(ic) {}
     ~Private();
     int nextFile(std::string& p, time_t& time) {
         int r;
         std::lock_guard<std::mutex> lock(mutex);
         r = nextFile();
         if (r > 0) {
-            p.assign(path, r);
+            p.assign(path, 0, r);
             time = mtime;
         }
         return r;
     }
     void startListing(const std::string&);
+    bool openDir(int parentfd, const char* name);
+    void closeDirs();
     int nextFile();
 };
-FileLister::Private::Private(
-            const AnalyzerConfiguration* ic) :
-        config(ic) {
-    int nOpenDirs = 100;
-    dirs = (DIR**)malloc(sizeof(DIR*)*nOpenDirs);
-    dirsEnd = dirs + nOpenDirs;
-    len = (std::string::size_type*)malloc(sizeof(std::string::size_type)*nOpenDirs);
-    lenEnd = len + nOpenDirs;
-    curDir = dirs - 1;
+FileLister::Private::~Private() {
+    closeDirs();
 }
 void
-FileLister::Private::startListing(const std::string& dir){
-    listedDirs.clear();
-    curDir = dirs;
-    curLen = len;
-    std::string::size_type len = dir.length();
-    *curLen = len;
-    strcpy(path, dir.c_str());
-    if (len) {
-        if (path[len-1] != '/') {
-            path[len++] = '/';
-            path[len] = 0;
-            *curLen = len;
-        }
-        DIR* d = opendir(path);
-        if (d) {
-            *curDir = d;
-            listedDirs.insert (path);
-        } else {
-            curDir--;
-        }
-    } else {
-        curDir--;
+FileLister::Private::closeDirs() {
+    while (depth > 0) {
+        levels[--depth].reader.close();
     }
 }
-FileLister::Private::~Private() {
-    while (curDir >= dirs) {
-        if (*curDir) {
-            closedir(*curDir);
+bool
+FileLister::Private::openDir(int parentfd, const char* name) {
+    if (depth == levels.size()) {
+        levels.push_back(Level());
+    }
+    Level& level = levels[depth];
+    if (!level.reader.open(parentfd, name)) {
+        return false;
+    }
+    struct stat s;
+    if (fstat(level.reader.fd, &s) == 0
+            && !visited.insert(DirId(s.st_dev, s.st_ino)).second) {
+        level.reader.close();
+        return false;
+    }
+    level.length = path.length();
+    depth++;
+    return true;
+}
+void
+FileLister::Private::startListing(const std::string& dir){
+    closeDirs();
+    visited.clear();
+    path.assign(dir);
+    if (path.length()) {
+        if (path[path.length()-1] != '/') {
+            path.append("/");
         }
-        curDir--;
+        openDir(AT_FDCWD, path.c_str());
     }
-    free(dirs);
-    free(len);
 }
 int
 FileLister::Private::nextFile() {
-
-    while (curDir >= dirs) {
-        DIR* dir = *curDir;
-        std::string::size_type l = *curLen;
-        subdir = readdir(dir);
-        while (subdir) {
-            // skip the directories '.' and '..'
-            char c1 = subdir->d_name[0];
-            if (c1 == '.') {
-                char c2 = subdir->d_name[1];
-                if (c2 == '.' || c2 == '\0') {
-                    subdir = readdir(dir);
-                    continue;
-                }
+    while (depth > 0) {
+        if (depth == levels.size()) {
+            // make room for a subdirectory now, so 'level' stays valid
+            levels.push_back(Level());
+        }
+        Level& level = levels[depth-1];
+        const int fd = level.reader.fd;
+        const std::string::size_type l = level.length;
+        unsigned char dtype;
+        const char* name = level.reader.next(dtype);
+        if (name == 0) {
+            level.reader.close();
+            depth--;
+            continue;
+        }
+        // skip the directories '.' and '..'
+        if (name[0] == '.' && (name[1] == '\0'
+                || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        path.resize(l);
+        path.append(name);
+        mode_t type = 0;
+        bool statted = false;
+#ifdef HAVE_DIRENT_D_TYPE
+        // with the type from readdir(), only the files that pass the
+        // filter need a call to stat() for their mtime
+        if (dtype == DT_DIR) {
+            type = S_IFDIR;
+        } else if (dtype == DT_REG) {
+            type = S_IFREG;
+        } else if (dtype != DT_UNKNOWN) {
+            continue;
+        }
+#endif
+        if (type == 0) {
+            statted = fstatat(fd, name, &dirstat, AT_SYMLINK_NOFOLLOW) == 0;
+            if (statted) {
+                type = dirstat.st_mode & S_IFMT;
             }
-            strcpy(path + l, subdir->d_name);
-            std::string::size_type sl = l + strlen(subdir->d_name);
-            if (lstat(path, &dirstat) == 0) {
-                if (S_ISREG(dirstat.st_mode)) {
-                    if (config == 0 || config->indexFile(path, path+l)) {
-                        mtime = dirstat.st_mtime;
-                        return (int)sl;
-                    }
-                } else if (dirstat.st_mode & S_IFDIR && (config == 0
-                        || config->indexDir(path, path+l))) {
-                    mtime = dirstat.st_mtime;
-                    strcpy(this->path+sl, "/");
-                    DIR* d = opendir(path);
-                    if (d) {
-                        curDir++;
-                        curLen++;
-                        dir = *curDir = d;
-                        l = *curLen = sl+1;
-                        listedDirs.insert ( path);
-                    }
-                }
+        }
+        const char* filename = path.c_str() + l;
+        if (type == S_IFREG) {
+            if ((config == 0 || config->indexFile(path.c_str(), filename))
+                    && (statted || (fstatat(fd, name, &dirstat,
+                        AT_SYMLINK_NOFOLLOW) == 0
+                        && S_ISREG(dirstat.st_mode)))) {
+                mtime = dirstat.st_mtime;
+                return (int)path.length();
             }
-            subdir = readdir(dir);
+        } else if (type == S_IFDIR && (config == 0
+                || config->indexDir(path.c_str(), filename))) {
+            path.append("/");
+            openDir(fd, name);
         }
-        closedir(dir);
-        curDir--;
-        curLen--;
     }
     return -1;
 }
@@ -177,7 +324,7 @@ FileLister::nextFile(const char*& path, time_t& time) {
     int r = p->nextFile();
     if (r >= 0) {
         time = p->mtime;
-        path = p->path;
+        path = p->path.c_str();
     }
     return r;
 }
@@ -189,15 +336,96 @@ FileLister::skipTillAfter(const std::string& lastToSkip) {
     }
 }
 
+namespace {
+/**
+ * The maximal number of entries that DirLister::nextDirBatch() returns at
+ * once.
+ **/
+const size_t maxBatchSize = 4096;
+
+#ifdef HAVE_LINUX_FIEMAP_H
+/**
+ * Return the physical position of the first extent of a file or 0 if it
+ * cannot be determined.
+ **/
+uint64_t
+firstExtentOffset(int dirfd, const char* name) {
+    int fd = openat(dirfd, name, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1) {
+        return 0;
+    }
+    // room for the request and a single extent
+    uint64_t buffer[(sizeof(struct fiemap) + sizeof(struct fiemap_extent))
+        / sizeof(uint64_t) + 1];
+    memset(buffer, 0, sizeof(buffer));
+    struct fiemap* map = (struct fiemap*)buffer;
+    map->fm_length = FIEMAP_MAX_OFFSET;
+    map->fm_extent_count = 1;
+    uint64_t offset = 0;
+    if (ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0) {
+        offset = map->fm_extents[0].fe_physical;
+    }
+    close(fd);
+    return offset;
+}
+#endif
+}
+
 class DirLister::Private {
 public:
+    /**
+     * A directory of which not all entries have been returned yet.
+     * position is the number of entries that have been read from it and
+     * last is the name of the last of those. A directory that was restored
+     * from a saved state has dir == 0 and position > 0.
+     **/
+    struct OpenDir {
+        std::string path;
+        DIR* dir;
+        long position;
+        std::string last;
+        OpenDir() :dir(0), position(0) {}
+    };
     std::mutex mutex;
+    // signalled when work is added to openDirs or todoPaths or when the last
+    // directory that was being listed is done
+    std::condition_variable queueChanged;
+    std::list<OpenDir> openDirs;
     std::list<std::string> todoPaths;
+    // the directories that have been queued since the listing started
+    std::set<DirId> visited;
+    // the number of directories that are being listed outside of the lock
+    int listing;
+    // the number of calls to stopListing(); a directory that was taken from
+    // the queue before a stop is not put back after it
+    int stops;
     const AnalyzerConfiguration* const config;
 
-    Private(const AnalyzerConfiguration* ic) :config(ic) {}
+    Private(const AnalyzerConfiguration* ic) :listing(0), stops(0),
+        config(ic) {}
+    ~Private() {
+        closeOpenDirs();
+    }
+    void closeOpenDirs();
     int nextDir(std::string& path,
-        std::vector<std::pair<std::string, struct stat> >& dirs);
+        std::vector<std::pair<std::string, struct stat> >& dirs,
+        size_t maxEntries);
+    bool openDir(OpenDir& cur) const;
+    bool listDir(OpenDir& cur,
+        std::vector<std::pair<std::string, struct stat> >& dirs,
+        std::list<std::string>& subdirs, std::vector<DirId>& subdirIds,
+        size_t maxEntries) const;
+    void addSubdirs(std::list<std::string>& subdirs,
+        const std::vector<DirId>& subdirIds);
+    void sortEntries(DIR* dir,
+        std::vector<std::pair<std::string, struct stat> >& dirs,
+        AnalyzerConfiguration::FileOrder order) const;
+    bool wanted(const std::string& path, const std::string& name,
+            bool isdir) const {
+        return config == 0 || ((isdir)
+            ?config->indexDir(path.c_str(), name.c_str())
+            :config->indexFile(path.c_str(), name.c_str()));
+    }
 };
 
 DirLister::DirLister(const AnalyzerConfiguration* ic)
@@ -208,74 +436,338 @@ DirLister::~DirLister() {
 }
 void
 DirLister::startListing(const std::string& dir) {
+    struct stat s;
+    bool statted = stat((dir.size()) ?dir.c_str() :"/", &s) == 0;
     std::lock_guard<std::mutex> lock(p->mutex);
+    if (p->todoPaths.empty() && p->openDirs.empty() && p->listing == 0) {
+        p->visited.clear();
+    }
+    if (statted && !p->visited.insert(DirId(s.st_dev, s.st_ino)).second) {
+        // this directory is listed already
+        return;
+    }
     p->todoPaths.push_back(dir);
 }
 void
 DirLister::stopListing() {
-    std::lock_guard<std::mutex> lock(p->mutex);
-    p->todoPaths.clear();
+    {
+        std::lock_guard<std::mutex> lock(p->mutex);
+        p->todoPaths.clear();
+        p->closeOpenDirs();
+        p->visited.clear();
+        ++p->stops;
+    }
+    p->queueChanged.notify_all();
+}
+void
+DirLister::Private::closeOpenDirs() {
+    std::list<OpenDir>::iterator i;
+    for (i = openDirs.begin(); i != openDirs.end(); ++i) {
+        if (i->dir) {
+            closedir(i->dir);
+        }
+    }
+    openDirs.clear();
 }
 int
 DirLister::Private::nextDir(std::string& path,
-        std::vector<std::pair<std::string, struct stat> >& dirs) {
+        std::vector<std::pair<std::string, struct stat> >& dirs,
+        size_t maxEntries) {
+    // take the next directory from the queue; only this is done under the
+    // lock, the directory itself is listed without it
+    // partially listed directories go first, so their memory is freed soon
+    OpenDir cur;
+    int stopsBefore;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        // while other threads are listing, they may still add directories
+        while (openDirs.empty() && todoPaths.empty() && listing > 0) {
+            queueChanged.wait(lock);
+        }
+        if (openDirs.size()) {
+            OpenDir& front = openDirs.front();
+            cur.path.swap(front.path);
+            cur.dir = front.dir;
+            cur.position = front.position;
+            cur.last.swap(front.last);
+            openDirs.pop_front();
+        } else if (todoPaths.size()) {
+            cur.path.swap(todoPaths.front());
+            todoPaths.pop_front();
+        } else {
+            return -1;
+        }
+        ++listing;
+        stopsBefore = stops;
+    }
+    int r = 0;
+    // if permission is denied, this is not an error
+    if (cur.dir == 0 && !openDir(cur) && errno != EACCES) {
+        r = -1;
+    }
+    path.assign(cur.path);
+    dirs.clear();
+    std::list<std::string> subdirs;
+    std::vector<DirId> subdirIds;
+    bool done = true;
+    if (cur.dir) {
+        done = listDir(cur, dirs, subdirs, subdirIds, maxEntries);
+        if (config
+                && config->fileOrder() != AnalyzerConfiguration::ReaddirOrder) {
+            sortEntries(cur.dir, dirs, config->fileOrder());
+        }
+        if (done) {
+            closedir(cur.dir);
+        }
+    }
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        --listing;
+        if (stops != stopsBefore) {
+            // the listing was stopped while this directory was read
+            if (!done) {
+                closedir(cur.dir);
+                done = true;
+            }
+            subdirs.clear();
+        } else if (!done) {
+            openDirs.push_back(cur);
+        }
+        addSubdirs(subdirs, subdirIds);
+        wake = !done || subdirs.size() > 0 || listing == 0;
+        todoPaths.splice(todoPaths.end(), subdirs);
+    }
+    if (wake) {
+        queueChanged.notify_all();
+    }
+    return r;
+}
+/**
+ * Remove the subdirectories that have been queued before from @p subdirs.
+ * Must be called with the lock held.
+ **/
+void
+DirLister::Private::addSubdirs(std::list<std::string>& subdirs,
+        const std::vector<DirId>& subdirIds) {
+    std::list<std::string>::iterator i = subdirs.begin();
+    std::vector<DirId>::const_iterator id = subdirIds.begin();
+    while (i != subdirs.end()) {
+        if (visited.insert(*id).second) {
+            ++i;
+        } else {
+            i = subdirs.erase(i);
+        }
+        ++id;
+    }
+}
+/**
+ * Open the directory of @p cur. For a directory that was restored from a
+ * saved state, the entries that were read before are skipped. If the
+ * directory has changed so that the last of these entries is not at the
+ * same position anymore, it is read again from the start.
+ **/
+bool
+DirLister::Private::openDir(OpenDir& cur) const {
+    // special case for root directory '/' on unix systems
+    cur.dir = opendir((cur.path.size()) ?cur.path.c_str() :"/");
+    if (cur.dir == 0 || cur.position == 0) {
+        return cur.dir != 0;
+    }
+    struct dirent* entry = 0;
+    long n = 0;
+    while (n < cur.position && (entry = readdir(cur.dir)) != 0) {
+        ++n;
+    }
+    if (n != cur.position || cur.last != entry->d_name) {
+        rewinddir(cur.dir);
+        cur.position = 0;
+    }
+    return true;
+}
+/**
+ * Read up to maxEntries wanted entries from the directory of @p cur.
+ * @return true if all entries of the directory have been read
+ **/
+bool
+DirLister::Private::listDir(OpenDir& cur,
+        std::vector<std::pair<std::string, struct stat> >& dirs,
+        std::list<std::string>& subdirs, std::vector<DirId>& subdirIds,
+        size_t maxEntries) const {
+    DIR* const dir = cur.dir;
+    const std::string& path = cur.path;
     std::string entryname;
     std::string entrypath;
     size_t entrypathlength;
-    // check if there are more directories to work on
-    // open the directory
-    std::lock_guard<std::mutex> lock(mutex);
-    if (todoPaths.empty()) {
-        return -1;
-    }
-    path.assign(todoPaths.front());
-    todoPaths.pop_front();
     entrypathlength = path.length()+1;
     entrypath.assign(path);
     entrypath.append("/");
-    dirs.clear();
-    DIR* dir;
-    if (path.size()) {
-        dir = opendir(path.c_str());
-    } else {
-        // special case for root directory '/' on unix systems
-        dir = opendir("/");
-    }
-    if (!dir) {
-        int e = errno;
-        // if permission is denied, this is not an error
-        return (e == EACCES) ?0 :-1;
-    }
-    struct dirent* entry = readdir(dir);
+    const int fd = dirfd(dir);
+    struct dirent* entry;
     struct stat entrystat;
-    while (entry) {
+    while (dirs.size() < maxEntries) {
+        entry = readdir(dir);
+        if (entry == 0) {
+            return true;
+        }
+        ++cur.position;
         entryname.assign(entry->d_name);
-        if (entryname != "." && entryname != "..") {
-            entrypath.resize(entrypathlength);
-            entrypath.append(entryname);
-            if (lstat(entrypath.c_str(), &entrystat) == 0) {
-                if (S_ISDIR(entrystat.st_mode)) {
-                    if (config == 0 ||
-                            config->indexDir(
-                                entrypath.c_str(), entryname.c_str())) {
-                        todoPaths.push_back(entrypath);
-                        dirs.push_back(std::make_pair(entrypath, entrystat));
-                    }
-                } else if (config == 0 || config->indexFile(entrypath.c_str(),
-                        entryname.c_str())) {
-                    dirs.push_back(std::make_pair(entrypath, entrystat));
-                }
+        if (entryname == "." || entryname == "..") {
+            continue;
+        }
+        entrypath.resize(entrypathlength);
+        entrypath.append(entryname);
+        bool isdir = false;
+        bool checked = false;
+#ifdef HAVE_DIRENT_D_TYPE
+        // with the type from readdir(), entries that are filtered out do not
+        // need a call to stat()
+        if (entry->d_type != DT_UNKNOWN) {
+            isdir = entry->d_type == DT_DIR;
+            if (!wanted(entrypath, entryname, isdir)) {
+                continue;
             }
+            checked = true;
         }
-        entry = readdir(dir);
+#endif
+        // stat relative to the open directory instead of resolving the
+        // full path again
+        if (fstatat(fd, entry->d_name, &entrystat, AT_SYMLINK_NOFOLLOW)) {
+            continue;
+        }
+        if (checked && isdir != S_ISDIR(entrystat.st_mode)) {
+            // the entry was replaced after it was read
+            checked = false;
+        }
+        if (!checked) {
+            isdir = S_ISDIR(entrystat.st_mode);
+            if (!wanted(entrypath, entryname, isdir)) {
+                continue;
+            }
+        }
+        if (isdir) {
+            subdirs.push_back(entrypath);
+            subdirIds.push_back(DirId(entrystat.st_dev, entrystat.st_ino));
+        }
+        dirs.push_back(std::make_pair(entrypath, entrystat));
     }
-    closedir(dir);
-    return 0;
+    cur.last.assign(entryname);
+    return false;
+}
+void
+DirLister::Private::sortEntries(DIR* dir,
+        std::vector<std::pair<std::string, struct stat> >& dirs,
+        AnalyzerConfiguration::FileOrder order) const {
+    // sort on (position on disk, inode) and keep the original index
+    std::vector<std::pair<std::pair<uint64_t, uint64_t>, size_t> > keys;
+    keys.reserve(dirs.size());
+    for (size_t i = 0; i < dirs.size(); ++i) {
+        const struct stat& s = dirs[i].second;
+        uint64_t offset = 0;
+#ifdef HAVE_LINUX_FIEMAP_H
+        if (order == AnalyzerConfiguration::ExtentOrder && S_ISREG(s.st_mode)) {
+            const std::string& path = dirs[i].first;
+            offset = firstExtentOffset(dirfd(dir),
+                path.c_str() + path.rfind('/') + 1);
+        }
+#else
+        (void)dir;
+        (void)order;
+#endif
+        keys.push_back(std::make_pair(std::make_pair(offset,
+            (uint64_t)s.st_ino), i));
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<std::pair<std::string, struct stat> > sorted(dirs.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::pair<std::string, struct stat>& e = dirs[keys[i].second];
+        sorted[i].first.swap(e.first);
+        sorted[i].second = e.second;
+    }
+    dirs.swap(sorted);
 }
 int
 DirLister::nextDir(std::string& path,
         std::vector<std::pair<std::string, struct stat> >& dirs) {
-    return p->nextDir(path, dirs);
+    return p->nextDir(path, dirs, (size_t)-1);
+}
+int
+DirLister::nextDirBatch(std::string& path,
+        std::vector<std::pair<std::string, struct stat> >& dirs) {
+    return p->nextDir(path, dirs, maxBatchSize);
+}
+int
+DirLister::saveState(const std::string& file) {
+    // write to a temporary file first, so a crash while writing does not
+    // destroy the previous state
+    const std::string tmp(file + ".new");
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (f == 0) {
+        return -1;
+    }
+    // the fields are separated by '\0' because paths may contain any
+    // other character
+    int n = 0;
+    {
+        std::lock_guard<std::mutex> lock(p->mutex);
+        std::list<Private::OpenDir>::const_iterator i;
+        for (i = p->openDirs.begin(); i != p->openDirs.end(); ++i, ++n) {
+            fprintf(f, "O%c%ld%c", 0, i->position, 0);
+            fwrite(i->last.c_str(), 1, i->last.length() + 1, f);
+            fwrite(i->path.c_str(), 1, i->path.length() + 1, f);
+        }
+        std::list<std::string>::const_iterator j;
+        for (j = p->todoPaths.begin(); j != p->todoPaths.end(); ++j, ++n) {
+            fprintf(f, "T%c", 0);
+            fwrite(j->c_str(), 1, j->length() + 1, f);
+        }
+    }
+    bool ok = fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), file.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return -1;
+    }
+    return n;
+}
+int
+DirLister::restoreState(const std::string& file) {
+    FILE* f = fopen(file.c_str(), "rb");
+    if (f == 0) {
+        return -1;
+    }
+    std::list<Private::OpenDir> opendirs;
+    std::list<std::string> todo;
+    std::vector<std::string> fields;
+    char* line = 0;
+    size_t linesize = 0;
+    ssize_t l;
+    while ((l = getdelim(&line, &linesize, '\0', f)) > 0) {
+        // getdelim includes the '\0' in the count
+        fields.push_back(std::string(line, l - 1));
+    }
+    free(line);
+    fclose(f);
+    size_t i = 0;
+    while (i < fields.size()) {
+        if (fields[i] == "O" && i + 3 < fields.size()) {
+            Private::OpenDir d;
+            d.position = atol(fields[i+1].c_str());
+            d.last.swap(fields[i+2]);
+            d.path.swap(fields[i+3]);
+            opendirs.push_back(d);
+            i += 4;
+        } else if (fields[i] == "T" && i + 1 < fields.size()) {
+            todo.push_back(fields[i+1]);
+            i += 2;
+        } else {
+            return -1;
+        }
+    }
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->openDirs.splice(p->openDirs.end(), opendirs);
+    p->todoPaths.splice(p->todoPaths.end(), todo);
+    return 0;
 }
 void
 DirLister::skipTillAfter(const std::string& lastToSkip) {
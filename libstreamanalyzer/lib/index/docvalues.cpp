@@ -0,0 +1,351 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "docvalues.h"
+#include "indexformat.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Strigi;
+
+namespace {
+// the largest difference between the values of a numeric column
+const uint64_t maxRange = ((uint64_t)1 << 56) - 2;
+
+uint64_t
+zigzag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+int64_t
+unzigzag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+std::string
+toString(int64_t v) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%lld", (long long)v);
+    return buf;
+}
+/**
+ * @return true if @p s is an integer that toString() writes the same way
+ **/
+bool
+toInteger(const std::string& s, int64_t& v) {
+    if (s.empty() || s.length() > 20) {
+        return false;
+    }
+    char* end;
+    errno = 0;
+    const long long n = strtoll(s.c_str(), &end, 10);
+    if (errno || *end) {
+        return false;
+    }
+    v = n;
+    return toString(v) == s;
+}
+/**
+ * Check that a packed table with @p n values of @p bits bits starts at
+ * @p p and advance @p p to its end.
+ **/
+bool
+skipPacked(const char*& p, const char* end, uint64_t n, uint64_t bits) {
+    // values of 0 bits take no space, so n is limited separately
+    if (bits > 56 || n > 0xffffffffffULL
+            || packedSize(n, (unsigned)bits) > (uint64_t)(end - p)) {
+        return false;
+    }
+    p += packedSize(n, (unsigned)bits);
+    return true;
+}
+}
+
+void
+ColumnWriter::add(uint32_t doc, const std::string& value) {
+    docs.push_back(doc);
+    values.push_back(value);
+}
+void
+ColumnWriter::write(uint32_t docCount, std::string& out) const {
+    std::vector<int64_t> numbers;
+    if (isNumeric(numbers)) {
+        writeNumbers(docCount, numbers, out);
+    } else {
+        writeStrings(docCount, out);
+    }
+}
+bool
+ColumnWriter::isNumeric(std::vector<int64_t>& numbers) const {
+    numbers.resize(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        if ((i && docs[i] == docs[i - 1])
+                || !toInteger(values[i], numbers[i])) {
+            return false;
+        }
+    }
+    return numbers.empty() || (uint64_t)*std::max_element(numbers.begin(),
+        numbers.end()) - (uint64_t)*std::min_element(numbers.begin(),
+        numbers.end()) <= maxRange;
+}
+void
+ColumnWriter::writeNumbers(uint32_t docCount,
+        const std::vector<int64_t>& numbers, std::string& out) const {
+    const int64_t min = (numbers.empty())
+        ?0 :*std::min_element(numbers.begin(), numbers.end());
+    std::vector<uint64_t> packed(docCount, 0);
+    uint64_t max = 0;
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        packed[docs[i]] = (uint64_t)numbers[i] - (uint64_t)min + 1;
+        max = std::max(max, packed[docs[i]]);
+    }
+    const unsigned bits = bitsNeeded(max);
+    out.append(1, (char)Column::Numeric);
+    putVarint(out, zigzag(min));
+    putVarint(out, bits);
+    putPacked(out, packed, bits);
+}
+void
+ColumnWriter::writeStrings(uint32_t docCount, std::string& out) const {
+    std::vector<std::string> dictionary(values);
+    std::sort(dictionary.begin(), dictionary.end());
+    dictionary.erase(std::unique(dictionary.begin(), dictionary.end()),
+        dictionary.end());
+    std::vector<uint64_t> offsets;
+    std::string bytes;
+    std::vector<std::string>::const_iterator i;
+    for (i = dictionary.begin(); i != dictionary.end(); ++i) {
+        offsets.push_back(bytes.length());
+        bytes.append(*i);
+    }
+    offsets.push_back(bytes.length());
+
+    std::vector<uint64_t> ordinals(values.size());
+    bool single = true;
+    for (size_t j = 0; j < values.size(); ++j) {
+        ordinals[j] = std::lower_bound(dictionary.begin(), dictionary.end(),
+            values[j]) - dictionary.begin();
+        single = single && (j == 0 || docs[j] != docs[j - 1]);
+    }
+
+    out.append(1, (char)((single) ?Column::Single :Column::Multiple));
+    putVarint(out, dictionary.size());
+    putVarint(out, bytes.length());
+    const unsigned offsetBits = bitsNeeded(bytes.length());
+    putVarint(out, offsetBits);
+    putPacked(out, offsets, offsetBits);
+    out.append(bytes);
+    if (single) {
+        std::vector<uint64_t> packed(docCount, 0);
+        for (size_t j = 0; j < values.size(); ++j) {
+            packed[docs[j]] = ordinals[j] + 1;
+        }
+        const unsigned bits = bitsNeeded(dictionary.size());
+        putVarint(out, bits);
+        putPacked(out, packed, bits);
+        return;
+    }
+    std::vector<uint64_t> starts(docCount + 1, 0);
+    for (size_t j = 0; j < docs.size(); ++j) {
+        ++starts[docs[j] + 1];
+    }
+    for (uint32_t d = 0; d < docCount; ++d) {
+        starts[d + 1] += starts[d];
+    }
+    const unsigned startBits = bitsNeeded(values.size());
+    putVarint(out, startBits);
+    putPacked(out, starts, startBits);
+    const unsigned bits = bitsNeeded(dictionary.size() - 1);
+    putVarint(out, bits);
+    putPacked(out, ordinals, bits);
+}
+
+bool
+Column::init(const char* data, const char* end, uint32_t n) {
+    const char* p = data;
+    if (p >= end) {
+        return false;
+    }
+    kind = (Kind)*p++;
+    docCount = n;
+    uint64_t v;
+    if (kind == Numeric) {
+        uint64_t b;
+        if (!getVarint(p, end, v) || !getVarint(p, end, b)) {
+            return false;
+        }
+        min = unzigzag(v);
+        bits = (unsigned)b;
+        table = p;
+        return skipPacked(p, end, docCount, b);
+    }
+    uint64_t count, size, b;
+    if ((kind != Single && kind != Multiple) || !getVarint(p, end, count)
+            || count > 0xffffffff || !getVarint(p, end, size)
+            || !getVarint(p, end, b)) {
+        return false;
+    }
+    m_valueCount = (uint32_t)count;
+    offsetBits = (unsigned)b;
+    offsets = p;
+    if (!skipPacked(p, end, count + 1, b) || size > (uint64_t)(end - p)) {
+        return false;
+    }
+    bytes = p;
+    bytesSize = size;
+    p += size;
+    if (kind == Multiple) {
+        if (!getVarint(p, end, b)) {
+            return false;
+        }
+        startBits = (unsigned)b;
+        starts = p;
+        if (!skipPacked(p, end, (uint64_t)docCount + 1, b)) {
+            return false;
+        }
+        ordinalCount = getPacked(starts, docCount, startBits);
+    } else {
+        ordinalCount = docCount;
+    }
+    if (!getVarint(p, end, b)) {
+        return false;
+    }
+    bits = (unsigned)b;
+    table = p;
+    return skipPacked(p, end, ordinalCount, bits);
+}
+std::string
+Column::value(uint32_t ordinal) const {
+    if (ordinal >= m_valueCount) {
+        return std::string();
+    }
+    const uint64_t start = getPacked(offsets, ordinal, offsetBits);
+    const uint64_t end = getPacked(offsets, ordinal + 1, offsetBits);
+    return (start <= end && end <= bytesSize)
+        ?std::string(bytes + start, (size_t)(end - start)) :std::string();
+}
+/**
+ * Find the positions of the ordinals of @p doc in a multiple column.
+ **/
+bool
+Column::range(uint32_t doc, uint64_t& first, uint64_t& end) const {
+    first = getPacked(starts, doc, startBits);
+    end = getPacked(starts, doc + 1, startBits);
+    return first <= end && end <= ordinalCount;
+}
+void
+Column::values(uint32_t doc, std::vector<std::string>& v) const {
+    if (doc >= docCount) {
+        return;
+    }
+    if (kind == Numeric) {
+        const uint64_t n = getPacked(table, doc, bits);
+        if (n) {
+            v.push_back(toString((int64_t)((uint64_t)min + n - 1)));
+        }
+    } else if (kind == Single) {
+        const uint64_t o = getPacked(table, doc, bits);
+        if (o && o <= m_valueCount) {
+            v.push_back(value((uint32_t)(o - 1)));
+        }
+    } else {
+        uint64_t first, end;
+        if (range(doc, first, end)) {
+            for (uint64_t i = first; i < end; ++i) {
+                const uint64_t o = getPacked(table, i, bits);
+                if (o < m_valueCount) {
+                    v.push_back(value((uint32_t)o));
+                }
+            }
+        }
+    }
+}
+void
+Column::histogram(const std::vector<uint32_t>& docs,
+        std::vector<std::pair<std::string, uint32_t> >& h) const {
+    if (kind == Numeric) {
+        std::vector<int64_t> numbers;
+        numbers.reserve(docs.size());
+        std::vector<uint32_t>::const_iterator i;
+        for (i = docs.begin(); i != docs.end(); ++i) {
+            const uint64_t n = (*i < docCount) ?getPacked(table, *i, bits) :0;
+            if (n) {
+                numbers.push_back((int64_t)((uint64_t)min + n - 1));
+            }
+        }
+        std::sort(numbers.begin(), numbers.end());
+        for (size_t j = 0; j < numbers.size(); ) {
+            size_t k = j;
+            while (k < numbers.size() && numbers[k] == numbers[j]) {
+                ++k;
+            }
+            h.push_back(std::make_pair(toString(numbers[j]),
+                (uint32_t)(k - j)));
+            j = k;
+        }
+        return;
+    }
+    // the counts of ordinal + 1; 0 counts documents without a value
+    std::vector<uint32_t> counts(m_valueCount + 1, 0);
+    const uint64_t max = m_valueCount;
+    if (kind == Single) {
+        // four sets of counters, so that increments of the same counter
+        // do not wait for each other
+        std::vector<uint32_t> more(3 * counts.size(), 0);
+        uint32_t* c[4] = { &counts[0], &more[0], &more[counts.size()],
+            &more[2 * counts.size()] };
+        const size_t n = docs.size();
+        uint64_t o[4];
+        size_t j = 0;
+        for (; j + 4 <= n; j += 4) {
+            for (int k = 0; k < 4; ++k) {
+                o[k] = (docs[j + k] < docCount)
+                    ?getPacked(table, docs[j + k], bits) :0;
+                o[k] = (o[k] <= max) ?o[k] :0;
+            }
+            for (int k = 0; k < 4; ++k) {
+                ++c[k][o[k]];
+            }
+        }
+        for (; j < n; ++j) {
+            o[0] = (docs[j] < docCount) ?getPacked(table, docs[j], bits) :0;
+            ++counts[(o[0] <= max) ?o[0] :0];
+        }
+        for (size_t k = 0; k < counts.size(); ++k) {
+            counts[k] += c[1][k] + c[2][k] + c[3][k];
+        }
+    } else {
+        std::vector<uint32_t>::const_iterator i;
+        for (i = docs.begin(); i != docs.end(); ++i) {
+            uint64_t first, end;
+            if (*i < docCount && range(*i, first, end)) {
+                for (uint64_t k = first; k < end; ++k) {
+                    const uint64_t o = getPacked(table, k, bits);
+                    ++counts[(o < max) ?o + 1 :0];
+                }
+            }
+        }
+    }
+    for (uint32_t k = 1; k < counts.size(); ++k) {
+        if (counts[k]) {
+            h.push_back(std::make_pair(value(k - 1), counts[k]));
+        }
+    }
+}
@@ -0,0 +1,127 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_DOCVALUES_H
+#define STRIGI_DOCVALUES_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * The values of one field for all documents of a segment, stored together
+ * so that reading a field for many documents does not read the other
+ * fields. A column starts with a byte for its kind:
+ *  - numeric: each document has at most one value and all values are
+ *    integers written as by "%lld". The smallest value as zigzag varint,
+ *    the number of bits as varint and for each document its value minus
+ *    the smallest value plus 1, or 0 if it has no value, as a packed table.
+ *  - single or multiple: the sorted distinct values as their number, the
+ *    size of their bytes, the number of bits of an offset as varints, a
+ *    packed table with the offset of each value and one for the end, and
+ *    the bytes. For single columns, each document has at most one value
+ *    and the number of bits as varint is followed by a packed table with
+ *    the ordinal of the value of each document plus 1, or 0 if it has no
+ *    value. For multiple columns, a packed table with the position of the
+ *    first ordinal of each document and one for the end and a packed table
+ *    with the ordinals follow, each after the number of its bits.
+ * Packed tables are written by putPacked().
+ */
+namespace Strigi {
+
+/**
+ * Collects the values of one field for the documents of a segment.
+ **/
+class ColumnWriter {
+private:
+    std::vector<uint32_t> docs;
+    std::vector<std::string> values;
+    bool isNumeric(std::vector<int64_t>& numbers) const;
+    void writeNumbers(uint32_t docCount, const std::vector<int64_t>& numbers,
+        std::string& out) const;
+    void writeStrings(uint32_t docCount, std::string& out) const;
+public:
+    /**
+     * Add a value of @p doc. The documents are added in increasing order.
+     **/
+    void add(uint32_t doc, const std::string& value);
+    bool empty() const { return docs.empty(); }
+    /**
+     * Append the column for @p docCount documents to @p out.
+     **/
+    void write(uint32_t docCount, std::string& out) const;
+};
+
+/**
+ * Reads a column in place.
+ **/
+class Column {
+public:
+    enum Kind { Numeric = 1, Single = 2, Multiple = 3 };
+private:
+    Kind kind;
+    uint32_t docCount;
+    // numeric columns
+    int64_t min;
+    // dictionary columns
+    uint32_t m_valueCount;
+    unsigned offsetBits;
+    const char* offsets;
+    const char* bytes;
+    uint64_t bytesSize;
+    unsigned startBits;
+    const char* starts;
+    uint64_t ordinalCount;
+    // the values of numeric columns and the ordinals of the others
+    unsigned bits;
+    const char* table;
+
+    bool range(uint32_t doc, uint64_t& first, uint64_t& end) const;
+public:
+    Column() :kind(Numeric), docCount(0), min(0), m_valueCount(0),
+        offsetBits(0), offsets(0), bytes(0), bytesSize(0), startBits(0),
+        starts(0), ordinalCount(0), bits(0), table(0) {}
+    /**
+     * @return false if the column does not fit between @p data and @p end
+     **/
+    bool init(const char* data, const char* end, uint32_t docCount);
+    Kind type() const { return kind; }
+    /**
+     * Append the values of @p doc to @p v.
+     **/
+    void values(uint32_t doc, std::vector<std::string>& v) const;
+    /**
+     * @return the number of distinct values of a column that is not
+     * numeric
+     **/
+    uint32_t valueCount() const { return m_valueCount; }
+    std::string value(uint32_t ordinal) const;
+    /**
+     * Count how often each value occurs in the documents @p docs and
+     * append the values with their counts to @p h in the order of the
+     * values.
+     **/
+    void histogram(const std::vector<uint32_t>& docs,
+        std::vector<std::pair<std::string, uint32_t> >& h) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,537 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "fst.h"
+#include "indexformat.h"
+#include <algorithm>
+
+using namespace Strigi;
+
+namespace {
+// nodes with at least this many arcs have a table of the arc positions
+const uint32_t indexedArcs = 8;
+// the offset of the node without arcs in which terms end
+const uint64_t finalLeaf = ~(uint64_t)0;
+}
+
+bool
+Fst::init(const char* d, size_t size, uint64_t r) {
+    data = d;
+    dataSize = size;
+    root = r;
+    Node n;
+    if (!readNode(root, n) || !count(n, m_size)) {
+        data = 0;
+        dataSize = 0;
+        m_size = 0;
+        return false;
+    }
+    return true;
+}
+bool
+Fst::readNode(uint64_t offset, Node& n) const {
+    n.offset = offset;
+    if (offset == finalLeaf) {
+        n.arcs = 0;
+        n.arcCount = 0;
+        n.final = true;
+        return true;
+    }
+    if (offset >= dataSize) {
+        return false;
+    }
+    const char* p = data + offset;
+    const char* end = data + dataSize;
+    uint64_t header;
+    if (!getVarint(p, end, header) || (header >> 1) > 256) {
+        return false;
+    }
+    n.arcs = p;
+    n.arcCount = (uint32_t)(header >> 1);
+    n.final = header & 1;
+    return n.arcCount < indexedArcs
+        || (uint64_t)(end - p) >= 4 * n.arcCount;
+}
+/**
+ * The terms of a node are the ones before its last arc and the ones behind
+ * it.
+ **/
+bool
+Fst::count(Node n, uint32_t& total) const {
+    total = 0;
+    Arc a;
+    while (n.arcCount) {
+        bool ok = (n.arcCount >= indexedArcs)
+            ?readArc(n, 0, n.arcCount - 1, a) :firstArc(n, a);
+        while (ok && a.index + 1 < n.arcCount) {
+            ok = nextArc(n, a);
+        }
+        if (!ok || !readNode(a.target, n)) {
+            return false;
+        }
+        total += a.output;
+    }
+    total += n.final;
+    return true;
+}
+/**
+ * @return the start of arc @p index of a node with a table of arc positions
+ **/
+const char*
+Fst::arcAt(const Node& n, uint32_t index) const {
+    const char* start = n.arcs + 4 * n.arcCount;
+    const uint32_t pos = getFixed32(n.arcs + 4 * index);
+    return (pos < (uint64_t)(data + dataSize - start)) ?start + pos :0;
+}
+bool
+Fst::readArc(const Node& n, const char* p, uint32_t index, Arc& a) const {
+    const char* end = data + dataSize;
+    if (n.arcCount >= indexedArcs) {
+        p = arcAt(n, index);
+    }
+    if (p == 0 || p >= end) {
+        return false;
+    }
+    a.label = (unsigned char)*p++;
+    uint64_t length, output = n.final, distance = 0;
+    if (!getVarint(p, end, length) || (length >> 1) > (uint64_t)(end - p)) {
+        return false;
+    }
+    a.tail = p;
+    a.tailLength = (uint32_t)(length >> 1);
+    p += a.tailLength;
+    if ((index && !getVarint(p, end, output)) || output > 0xffffffff
+            || (!(length & 1) && (!getVarint(p, end, distance)
+                || distance == 0 || distance > n.offset))) {
+        return false;
+    }
+    a.output = (uint32_t)output;
+    // the targets come before the node, so every path ends
+    a.target = (length & 1) ?finalLeaf :n.offset - distance;
+    a.next = p;
+    a.index = index;
+    return true;
+}
+bool
+Fst::firstArc(const Node& n, Arc& a) const {
+    return n.arcCount && readArc(n, n.arcs, 0, a);
+}
+bool
+Fst::nextArc(const Node& n, Arc& a) const {
+    return a.index + 1 < n.arcCount && readArc(n, a.next, a.index + 1, a);
+}
+bool
+Fst::findArc(const Node& n, unsigned char label, Arc& a) const {
+    if (n.arcCount < indexedArcs) {
+        for (bool ok = firstArc(n, a); ok; ok = nextArc(n, a)) {
+            if (a.label >= label) {
+                return true;
+            }
+        }
+        return false;
+    }
+    uint32_t lo = 0, hi = n.arcCount;
+    while (lo < hi) {
+        const uint32_t mid = (lo + hi) / 2;
+        const char* p = arcAt(n, mid);
+        if (p == 0) {
+            return false;
+        }
+        if ((unsigned char)*p < label) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < n.arcCount && readArc(n, 0, lo, a);
+}
+bool
+Fst::findOrdinal(const Node& n, uint32_t ordinal, Arc& a) const {
+    if (n.arcCount < indexedArcs) {
+        if (!firstArc(n, a) || a.output > ordinal) {
+            return false;
+        }
+        Arc b = a;
+        while (nextArc(n, b) && b.output <= ordinal) {
+            a = b;
+        }
+        return true;
+    }
+    // the first arc with a larger output follows the one that is needed
+    uint32_t lo = 0, hi = n.arcCount;
+    while (lo < hi) {
+        const uint32_t mid = (lo + hi) / 2;
+        if (!readArc(n, 0, mid, a)) {
+            return false;
+        }
+        if (a.output <= ordinal) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo > 0 && readArc(n, 0, lo - 1, a);
+}
+bool
+Fst::walk(const std::string& prefix, Node& n, uint32_t& base,
+        bool& inside) const {
+    if (!data || !readNode(root, n)) {
+        return false;
+    }
+    base = 0;
+    inside = false;
+    Arc a;
+    for (size_t i = 0; i < prefix.length(); ) {
+        const unsigned char label = (unsigned char)prefix[i++];
+        if (!findArc(n, label, a) || a.label != label) {
+            return false;
+        }
+        const size_t length = std::min((size_t)a.tailLength,
+            prefix.length() - i);
+        if (prefix.compare(i, length, a.tail, length) != 0
+                || !readNode(a.target, n)) {
+            return false;
+        }
+        i += length;
+        inside = length < a.tailLength;
+        base += a.output;
+    }
+    return true;
+}
+bool
+Fst::find(const std::string& term, uint32_t& ordinal) const {
+    Node n;
+    bool inside;
+    return walk(term, n, ordinal, inside) && !inside && n.final;
+}
+uint32_t
+Fst::countPrefix(const std::string& prefix, uint32_t& first) const {
+    Node n;
+    bool inside;
+    uint32_t c;
+    if (!walk(prefix, n, first, inside) || !count(n, c)) {
+        first = 0;
+        return 0;
+    }
+    return c;
+}
+
+bool
+Fst::Iterator::result(bool ok) {
+    if (!ok) {
+        frames.clear();
+        m_term.clear();
+    }
+    return ok;
+}
+bool
+Fst::Iterator::push(uint64_t offset, uint32_t base) {
+    Frame f;
+    if (!fst->readNode(offset, f.node)) {
+        return false;
+    }
+    f.base = base;
+    f.length = m_term.length();
+    frames.push_back(f);
+    return true;
+}
+/**
+ * Enter the node behind the arc of the last frame.
+ **/
+bool
+Fst::Iterator::follow() {
+    const Frame& f = frames.back();
+    m_term += (char)f.arc.label;
+    m_term.append(f.arc.tail, f.arc.tailLength);
+    return push(f.arc.target, f.base + f.arc.output);
+}
+/**
+ * Move from the node of the last frame to the first term that starts in it.
+ **/
+bool
+Fst::Iterator::descend() {
+    for (;;) {
+        Frame& f = frames.back();
+        if (f.node.final) {
+            return true;
+        }
+        if (!fst->firstArc(f.node, f.arc) || !follow()) {
+            return false;
+        }
+    }
+}
+/**
+ * Move to the first term after the terms behind the arc of the last frame.
+ **/
+bool
+Fst::Iterator::skip() {
+    for (;;) {
+        Frame& f = frames.back();
+        m_term.resize(f.length);
+        if (fst->nextArc(f.node, f.arc)) {
+            return follow() && descend();
+        }
+        frames.pop_back();
+        if (frames.empty()) {
+            return false;
+        }
+    }
+}
+/**
+ * Move to the first term after the terms that start in the node of the last
+ * frame.
+ **/
+bool
+Fst::Iterator::ascend() {
+    frames.pop_back();
+    return !frames.empty() && skip();
+}
+bool
+Fst::Iterator::seek(const Fst& f, const std::string& term) {
+    fst = &f;
+    frames.clear();
+    m_term.clear();
+    if (!f.data || !push(f.root, 0)) {
+        return false;
+    }
+    for (size_t i = 0; i < term.length(); ) {
+        Frame& top = frames.back();
+        const unsigned char label = (unsigned char)term[i++];
+        if (!f.findArc(top.node, label, top.arc)) {
+            // all terms that start in this node are smaller
+            return result(ascend());
+        }
+        if (top.arc.label > label) {
+            return result(follow() && descend());
+        }
+        const size_t length = std::min((size_t)top.arc.tailLength,
+            term.length() - i);
+        const int c = term.compare(i, length, top.arc.tail, length);
+        if (c > 0) {
+            // all terms behind the arc are smaller
+            return result(skip());
+        }
+        // the term ends inside the label
+        const bool inside = length < top.arc.tailLength;
+        if (!follow()) {
+            return result(false);
+        }
+        if (c < 0 || inside) {
+            // all terms behind the arc are larger
+            break;
+        }
+        i += length;
+    }
+    return result(descend());
+}
+bool
+Fst::Iterator::seekOrdinal(const Fst& f, uint32_t ordinal) {
+    fst = &f;
+    frames.clear();
+    m_term.clear();
+    if (ordinal >= f.m_size || !push(f.root, 0)) {
+        return result(false);
+    }
+    for (;;) {
+        Frame& top = frames.back();
+        if (top.node.final && top.base == ordinal) {
+            return true;
+        }
+        if (!f.findOrdinal(top.node, ordinal - top.base, top.arc)
+                || !follow()) {
+            return result(false);
+        }
+    }
+}
+bool
+Fst::Iterator::next() {
+    if (frames.empty()) {
+        return false;
+    }
+    Frame& top = frames.back();
+    if (top.node.arcCount == 0) {
+        return result(ascend());
+    }
+    return result(fst->firstArc(top.node, top.arc) && follow() && descend());
+}
+
+FstBuilder::FstBuilder(std::string& o) :out(o), path(1), used(0), m_size(0) {
+}
+bool
+FstBuilder::add(const std::string& term) {
+    if (path.empty() || (m_size && term <= last)) {
+        return false;
+    }
+    const size_t max = std::min(term.length(), last.length());
+    size_t prefix = 0;
+    while (prefix < max && term[prefix] == last[prefix]) {
+        ++prefix;
+    }
+    freeze(prefix);
+    for (size_t i = prefix; i < term.length(); ++i) {
+        Arc a;
+        a.label = term[i];
+        a.target = 0;
+        a.count = 0;
+        path[i].arcs.push_back(a);
+        path.push_back(Node());
+    }
+    path.back().final = true;
+    last = term;
+    ++m_size;
+    return true;
+}
+uint64_t
+FstBuilder::finish() {
+    if (path.empty()) {
+        return 0;
+    }
+    freeze(0);
+    uint32_t count;
+    const uint64_t root = write(path[0], count);
+    path.clear();
+    std::vector<std::pair<uint64_t, uint64_t> >().swap(table);
+    return root;
+}
+/**
+ * Write the nodes of the last term that are deeper than @p depth. They
+ * cannot change anymore because the next term leaves the path there.
+ **/
+void
+FstBuilder::freeze(size_t depth) {
+    while (path.size() > depth + 1) {
+        Node& n = path.back();
+        Arc& a = path[path.size() - 2].arcs.back();
+        if (n.arcs.size() == 1 && !n.final) {
+            // merge the node into the arc that leads to it
+            a.label += n.arcs[0].label;
+            a.target = n.arcs[0].target;
+            a.count = n.arcs[0].count;
+        } else {
+            a.target = write(n, a.count);
+        }
+        path.pop_back();
+    }
+}
+/**
+ * Write @p n unless the same node was written before.
+ * @return the offset of the node
+ **/
+uint64_t
+FstBuilder::write(const Node& n, uint32_t& count) {
+    count = n.final;
+    std::vector<Arc>::const_iterator i;
+    for (i = n.arcs.begin(); i != n.arcs.end(); ++i) {
+        count += i->count;
+    }
+    if (n.arcs.empty() && n.final) {
+        return finalLeaf;
+    }
+    const uint64_t h = hash(n);
+    const size_t mask = table.size() - 1;
+    for (size_t j = h & mask; table.size() && table[j].second;
+            j = (j + 1) & mask) {
+        if (table[j].first == h && equals(table[j].second - 1, n)) {
+            return table[j].second - 1;
+        }
+    }
+
+    const uint64_t offset = out.length();
+    putVarint(out, (n.arcs.size() << 1) | n.final);
+    arcs.clear();
+    uint32_t output = n.final;
+    for (i = n.arcs.begin(); i != n.arcs.end(); ++i) {
+        if (n.arcs.size() >= indexedArcs) {
+            putFixed32(out, (uint32_t)arcs.length());
+        }
+        const bool leaf = i->target == finalLeaf;
+        arcs += i->label[0];
+        putVarint(arcs, (i->label.length() - 1) << 1 | leaf);
+        arcs.append(i->label, 1, std::string::npos);
+        if (i != n.arcs.begin()) {
+            putVarint(arcs, output);
+        }
+        if (!leaf) {
+            putVarint(arcs, offset - i->target);
+        }
+        output += i->count;
+    }
+    out.append(arcs);
+
+    if (2 * (used + 1) > table.size()) {
+        std::vector<std::pair<uint64_t, uint64_t> > old;
+        old.swap(table);
+        table.resize(std::max((size_t)1024, 2 * old.size()));
+        for (size_t j = 0; j < old.size(); ++j) {
+            if (old[j].second) {
+                insert(old[j].first, old[j].second - 1);
+            }
+        }
+    }
+    insert(h, offset);
+    ++used;
+    return offset;
+}
+void
+FstBuilder::insert(uint64_t h, uint64_t offset) {
+    const size_t mask = table.size() - 1;
+    size_t j = h & mask;
+    while (table[j].second) {
+        j = (j + 1) & mask;
+    }
+    table[j].first = h;
+    table[j].second = offset + 1;
+}
+bool
+FstBuilder::equals(uint64_t offset, const Node& n) const {
+    Fst f;
+    f.data = out.data();
+    f.dataSize = out.length();
+    Fst::Node node;
+    Fst::Arc a;
+    if (!f.readNode(offset, node) || node.final != n.final
+            || node.arcCount != n.arcs.size()) {
+        return false;
+    }
+    bool ok = f.firstArc(node, a);
+    std::vector<Arc>::const_iterator i;
+    for (i = n.arcs.begin(); i != n.arcs.end(); ++i) {
+        if (!ok || a.target != i->target
+                || a.label != (unsigned char)i->label[0]
+                || i->label.compare(1, std::string::npos, a.tail,
+                    a.tailLength) != 0) {
+            return false;
+        }
+        ok = f.nextArc(node, a);
+    }
+    return true;
+}
+uint64_t
+FstBuilder::hash(const Node& n) {
+    uint64_t h = n.final;
+    std::vector<Arc>::const_iterator i;
+    for (i = n.arcs.begin(); i != n.arcs.end(); ++i) {
+        for (size_t j = 0; j < i->label.length(); ++j) {
+            h = h * 31 + (unsigned char)i->label[j];
+        }
+        h = h * 0x9e3779b97f4a7c15ULL + i->target;
+    }
+    return h ^ (h >> 29);
+}
@@ -0,0 +1,253 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_FST_H
+#define STRIGI_FST_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * A finite-state transducer that maps a sorted set of terms to their
+ * ordinals, the number of smaller terms in the set.
+ *
+ * Each arc stores the number of terms of its node that are smaller than the
+ * terms behind the arc, so the ordinal of a term is the sum of the outputs
+ * of the arcs on its path. The outputs also make it cheap to count the
+ * terms with a prefix and to jump to the n-th term.
+ *
+ * Nodes with the same arcs are stored once, so terms share their common
+ * suffixes as well as their common prefixes. A node with one arc in which
+ * no term ends is merged into the arc that leads to it, so an arc has a
+ * label of one or more bytes. A node is written before the nodes that
+ * point to it and the root is written last. The node without arcs in
+ * which terms end is not written. A node is:
+ *  - varint: the number of arcs << 1 | 1 if a term ends in the node
+ *  - for nodes with many arcs, the position of each arc after the table
+ *    as fixed32, so the arcs can be searched by bisection
+ *  - the arcs sorted by label. An arc is the first byte of its label,
+ *    the number of the other bytes << 1 | 1 if the arc leads to the node
+ *    that is not written as varint, the other bytes, the output as varint
+ *    and the distance back to the target as varint. The output of the first
+ *    arc is not stored; it is 1 if a term ends in the node and 0 otherwise.
+ *    The distance is not stored for arcs to the node that is not written.
+ */
+namespace Strigi {
+
+/**
+ * Reads a transducer that was written by FstBuilder. The transducer is
+ * read in place, so it can be used on a mapped file.
+ **/
+class Fst {
+friend class FstBuilder;
+public:
+    class Iterator;
+    Fst() :data(0), dataSize(0), root(0), m_size(0) {}
+    /**
+     * @param data the output of FstBuilder
+     * @param root the offset of the root as returned by FstBuilder::finish()
+     * @return false if the root cannot be read
+     **/
+    bool init(const char* data, size_t size, uint64_t root);
+    /**
+     * @return the number of terms
+     **/
+    uint32_t size() const { return m_size; }
+    /**
+     * Look up @p term and set @p ordinal to its ordinal.
+     * @return false if the transducer does not contain @p term
+     **/
+    bool find(const std::string& term, uint32_t& ordinal) const;
+    /**
+     * Count the terms that start with @p prefix and set @p first to the
+     * ordinal of the first of them.
+     **/
+    uint32_t countPrefix(const std::string& prefix, uint32_t& first) const;
+private:
+    class Node {
+    public:
+        uint64_t offset;
+        const char* arcs;
+        uint32_t arcCount;
+        bool final;
+    };
+    class Arc {
+    public:
+        // the bytes of the label after the first one
+        const char* tail;
+        // the arc after this one
+        const char* next;
+        uint64_t target;
+        uint32_t tailLength;
+        uint32_t output;
+        uint32_t index;
+        unsigned char label;
+    };
+    const char* data;
+    size_t dataSize;
+    uint64_t root;
+    uint32_t m_size;
+
+    bool readNode(uint64_t offset, Node& n) const;
+    /**
+     * Count the terms that start in @p n.
+     **/
+    bool count(Node n, uint32_t& total) const;
+    /**
+     * Follow the arcs for @p prefix from the root to @p n and set @p base
+     * to the sum of their outputs. If @p prefix ends inside the label of
+     * the last arc, @p inside is set to true.
+     **/
+    bool walk(const std::string& prefix, Node& n, uint32_t& base,
+        bool& inside) const;
+    /**
+     * Read the first arc of @p n.
+     **/
+    bool firstArc(const Node& n, Arc& a) const;
+    /**
+     * Replace @p a with the arc after it.
+     * @return false if @p a is the last arc of @p n or if it is damaged
+     **/
+    bool nextArc(const Node& n, Arc& a) const;
+    /**
+     * Find the first arc of @p n with a label that does not start with a
+     * byte smaller than @p label.
+     **/
+    bool findArc(const Node& n, unsigned char label, Arc& a) const;
+    /**
+     * Find the arc of @p n that leads to the term with the relative
+     * ordinal @p ordinal.
+     **/
+    bool findOrdinal(const Node& n, uint32_t ordinal, Arc& a) const;
+    bool readArc(const Node& n, const char* p, uint32_t index, Arc& a) const;
+    const char* arcAt(const Node& n, uint32_t index) const;
+};
+
+/**
+ * Iterates over the terms of an Fst in byte order.
+ **/
+class Fst::Iterator {
+private:
+    class Frame {
+    public:
+        Node node;
+        // the arc that leads to the next frame
+        Arc arc;
+        // the ordinal of the first term of the node
+        uint32_t base;
+        // the length of the term up to the node
+        size_t length;
+    };
+    const Fst* fst;
+    std::vector<Frame> frames;
+    std::string m_term;
+
+    bool push(uint64_t offset, uint32_t base);
+    bool follow();
+    bool descend();
+    bool skip();
+    bool ascend();
+    bool result(bool ok);
+public:
+    Iterator() :fst(0) {}
+    /**
+     * Move to the first term that is not smaller than @p term.
+     * @return false if there is no such term
+     **/
+    bool seek(const Fst& fst, const std::string& term);
+    /**
+     * Move to the term with ordinal @p ordinal.
+     * @return false if there is no such term
+     **/
+    bool seekOrdinal(const Fst& fst, uint32_t ordinal);
+    /**
+     * @return false if there are no more terms
+     **/
+    bool next();
+    const std::string& term() const { return m_term; }
+    uint32_t ordinal() const { return frames.back().base; }
+};
+
+/**
+ * Writes a transducer for terms that are added in increasing byte order.
+ *
+ * Only the nodes of the last term are kept in memory until a term with a
+ * different prefix is added. The nodes that are written are remembered in
+ * a hash table with their offsets, so the builder needs a few bytes per
+ * node and compares new nodes with the ones in the output.
+ **/
+class FstBuilder {
+private:
+    class Arc {
+    public:
+        std::string label;
+        uint64_t target;
+        uint32_t count;
+    };
+    class Node {
+    public:
+        std::vector<Arc> arcs;
+        bool final;
+        Node() :final(false) {}
+    };
+    std::string& out;
+    std::string arcs;
+    // the nodes of the last term that have not been written
+    std::vector<Node> path;
+    std::string last;
+    // the hashes and the offsets + 1 of the written nodes; an offset of 0
+    // marks an empty slot
+    std::vector<std::pair<uint64_t, uint64_t> > table;
+    size_t used;
+    uint32_t m_size;
+
+    void freeze(size_t depth);
+    uint64_t write(const Node& n, uint32_t& count);
+    bool equals(uint64_t offset, const Node& n) const;
+    static uint64_t hash(const Node& n);
+    void insert(uint64_t h, uint64_t offset);
+    FstBuilder(const FstBuilder&);
+    void operator=(const FstBuilder&);
+public:
+    /**
+     * @param out the string to which the nodes are appended. The offsets
+     * in the transducer are relative to the start of @p out.
+     **/
+    explicit FstBuilder(std::string& out);
+    /**
+     * Add @p term. The terms must be added in increasing byte order.
+     * @return false if @p term is not larger than the previous term
+     **/
+    bool add(const std::string& term);
+    /**
+     * Write the remaining nodes. No terms can be added afterwards.
+     * @return the offset of the root
+     **/
+    uint64_t finish();
+    /**
+     * @return the number of terms that were added
+     **/
+    uint32_t size() const { return m_size; }
+};
+
+}
+
+#endif
@@ -0,0 +1,283 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "indexformat.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace Strigi;
+
+namespace {
+/**
+ * The first line of the list of segments. It changes when the format of
+ * the index changes.
+ **/
+const char segmentsMagic[] = "strigi-segments 1";
+}
+
+const char Strigi::tisMagic[] = "strgtis3";
+const char Strigi::pstMagic[] = "strgpst3";
+const char Strigi::fldMagic[] = "strgfld1";
+const char Strigi::dvMagic[] = "strgdvl1";
+const char Strigi::triMagic[] = "strgtri1";
+const char Strigi::posMagic[] = "strgpos1";
+
+void
+Strigi::putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.append(1, (char)(v | 0x80));
+        v >>= 7;
+    }
+    out.append(1, (char)v);
+}
+bool
+Strigi::getVarint(const char*& p, const char* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char c = (unsigned char)*p++;
+        v |= (uint64_t)(c & 0x7f) << shift;
+        if (c < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+void
+Strigi::putFixed32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out.append(1, (char)(v >> (8 * i)));
+    }
+}
+void
+Strigi::putFixed64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        out.append(1, (char)(v >> (8 * i)));
+    }
+}
+uint32_t
+Strigi::getFixed32(const char* p) {
+    const unsigned char* u = (const unsigned char*)p;
+    return (uint32_t)u[0] | ((uint32_t)u[1] << 8) | ((uint32_t)u[2] << 16)
+        | ((uint32_t)u[3] << 24);
+}
+uint64_t
+Strigi::getFixed64(const char* p) {
+    return (uint64_t)getFixed32(p) | ((uint64_t)getFixed32(p + 4) << 32);
+}
+unsigned
+Strigi::bitsNeeded(uint64_t v) {
+    unsigned bits = 0;
+    while (v) {
+        ++bits;
+        v >>= 1;
+    }
+    return bits;
+}
+void
+Strigi::putPacked(std::string& out, const std::vector<uint64_t>& values,
+        unsigned bits) {
+    uint64_t pending = 0;
+    unsigned n = 0;
+    std::vector<uint64_t>::const_iterator i;
+    for (i = values.begin(); i != values.end(); ++i) {
+        pending |= *i << n;
+        n += bits;
+        while (n >= 8) {
+            out.append(1, (char)pending);
+            pending >>= 8;
+            n -= 8;
+        }
+    }
+    if (n) {
+        out.append(1, (char)pending);
+    }
+    out.append(8, '\0');
+}
+uint64_t
+Strigi::getPacked(const char* p, uint64_t index, unsigned bits) {
+    const uint64_t bit = index * bits;
+    return (getFixed64(p + bit / 8) >> (bit % 8))
+        & (((uint64_t)1 << bits) - 1);
+}
+uint64_t
+Strigi::packedSize(uint64_t count, unsigned bits) {
+    return (count * bits + 7) / 8 + 8;
+}
+void
+Strigi::putBytes(std::string& out, const std::string& s) {
+    putVarint(out, s.length());
+    out.append(s);
+}
+bool
+Strigi::getBytes(const char*& p, const char* end, std::string& s) {
+    uint64_t length;
+    if (!getVarint(p, end, length) || length > (uint64_t)(end - p)) {
+        return false;
+    }
+    s.assign(p, (size_t)length);
+    p += length;
+    return true;
+}
+
+MappedFile::~MappedFile() {
+    if (m_size) {
+        munmap((void*)m_data, m_size);
+    }
+}
+bool
+MappedFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat s;
+    if (fstat(fd, &s) != 0) {
+        close(fd);
+        return false;
+    }
+    if (s.st_size > 0) {
+        void* data = mmap(0, (size_t)s.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+        m_data = (const char*)data;
+        m_size = (size_t)s.st_size;
+    }
+    close(fd);
+    return true;
+}
+
+bool
+Strigi::writeFileAtomically(const std::string& path, const std::string& data) {
+    const std::string tmp(path + ".new");
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (f == 0) {
+        return false;
+    }
+    bool ok = fwrite(data.c_str(), 1, data.length(), f) == data.length();
+    ok = fflush(f) == 0 && ok;
+    // the file has to be on disk before the list of segments refers to it
+    ok = fdatasync(fileno(f)) == 0 && ok;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string
+SegmentInfo::fileName(const char* extension) const {
+    return name + '.' + extension;
+}
+std::string
+SegmentInfo::delFileName() const {
+    char gen[16];
+    snprintf(gen, sizeof(gen), "_%u.del", delGen);
+    return name + gen;
+}
+
+bool
+SegmentInfos::read(const std::string& dir) {
+    segments.clear();
+    counter = 0;
+    FILE* f = fopen((dir + "/segments").c_str(), "rb");
+    if (f == 0) {
+        return true;
+    }
+    char line[1024];
+    bool ok = fgets(line, sizeof(line), f) != 0
+        && strncmp(line, segmentsMagic, sizeof(segmentsMagic) - 1) == 0
+        && fscanf(f, "%u\n", &counter) == 1;
+    char name[256];
+    SegmentInfo info;
+    while (ok && fscanf(f, "%255s %u %u %u\n", name, &info.docCount,
+            &info.delGen, &info.delCount) == 4) {
+        info.name.assign(name);
+        segments.push_back(info);
+    }
+    ok = ok && feof(f);
+    fclose(f);
+    if (!ok) {
+        segments.clear();
+    }
+    return ok;
+}
+bool
+SegmentInfos::write(const std::string& dir) const {
+    std::string data(segmentsMagic);
+    char line[512];
+    snprintf(line, sizeof(line), "\n%u\n", counter);
+    data.append(line);
+    std::vector<SegmentInfo>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+        snprintf(line, sizeof(line), "%s %u %u %u\n", i->name.c_str(),
+            i->docCount, i->delGen, i->delCount);
+        data.append(line);
+    }
+    return writeFileAtomically(dir + "/segments", data);
+}
+std::string
+SegmentInfos::newSegmentName() {
+    char name[16];
+    snprintf(name, sizeof(name), "_%u", counter++);
+    return name;
+}
+
+uint32_t
+DeletionBitmap::count() const {
+    uint32_t n = 0;
+    std::vector<uint64_t>::const_iterator i;
+    for (i = bits.begin(); i != bits.end(); ++i) {
+        n += __builtin_popcountll(*i);
+    }
+    return n;
+}
+bool
+DeletionBitmap::read(const std::string& path, uint32_t n) {
+    MappedFile file;
+    size_t size = 8 * (size_t)((n + 63) / 64);
+    if (!file.open(path) || file.size() != size + 4
+            || getFixed32(file.data()) != n) {
+        return false;
+    }
+    docCount = n;
+    bits.resize(size / 8);
+    for (size_t i = 0; i < bits.size(); ++i) {
+        bits[i] = getFixed64(file.data() + 4 + 8 * i);
+    }
+    return true;
+}
+bool
+DeletionBitmap::write(const std::string& path) const {
+    std::string data;
+    putFixed32(data, docCount);
+    std::vector<uint64_t>::const_iterator i;
+    for (i = bits.begin(); i != bits.end(); ++i) {
+        putFixed64(data, *i);
+    }
+    return writeFileAtomically(path, data);
+}
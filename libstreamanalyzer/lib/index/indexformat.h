@@ -0,0 +1,179 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_INDEXFORMAT_H
+#define STRIGI_INDEXFORMAT_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * Helpers for the files of the segment index.
+ *
+ * An index directory contains a file 'segments' that lists the segments
+ * that make up the index. Each segment is a set of files that is written
+ * once and never changed:
+ *  - NAME.tis: the term dictionary; a transducer from the terms of each
+ *    field to their ordinals and a table with the number of documents and
+ *    the offset of the postings for each ordinal
+ *  - NAME.pst: the postings of the terms
+ *  - NAME.pos: the positions of the terms of the fields that have them,
+ *    see positions.h
+ *  - NAME.fld: the stored fields of the documents
+ *  - NAME.dv: the stored fields except the fragments as a column per
+ *    field, see docvalues.h
+ *  - NAME.tri: the trigrams of the terms of each field, see trigram.h
+ * Documents that are deleted after a segment was written are marked in a
+ * bitmap NAME_GEN.del. A new generation of the bitmap is written for each
+ * commit that deletes documents from the segment.
+ */
+namespace Strigi {
+
+/**
+ * The first and the last bytes of the files of a segment. They change when
+ * the format of the files changes.
+ **/
+extern const char tisMagic[];
+extern const char pstMagic[];
+extern const char fldMagic[];
+extern const char dvMagic[];
+extern const char triMagic[];
+extern const char posMagic[];
+const size_t magicSize = 8;
+
+/**
+ * Append @p v to @p out with 7 bits per byte.
+ **/
+void putVarint(std::string& out, uint64_t v);
+/**
+ * Read a number written by putVarint() from @p p and advance @p p.
+ * @return false if the number does not end before @p end
+ **/
+bool getVarint(const char*& p, const char* end, uint64_t& v);
+void putFixed32(std::string& out, uint32_t v);
+void putFixed64(std::string& out, uint64_t v);
+uint32_t getFixed32(const char* p);
+uint64_t getFixed64(const char* p);
+/**
+ * @return the number of bits that are needed to write @p v
+ **/
+unsigned bitsNeeded(uint64_t v);
+/**
+ * Append @p values with @p bits bits each, followed by padding, so that
+ * getPacked() reads any value with one load. @p bits is at most 56.
+ **/
+void putPacked(std::string& out, const std::vector<uint64_t>& values,
+    unsigned bits);
+uint64_t getPacked(const char* p, uint64_t index, unsigned bits);
+/**
+ * @return the number of bytes that putPacked() appends
+ **/
+uint64_t packedSize(uint64_t count, unsigned bits);
+/**
+ * Append a string preceded by its length.
+ **/
+void putBytes(std::string& out, const std::string& s);
+bool getBytes(const char*& p, const char* end, std::string& s);
+
+/**
+ * A file that is mapped into memory for reading.
+ **/
+class MappedFile {
+private:
+    const char* m_data;
+    size_t m_size;
+    MappedFile(const MappedFile&);
+    void operator=(const MappedFile&);
+public:
+    MappedFile() :m_data(0), m_size(0) {}
+    ~MappedFile();
+    /**
+     * @return false if the file could not be opened or mapped
+     **/
+    bool open(const std::string& path);
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+};
+
+/**
+ * Write @p data to a file next to @p path and rename it to @p path, so
+ * readers see either the old or the new file.
+ **/
+bool writeFileAtomically(const std::string& path, const std::string& data);
+
+/**
+ * The entry for a segment in the list of segments.
+ **/
+class SegmentInfo {
+public:
+    std::string name;
+    uint32_t docCount;
+    // the generation of the deletion bitmap; 0 if nothing was deleted
+    uint32_t delGen;
+    uint32_t delCount;
+    SegmentInfo() :docCount(0), delGen(0), delCount(0) {}
+    std::string fileName(const char* extension) const;
+    std::string delFileName() const;
+};
+
+/**
+ * The list of segments in an index directory.
+ **/
+class SegmentInfos {
+public:
+    std::vector<SegmentInfo> segments;
+    // the number used for the name of the next new segment
+    uint32_t counter;
+    SegmentInfos() :counter(0) {}
+    /**
+     * Read the list from @p dir. A directory without a list is an empty
+     * index.
+     * @return false if the list exists but cannot be read
+     **/
+    bool read(const std::string& dir);
+    bool write(const std::string& dir) const;
+    std::string newSegmentName();
+};
+
+/**
+ * A bitmap with one bit per document of a segment.
+ **/
+class DeletionBitmap {
+private:
+    std::vector<uint64_t> bits;
+    uint32_t docCount;
+public:
+    explicit DeletionBitmap(uint32_t n = 0)
+        :bits((n + 63) / 64, 0), docCount(n) {}
+    bool get(uint32_t doc) const {
+        return (bits[doc >> 6] >> (doc & 63)) & 1;
+    }
+    void set(uint32_t doc) {
+        bits[doc >> 6] |= (uint64_t)1 << (doc & 63);
+    }
+    uint32_t count() const;
+    bool read(const std::string& path, uint32_t n);
+    bool write(const std::string& path) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,148 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "levenshtein.h"
+
+using namespace Strigi;
+
+LevenshteinAutomaton::LevenshteinAutomaton(const std::string& t,
+        unsigned maxEdits) :term(t),
+        m_maxEdits((maxEdits < maxDistance) ?maxEdits :maxDistance) {
+    std::fill(inTerm, inTerm + 256, false);
+    for (size_t i = 0; i < term.length(); ++i) {
+        inTerm[(unsigned char)term[i]] = true;
+    }
+}
+void
+LevenshteinAutomaton::setMaxEdits(unsigned maxEdits) {
+    m_maxEdits = std::min(maxEdits, m_maxEdits);
+}
+/**
+ * @return the distances between the empty string and the prefixes
+ **/
+LevenshteinAutomaton::Row
+LevenshteinAutomaton::start() const {
+    Row row(term.length() + 1);
+    for (size_t j = 0; j < row.size(); ++j) {
+        row[j] = (uint8_t)std::min<size_t>(j, m_maxEdits + 1);
+    }
+    return row;
+}
+/**
+ * @return the row after the byte @p c or, if @p c is -1, after a byte
+ *         that is not in the term
+ **/
+LevenshteinAutomaton::Row
+LevenshteinAutomaton::step(const Row& row, int c) const {
+    const unsigned cap = m_maxEdits + 1;
+    Row next(row.size());
+    next[0] = (uint8_t)std::min<unsigned>(row[0] + 1, cap);
+    for (size_t j = 1; j < row.size(); ++j) {
+        const unsigned replace = row[j - 1]
+            + ((unsigned char)term[j - 1] != c);
+        const unsigned d = std::min(replace, std::min<unsigned>(row[j],
+            next[j - 1]) + 1);
+        next[j] = (uint8_t)std::min(d, cap);
+    }
+    return next;
+}
+/**
+ * @return true if some string that starts with the string of @p row is
+ *         accepted
+ **/
+bool
+LevenshteinAutomaton::isLive(const Row& row) const {
+    return *std::min_element(row.begin(), row.end()) <= m_maxEdits;
+}
+unsigned
+LevenshteinAutomaton::distance(const std::string& s) const {
+    Row row(start());
+    for (size_t i = 0; i < s.length() && isLive(row); ++i) {
+        row = step(row, (unsigned char)s[i]);
+    }
+    return row.back();
+}
+/**
+ * Find the smallest accepted suffix for @p row that starts with a byte
+ * that is not smaller than @p lo.
+ * @return false if there is none
+ **/
+bool
+LevenshteinAutomaton::larger(const Row& row, unsigned lo,
+        std::string& suffix) const {
+    // all bytes that are not in the term lead to the same row
+    const Row other(step(row, -1));
+    const bool otherIsLive = isLive(other);
+    for (unsigned c = lo; c < 256; ++c) {
+        if (!inTerm[c] && !otherIsLive) {
+            continue;
+        }
+        const Row next((inTerm[c]) ?step(row, (int)c) :other);
+        if (isLive(next)) {
+            suffix.assign(1, (char)c);
+            std::string rest;
+            smallest(next, rest);
+            suffix.append(rest);
+            return true;
+        }
+    }
+    return false;
+}
+/**
+ * Find the smallest accepted suffix for the live row @p row. Each byte that
+ * does not match adds to the first distance, so the suffix ends.
+ **/
+void
+LevenshteinAutomaton::smallest(const Row& row, std::string& suffix) const {
+    suffix.clear();
+    if (!isMatch(row)) {
+        larger(row, 0, suffix);
+    }
+}
+bool
+LevenshteinAutomaton::next(const std::string& s, std::string& match) const {
+    // the rows of the prefixes of s as long as they are live
+    std::vector<Row> rows(1, start());
+    while (rows.size() <= s.length() && isLive(rows.back())) {
+        rows.push_back(step(rows.back(), (unsigned char)s[rows.size() - 1]));
+    }
+    if (!isLive(rows.back())) {
+        rows.pop_back();
+    }
+    size_t k = rows.size() - 1;
+    std::string suffix;
+    if (k == s.length()) {
+        smallest(rows[k], suffix);
+        match = s + suffix;
+        return true;
+    }
+    // replace the byte after the live prefix by a larger one, or else the
+    // byte before it
+    for (;;) {
+        if (larger(rows[k], (unsigned char)s[k] + 1u, suffix)) {
+            match = s.substr(0, k) + suffix;
+            return true;
+        }
+        if (k == 0) {
+            return false;
+        }
+        --k;
+    }
+}
@@ -0,0 +1,152 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_LEVENSHTEIN_H
+#define STRIGI_LEVENSHTEIN_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace Strigi {
+
+/**
+ * Accepts the strings that are at most a few edits away from a term. An
+ * edit inserts, deletes or replaces one byte.
+ *
+ * The automaton is not built as a table. Its state after a string is the
+ * row of the edit distances between the string and each prefix of the
+ * term, capped at maxEdits() + 1, which takes as long to compute per byte
+ * as the term is long. With next() it can tell which string to look for
+ * in a sorted list of terms after a term that does not match, so a list
+ * of terms can be searched with a few lookups instead of a full scan.
+ **/
+class LevenshteinAutomaton {
+private:
+    typedef std::vector<uint8_t> Row;
+    const std::string term;
+    unsigned m_maxEdits;
+    // whether a byte occurs in the term
+    bool inTerm[256];
+
+    Row start() const;
+    Row step(const Row& row, int c) const;
+    bool isLive(const Row& row) const;
+    bool isMatch(const Row& row) const {
+        return row.back() <= m_maxEdits;
+    }
+    bool larger(const Row& row, unsigned lo, std::string& suffix) const;
+    void smallest(const Row& row, std::string& suffix) const;
+public:
+    /**
+     * The largest number of edits that is supported.
+     **/
+    static const unsigned maxDistance = 2;
+    /**
+     * @param maxEdits the number of edits, at most maxDistance
+     **/
+    LevenshteinAutomaton(const std::string& term, unsigned maxEdits);
+    unsigned maxEdits() const { return m_maxEdits; }
+    /**
+     * Accept fewer edits than before.
+     **/
+    void setMaxEdits(unsigned maxEdits);
+    /**
+     * @return the number of edits between @p s and the term or
+     *         maxEdits() + 1 if there are more
+     **/
+    unsigned distance(const std::string& s) const;
+    /**
+     * Find the smallest string in byte order that is not smaller than
+     * @p s and that is accepted.
+     * @return false if there is no such string
+     **/
+    bool next(const std::string& s, std::string& match) const;
+};
+
+/**
+ * A term that is a few edits away from the term of a fuzzy query.
+ **/
+class FuzzyTerm {
+public:
+    std::string term;
+    unsigned distance;
+    FuzzyTerm() :distance(0) {}
+    FuzzyTerm(const std::string& t, unsigned d) :term(t), distance(d) {}
+    bool operator<(const FuzzyTerm& o) const {
+        return distance < o.distance
+            || (distance == o.distance && term < o.term);
+    }
+};
+
+/**
+ * Find the terms of @p source that are at most @p maxEdits edits away from
+ * @p term and put the @p maxExpansions closest of them in @p terms, the
+ * closest first. Of terms that are equally close, the smaller ones are
+ * kept.
+ *
+ * @p source is a sorted list of terms with the functions
+ * bool seek(const std::string& s), which moves to the first term that is
+ * not smaller than s and returns false if there is none, and
+ * const std::string& term() const.
+ **/
+template <class Source>
+void
+expandFuzzy(Source& source, const std::string& term, unsigned maxEdits,
+        size_t maxExpansions, std::vector<FuzzyTerm>& terms) {
+    terms.clear();
+    if (maxExpansions == 0) {
+        return;
+    }
+    LevenshteinAutomaton automaton(term, maxEdits);
+    // a heap with the farthest term in front
+    std::string target;
+    bool ok = automaton.next(target, target) && source.seek(target);
+    while (ok) {
+        const std::string& t = source.term();
+        const unsigned d = automaton.distance(t);
+        if (d <= automaton.maxEdits()) {
+            terms.push_back(FuzzyTerm(t, d));
+            std::push_heap(terms.begin(), terms.end());
+            if (terms.size() > maxExpansions) {
+                std::pop_heap(terms.begin(), terms.end());
+                terms.pop_back();
+            }
+            if (terms.size() == maxExpansions) {
+                // only closer terms can replace the ones that were found
+                if (terms.front().distance == 0) {
+                    break;
+                }
+                automaton.setMaxEdits(terms.front().distance - 1);
+            }
+            // the smallest string after t
+            target.assign(t).append(1, '\0');
+        } else {
+            target.assign(t);
+        }
+        ok = automaton.next(target, target) && source.seek(target);
+    }
+    std::sort_heap(terms.begin(), terms.end());
+}
+
+}
+
+#endif
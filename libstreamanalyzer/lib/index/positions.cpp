@@ -0,0 +1,182 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "positions.h"
+#include "indexformat.h"
+
+using namespace Strigi;
+
+void
+Strigi::encodePositions(const std::vector<Posting>& postings,
+        const std::vector<uint32_t>& positions, std::string& out) {
+    std::vector<uint64_t> starts;
+    std::string groups;
+    std::string group;
+    size_t k = 0;
+    for (size_t i = 0; i < postings.size(); ++i) {
+        if (i && i % postingBlockSize == 0) {
+            starts.push_back(groups.length());
+        }
+        group.clear();
+        uint32_t last = 0;
+        for (uint32_t j = 0; j < postings[i].freq && k < positions.size();
+                ++j, ++k) {
+            putVarint(group, positions[k] - last);
+            last = positions[k];
+        }
+        putVarint(groups, group.length());
+        groups.append(group);
+    }
+    std::vector<uint64_t>::const_iterator s;
+    for (s = starts.begin(); s != starts.end(); ++s) {
+        putFixed64(out, *s);
+    }
+    out.append(groups);
+}
+
+bool
+PositionReader::init(const char* data, const char* e, uint32_t n) {
+    const uint64_t blocks = (n) ?(n - 1) / postingBlockSize :0;
+    p = 0;
+    if (data > e || 8 * blocks > (uint64_t)(e - data)) {
+        return false;
+    }
+    table = data;
+    groups = p = data + 8 * blocks;
+    end = e;
+    count = n;
+    current = 0;
+    return true;
+}
+bool
+PositionReader::read(uint32_t index, std::vector<uint32_t>& positions) {
+    positions.clear();
+    if (p == 0 || index >= count) {
+        return false;
+    }
+    const uint32_t block = index / postingBlockSize;
+    if (index < current || block > current / postingBlockSize) {
+        const uint64_t offset = (block)
+            ?getFixed64(table + 8 * (block - 1)) :0;
+        if (offset > (uint64_t)(end - groups)) {
+            p = 0;
+            return false;
+        }
+        p = groups + offset;
+        current = block * postingBlockSize;
+    }
+    uint64_t size;
+    for (; current < index; ++current) {
+        if (!getVarint(p, end, size) || size > (uint64_t)(end - p)) {
+            p = 0;
+            return false;
+        }
+        p += size;
+    }
+    if (!getVarint(p, end, size) || size > (uint64_t)(end - p)) {
+        p = 0;
+        return false;
+    }
+    const char* groupEnd = p + size;
+    uint64_t position = 0, delta;
+    while (p < groupEnd) {
+        if (!getVarint(p, groupEnd, delta)) {
+            positions.clear();
+            p = 0;
+            return false;
+        }
+        position += delta;
+        positions.push_back((uint32_t)position);
+    }
+    ++current;
+    return true;
+}
+
+bool
+Strigi::matchPositions(const std::vector<const std::vector<uint32_t>*>& lists,
+        uint32_t maxGaps, bool ordered) {
+    const int64_t n = (int64_t)lists.size();
+    if (n == 0) {
+        return false;
+    }
+    if (ordered) {
+        // for each start, take the first position of each next list;
+        // if a list has no more positions, later starts do not either
+        const std::vector<uint32_t>& first = *lists[0];
+        std::vector<uint32_t>::const_iterator s;
+        for (s = first.begin(); s != first.end(); ++s) {
+            uint32_t last = *s;
+            for (size_t i = 1; i < lists.size(); ++i) {
+                const std::vector<uint32_t>& l = *lists[i];
+                std::vector<uint32_t>::const_iterator j
+                    = std::upper_bound(l.begin(), l.end(), last);
+                if (j == l.end()) {
+                    return false;
+                }
+                last = *j;
+            }
+            if ((int64_t)last - *s + 1 - n <= (int64_t)maxGaps) {
+                return true;
+            }
+        }
+        return false;
+    }
+    // the different lists and the number of positions needed from each
+    std::vector<const std::vector<uint32_t>*> distinct;
+    std::vector<uint32_t> needed;
+    for (size_t i = 0; i < lists.size(); ++i) {
+        const size_t k = std::find(distinct.begin(), distinct.end(),
+            lists[i]) - distinct.begin();
+        if (k == distinct.size()) {
+            distinct.push_back(lists[i]);
+            needed.push_back(1);
+        } else {
+            ++needed[k];
+        }
+    }
+    // slide a window over the positions of all lists in order
+    std::vector<std::pair<uint32_t, uint32_t> > events;
+    for (uint32_t k = 0; k < distinct.size(); ++k) {
+        std::vector<uint32_t>::const_iterator j;
+        for (j = distinct[k]->begin(); j != distinct[k]->end(); ++j) {
+            events.push_back(std::make_pair(*j, k));
+        }
+    }
+    std::sort(events.begin(), events.end());
+    std::vector<uint32_t> have(distinct.size(), 0);
+    size_t missing = distinct.size();
+    size_t lo = 0;
+    for (size_t hi = 0; hi < events.size(); ++hi) {
+        if (++have[events[hi].second] == needed[events[hi].second]) {
+            --missing;
+        }
+        while (missing == 0) {
+            if ((int64_t)events[hi].first - events[lo].first + 1 - n
+                    <= (int64_t)maxGaps) {
+                return true;
+            }
+            const uint32_t k = events[lo++].second;
+            if (have[k]-- == needed[k]) {
+                ++missing;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,99 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_POSITIONS_H
+#define STRIGI_POSITIONS_H
+
+#include "postinglist.h"
+
+/*
+ * The positions of a term in the documents that contain it.
+ *
+ * The positions of each posting are written after each other in the order
+ * of the postings, so the positions of the n-th posting of a list are the
+ * n-th group. A table with the offset of the group of the first posting of
+ * each block of postingBlockSize postings comes first, so a reader that
+ * skips blocks of postings can skip their positions too. The first block
+ * starts right after the table and has no entry.
+ *
+ *  block table    per block after the first: offset of its first group
+ *                 from the end of the table (fixed64)
+ *  groups         per posting: size of the group in bytes (varint),
+ *                 per position: difference to the previous position or
+ *                 to 0 (varint)
+ */
+namespace Strigi {
+
+/**
+ * Append the positions of @p postings to @p out. @p positions has the
+ * sorted positions of each posting after each other, as many as the
+ * frequency of the posting.
+ **/
+void encodePositions(const std::vector<Posting>& postings,
+    const std::vector<uint32_t>& positions, std::string& out);
+
+/**
+ * Reads the positions that were written by encodePositions(). The groups
+ * are read in increasing order of the posting, which is the index of the
+ * posting in a PostingIterator over the same list.
+ *
+ * The reader does not own the data. If the data is damaged, no positions
+ * are read.
+ **/
+class PositionReader {
+private:
+    const char* table;
+    const char* groups;
+    const char* end;
+    uint32_t count;
+    // the posting of the group at p
+    uint32_t current;
+    const char* p;
+public:
+    PositionReader() :table(0), groups(0), end(0), count(0), current(0),
+        p(0) {}
+    /**
+     * Start reading the positions of a list of @p count postings at
+     * @p data. The positions must end before @p end.
+     * @return false if the table of blocks does not fit
+     **/
+    bool init(const char* data, const char* end, uint32_t count);
+    /**
+     * Replace @p positions by the positions of the posting @p index.
+     * @return false if the posting is before the last one read or if the
+     *         positions are damaged
+     **/
+    bool read(uint32_t index, std::vector<uint32_t>& positions);
+};
+
+/**
+ * @return true if @p lists have one position each, with at most
+ * @p maxGaps positions between the first and the last of them that are
+ * not one of them. If @p ordered is true, the positions must be in the
+ * order of @p lists. Each list must be sorted. A list that occurs more
+ * than once, for a word that occurs more than once in a phrase, needs as
+ * many different positions.
+ **/
+bool matchPositions(const std::vector<const std::vector<uint32_t>*>& lists,
+    uint32_t maxGaps, bool ordered);
+
+}
+
+#endif
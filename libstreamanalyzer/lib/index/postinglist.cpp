@@ -0,0 +1,347 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "postinglist.h"
+#include "indexformat.h"
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace Strigi;
+
+namespace {
+/**
+ * The size of an entry in the skip table.
+ **/
+const uint32_t skipSize = 12;
+/**
+ * Unpack postingBlockSize values of B bits. The values are interleaved in
+ * four lanes of 32 bit words: value 4 * k + l is in lane l at bit k * B.
+ **/
+template <unsigned B>
+void
+unpack(const char* in, uint32_t* out) {
+    if (B == 0) {
+        memset(out, 0, postingBlockSize * sizeof(uint32_t));
+        return;
+    }
+    const uint32_t mask = (uint32_t)(((uint64_t)1 << B) - 1);
+#if defined(__SSE2__)
+    const __m128i* w = reinterpret_cast<const __m128i*>(in);
+    const __m128i m = _mm_set1_epi32((int)mask);
+    for (unsigned k = 0; k < postingBlockSize / 4; ++k) {
+        const unsigned bit = k * B;
+        const unsigned s = bit & 31;
+        __m128i v = _mm_srl_epi32(_mm_loadu_si128(w + (bit >> 5)),
+            _mm_cvtsi32_si128((int)s));
+        if (s + B > 32) {
+            v = _mm_or_si128(v, _mm_sll_epi32(
+                _mm_loadu_si128(w + (bit >> 5) + 1),
+                _mm_cvtsi32_si128((int)(32 - s))));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * k),
+            _mm_and_si128(v, m));
+    }
+#else
+    uint32_t w[4 * B + 4];
+    for (unsigned i = 0; i < 4 * B; ++i) {
+        w[i] = getFixed32(in + 4 * i);
+    }
+    for (unsigned k = 0; k < postingBlockSize / 4; ++k) {
+        const unsigned bit = k * B;
+        const unsigned s = bit & 31;
+        const uint32_t* lo = w + 4 * (bit >> 5);
+        for (unsigned l = 0; l < 4; ++l) {
+            uint32_t v = lo[l] >> s;
+            if (s + B > 32) {
+                v |= lo[l + 4] << (32 - s);
+            }
+            out[4 * k + l] = v & mask;
+        }
+    }
+#endif
+}
+typedef void (*Unpacker)(const char*, uint32_t*);
+const Unpacker unpackers[33] = {
+    unpack<0>, unpack<1>, unpack<2>, unpack<3>, unpack<4>, unpack<5>,
+    unpack<6>, unpack<7>, unpack<8>, unpack<9>, unpack<10>, unpack<11>,
+    unpack<12>, unpack<13>, unpack<14>, unpack<15>, unpack<16>, unpack<17>,
+    unpack<18>, unpack<19>, unpack<20>, unpack<21>, unpack<22>, unpack<23>,
+    unpack<24>, unpack<25>, unpack<26>, unpack<27>, unpack<28>, unpack<29>,
+    unpack<30>, unpack<31>, unpack<32>
+};
+/**
+ * Replace the differences in @p v by the documents, starting at @p base.
+ **/
+void
+prefixSum(uint32_t* v, uint32_t base) {
+#if defined(__SSE2__)
+    __m128i prev = _mm_set1_epi32((int)base);
+    for (unsigned k = 0; k < postingBlockSize / 4; ++k) {
+        __m128i* p = reinterpret_cast<__m128i*>(v + 4 * k);
+        __m128i x = _mm_loadu_si128(p);
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, prev);
+        _mm_storeu_si128(p, x);
+        prev = _mm_shuffle_epi32(x, 0xff);
+    }
+#else
+    for (unsigned i = 0; i < postingBlockSize; ++i) {
+        base += v[i];
+        v[i] = base;
+    }
+#endif
+}
+unsigned
+blockBits(const uint32_t* v) {
+    uint32_t m = 0;
+    for (unsigned i = 0; i < postingBlockSize; ++i) {
+        m |= v[i];
+    }
+    unsigned bits = 0;
+    while (m) {
+        ++bits;
+        m >>= 1;
+    }
+    return bits;
+}
+void
+pack(const uint32_t* in, unsigned bits, std::string& out) {
+    uint32_t w[4 * 32];
+    memset(w, 0, sizeof(w));
+    for (unsigned k = 0; k < postingBlockSize / 4; ++k) {
+        const unsigned bit = k * bits;
+        const unsigned s = bit & 31;
+        uint32_t* lo = w + 4 * (bit >> 5);
+        for (unsigned l = 0; l < 4; ++l) {
+            const uint32_t v = in[4 * k + l];
+            lo[l] |= v << s;
+            if (s + bits > 32) {
+                lo[l + 4] |= v >> (32 - s);
+            }
+        }
+    }
+    for (unsigned i = 0; i < 4 * bits; ++i) {
+        putFixed32(out, w[i]);
+    }
+}
+}
+
+void
+Strigi::encodePostings(const std::vector<Posting>& postings,
+        std::string& out) {
+    const uint32_t count = (uint32_t)postings.size();
+    const uint32_t nblocks = count / postingBlockSize;
+    std::string skips;
+    std::string blocks;
+    uint32_t deltas[postingBlockSize];
+    uint32_t freqs[postingBlockSize];
+    uint32_t last = 0;
+    uint32_t maxFreq = 0;
+    std::vector<Posting>::const_iterator p = postings.begin();
+    for (uint32_t b = 0; b < nblocks; ++b) {
+        uint32_t blockMax = 0;
+        for (uint32_t i = 0; i < postingBlockSize; ++i, ++p) {
+            deltas[i] = p->doc - last;
+            freqs[i] = p->freq - 1;
+            blockMax = std::max(blockMax, p->freq);
+            last = p->doc;
+        }
+        unsigned bits = blockBits(deltas);
+        blocks.append(1, (char)bits);
+        pack(deltas, bits, blocks);
+        bits = blockBits(freqs);
+        blocks.append(1, (char)bits);
+        pack(freqs, bits, blocks);
+        putFixed32(skips, last);
+        putFixed32(skips, (uint32_t)blocks.length());
+        putFixed32(skips, blockMax);
+        maxFreq = std::max(maxFreq, blockMax);
+    }
+    for (std::vector<Posting>::const_iterator i = p; i != postings.end(); ++i) {
+        maxFreq = std::max(maxFreq, i->freq);
+    }
+    putVarint(out, count);
+    putVarint(out, maxFreq);
+    out.append(skips);
+    out.append(blocks);
+    for (; p != postings.end(); ++p) {
+        putVarint(out, (uint64_t)(p->doc - last) << 1 | (p->freq == 1));
+        if (p->freq != 1) {
+            putVarint(out, p->freq);
+        }
+        last = p->doc;
+    }
+}
+
+/**
+ * @return the first block from @p b on that ends at or after @p target or
+ *         the number of full blocks if there is none
+ **/
+uint32_t
+PostingIterator::findBlock(uint32_t b, uint32_t target) const {
+    uint32_t hi = nblocks;
+    while (b < hi) {
+        const uint32_t mid = b + (hi - b) / 2;
+        if (lastDoc(mid) < target) {
+            b = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return b;
+}
+bool
+PostingIterator::init(const char* data, const char* e) {
+    const char* p = data;
+    uint64_t c, max;
+    count = 0;
+    n = pos = 0;
+    m_doc = noMoreDocs;
+    if (!getVarint(p, e, c) || c > 0xffffffff || !getVarint(p, e, max)
+            || max > 0xffffffff) {
+        return false;
+    }
+    nblocks = (uint32_t)(c / postingBlockSize);
+    if ((uint64_t)nblocks * skipSize > (uint64_t)(e - p)) {
+        return false;
+    }
+    skips = p;
+    blocks = skips + skipSize * nblocks;
+    tail = blocks;
+    if (nblocks) {
+        const uint32_t size = blockEnd(nblocks - 1);
+        if (size > (uint64_t)(e - blocks)) {
+            return false;
+        }
+        tail += size;
+    }
+    end = e;
+    count = (uint32_t)c;
+    m_maxFreq = (uint32_t)max;
+    shallowBlock = 0;
+    nextBlock(0);
+    return true;
+}
+uint32_t
+PostingIterator::lastDoc(uint32_t b) const {
+    return getFixed32(skips + skipSize * b);
+}
+uint32_t
+PostingIterator::blockEnd(uint32_t b) const {
+    return getFixed32(skips + skipSize * b + 4);
+}
+/**
+ * Decode block @p b or the tail if @p b is the number of full blocks.
+ * @return the first document of the block
+ **/
+uint32_t
+PostingIterator::nextBlock(uint32_t b) {
+    block = b;
+    pos = 0;
+    if ((b < nblocks && decodeBlock(b))
+            || (b == nblocks && count % postingBlockSize && decodeTail())) {
+        return m_doc = docs[0];
+    }
+    block = nblocks + 1;
+    n = 0;
+    return m_doc = noMoreDocs;
+}
+bool
+PostingIterator::decodeBlock(uint32_t b) {
+    const uint32_t start = (b) ?blockEnd(b - 1) :0;
+    const uint32_t stop = blockEnd(b);
+    const char* p = blocks + start;
+    const char* e = blocks + stop;
+    if (start >= stop || e > tail) {
+        return false;
+    }
+    const unsigned docBits = (unsigned char)*p++;
+    if (docBits > 32 || 16 * docBits + 1 > (size_t)(e - p)) {
+        return false;
+    }
+    unpackers[docBits](p, docs);
+    p += 16 * docBits;
+    const unsigned freqBits = (unsigned char)*p++;
+    if (freqBits > 32 || 16 * freqBits != (size_t)(e - p)) {
+        return false;
+    }
+    unpackers[freqBits](p, freqs);
+    prefixSum(docs, (b) ?lastDoc(b - 1) :0);
+    for (uint32_t i = 0; i < postingBlockSize; ++i) {
+        ++freqs[i];
+    }
+    n = postingBlockSize;
+    return docs[postingBlockSize - 1] == lastDoc(b);
+}
+bool
+PostingIterator::decodeTail() {
+    const char* p = tail;
+    uint32_t doc = (nblocks) ?lastDoc(nblocks - 1) :0;
+    n = count % postingBlockSize;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint64_t v, freq = 1;
+        if (!getVarint(p, end, v) || (!(v & 1) && !getVarint(p, end, freq))) {
+            return false;
+        }
+        doc += (uint32_t)(v >> 1);
+        docs[i] = doc;
+        freqs[i] = (uint32_t)freq;
+    }
+    return true;
+}
+uint32_t
+PostingIterator::advance(uint32_t target) {
+    if (m_doc >= target) {
+        return m_doc;
+    }
+    if (target > docs[n - 1]) {
+        if (block >= nblocks) {
+            return nextBlock(nblocks + 1);
+        }
+        if (nextBlock(findBlock(block + 1, target)) >= target) {
+            return m_doc;
+        }
+    }
+    pos = (uint32_t)(std::lower_bound(docs + pos, docs + n, target) - docs);
+    if (pos == n) {
+        return nextBlock(nblocks + 1);
+    }
+    return m_doc = docs[pos];
+}
+uint32_t
+PostingIterator::shallowAdvance(uint32_t target) {
+    shallowBlock = findBlock(std::max(shallowBlock, std::min(block, nblocks)),
+        target);
+    return (shallowBlock < nblocks) ?lastDoc(shallowBlock) :noMoreDocs;
+}
+uint32_t
+PostingIterator::maxFreq(uint32_t upTo) const {
+    uint32_t max = 0;
+    for (uint32_t b = shallowBlock; b < nblocks; ++b) {
+        max = std::max(max, getFixed32(skips + skipSize * b + 8));
+        if (lastDoc(b) >= upTo) {
+            return max;
+        }
+    }
+    return m_maxFreq;
+}
@@ -0,0 +1,214 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_POSTINGLIST_H
+#define STRIGI_POSTINGLIST_H
+
+#include "segmentwriter.h"
+#include <algorithm>
+
+/*
+ * A compressed list of postings.
+ *
+ * The postings are stored in blocks of postingBlockSize documents. In each
+ * block, the differences between the document numbers and the frequencies
+ * minus one are packed with as many bits as the largest of them needs.
+ * The values are interleaved in four lanes, so four of them can be
+ * unpacked with one SIMD instruction. A table with the last document, the
+ * end and the largest frequency of each block comes before the blocks, so
+ * a reader can skip blocks and bound their scores without decoding them.
+ * The postings that do not fill a block are written as variable length
+ * numbers at the end.
+ *
+ *  count            varint
+ *  max frequency    varint
+ *  skip table       per block: last document (fixed32), end (fixed32),
+ *                              max frequency (fixed32)
+ *  blocks           per block: bits (byte), packed differences,
+ *                              bits (byte), packed frequencies - 1
+ *  tail             per posting: difference << 1 | (freq == 1) (varint),
+ *                                freq if it is not 1 (varint)
+ */
+namespace Strigi {
+
+const uint32_t postingBlockSize = 128;
+
+/**
+ * Append @p postings to @p out. The postings must be sorted by document and
+ * each document may occur only once.
+ **/
+void encodePostings(const std::vector<Posting>& postings, std::string& out);
+
+/**
+ * Reads a list that was written by encodePostings(). Only the block that
+ * contains the current document is decoded.
+ *
+ * The iterator does not own the data. If the data is damaged, the list
+ * ends early.
+ **/
+class PostingIterator {
+public:
+    /**
+     * The document number after the end of the list.
+     **/
+    static const uint32_t noMoreDocs = 0xffffffff;
+
+    PostingIterator() :count(0), m_doc(noMoreDocs) {}
+    /**
+     * Start reading the list at @p data. The list must end before @p end.
+     * The iterator is positioned on the first document.
+     * @return false if the start of the list is damaged
+     **/
+    bool init(const char* data, const char* end);
+    /**
+     * @return the number of postings in the list
+     **/
+    uint32_t size() const { return count; }
+    /**
+     * @return the largest frequency in the list
+     **/
+    uint32_t maxFreq() const { return m_maxFreq; }
+    /**
+     * @return the current document or noMoreDocs
+     **/
+    uint32_t doc() const { return m_doc; }
+    uint32_t freq() const { return freqs[pos]; }
+    /**
+     * @return the number of postings before the current one
+     **/
+    uint32_t index() const { return block * postingBlockSize + pos; }
+    /**
+     * Move to the next document.
+     * @return the new current document
+     **/
+    uint32_t next() {
+        if (++pos < n) {
+            return m_doc = docs[pos];
+        }
+        return nextBlock(block + 1);
+    }
+    /**
+     * Move to the first document that is not smaller than @p target.
+     * Blocks that end before @p target are skipped without decoding them.
+     * @return the new current document
+     **/
+    uint32_t advance(uint32_t target);
+    /**
+     * Find the block that contains @p target without decoding it. The
+     * current document does not change.
+     * @return the last document of the block or noMoreDocs for the
+     *         postings after the last full block
+     **/
+    uint32_t shallowAdvance(uint32_t target);
+    /**
+     * @return the largest frequency of the documents from the block found
+     *         by shallowAdvance() up to @p upTo
+     **/
+    uint32_t maxFreq(uint32_t upTo) const;
+private:
+    const char* skips;
+    const char* blocks;
+    const char* tail;
+    const char* end;
+    uint32_t count;
+    uint32_t m_maxFreq;
+    // the number of full blocks
+    uint32_t nblocks;
+    // the decoded block and the position in it
+    uint32_t block;
+    uint32_t n;
+    uint32_t pos;
+    uint32_t m_doc;
+    // the block found by shallowAdvance()
+    uint32_t shallowBlock;
+    uint32_t docs[postingBlockSize];
+    uint32_t freqs[postingBlockSize];
+
+    uint32_t lastDoc(uint32_t b) const;
+    uint32_t blockEnd(uint32_t b) const;
+    uint32_t findBlock(uint32_t b, uint32_t target) const;
+    uint32_t nextBlock(uint32_t b);
+    bool decodeBlock(uint32_t b);
+    bool decodeTail();
+};
+
+/**
+ * Call @p f for each document that is in all @p lists, like Query::And.
+ * When @p f is called, all lists are positioned on the document, so their
+ * frequencies can be read. The shortest list proposes documents and the
+ * others skip ahead to them.
+ **/
+template <class F>
+void
+intersectPostings(std::vector<PostingIterator*> lists, F f) {
+    if (lists.empty()) {
+        return;
+    }
+    std::sort(lists.begin(), lists.end(),
+        [](const PostingIterator* a, const PostingIterator* b) {
+            return a->size() < b->size();
+        });
+    PostingIterator& lead = *lists[0];
+    uint32_t doc = lead.doc();
+    while (doc != PostingIterator::noMoreDocs) {
+        size_t i = 1;
+        for (; i < lists.size(); ++i) {
+            const uint32_t d = lists[i]->advance(doc);
+            if (d != doc) {
+                doc = lead.advance(d);
+                break;
+            }
+        }
+        if (i == lists.size()) {
+            f(doc);
+            doc = lead.next();
+        }
+    }
+}
+
+/**
+ * Call @p f for each document that is in any of @p lists, like Query::Or.
+ * When @p f is called, the lists that contain the document are positioned
+ * on it.
+ **/
+template <class F>
+void
+unitePostings(const std::vector<PostingIterator*>& lists, F f) {
+    for (;;) {
+        uint32_t doc = PostingIterator::noMoreDocs;
+        std::vector<PostingIterator*>::const_iterator i;
+        for (i = lists.begin(); i != lists.end(); ++i) {
+            doc = std::min(doc, (*i)->doc());
+        }
+        if (doc == PostingIterator::noMoreDocs) {
+            return;
+        }
+        f(doc);
+        for (i = lists.begin(); i != lists.end(); ++i) {
+            if ((*i)->doc() == doc) {
+                (*i)->next();
+            }
+        }
+    }
+}
+
+}
+
+#endif
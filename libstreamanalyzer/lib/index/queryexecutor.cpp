@@ -0,0 +1,603 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "queryexecutor.h"
+#include <strigi/query.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Strigi;
+
+namespace {
+/**
+ * @return true if a document with a score of at most @p bound can beat
+ *         @p minScore. The bound is raised a little, because scores that
+ *         are added in another order can differ in the last bits.
+ **/
+bool
+competitive(float bound, float minScore) {
+    return bound + std::fabs(bound) * 1e-5f > minScore;
+}
+/**
+ * @return the bound of a child of an Or; a child that does not match a
+ *         document does not lower its score
+ **/
+float
+optional(float bound) {
+    return std::max(bound, 0.0f);
+}
+uint32_t
+after(uint32_t doc) {
+    return (doc == DocIterator::noMoreDocs) ?doc :doc + 1;
+}
+void
+deleteAll(std::vector<DocIterator*>& iterators) {
+    std::vector<DocIterator*>::const_iterator i;
+    for (i = iterators.begin(); i != iterators.end(); ++i) {
+        delete *i;
+    }
+    iterators.clear();
+}
+
+/**
+ * The documents that all children match.
+ **/
+class ConjunctionIterator : public DocIterator {
+private:
+    // sorted by cost, so the rarest child proposes the documents
+    std::vector<DocIterator*> children;
+    float minScore;
+    bool pruning;
+    // the end of the blocks for which blockBound was computed
+    uint32_t upTo;
+    float blockBound;
+    float m_maxScore;
+
+    uint32_t doNext(uint32_t doc);
+public:
+    explicit ConjunctionIterator(const std::vector<DocIterator*>& c);
+    ~ConjunctionIterator() { deleteAll(children); }
+    uint32_t next() {
+        return m_doc = doNext(children[0]->next());
+    }
+    uint32_t advance(uint32_t target) {
+        if (m_doc >= target) {
+            return m_doc;
+        }
+        return m_doc = doNext(children[0]->advance(target));
+    }
+    float score();
+    uint64_t cost() const { return children[0]->cost(); }
+    float maxScore() const { return m_maxScore; }
+    uint32_t shallowAdvance(uint32_t target);
+    float blockMaxScore(uint32_t upTo);
+    void setMinScore(float score) {
+        minScore = score;
+        pruning = true;
+    }
+};
+ConjunctionIterator::ConjunctionIterator(const std::vector<DocIterator*>& c)
+        :children(c), minScore(0), pruning(false), upTo(0), blockBound(0),
+         m_maxScore(0) {
+    std::stable_sort(children.begin(), children.end(),
+        [](const DocIterator* a, const DocIterator* b) {
+            return a->cost() < b->cost();
+        });
+    for (size_t i = 0; i < children.size(); ++i) {
+        m_maxScore += children[i]->maxScore();
+    }
+    m_doc = doNext(children[0]->doc());
+}
+uint32_t
+ConjunctionIterator::doNext(uint32_t doc) {
+    for (;;) {
+        if (doc == noMoreDocs) {
+            return doc;
+        }
+        if (pruning) {
+            if (doc > upTo || upTo == 0) {
+                upTo = shallowAdvance(doc);
+                blockBound = blockMaxScore(upTo);
+            }
+            if (!competitive(blockBound, minScore)) {
+                // no document up to the end of the blocks can be good enough
+                doc = children[0]->advance(after(upTo));
+                continue;
+            }
+        }
+        size_t i = 1;
+        for (; i < children.size(); ++i) {
+            const uint32_t d = children[i]->advance(doc);
+            if (d != doc) {
+                doc = children[0]->advance(d);
+                break;
+            }
+        }
+        if (i == children.size()) {
+            return doc;
+        }
+    }
+}
+float
+ConjunctionIterator::score() {
+    float score = 0;
+    for (size_t i = 0; i < children.size(); ++i) {
+        score += children[i]->score();
+    }
+    return score;
+}
+uint32_t
+ConjunctionIterator::shallowAdvance(uint32_t target) {
+    uint32_t end = noMoreDocs;
+    for (size_t i = 0; i < children.size(); ++i) {
+        end = std::min(end, children[i]->shallowAdvance(target));
+    }
+    return end;
+}
+float
+ConjunctionIterator::blockMaxScore(uint32_t end) {
+    float score = 0;
+    for (size_t i = 0; i < children.size(); ++i) {
+        score += children[i]->blockMaxScore(end);
+    }
+    return score;
+}
+
+/**
+ * The documents that any child matches.
+ **/
+class DisjunctionIterator : public DocIterator {
+private:
+    std::vector<DocIterator*> children;
+    float minScore;
+    bool pruning;
+    float m_maxScore;
+    uint64_t m_cost;
+
+    uint32_t firstDoc() const;
+    uint32_t nextCandidate();
+public:
+    explicit DisjunctionIterator(const std::vector<DocIterator*>& c);
+    ~DisjunctionIterator() { deleteAll(children); }
+    uint32_t next() { return advance(after(m_doc)); }
+    uint32_t advance(uint32_t target);
+    float score();
+    uint64_t cost() const { return m_cost; }
+    float maxScore() const { return m_maxScore; }
+    uint32_t shallowAdvance(uint32_t target);
+    float blockMaxScore(uint32_t upTo);
+    void setMinScore(float score) {
+        minScore = score;
+        pruning = true;
+    }
+};
+DisjunctionIterator::DisjunctionIterator(const std::vector<DocIterator*>& c)
+        :children(c), minScore(0), pruning(false), m_maxScore(0), m_cost(0) {
+    for (size_t i = 0; i < children.size(); ++i) {
+        m_maxScore += optional(children[i]->maxScore());
+        m_cost += children[i]->cost();
+    }
+    m_doc = firstDoc();
+}
+uint32_t
+DisjunctionIterator::firstDoc() const {
+    uint32_t doc = noMoreDocs;
+    for (size_t i = 0; i < children.size(); ++i) {
+        doc = std::min(doc, children[i]->doc());
+    }
+    return doc;
+}
+uint32_t
+DisjunctionIterator::advance(uint32_t target) {
+    if (m_doc >= target) {
+        return m_doc;
+    }
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (children[i]->doc() < target) {
+            children[i]->advance(target);
+        }
+    }
+    return m_doc = (pruning) ?nextCandidate() :firstDoc();
+}
+/**
+ * Find the first document that may have a score above minScore. The
+ * children are sorted by their current document; the pivot is the first
+ * document at which the children up to it can reach minScore together.
+ * Documents before the pivot cannot, so the children are advanced to it.
+ **/
+uint32_t
+DisjunctionIterator::nextCandidate() {
+    const size_t n = children.size();
+    for (;;) {
+        std::sort(children.begin(), children.end(),
+            [](const DocIterator* a, const DocIterator* b) {
+                return a->doc() < b->doc();
+            });
+        float bound = 0;
+        size_t p = 0;
+        for (; p < n && children[p]->doc() != noMoreDocs; ++p) {
+            bound += optional(children[p]->maxScore());
+            if (competitive(bound, minScore)) {
+                break;
+            }
+        }
+        if (p == n || children[p]->doc() == noMoreDocs) {
+            return noMoreDocs;
+        }
+        const uint32_t pivot = children[p]->doc();
+        while (p + 1 < n && children[p + 1]->doc() == pivot) {
+            ++p;
+        }
+        // the children after the pivot do not match up to upTo; check if
+        // the blocks of the others can reach minScore
+        uint32_t upTo = (p + 1 < n) ?children[p + 1]->doc() - 1 :noMoreDocs;
+        for (size_t i = 0; i <= p; ++i) {
+            upTo = std::min(upTo, children[i]->shallowAdvance(pivot));
+        }
+        float blockBound = 0;
+        for (size_t i = 0; i <= p; ++i) {
+            blockBound += optional(children[i]->blockMaxScore(upTo));
+        }
+        if (!competitive(blockBound, minScore)) {
+            if (upTo == noMoreDocs) {
+                return noMoreDocs;
+            }
+            for (size_t i = 0; i <= p; ++i) {
+                children[i]->advance(upTo + 1);
+            }
+            continue;
+        }
+        if (children[0]->doc() == pivot) {
+            return pivot;
+        }
+        for (size_t i = 0; i < p && children[i]->doc() < pivot; ++i) {
+            children[i]->advance(pivot);
+        }
+    }
+}
+float
+DisjunctionIterator::score() {
+    float score = 0;
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (children[i]->doc() == m_doc) {
+            score += children[i]->score();
+        }
+    }
+    return score;
+}
+uint32_t
+DisjunctionIterator::shallowAdvance(uint32_t target) {
+    uint32_t end = noMoreDocs;
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (children[i]->doc() != noMoreDocs) {
+            end = std::min(end, children[i]->shallowAdvance(
+                std::max(target, children[i]->doc())));
+        }
+    }
+    return end;
+}
+float
+DisjunctionIterator::blockMaxScore(uint32_t upTo) {
+    float score = 0;
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (children[i]->doc() <= upTo) {
+            score += optional(children[i]->blockMaxScore(upTo));
+        }
+    }
+    return score;
+}
+
+/**
+ * The documents of one iterator that another one does not return.
+ **/
+class ExclusionIterator : public DocIterator {
+private:
+    DocIterator* const include;
+    DocIterator* const exclude;
+
+    uint32_t skipExcluded(uint32_t doc) {
+        while (doc != noMoreDocs && exclude->advance(doc) == doc) {
+            doc = include->next();
+        }
+        return doc;
+    }
+public:
+    ExclusionIterator(DocIterator* i, DocIterator* e) :include(i), exclude(e) {
+        m_doc = skipExcluded(include->doc());
+    }
+    ~ExclusionIterator() {
+        delete include;
+        delete exclude;
+    }
+    uint32_t next() { return m_doc = skipExcluded(include->next()); }
+    uint32_t advance(uint32_t target) {
+        if (m_doc >= target) {
+            return m_doc;
+        }
+        return m_doc = skipExcluded(include->advance(target));
+    }
+    float score() { return include->score(); }
+    uint64_t cost() const { return include->cost(); }
+    float maxScore() const { return include->maxScore(); }
+    uint32_t shallowAdvance(uint32_t target) {
+        return include->shallowAdvance(target);
+    }
+    float blockMaxScore(uint32_t upTo) {
+        return include->blockMaxScore(upTo);
+    }
+    void setMinScore(float score) { include->setMinScore(score); }
+};
+
+/**
+ * Multiplies the scores of an iterator.
+ **/
+class BoostIterator : public DocIterator {
+private:
+    DocIterator* const child;
+    const float boost;
+
+    float bound(float score) const {
+        // the scores cannot be bounded if they change sign
+        return (boost >= 0) ?score * boost :std::numeric_limits<float>::max();
+    }
+public:
+    BoostIterator(DocIterator* c, float b) :child(c), boost(b) {
+        m_doc = child->doc();
+    }
+    ~BoostIterator() { delete child; }
+    uint32_t next() { return m_doc = child->next(); }
+    uint32_t advance(uint32_t target) {
+        return m_doc = child->advance(target);
+    }
+    float score() { return boost * child->score(); }
+    uint64_t cost() const { return child->cost(); }
+    float maxScore() const { return bound(child->maxScore()); }
+    uint32_t shallowAdvance(uint32_t target) {
+        return child->shallowAdvance(target);
+    }
+    float blockMaxScore(uint32_t upTo) {
+        return bound(child->blockMaxScore(upTo));
+    }
+    void setMinScore(float score) {
+        if (boost > 0) {
+            const float min = score / boost;
+            child->setMinScore(min - std::fabs(min) * 1e-5f);
+        }
+    }
+};
+
+DocIterator* compile(const Query& q, DocIteratorSource& source);
+
+/**
+ * Compile @p q, ignoring q.negate().
+ **/
+DocIterator*
+compilePositive(const Query& q, DocIteratorSource& source) {
+    if (q.type() != Query::And && q.type() != Query::Or) {
+        return source.leaf(q);
+    }
+    std::vector<DocIterator*> positive;
+    std::vector<DocIterator*> negative;
+    const std::vector<Query>& subs = q.subQueries();
+    std::vector<Query>::const_iterator i;
+    if (q.type() == Query::And) {
+        for (i = subs.begin(); i != subs.end(); ++i) {
+            if (i->negate()) {
+                continue;
+            }
+            DocIterator* it = compilePositive(*i, source);
+            if (it == 0) {
+                deleteAll(positive);
+                return 0;
+            }
+            positive.push_back(it);
+        }
+        if (positive.empty()) {
+            if (subs.empty()) {
+                return 0;
+            }
+            // only negated subqueries
+            DocIterator* all = source.allDocuments();
+            if (all == 0) {
+                return 0;
+            }
+            positive.push_back(all);
+        }
+        for (i = subs.begin(); i != subs.end(); ++i) {
+            if (i->negate()) {
+                DocIterator* it = compilePositive(*i, source);
+                if (it) {
+                    negative.push_back(it);
+                }
+            }
+        }
+    } else {
+        for (i = subs.begin(); i != subs.end(); ++i) {
+            DocIterator* it = compile(*i, source);
+            if (it) {
+                positive.push_back(it);
+            }
+        }
+        if (positive.empty()) {
+            return 0;
+        }
+    }
+    DocIterator* it;
+    if (positive.size() == 1) {
+        it = positive[0];
+    } else if (q.type() == Query::And) {
+        it = new ConjunctionIterator(positive);
+    } else {
+        it = new DisjunctionIterator(positive);
+    }
+    if (negative.size()) {
+        it = new ExclusionIterator(it, (negative.size() == 1)
+            ?negative[0] :new DisjunctionIterator(negative));
+    }
+    if (q.boost() != 1) {
+        it = new BoostIterator(it, q.boost());
+    }
+    return it;
+}
+DocIterator*
+compile(const Query& q, DocIteratorSource& source) {
+    DocIterator* it = compilePositive(q, source);
+    if (!q.negate()) {
+        return it;
+    }
+    DocIterator* all = source.allDocuments();
+    if (all == 0 || it == 0) {
+        return all;
+    }
+    return new ExclusionIterator(all, it);
+}
+}
+
+ListDocIterator::ListDocIterator(std::vector<std::pair<uint32_t, float> > h,
+        uint32_t size) :blockSize(size), pos(0), shallowBlock(0),
+        m_maxScore(-std::numeric_limits<float>::max()), minScore(0),
+        pruning(false) {
+    hits.swap(h);
+    for (size_t i = 0; i < hits.size(); ++i) {
+        if (i % blockSize == 0) {
+            blockMax.push_back(hits[i].second);
+        } else {
+            blockMax.back() = std::max(blockMax.back(), hits[i].second);
+        }
+        m_maxScore = std::max(m_maxScore, hits[i].second);
+    }
+    m_doc = (hits.empty()) ?noMoreDocs :hits[0].first;
+}
+/**
+ * Skip the documents that cannot beat minScore.
+ **/
+uint32_t
+ListDocIterator::skip() {
+    while (pruning && pos < hits.size() && hits[pos].second <= minScore) {
+        ++pos;
+    }
+    return m_doc = (pos < hits.size()) ?hits[pos].first :noMoreDocs;
+}
+uint32_t
+ListDocIterator::next() {
+    if (pos < hits.size()) {
+        ++pos;
+    }
+    return skip();
+}
+uint32_t
+ListDocIterator::advance(uint32_t target) {
+    if (m_doc >= target) {
+        return m_doc;
+    }
+    pos = std::lower_bound(hits.begin() + pos, hits.end(),
+        std::make_pair(target, -std::numeric_limits<float>::max())) - hits.begin();
+    return skip();
+}
+uint32_t
+ListDocIterator::shallowAdvance(uint32_t target) {
+    shallowBlock = pos / blockSize;
+    while (shallowBlock < blockMax.size()) {
+        const uint32_t last = hits[std::min(hits.size(),
+            (shallowBlock + 1) * blockSize) - 1].first;
+        if (last >= target) {
+            return last;
+        }
+        ++shallowBlock;
+    }
+    return noMoreDocs;
+}
+float
+ListDocIterator::blockMaxScore(uint32_t upTo) {
+    float score = -std::numeric_limits<float>::max();
+    for (size_t b = shallowBlock; b < blockMax.size(); ++b) {
+        score = std::max(score, blockMax[b]);
+        if (hits[std::min(hits.size(), (b + 1) * blockSize) - 1].first >= upTo) {
+            break;
+        }
+    }
+    return score;
+}
+void
+ListDocIterator::setMinScore(float score) {
+    minScore = score;
+    pruning = true;
+}
+
+DocIterator*
+Strigi::newConjunction(const std::vector<DocIterator*>& children) {
+    return (children.size() == 1)
+        ?children[0] :new ConjunctionIterator(children);
+}
+DocIterator*
+Strigi::newDisjunction(const std::vector<DocIterator*>& children) {
+    return (children.size() == 1)
+        ?children[0] :new DisjunctionIterator(children);
+}
+DocIterator*
+Strigi::compileQuery(const Query& q, DocIteratorSource& source) {
+    return compile(q, source);
+}
+uint32_t
+Strigi::countMatches(DocIterator& it, const DocIteratorSource& source) {
+    uint32_t n = 0;
+    for (uint32_t d = it.doc(); d != DocIterator::noMoreDocs; d = it.next()) {
+        n += source.isLive(d);
+    }
+    return n;
+}
+
+void
+TopDocs::collect(DocIterator& it, uint32_t segment,
+        const DocIteratorSource& source) {
+    if (k && heap.size() == k) {
+        it.setMinScore(heap.front().score);
+    }
+    Hit hit;
+    hit.segment = segment;
+    for (uint32_t d = it.doc(); d != DocIterator::noMoreDocs; d = it.next()) {
+        if (!source.isLive(d)) {
+            continue;
+        }
+        hit.doc = d;
+        hit.score = it.score();
+        if (k == 0 || heap.size() < k) {
+            heap.push_back(hit);
+            if (k) {
+                std::push_heap(heap.begin(), heap.end());
+                if (heap.size() == k) {
+                    it.setMinScore(heap.front().score);
+                }
+            }
+        } else if (hit < heap.front()) {
+            std::pop_heap(heap.begin(), heap.end());
+            heap.back() = hit;
+            std::push_heap(heap.begin(), heap.end());
+            it.setMinScore(heap.front().score);
+        }
+    }
+}
+void
+TopDocs::hits(std::vector<Hit>& hits) {
+    hits.clear();
+    hits.swap(heap);
+    std::sort(hits.begin(), hits.end());
+}
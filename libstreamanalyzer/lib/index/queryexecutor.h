@@ -0,0 +1,226 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_QUERYEXECUTOR_H
+#define STRIGI_QUERYEXECUTOR_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+ * Evaluation of a Strigi::Query on an index.
+ *
+ * A query is compiled into a tree of DocIterators. The leaves of the tree
+ * come from the index; the executor combines them for Query::And,
+ * Query::Or, negate() and boost(). The documents are visited in the order
+ * of their numbers and the score of a document is the sum of the scores of
+ * the subqueries that match it.
+ *
+ * When only the best results are needed, TopDocs tells the iterators the
+ * score that a document has to beat. An Or skips documents whose
+ * subqueries cannot reach that score together (WAND) and an And skips
+ * blocks of documents in which that is impossible (block-max). So a page
+ * of results does not require scoring every match.
+ */
+namespace Strigi {
+
+class Query;
+
+/**
+ * Iterates over the documents that match a query, in increasing order.
+ * A new iterator is positioned on its first document.
+ **/
+class DocIterator {
+protected:
+    uint32_t m_doc;
+public:
+    /**
+     * The document number after the last document.
+     **/
+    static const uint32_t noMoreDocs = 0xffffffff;
+
+    DocIterator() :m_doc(noMoreDocs) {}
+    virtual ~DocIterator() {}
+    /**
+     * @return the current document or noMoreDocs
+     **/
+    uint32_t doc() const { return m_doc; }
+    /**
+     * Move to the next document.
+     * @return the new current document
+     **/
+    virtual uint32_t next() = 0;
+    /**
+     * Move to the first document that is not smaller than @p target.
+     * @return the new current document
+     **/
+    virtual uint32_t advance(uint32_t target) = 0;
+    /**
+     * @return the score of the current document
+     **/
+    virtual float score() = 0;
+    /**
+     * @return an estimate of the number of documents
+     **/
+    virtual uint64_t cost() const = 0;
+    /**
+     * @return an upper bound for the score of any document
+     **/
+    virtual float maxScore() const = 0;
+    /**
+     * Find the block of documents that contains @p target, which may not
+     * be smaller than the current document. The current document does not
+     * change.
+     * @return the last document of the block
+     **/
+    virtual uint32_t shallowAdvance(uint32_t) { return noMoreDocs; }
+    /**
+     * @return an upper bound for the score of the documents from the block
+     *         found by shallowAdvance() up to @p upTo
+     **/
+    virtual float blockMaxScore(uint32_t) { return maxScore(); }
+    /**
+     * Documents with a score that is not larger than @p score are not
+     * needed any more and may be skipped.
+     **/
+    virtual void setMinScore(float) {}
+};
+
+/**
+ * Iterates over a list of documents and scores in memory. The list is
+ * divided in blocks of @p blockSize documents for shallowAdvance().
+ **/
+class ListDocIterator : public DocIterator {
+private:
+    std::vector<std::pair<uint32_t, float> > hits;
+    std::vector<float> blockMax;
+    const uint32_t blockSize;
+    size_t pos;
+    size_t shallowBlock;
+    float m_maxScore;
+    float minScore;
+    bool pruning;
+
+    uint32_t skip();
+public:
+    /**
+     * @param hits the documents and their scores, sorted by document
+     **/
+    explicit ListDocIterator(std::vector<std::pair<uint32_t, float> > hits,
+        uint32_t blockSize = 128);
+    uint32_t next();
+    uint32_t advance(uint32_t target);
+    float score() { return hits[pos].second; }
+    uint64_t cost() const { return hits.size(); }
+    float maxScore() const { return m_maxScore; }
+    uint32_t shallowAdvance(uint32_t target);
+    float blockMaxScore(uint32_t upTo);
+    void setMinScore(float score);
+};
+
+/**
+ * Creates the iterators for the leaves of a query. An index implements
+ * this for each part of the index that numbers its documents separately.
+ **/
+class DocIteratorSource {
+public:
+    virtual ~DocIteratorSource() {}
+    /**
+     * @return the documents that match @p q, which is not an And or an Or,
+     *         ignoring q.negate(), or 0 if no document matches.
+     **/
+    virtual DocIterator* leaf(const Query& q) = 0;
+    /**
+     * @return all documents with a score of 0 or 0 if there are none
+     **/
+    virtual DocIterator* allDocuments() = 0;
+    /**
+     * Iterators may return documents that were deleted; they are left out
+     * of the results.
+     **/
+    virtual bool isLive(uint32_t) const { return true; }
+};
+
+/**
+ * @return an iterator over the documents that all @p children match, with
+ *         the sum of their scores. The iterator owns the children.
+ **/
+DocIterator* newConjunction(const std::vector<DocIterator*>& children);
+/**
+ * @return an iterator over the documents that any of @p children matches,
+ *         with the sum of their scores. The iterator owns the children.
+ **/
+DocIterator* newDisjunction(const std::vector<DocIterator*>& children);
+
+/**
+ * Compile @p q into iterators over the documents of @p source.
+ * @return the iterator for the query or 0 if no document can match
+ **/
+DocIterator* compileQuery(const Query& q, DocIteratorSource& source);
+
+/**
+ * @return the number of live documents that @p it returns
+ **/
+uint32_t countMatches(DocIterator& it, const DocIteratorSource& source);
+
+/**
+ * Collects the best hits from one or more sources.
+ **/
+class TopDocs {
+public:
+    class Hit {
+    public:
+        float score;
+        uint32_t segment;
+        uint32_t doc;
+        /**
+         * Better hits come first: a higher score, then a lower segment,
+         * then a lower document.
+         **/
+        bool operator<(const Hit& h) const {
+            return score > h.score || (score == h.score
+                && (segment < h.segment
+                    || (segment == h.segment && doc < h.doc)));
+        }
+    };
+    /**
+     * @param k the number of hits to keep; all hits are kept if this is 0
+     **/
+    explicit TopDocs(size_t n) :k(n) {}
+    /**
+     * Add the live documents of @p it that are among the best so far.
+     * The sources must be collected in the order of @p segment.
+     **/
+    void collect(DocIterator& it, uint32_t segment,
+        const DocIteratorSource& source);
+    /**
+     * Move the hits, best first, to @p hits.
+     **/
+    void hits(std::vector<Hit>& hits);
+private:
+    // the hits; if k is not 0, a heap with the worst hit first
+    std::vector<Hit> heap;
+    const size_t k;
+};
+
+}
+
+#endif
@@ -0,0 +1,73 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <strigi/segmentindexmanager.h>
+#include "segmentindexreader.h"
+#include "segmentindexwriter.h"
+#include <mutex>
+#include <sys/stat.h>
+
+using namespace Strigi;
+
+class SegmentIndexManager::Private {
+public:
+    const std::string dir;
+    // the writer is made when it is first needed, so a process that only
+    // reads does not take the write lock of the index
+    std::mutex writerMutex;
+    SegmentIndexWriter* writer;
+    SegmentIndexReader reader;
+
+    explicit Private(const std::string& d) :dir(d), writer(0), reader(d) {}
+    ~Private() {
+        delete writer;
+    }
+};
+
+namespace {
+/**
+ * Create @p dir if it does not exist.
+ * @return @p dir
+ **/
+const std::string&
+makeDir(const std::string& dir) {
+    mkdir(dir.c_str(), 0700);
+    return dir;
+}
+}
+
+SegmentIndexManager::SegmentIndexManager(const std::string& dir)
+        :p(new Private(makeDir(dir))) {
+}
+SegmentIndexManager::~SegmentIndexManager() {
+    delete p;
+}
+IndexReader*
+SegmentIndexManager::indexReader() {
+    return &p->reader;
+}
+IndexWriter*
+SegmentIndexManager::indexWriter() {
+    std::lock_guard<std::mutex> lock(p->writerMutex);
+    if (p->writer == 0) {
+        p->writer = new SegmentIndexWriter(p->dir);
+    }
+    return p->writer;
+}
@@ -0,0 +1,1244 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "segmentindexreader.h"
+#include "queryexecutor.h"
+#include "levenshtein.h"
+#include "segmentreader.h"
+#include "tokenizer.h"
+#include <strigi/fieldtypes.h>
+#include <strigi/query.h>
+#include <strigi/queryparser.h>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <regex>
+#include <set>
+#include <cmath>
+#include <cstdlib>
+#include <strings.h>
+#include <sys/stat.h>
+
+using namespace Strigi;
+
+namespace {
+/**
+ * The documents of a segment that match a query and their scores, sorted
+ * by document.
+ **/
+typedef std::vector<std::pair<uint32_t, float> > Hits;
+
+/**
+ * A document in the results of a query.
+ **/
+typedef TopDocs::Hit Result;
+
+/**
+ * The largest number of terms that a fuzzy term is expanded to.
+ **/
+const size_t maxFuzzyExpansions = 50;
+
+/**
+ * Sort the documents and keep the best score of documents that occur more
+ * than once, so a document that matches many expansions of a term does not
+ * get a high score because of that.
+ **/
+void
+normalize(Hits& hits) {
+    std::sort(hits.begin(), hits.end());
+    size_t n = 0;
+    for (size_t i = 0; i < hits.size(); ++i) {
+        if (n && hits[n - 1].first == hits[i].first) {
+            hits[n - 1].second = std::max(hits[n - 1].second,
+                hits[i].second);
+        } else {
+            hits[n++] = hits[i];
+        }
+    }
+    hits.resize(n);
+}
+bool
+startsWith(const std::string& s, const std::string& prefix) {
+    return s.compare(0, prefix.length(), prefix) == 0;
+}
+std::string
+toLower(const std::string& s) {
+    std::string l(s);
+    for (std::string::iterator i = l.begin(); i != l.end(); ++i) {
+        if (*i >= 'A' && *i <= 'Z') {
+            *i = (char)(*i + 'a' - 'A');
+        }
+    }
+    return l;
+}
+/**
+ * Parse @p s as a number.
+ * @return false if @p s is not a number
+ **/
+bool
+toNumber(const std::string& s, double& d) {
+    if (s.empty()) {
+        return false;
+    }
+    char* end;
+    d = strtod(s.c_str(), &end);
+    return *end == '\0';
+}
+/**
+ * Compare two values as numbers if they both are numbers and as strings
+ * otherwise.
+ **/
+int
+compareValues(const std::string& a, const std::string& b) {
+    double x, y;
+    if (toNumber(a, x) && toNumber(b, y)) {
+        return (x < y) ?-1 :((x > y) ?1 :0);
+    }
+    return a.compare(b);
+}
+/**
+ * Convert the values of a field to the type that was asked for.
+ **/
+Variant
+toVariant(const std::vector<std::string>& v, Variant::Type type) {
+    if (type == Variant::as_val) {
+        return v;
+    } else if (type == Variant::aas_val) {
+        std::vector<std::vector<std::string> > aas;
+        for (size_t n = 0; n < v.size(); ++n) {
+            aas.push_back(std::vector<std::string>(1, v[n]));
+        }
+        return aas;
+    } else if (v.empty()) {
+        return Variant();
+    }
+    const Variant s(v[0]);
+    switch (type) {
+    case Variant::b_val: return s.b();
+    case Variant::i_val: return s.i();
+    case Variant::u_val: return s.u();
+    default:             return s;
+    }
+}
+
+/**
+ * @return the number of edits that a fuzzy query for @p word allows. A
+ *         fuzziness from 1 is the number of edits and a smaller one is the
+ *         part of the word that has to stay the same.
+ **/
+unsigned
+maxEditsOf(float fuzzy, const std::string& word) {
+    if (fuzzy <= 0) {
+        return 0;
+    }
+    const float edits = (fuzzy >= 1) ?fuzzy :(1 - fuzzy) * word.length();
+    return (unsigned)std::min(edits,
+        (float)LevenshteinAutomaton::maxDistance);
+}
+
+/**
+ * The terms of one field of a segment as a source for expandFuzzy().
+ **/
+class FieldTerms {
+private:
+    const SegmentReader& reader;
+    const int field;
+    SegmentReader::TermIterator i;
+public:
+    FieldTerms(const SegmentReader& r, int f) :reader(r), field(f) {}
+    bool seek(const std::string& term) {
+        return i.seek(reader, field, term);
+    }
+    const std::string& term() const { return i.term(); }
+};
+
+/**
+ * Iterates over the postings of a term. Documents that contain a term
+ * often get a higher score.
+ **/
+class TermDocIterator : public DocIterator {
+private:
+    PostingIterator list;
+    float weight;
+    float minScore;
+    bool pruning;
+
+    float scoreOf(uint32_t freq) const {
+        return weight * (1.0f + (float)log((double)freq));
+    }
+    float bound(uint32_t maxFreq) const {
+        return (weight >= 0) ?scoreOf(maxFreq) :weight;
+    }
+    /**
+     * Skip the blocks in which no document can beat minScore.
+     **/
+    uint32_t skip(uint32_t doc) {
+        while (pruning && doc != noMoreDocs) {
+            const uint32_t end = list.shallowAdvance(doc);
+            if (bound(list.maxFreq(end)) > minScore
+                    || end == noMoreDocs) {
+                break;
+            }
+            doc = list.advance(end + 1);
+        }
+        return doc;
+    }
+public:
+    TermDocIterator() :weight(0), minScore(0), pruning(false) {}
+    /**
+     * @param weight the score of a document that contains the term once
+     **/
+    bool init(const SegmentReader& r, const SegmentReader::TermIterator& t,
+            float w) {
+        weight = w;
+        if (!r.postings(t, list)) {
+            return false;
+        }
+        m_doc = list.doc();
+        return true;
+    }
+    uint32_t next() { return m_doc = skip(list.next()); }
+    uint32_t advance(uint32_t target) {
+        return m_doc = skip(list.advance(target));
+    }
+    float score() { return scoreOf(list.freq()); }
+    uint64_t cost() const { return list.size(); }
+    float maxScore() const { return bound(list.maxFreq()); }
+    uint32_t shallowAdvance(uint32_t target) {
+        return list.shallowAdvance(target);
+    }
+    float blockMaxScore(uint32_t upTo) {
+        return bound(list.maxFreq(upTo));
+    }
+    void setMinScore(float score) {
+        minScore = score;
+        pruning = weight >= 0;
+    }
+};
+
+/**
+ * Iterates over the documents that contain the words of a phrase close to
+ * each other. The postings of the words propose the documents that contain
+ * all of them and the positions of the words decide.
+ **/
+class PhraseDocIterator : public DocIterator {
+private:
+    // the postings and the positions of each different word, the word with
+    // the fewest postings first
+    std::vector<PostingIterator> lists;
+    std::vector<PositionReader> readers;
+    std::vector<std::vector<uint32_t> > positions;
+    // the positions of each word of the phrase
+    std::vector<const std::vector<uint32_t>*> phrase;
+    uint32_t maxGaps;
+    bool ordered;
+    float weight;
+
+    float scoreOf(uint32_t freq) const {
+        return weight * (1.0f + (float)log((double)freq));
+    }
+    bool matches() {
+        for (size_t i = 0; i < lists.size(); ++i) {
+            if (!readers[i].read(lists[i].index(), positions[i])) {
+                return false;
+            }
+        }
+        return matchPositions(phrase, maxGaps, ordered);
+    }
+    /**
+     * @return the first document from @p doc that matches
+     **/
+    uint32_t find(uint32_t doc) {
+        size_t i = 0;
+        while (doc != noMoreDocs && i < lists.size()) {
+            const uint32_t d = lists[i].advance(doc);
+            if (d != doc) {
+                doc = d;
+                i = 0;
+            } else if (++i == lists.size() && !matches()) {
+                doc = lists[0].next();
+                i = 0;
+            }
+        }
+        return doc;
+    }
+public:
+    PhraseDocIterator() :maxGaps(0), ordered(true), weight(0) {}
+    /**
+     * @param terms the different words of the phrase
+     * @param words the index in @p terms of each word of the phrase
+     * @param weight the score of a document that contains the phrase once
+     **/
+    bool init(const SegmentReader& r,
+            const std::vector<SegmentReader::TermIterator>& terms,
+            const std::vector<size_t>& words, uint32_t gaps, bool o,
+            float w) {
+        maxGaps = gaps;
+        ordered = o;
+        weight = w;
+        std::vector<size_t> order(terms.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return terms[a].docFreq() < terms[b].docFreq();
+        });
+        lists.resize(terms.size());
+        readers.resize(terms.size());
+        positions.resize(terms.size());
+        std::vector<size_t> slot(terms.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            slot[order[i]] = i;
+            if (!r.postings(terms[order[i]], lists[i])
+                    || !r.positions(terms[order[i]], readers[i])) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < words.size(); ++i) {
+            phrase.push_back(&positions[slot[words[i]]]);
+        }
+        m_doc = find(lists[0].doc());
+        return true;
+    }
+    uint32_t next() {
+        return m_doc = (m_doc == noMoreDocs) ?m_doc :find(lists[0].next());
+    }
+    uint32_t advance(uint32_t target) {
+        return m_doc = find(lists[0].advance(target));
+    }
+    float score() {
+        uint32_t freq = lists[0].freq();
+        for (size_t i = 1; i < lists.size(); ++i) {
+            freq = std::min(freq, lists[i].freq());
+        }
+        return scoreOf(freq);
+    }
+    uint64_t cost() const { return lists[0].size(); }
+    float maxScore() const {
+        uint32_t freq = lists[0].maxFreq();
+        for (size_t i = 1; i < lists.size(); ++i) {
+            freq = std::min(freq, lists[i].maxFreq());
+        }
+        return (weight >= 0) ?scoreOf(freq) :weight;
+    }
+};
+}
+
+class SegmentIndexReader::Private {
+public:
+    class Segment {
+    public:
+        SegmentReader* reader;
+        SegmentInfo info;
+        DeletionBitmap deleted;
+        Segment() :reader(0) {}
+        ~Segment() { delete reader; }
+    };
+    /**
+     * Creates the iterators for the queries on a segment.
+     **/
+    class Source : public DocIteratorSource {
+    private:
+        Private& p;
+        const Segment& s;
+    public:
+        Source(Private& priv, const Segment& segment) :p(priv), s(segment) {}
+        DocIterator* leaf(const Query& q) { return p.leaf(s, q); }
+        DocIterator* allDocuments() {
+            Hits all;
+            p.allDocuments(s, all);
+            return (all.empty()) ?0 :new ListDocIterator(all);
+        }
+        bool isLive(uint32_t doc) const {
+            return doc < s.info.docCount && !s.deleted.get(doc);
+        }
+    };
+    const std::string dir;
+    std::mutex mutex;
+    std::vector<Segment*> segments;
+    // identifies the list of segments that was read last
+    ino_t ino;
+    time_t mtime;
+    long mtimeNsec;
+
+    explicit Private(const std::string& d) :dir(d), ino(0), mtime(0),
+        mtimeNsec(0) {}
+    ~Private();
+    void refresh();
+    bool open(const SegmentInfos& infos);
+    uint32_t liveDocs(const Segment& s) const {
+        return s.info.docCount - s.info.delCount;
+    }
+    void allDocuments(const Segment& s, Hits& hits);
+    static float idfOf(const Segment& s,
+            const SegmentReader::TermIterator& t) {
+        return (float)log(1.0 + (double)s.info.docCount
+            / (double)t.docFreq());
+    }
+    void addPostings(const Segment& s, const SegmentReader::TermIterator& t,
+        float boost, Hits& hits);
+    void matchTerms(const Segment& s, int field, Query::Type type,
+        const std::string& value, bool caseSensitive, float boost,
+        Hits& hits);
+    static bool isExact(Query::Type type);
+    DocIterator* termIterator(const Segment& s, int field, Query::Type type,
+        const std::string& value, bool caseSensitive, float fuzzy,
+        float boost);
+    DocIterator* fuzzyIterator(const Segment& s, int field,
+        const std::string& value, unsigned maxEdits, float boost);
+    DocIterator* phraseIterator(const Segment& s, int field,
+        const std::vector<std::string>& words, int maxGaps, bool ordered,
+        float boost);
+    DocIterator* fieldIterator(const Segment& s, const Query& q,
+        const std::string& field);
+    DocIterator* leaf(const Segment& s, const Query& q);
+    void results(const Query& q, std::vector<Result>& results, int off,
+        int max);
+    bool document(const Result& r, std::multimap<std::string, std::string>&
+        values);
+    /**
+     * The values of the fields of one document. The values are read from
+     * the columns of the fields and only fields without a column read the
+     * stored document.
+     **/
+    class Row {
+    public:
+        Private& p;
+        const Result& r;
+        std::multimap<std::string, std::string> stored;
+        bool read;
+        Row(Private& priv, const Result& result) :p(priv), r(result),
+            read(false) {}
+        void values(const std::string& field, std::vector<std::string>& v);
+    };
+    IndexedDocument indexedDocument(const Result& r);
+    /**
+     * The terms with a common prefix in one field of one segment.
+     **/
+    class TermRange {
+    public:
+        const Segment* segment;
+        int field;
+        uint32_t first;
+        uint32_t count;
+    };
+    void termRanges(const std::string& prefix,
+        const std::vector<std::string>& fieldnames,
+        std::vector<TermRange>& ranges);
+    int32_t countTerms(const std::string& prefix,
+        const std::vector<std::string>& fieldnames);
+    void forEachTerm(const std::vector<TermRange>& ranges,
+        const std::function<bool (const std::string&)>& f);
+};
+
+SegmentIndexReader::Private::~Private() {
+    std::vector<Segment*>::const_iterator i;
+    for (i = segments.begin(); i != segments.end(); ++i) {
+        delete *i;
+    }
+}
+/**
+ * Read the list of segments again if it has changed.
+ **/
+void
+SegmentIndexReader::Private::refresh() {
+    // the writer may remove a segment between reading the list and
+    // opening the segment; then the list is read again
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        struct stat s;
+        if (stat((dir + "/segments").c_str(), &s) != 0) {
+            s.st_ino = 0;
+            s.st_mtim.tv_sec = 0;
+            s.st_mtim.tv_nsec = 0;
+        }
+        if (ino && s.st_ino == ino && s.st_mtim.tv_sec == mtime
+                && s.st_mtim.tv_nsec == mtimeNsec) {
+            return;
+        }
+        SegmentInfos infos;
+        if (infos.read(dir) && open(infos)) {
+            ino = s.st_ino;
+            mtime = s.st_mtim.tv_sec;
+            mtimeNsec = s.st_mtim.tv_nsec;
+            return;
+        }
+    }
+}
+bool
+SegmentIndexReader::Private::open(const SegmentInfos& infos) {
+    std::vector<Segment*> next;
+    bool ok = true;
+    std::vector<SegmentInfo>::const_iterator i;
+    for (i = infos.segments.begin(); ok && i != infos.segments.end(); ++i) {
+        Segment* s = 0;
+        std::vector<Segment*>::iterator j;
+        for (j = segments.begin(); s == 0 && j != segments.end(); ++j) {
+            if (*j && (*j)->info.name == i->name) {
+                s = *j;
+                *j = 0;
+            }
+        }
+        if (s == 0) {
+            s = new Segment();
+            s->reader = SegmentReader::open(dir, *i);
+            if (s->reader == 0) {
+                delete s;
+                ok = false;
+                break;
+            }
+        }
+        next.push_back(s);
+        if (s->info.delGen != i->delGen || s->info.name.empty()) {
+            s->deleted = DeletionBitmap(i->docCount);
+            ok = i->delGen == 0
+                || s->deleted.read(dir + '/' + i->delFileName(), i->docCount);
+        }
+        s->info = *i;
+    }
+    // close the segments that are no longer in the list
+    std::vector<Segment*>::const_iterator j;
+    for (j = segments.begin(); j != segments.end(); ++j) {
+        delete *j;
+    }
+    segments.swap(next);
+    if (!ok) {
+        // the segments that were read do not match the list
+        ino = 0;
+    }
+    return ok;
+}
+void
+SegmentIndexReader::Private::allDocuments(const Segment& s, Hits& hits) {
+    hits.clear();
+    for (uint32_t d = 0; d < s.info.docCount; ++d) {
+        if (!s.deleted.get(d)) {
+            hits.push_back(std::make_pair(d, 0.0f));
+        }
+    }
+}
+/**
+ * Add the documents that contain the current term of @p t to @p hits.
+ * Documents that contain rare terms and documents that contain a term
+ * often get a higher score.
+ **/
+void
+SegmentIndexReader::Private::addPostings(const Segment& s,
+        const SegmentReader::TermIterator& t, float boost, Hits& hits) {
+    PostingIterator list;
+    if (!s.reader->postings(t, list)) {
+        return;
+    }
+    const float idf = idfOf(s, t);
+    for (uint32_t doc = list.doc(); doc < s.info.docCount; doc = list.next()) {
+        if (!s.deleted.get(doc)) {
+            hits.push_back(std::make_pair(doc,
+                boost * idf * (1.0f + (float)log((double)list.freq()))));
+        }
+    }
+}
+/**
+ * Find the documents that have a term in @p field that matches @p value.
+ **/
+void
+SegmentIndexReader::Private::matchTerms(const Segment& s, int field,
+        Query::Type type, const std::string& value, bool caseSensitive,
+        float boost, Hits& hits) {
+    const SegmentReader& r = *s.reader;
+    SegmentReader::TermIterator t;
+    if (caseSensitive && type == Query::StartsWith) {
+        for (bool ok = t.seek(r, field, value);
+                ok && startsWith(t.term(), value); ok = t.next()) {
+            addPostings(s, t, boost, hits);
+        }
+    } else {
+        // compare the value to the terms of the field
+        const std::string lower(toLower(value));
+        std::regex re;
+        if (type == Query::RegExp) {
+            try {
+                re.assign(value, (caseSensitive)
+                    ?std::regex::ECMAScript
+                    :std::regex::ECMAScript | std::regex::icase);
+            } catch (const std::regex_error&) {
+                return;
+            }
+        }
+        const auto matches = [&](const std::string& term) {
+            switch (type) {
+            case Query::Equals:
+            case Query::Keyword:
+                return strcasecmp(term.c_str(), value.c_str()) == 0;
+            case Query::StartsWith:
+                return startsWith(toLower(term), lower);
+            case Query::LessThan:
+                return compareValues(term, value) < 0;
+            case Query::LessThanEquals:
+                return compareValues(term, value) <= 0;
+            case Query::GreaterThan:
+                return compareValues(term, value) > 0;
+            case Query::GreaterThanEquals:
+                return compareValues(term, value) >= 0;
+            case Query::RegExp:
+                return std::regex_search(term, re);
+            default:
+                return (caseSensitive)
+                    ?term.find(value) != std::string::npos
+                    :toLower(term).find(lower) != std::string::npos;
+            }
+        };
+        // regular expressions and substrings only have to be compared to
+        // the terms that have their trigrams
+        std::vector<uint32_t> candidates;
+        if ((type == Query::RegExp || type == Query::Contains)
+                && r.trigramCandidates(field, (type == Query::RegExp)
+                    ?TrigramQuery::regExp(value)
+                    :TrigramQuery::substring(value), candidates)) {
+            bool ok = false;
+            std::vector<uint32_t>::const_iterator i;
+            for (i = candidates.begin(); i != candidates.end(); ++i) {
+                ok = (ok && t.ordinal() + 1 == *i)
+                    ?t.next() :t.seekOrdinal(r, field, *i);
+                if (ok && matches(t.term())) {
+                    addPostings(s, t, boost, hits);
+                }
+            }
+            return;
+        }
+        for (bool ok = t.seek(r, field, std::string()); ok; ok = t.next()) {
+            if (matches(t.term())) {
+                addPostings(s, t, boost, hits);
+            }
+        }
+    }
+}
+/**
+ * @return true if @p type matches a value only if it is equal to the term
+ **/
+bool
+SegmentIndexReader::Private::isExact(Query::Type type) {
+    return type == Query::Equals || type == Query::Keyword
+        || type == Query::FullText || type == Query::Proximity;
+}
+/**
+ * @return the documents that have a term in @p field that matches @p value
+ *         or 0 if there are none
+ **/
+DocIterator*
+SegmentIndexReader::Private::termIterator(const Segment& s, int field,
+        Query::Type type, const std::string& value, bool caseSensitive,
+        float fuzzy, float boost) {
+    const unsigned maxEdits = (isExact(type)) ?maxEditsOf(fuzzy, value) :0;
+    if (maxEdits) {
+        return fuzzyIterator(s, field, value, maxEdits, boost);
+    }
+    if (caseSensitive && isExact(type)) {
+        SegmentReader::TermIterator t;
+        TermDocIterator* it = new TermDocIterator();
+        if (!s.reader->findTerm(field, value, t)
+                || !it->init(*s.reader, t, boost * idfOf(s, t))) {
+            delete it;
+            it = 0;
+        }
+        return it;
+    }
+    Hits hits;
+    matchTerms(s, field, type, value, caseSensitive, boost, hits);
+    normalize(hits);
+    return (hits.empty()) ?0 :new ListDocIterator(hits);
+}
+/**
+ * @return the documents that have one of the terms in @p field that are
+ *         at most @p maxEdits edits away from @p value or 0 if there are
+ *         none. Closer terms give higher scores. The terms are compared
+ *         with their case.
+ **/
+DocIterator*
+SegmentIndexReader::Private::fuzzyIterator(const Segment& s, int field,
+        const std::string& value, unsigned maxEdits, float boost) {
+    FieldTerms source(*s.reader, field);
+    std::vector<FuzzyTerm> terms;
+    expandFuzzy(source, value, maxEdits, maxFuzzyExpansions, terms);
+    std::vector<DocIterator*> its;
+    std::vector<FuzzyTerm>::const_iterator i;
+    for (i = terms.begin(); i != terms.end(); ++i) {
+        SegmentReader::TermIterator t;
+        TermDocIterator* it = new TermDocIterator();
+        const float similarity = 1.0f - (float)i->distance / (maxEdits + 1);
+        if (s.reader->findTerm(field, i->term, t) && it->init(*s.reader, t,
+                boost * similarity * idfOf(s, t))) {
+            its.push_back(it);
+        } else {
+            delete it;
+        }
+    }
+    return (its.empty()) ?0 :newDisjunction(its);
+}
+/**
+ * @return the documents in which @p words occur with at most @p maxGaps
+ *         other words between them or 0 if there are none
+ **/
+DocIterator*
+SegmentIndexReader::Private::phraseIterator(const Segment& s, int field,
+        const std::vector<std::string>& words, int maxGaps, bool ordered,
+        float boost) {
+    std::vector<std::string> different(words);
+    std::sort(different.begin(), different.end());
+    different.erase(std::unique(different.begin(), different.end()),
+        different.end());
+    std::vector<SegmentReader::TermIterator> terms(different.size());
+    float weight = 0;
+    for (size_t i = 0; i < different.size(); ++i) {
+        if (!s.reader->findTerm(field, different[i], terms[i])) {
+            return 0;
+        }
+        weight += boost * idfOf(s, terms[i]);
+    }
+    std::vector<size_t> index;
+    for (size_t i = 0; i < words.size(); ++i) {
+        index.push_back(std::lower_bound(different.begin(), different.end(),
+            words[i]) - different.begin());
+    }
+    PhraseDocIterator* it = new PhraseDocIterator();
+    if (!it->init(*s.reader, terms, index, (uint32_t)std::max(maxGaps, 0),
+            ordered, weight) || it->doc() == DocIterator::noMoreDocs) {
+        delete it;
+        it = 0;
+    }
+    return it;
+}
+DocIterator*
+SegmentIndexReader::Private::fieldIterator(const Segment& s, const Query& q,
+        const std::string& fieldname) {
+    const int field = s.reader->fieldNumber(fieldname);
+    if (field < 0) {
+        return 0;
+    }
+    if (fieldname != FieldRegister::contentFieldName
+            || q.type() == Query::RegExp || q.type() == Query::LessThan
+            || q.type() == Query::LessThanEquals
+            || q.type() == Query::GreaterThan
+            || q.type() == Query::GreaterThanEquals) {
+        return termIterator(s, field, q.type(), q.term().string(),
+            q.term().caseSensitive(), q.term().fuzzy(), q.boost());
+    }
+    // the text is stored as lower case words; all words have to match and,
+    // for a phrase of exact words, they have to be close to each other
+    const std::vector<std::string> words(Tokenizer::words(q.term().string()));
+    if (words.size() > 1 && s.reader->hasPositions(field)
+            && q.term().fuzzy() <= 0) {
+        if (q.type() == Query::Proximity) {
+            return phraseIterator(s, field, words,
+                q.term().proximityDistance(), q.term().ordered(),
+                q.boost());
+        } else if (q.type() == Query::FullText) {
+            return phraseIterator(s, field, words, q.term().slack(),
+                q.term().ordered(), q.boost());
+        }
+    }
+    std::vector<DocIterator*> its;
+    for (size_t i = 0; i < words.size(); ++i) {
+        DocIterator* it = termIterator(s, field, q.type(), words[i], true,
+            q.term().fuzzy(), q.boost());
+        if (it == 0) {
+            for (i = 0; i < its.size(); ++i) {
+                delete its[i];
+            }
+            return 0;
+        }
+        its.push_back(it);
+    }
+    return (its.empty()) ?0 :newConjunction(its);
+}
+DocIterator*
+SegmentIndexReader::Private::leaf(const Segment& s, const Query& q) {
+    std::vector<std::string> fields(q.fields());
+    if (fields.empty()) {
+        fields.push_back(FieldRegister::contentFieldName);
+        fields.push_back(FieldRegister::filenameFieldName);
+    }
+    std::vector<DocIterator*> its;
+    std::vector<std::string>::const_iterator f;
+    for (f = fields.begin(); f != fields.end(); ++f) {
+        DocIterator* it = fieldIterator(s, q, *f);
+        if (it) {
+            its.push_back(it);
+        }
+    }
+    return (its.empty()) ?0 :newDisjunction(its);
+}
+/**
+ * Put the best results of @p q from @p off to @p off + @p max in
+ * @p results. If @p max is negative, all results from @p off are returned.
+ **/
+void
+SegmentIndexReader::Private::results(const Query& q,
+        std::vector<Result>& results, int off, int max) {
+    results.clear();
+    if (off < 0) {
+        off = 0;
+    }
+    if (max == 0) {
+        return;
+    }
+    TopDocs top((max < 0) ?0 :(size_t)off + max);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        Source source(*this, *segments[i]);
+        DocIterator* it = compileQuery(q, source);
+        if (it) {
+            top.collect(*it, (uint32_t)i, source);
+            delete it;
+        }
+    }
+    top.hits(results);
+    if ((size_t)off >= results.size()) {
+        results.clear();
+    } else {
+        results.erase(results.begin(), results.begin() + off);
+    }
+}
+bool
+SegmentIndexReader::Private::document(const Result& r,
+        std::multimap<std::string, std::string>& values) {
+    values.clear();
+    const SegmentReader& reader = *segments[r.segment]->reader;
+    StoredDocument stored;
+    if (!reader.document(r.doc, stored)) {
+        return false;
+    }
+    StoredDocument::const_iterator i;
+    for (i = stored.begin(); i != stored.end(); ++i) {
+        values.insert(std::make_pair(reader.fieldNames()[i->first],
+            i->second));
+    }
+    return true;
+}
+void
+SegmentIndexReader::Private::Row::values(const std::string& field,
+        std::vector<std::string>& v) {
+    v.clear();
+    const SegmentReader& reader = *p.segments[r.segment]->reader;
+    const int f = reader.fieldNumber(field);
+    const Column* column = reader.column(f);
+    if (column) {
+        column->values(r.doc, v);
+        return;
+    }
+    if (f < 0) {
+        return;
+    }
+    if (!read) {
+        p.document(r, stored);
+        read = true;
+    }
+    std::multimap<std::string, std::string>::const_iterator i;
+    for (i = stored.lower_bound(field);
+            i != stored.end() && i->first == field; ++i) {
+        v.push_back(i->second);
+    }
+}
+IndexedDocument
+SegmentIndexReader::Private::indexedDocument(const Result& r) {
+    IndexedDocument doc;
+    doc.score = r.score;
+    document(r, doc.properties);
+    std::multimap<std::string, std::string>::iterator i
+        = doc.properties.begin();
+    while (i != doc.properties.end()) {
+        if (i->first == FieldRegister::pathFieldName) {
+            doc.uri = i->second;
+        } else if (i->first == FieldRegister::mimetypeFieldName) {
+            doc.mimetype = i->second;
+        } else if (i->first == FieldRegister::sizeFieldName) {
+            doc.size = atoll(i->second.c_str());
+        } else if (i->first == FieldRegister::mtimeFieldName) {
+            doc.mtime = strtoull(i->second.c_str(), 0, 10);
+        } else if (i->first == FieldRegister::contentFieldName) {
+            doc.fragment = i->second;
+            doc.properties.erase(i++);
+            continue;
+        }
+        ++i;
+    }
+    return doc;
+}
+/**
+ * Find the terms that start with @p prefix in the fields @p fieldnames, or
+ * in the words of the text if no fields are given.
+ **/
+void
+SegmentIndexReader::Private::termRanges(const std::string& prefix,
+        const std::vector<std::string>& fieldnames,
+        std::vector<TermRange>& ranges) {
+    std::vector<std::string> fields(fieldnames);
+    if (fields.empty()) {
+        fields.push_back(FieldRegister::contentFieldName);
+    }
+    std::vector<std::string>::const_iterator i;
+    std::vector<Segment*>::const_iterator s;
+    for (i = fields.begin(); i != fields.end(); ++i) {
+        const std::string p((*i == FieldRegister::contentFieldName)
+            ?toLower(prefix) :prefix);
+        for (s = segments.begin(); s != segments.end(); ++s) {
+            TermRange r;
+            r.segment = *s;
+            r.field = (*s)->reader->fieldNumber(*i);
+            r.count = (*s)->reader->countTerms(r.field, p, r.first);
+            if (r.count) {
+                ranges.push_back(r);
+            }
+        }
+    }
+}
+int32_t
+SegmentIndexReader::Private::countTerms(const std::string& prefix,
+        const std::vector<std::string>& fieldnames) {
+    std::vector<TermRange> ranges;
+    termRanges(prefix, fieldnames, ranges);
+    if (ranges.size() == 1) {
+        // the terms of one dictionary are counted without reading them
+        return (int32_t)ranges[0].count;
+    }
+    int32_t n = 0;
+    forEachTerm(ranges, [&n](const std::string&) { ++n; return true; });
+    return n;
+}
+/**
+ * Call @p f for each distinct term in @p ranges in byte order until it
+ * returns false.
+ **/
+void
+SegmentIndexReader::Private::forEachTerm(const std::vector<TermRange>& ranges,
+        const std::function<bool (const std::string&)>& f) {
+    // an iterator for each range and the number of terms it has left
+    std::vector<std::pair<SegmentReader::TermIterator, uint32_t> > terms;
+    std::vector<TermRange>::const_iterator r;
+    for (r = ranges.begin(); r != ranges.end(); ++r) {
+        SegmentReader::TermIterator t;
+        if (t.seekOrdinal(*r->segment->reader, r->field, r->first)) {
+            terms.push_back(std::make_pair(t, r->count));
+        }
+    }
+    while (terms.size()) {
+        std::string term(terms[0].first.term());
+        for (size_t j = 1; j < terms.size(); ++j) {
+            if (terms[j].first.term() < term) {
+                term = terms[j].first.term();
+            }
+        }
+        for (size_t j = 0; j < terms.size(); ) {
+            SegmentReader::TermIterator& t = terms[j].first;
+            if (t.term() == term
+                    && !(--terms[j].second && t.next())) {
+                terms.erase(terms.begin() + j);
+            } else {
+                ++j;
+            }
+        }
+        if (!f(term)) {
+            return;
+        }
+    }
+}
+
+SegmentIndexReader::SegmentIndexReader(const std::string& dir)
+        :p(new Private(dir)) {
+}
+SegmentIndexReader::~SegmentIndexReader() {
+    delete p;
+}
+int32_t
+SegmentIndexReader::countHits(const Query& q) {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    int32_t n = 0;
+    std::vector<Private::Segment*>::const_iterator s;
+    for (s = p->segments.begin(); s != p->segments.end(); ++s) {
+        Private::Source source(*p, **s);
+        DocIterator* it = compileQuery(q, source);
+        if (it) {
+            n += (int32_t)countMatches(*it, source);
+            delete it;
+        }
+    }
+    return n;
+}
+std::vector<IndexedDocument>
+SegmentIndexReader::query(const Query& q, int off, int max) {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    std::vector<Result> results;
+    p->results(q, results, off, max);
+    std::vector<IndexedDocument> docs;
+    docs.reserve(results.size());
+    std::vector<Result>::const_iterator i;
+    for (i = results.begin(); i != results.end(); ++i) {
+        docs.push_back(p->indexedDocument(*i));
+    }
+    return docs;
+}
+void
+SegmentIndexReader::getHits(const Query& q,
+        const std::vector<std::string>& fields,
+        const std::vector<Variant::Type>& types,
+        std::vector<std::vector<Variant> >& result, int off, int max) {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    result.clear();
+    std::vector<Result> results;
+    p->results(q, results, off, max);
+    result.reserve(results.size());
+    std::vector<std::string> v;
+    std::vector<Result>::const_iterator i;
+    for (i = results.begin(); i != results.end(); ++i) {
+        Private::Row values(*p, *i);
+        result.push_back(std::vector<Variant>(fields.size()));
+        std::vector<Variant>& row = result.back();
+        for (size_t j = 0; j < fields.size(); ++j) {
+            values.values(fields[j], v);
+            row[j] = toVariant(v, (j < types.size())
+                ?types[j] :Variant::s_val);
+        }
+    }
+}
+void
+SegmentIndexReader::getChildren(const std::string& parent,
+        std::map<std::string, time_t>& children) {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    children.clear();
+    std::vector<Posting> postings;
+    std::vector<std::string> path, mtime;
+    for (size_t i = 0; i < p->segments.size(); ++i) {
+        const Private::Segment& s = *p->segments[i];
+        SegmentReader::TermIterator t;
+        if (!s.reader->findTerm(s.reader->fieldNumber(
+                FieldRegister::parentLocationFieldName), parent, t)) {
+            continue;
+        }
+        postings.clear();
+        s.reader->postings(t, postings);
+        Result r;
+        r.segment = (uint32_t)i;
+        std::vector<Posting>::const_iterator j;
+        for (j = postings.begin(); j != postings.end(); ++j) {
+            if (s.deleted.get(j->doc)) {
+                continue;
+            }
+            r.doc = j->doc;
+            Private::Row values(*p, r);
+            values.values(FieldRegister::pathFieldName, path);
+            values.values(FieldRegister::mtimeFieldName, mtime);
+            if (path.size()) {
+                children[path[0]] = (mtime.empty())
+                    ?0 :(time_t)atoll(mtime[0].c_str());
+            }
+        }
+    }
+}
+int32_t
+SegmentIndexReader::countDocuments() {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    int32_t n = 0;
+    std::vector<Private::Segment*>::const_iterator s;
+    for (s = p->segments.begin(); s != p->segments.end(); ++s) {
+        n += (int32_t)p->liveDocs(**s);
+    }
+    return n;
+}
+int32_t
+SegmentIndexReader::countWords() {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    return p->countTerms(std::string(), std::vector<std::string>());
+}
+int64_t
+SegmentIndexReader::indexSize() {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    int64_t size = 0;
+    struct stat s;
+    if (stat((p->dir + "/segments").c_str(), &s) == 0) {
+        size += s.st_size;
+    }
+    std::vector<Private::Segment*>::const_iterator i;
+    for (i = p->segments.begin(); i != p->segments.end(); ++i) {
+        const SegmentInfo& info = (*i)->info;
+        const std::string files[] = { info.fileName("tis"),
+            info.fileName("pst"), info.fileName("fld"), info.fileName("dv"),
+            info.fileName("tri"), info.fileName("pos"),
+            (info.delGen) ?info.delFileName() :std::string() };
+        for (size_t j = 0; j < 7; ++j) {
+            if (files[j].length()
+                    && stat((p->dir + '/' + files[j]).c_str(), &s) == 0) {
+                size += s.st_size;
+            }
+        }
+    }
+    return size;
+}
+time_t
+SegmentIndexReader::mTime(const std::string& path) {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    std::vector<Posting> postings;
+    std::vector<std::string> mtime;
+    // the last version of the file is in the last segment that has it
+    for (size_t i = p->segments.size(); i > 0; --i) {
+        const Private::Segment& s = *p->segments[i - 1];
+        SegmentReader::TermIterator t;
+        if (!s.reader->findTerm(s.reader->fieldNumber(
+                FieldRegister::pathFieldName), path, t)) {
+            continue;
+        }
+        postings.clear();
+        s.reader->postings(t, postings);
+        std::vector<Posting>::const_reverse_iterator j;
+        for (j = postings.rbegin(); j != postings.rend(); ++j) {
+            if (s.deleted.get(j->doc)) {
+                continue;
+            }
+            Result r;
+            r.segment = (uint32_t)(i - 1);
+            r.doc = j->doc;
+            Private::Row(*p, r).values(FieldRegister::mtimeFieldName, mtime);
+            return (mtime.empty()) ?0 :(time_t)atoll(mtime[0].c_str());
+        }
+    }
+    return -1;
+}
+std::vector<std::string>
+SegmentIndexReader::fieldNames() {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    std::set<std::string> names;
+    std::vector<Private::Segment*>::const_iterator s;
+    for (s = p->segments.begin(); s != p->segments.end(); ++s) {
+        names.insert((*s)->reader->fieldNames().begin(),
+            (*s)->reader->fieldNames().end());
+    }
+    return std::vector<std::string>(names.begin(), names.end());
+}
+/**
+ * Count the values of @p fieldname in the documents that match @p query.
+ * The values are counted per segment on the column of the field.
+ * The labels are sorted as numbers if they all are numbers.
+ **/
+std::vector<std::pair<std::string,uint32_t> >
+SegmentIndexReader::histogram(const std::string& query,
+        const std::string& fieldname, const std::string&) {
+    const Query q = QueryParser::buildQuery(query);
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    std::map<std::string, uint32_t> counts;
+    std::vector<Result> results;
+    p->results(q, results, 0, -1);
+    std::vector<std::vector<uint32_t> > docs(p->segments.size());
+    std::vector<Result>::const_iterator i;
+    for (i = results.begin(); i != results.end(); ++i) {
+        docs[i->segment].push_back(i->doc);
+    }
+    std::vector<std::pair<std::string,uint32_t> > part;
+    std::vector<std::string> v;
+    for (size_t s = 0; s < docs.size(); ++s) {
+        const SegmentReader& reader = *p->segments[s]->reader;
+        const Column* column = reader.column(reader.fieldNumber(fieldname));
+        if (column) {
+            std::sort(docs[s].begin(), docs[s].end());
+            part.clear();
+            column->histogram(docs[s], part);
+            std::vector<std::pair<std::string,uint32_t> >::const_iterator j;
+            for (j = part.begin(); j != part.end(); ++j) {
+                counts[j->first] += j->second;
+            }
+            continue;
+        }
+        Result r;
+        r.segment = (uint32_t)s;
+        std::vector<uint32_t>::const_iterator d;
+        for (d = docs[s].begin(); d != docs[s].end(); ++d) {
+            r.doc = *d;
+            Private::Row(*p, r).values(fieldname, v);
+            std::vector<std::string>::const_iterator j;
+            for (j = v.begin(); j != v.end(); ++j) {
+                ++counts[*j];
+            }
+        }
+    }
+    std::vector<std::pair<std::string,uint32_t> > h(counts.begin(),
+        counts.end());
+    bool numeric = true;
+    double d;
+    std::vector<std::pair<std::string,uint32_t> >::const_iterator j;
+    for (j = h.begin(); numeric && j != h.end(); ++j) {
+        numeric = toNumber(j->first, d);
+    }
+    if (numeric) {
+        std::sort(h.begin(), h.end(),
+            [](const std::pair<std::string,uint32_t>& a,
+                    const std::pair<std::string,uint32_t>& b) {
+                return compareValues(a.first, b.first) < 0;
+            });
+    }
+    return h;
+}
+int32_t
+SegmentIndexReader::countKeywords(const std::string& keywordprefix,
+        const std::vector<std::string>& fieldnames) {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    return p->countTerms(keywordprefix, fieldnames);
+}
+std::vector<std::string>
+SegmentIndexReader::keywords(const std::string& keywordmatch,
+        const std::vector<std::string>& fieldnames,
+        uint32_t max, uint32_t offset) {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->refresh();
+    std::vector<std::string> k;
+    if (max == 0) {
+        return k;
+    }
+    std::vector<Private::TermRange> ranges;
+    p->termRanges(keywordmatch, fieldnames, ranges);
+    if (ranges.size() == 1) {
+        // the page of a single dictionary starts at an ordinal
+        const Private::TermRange& r = ranges[0];
+        SegmentReader::TermIterator t;
+        if (offset < r.count && t.seekOrdinal(*r.segment->reader, r.field,
+                r.first + offset)) {
+            uint32_t left = r.count - offset;
+            do {
+                k.push_back(t.term());
+            } while (k.size() < max && --left && t.next());
+        }
+        return k;
+    }
+    p->forEachTerm(ranges,
+        [&](const std::string& term) {
+            if (offset) {
+                --offset;
+            } else {
+                k.push_back(term);
+            }
+            return k.size() < max;
+        });
+    return k;
+}
@@ -0,0 +1,71 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_SEGMENTINDEXREADER_H
+#define STRIGI_SEGMENTINDEXREADER_H
+
+#include <strigi/indexreader.h>
+
+namespace Strigi {
+
+/**
+ * Reads a segment index.
+ *
+ * The reader works on the segments that were committed when it was last
+ * used. Before each call, it checks if the list of segments has changed
+ * and opens the new segments. All functions may be called from several
+ * threads at once.
+ *
+ * A query without fields searches the words of the text and the file
+ * names. Words are matched without regard to case; other values are
+ * matched as specified by the Term of the query.
+ **/
+class SegmentIndexReader : public IndexReader {
+private:
+    class Private;
+    Private* const p;
+public:
+    explicit SegmentIndexReader(const std::string& dir);
+    ~SegmentIndexReader();
+    int32_t countHits(const Query& query);
+    std::vector<IndexedDocument> query(const Query&, int off, int max);
+    void getHits(const Query& query, const std::vector<std::string>& fields,
+        const std::vector<Variant::Type>& types,
+        std::vector<std::vector<Variant> >& result, int off, int max);
+    void getChildren(const std::string& parent,
+        std::map<std::string, time_t>& children);
+    int32_t countDocuments();
+    int32_t countWords();
+    int64_t indexSize();
+    time_t mTime(const std::string& path);
+    std::vector<std::string> fieldNames();
+    std::vector<std::pair<std::string,uint32_t> > histogram(
+        const std::string& query, const std::string& fieldname,
+        const std::string& labeltype);
+    int32_t countKeywords(const std::string& keywordprefix,
+        const std::vector<std::string>& fieldnames);
+    std::vector<std::string> keywords(const std::string& keywordmatch,
+        const std::vector<std::string>& fieldnames,
+        uint32_t max, uint32_t offset);
+};
+
+}
+
+#endif
@@ -0,0 +1,814 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "segmentindexwriter.h"
+#include "segmentreader.h"
+#include "segmentwriter.h"
+#include "tokenizer.h"
+#include <strigi/analysisresult.h>
+#include <strigi/fieldtypes.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+
+using namespace Strigi;
+
+namespace {
+/**
+ * When the documents in memory take more than this many bytes, they are
+ * committed.
+ **/
+const size_t maxBufferSize = 32 * 1024 * 1024;
+/**
+ * The number of bytes of text that is stored as a fragment of a document.
+ **/
+const size_t fragmentSize = 256;
+/**
+ * Values longer than this are stored but cannot be searched for.
+ **/
+const size_t maxTermLength = 4096;
+/**
+ * When there are this many segments of about the same size, they are
+ * merged into one.
+ **/
+const size_t mergeFactor = 10;
+
+/**
+ * The level of a segment for merging. Segments on the same level have
+ * about the same number of documents.
+ **/
+int
+mergeLevel(const SegmentInfo& info) {
+    int level = 0;
+    for (uint32_t n = (info.docCount - info.delCount) / mergeFactor; n;
+            n /= mergeFactor) {
+        ++level;
+    }
+    return level;
+}
+/**
+ * Cut @p s to at most @p n bytes without splitting a UTF-8 character.
+ **/
+void
+truncateUtf8(std::string& s, size_t n) {
+    if (s.length() > n) {
+        while (n > 0 && (s[n] & 0xc0) == 0x80) {
+            --n;
+        }
+        s.resize(n);
+    }
+}
+}
+
+class SegmentIndexWriter::Private {
+public:
+    /**
+     * The values and words of a document that is being analyzed.
+     **/
+    class Document {
+    public:
+        std::vector<std::pair<std::string, std::string> > values;
+        // the positions of each word of the text
+        std::map<std::string, std::vector<uint32_t> > words;
+        std::vector<Token> newWords;
+        Tokenizer tokenizer;
+        std::string fragment;
+
+        void addWords() {
+            std::vector<Token>::const_iterator i;
+            for (i = newWords.begin(); i != newWords.end(); ++i) {
+                words[i->word].push_back(i->position);
+            }
+            newWords.clear();
+        }
+    };
+    /**
+     * A document that is buffered until the next commit.
+     **/
+    class BufferedDocument {
+    public:
+        std::string path;
+        std::vector<std::pair<std::string, std::string> > values;
+        bool deleted;
+    };
+    typedef std::map<std::string, std::map<std::string, std::vector<Posting> > >
+        PostingsBuffer;
+    typedef std::map<std::string, std::vector<uint32_t> > PositionsBuffer;
+
+    const std::string dir;
+    std::mutex mutex;
+    SegmentInfos infos;
+    std::map<std::string, SegmentReader*> readers;
+    std::vector<BufferedDocument> docs;
+    PostingsBuffer postings;
+    // the positions of the postings of each content word after each other
+    PositionsBuffer positions;
+    std::vector<std::string> pendingDeletes;
+    size_t bufferSize;
+    // the buffer is committed when it grows beyond this size
+    size_t commitSize;
+    // the descriptor of write.lock while the lock is held, or -1
+    int lockFd;
+
+    explicit Private(const std::string& d);
+    ~Private();
+    void addValue(const AnalysisResult* ar, const RegisteredField* field,
+        const std::string& value);
+    void addDocument(const AnalysisResult* ar, Document* doc);
+    SegmentReader* reader(const SegmentInfo& info);
+    bool readDeletions(const SegmentInfo& info, DeletionBitmap& bits);
+    bool applyDeletes(SegmentInfos& next);
+    bool flush(SegmentInfos& next);
+    bool merge(SegmentInfos& next, const std::vector<size_t>& which);
+    bool maybeMerge(SegmentInfos& next);
+    bool publish(const SegmentInfos& next);
+    bool lock();
+    void removeUnusedFiles();
+    void clearBuffer();
+    void commit();
+};
+
+SegmentIndexWriter::Private::Private(const std::string& d)
+        :dir(d), bufferSize(0), commitSize(maxBufferSize), lockFd(-1) {
+    if (!lock()) {
+        fprintf(stderr, "The segment index in %s is locked by another "
+            "writer.\n", dir.c_str());
+    }
+}
+SegmentIndexWriter::Private::~Private() {
+    std::map<std::string, SegmentReader*>::const_iterator i;
+    for (i = readers.begin(); i != readers.end(); ++i) {
+        delete i->second;
+    }
+    if (lockFd != -1) {
+        // closing the file releases the lock
+        close(lockFd);
+    }
+}
+/**
+ * Take the write lock of the index if it is not held yet. The list of
+ * segments is read after the lock is taken, because another writer may
+ * have changed it until then.
+ * @return true if the lock is held
+ **/
+bool
+SegmentIndexWriter::Private::lock() {
+    if (lockFd != -1) {
+        return true;
+    }
+    const int fd = open((dir + "/write.lock").c_str(),
+        O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        return false;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        close(fd);
+        return false;
+    }
+    lockFd = fd;
+    if (!infos.read(dir)) {
+        fprintf(stderr, "The segment index in %s cannot be read.\n",
+            dir.c_str());
+    }
+    // remove what is left of commits that did not finish
+    removeUnusedFiles();
+    return true;
+}
+void
+SegmentIndexWriter::Private::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, const std::string& value) {
+    Document* doc = static_cast<Document*>(ar->writerData());
+    if (field->key() == FieldRegister::contentFieldName) {
+        // the value follows the text, but its words are not joined to it
+        doc->tokenizer.finish(doc->newWords);
+        doc->tokenizer.tokenize(value.c_str(), (int32_t)value.length(),
+            doc->newWords);
+        doc->tokenizer.finish(doc->newWords);
+        doc->addWords();
+    } else {
+        doc->values.push_back(std::make_pair(field->key(), value));
+    }
+}
+/**
+ * Add the document that was analyzed to the buffer.
+ **/
+void
+SegmentIndexWriter::Private::addDocument(const AnalysisResult* ar,
+        Document* doc) {
+    BufferedDocument buffered;
+    buffered.path = ar->path();
+    buffered.values.swap(doc->values);
+    buffered.deleted = false;
+    if (doc->fragment.length()) {
+        truncateUtf8(doc->fragment, fragmentSize);
+        buffered.values.push_back(std::make_pair(
+            FieldRegister::contentFieldName, doc->fragment));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const uint32_t docid = (uint32_t)docs.size();
+    std::vector<std::pair<std::string, std::string> >::const_iterator i;
+    for (i = buffered.values.begin(); i != buffered.values.end(); ++i) {
+        bufferSize += i->first.length() + i->second.length()
+            + sizeof(Posting);
+        if (i->second.length() > maxTermLength
+                || i->first == FieldRegister::contentFieldName) {
+            continue;
+        }
+        std::vector<Posting>& p = postings[i->first][i->second];
+        if (p.size() && p.back().doc == docid) {
+            ++p.back().freq;
+        } else {
+            p.push_back(Posting(docid, 1));
+        }
+    }
+    if (doc->words.size()) {
+        std::map<std::string, std::vector<Posting> >& content
+            = postings[FieldRegister::contentFieldName];
+        std::map<std::string, std::vector<uint32_t> >::const_iterator j;
+        for (j = doc->words.begin(); j != doc->words.end(); ++j) {
+            content[j->first].push_back(Posting(docid,
+                (uint32_t)j->second.size()));
+            std::vector<uint32_t>& p = positions[j->first];
+            p.insert(p.end(), j->second.begin(), j->second.end());
+            bufferSize += j->first.length() + sizeof(Posting)
+                + j->second.size() * sizeof(uint32_t);
+        }
+    }
+    docs.push_back(buffered);
+    if (bufferSize > commitSize) {
+        commit();
+    }
+}
+SegmentReader*
+SegmentIndexWriter::Private::reader(const SegmentInfo& info) {
+    std::map<std::string, SegmentReader*>::const_iterator i
+        = readers.find(info.name);
+    if (i != readers.end()) {
+        return i->second;
+    }
+    SegmentReader* r = SegmentReader::open(dir, info);
+    if (r) {
+        readers[info.name] = r;
+    }
+    return r;
+}
+bool
+SegmentIndexWriter::Private::readDeletions(const SegmentInfo& info,
+        DeletionBitmap& bits) {
+    bits = DeletionBitmap(info.docCount);
+    return info.delGen == 0
+        || bits.read(dir + '/' + info.delFileName(), info.docCount);
+}
+/**
+ * Mark the documents with the paths in pendingDeletes and the documents
+ * below these paths as deleted.
+ **/
+bool
+SegmentIndexWriter::Private::applyDeletes(SegmentInfos& next) {
+    if (pendingDeletes.empty()) {
+        return true;
+    }
+    std::sort(pendingDeletes.begin(), pendingDeletes.end());
+    std::vector<SegmentInfo>::iterator s;
+    for (s = next.segments.begin(); s != next.segments.end(); ++s) {
+        SegmentReader* r = reader(*s);
+        DeletionBitmap bits;
+        if (r == 0 || !readDeletions(*s, bits)) {
+            return false;
+        }
+        const int field = r->fieldNumber(FieldRegister::pathFieldName);
+        bool changed = false;
+        std::vector<Posting> docs;
+        SegmentReader::TermIterator t;
+        std::vector<std::string>::const_iterator i;
+        for (i = pendingDeletes.begin(); i != pendingDeletes.end(); ++i) {
+            if (r->findTerm(field, *i, t)) {
+                r->postings(t, docs);
+            }
+            const std::string prefix(*i + '/');
+            for (bool ok = t.seek(*r, field, prefix); ok
+                    && t.term().compare(0, prefix.length(), prefix) == 0;
+                    ok = t.next()) {
+                r->postings(t, docs);
+            }
+        }
+        std::vector<Posting>::const_iterator d;
+        for (d = docs.begin(); d != docs.end(); ++d) {
+            if (!bits.get(d->doc)) {
+                bits.set(d->doc);
+                changed = true;
+            }
+        }
+        if (changed) {
+            ++s->delGen;
+            s->delCount = bits.count();
+            if (!bits.write(dir + '/' + s->delFileName())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+/**
+ * Write the documents in the buffer to a new segment.
+ **/
+bool
+SegmentIndexWriter::Private::flush(SegmentInfos& next) {
+    // the numbers of the documents in the new segment
+    std::vector<uint32_t> docMap(docs.size());
+    uint32_t live = 0;
+    for (size_t i = 0; i < docs.size(); ++i) {
+        docMap[i] = (docs[i].deleted) ?~0u :live++;
+    }
+    if (live == 0) {
+        return true;
+    }
+    std::set<std::string> fieldSet;
+    PostingsBuffer::const_iterator f;
+    for (f = postings.begin(); f != postings.end(); ++f) {
+        fieldSet.insert(f->first);
+    }
+    std::vector<BufferedDocument>::const_iterator d;
+    std::vector<std::pair<std::string, std::string> >::const_iterator v;
+    for (d = docs.begin(); d != docs.end(); ++d) {
+        for (v = d->values.begin(); v != d->values.end(); ++v) {
+            fieldSet.insert(v->first);
+        }
+    }
+    const std::vector<std::string> fields(fieldSet.begin(), fieldSet.end());
+
+    SegmentInfo info;
+    info.name = next.newSegmentName();
+    SegmentWriter writer(dir, info.name, fields);
+    if (!writer.open()) {
+        return false;
+    }
+    StoredDocument stored;
+    for (d = docs.begin(); d != docs.end(); ++d) {
+        if (d->deleted) {
+            continue;
+        }
+        stored.clear();
+        for (v = d->values.begin(); v != d->values.end(); ++v) {
+            stored.push_back(std::make_pair((uint32_t)(std::lower_bound(
+                fields.begin(), fields.end(), v->first) - fields.begin()),
+                v->second));
+        }
+        writer.addDocument(stored);
+    }
+    std::vector<Posting> mapped;
+    std::vector<uint32_t> mappedPositions;
+    uint32_t fieldNumber = 0;
+    for (f = postings.begin(); f != postings.end(); ++f) {
+        while (fields[fieldNumber] != f->first) {
+            ++fieldNumber;
+        }
+        const bool content = f->first == FieldRegister::contentFieldName;
+        std::map<std::string, std::vector<Posting> >::const_iterator t;
+        for (t = f->second.begin(); t != f->second.end(); ++t) {
+            mapped.clear();
+            mappedPositions.clear();
+            const std::vector<uint32_t>* all = (content)
+                ?&positions[t->first] :0;
+            size_t k = 0;
+            std::vector<Posting>::const_iterator p;
+            for (p = t->second.begin(); p != t->second.end(); ++p) {
+                if (docMap[p->doc] != ~0u) {
+                    mapped.push_back(Posting(docMap[p->doc], p->freq));
+                    if (all) {
+                        mappedPositions.insert(mappedPositions.end(),
+                            all->begin() + k, all->begin() + k + p->freq);
+                    }
+                }
+                k += p->freq;
+            }
+            writer.addTerm(fieldNumber, t->first, mapped,
+                (content) ?&mappedPositions :0);
+        }
+    }
+    info.docCount = writer.docCount();
+    if (!writer.finish()) {
+        return false;
+    }
+    next.segments.push_back(info);
+    return true;
+}
+/**
+ * Merge the segments at the positions @p which in @p next into one
+ * segment without the deleted documents.
+ **/
+bool
+SegmentIndexWriter::Private::merge(SegmentInfos& next,
+        const std::vector<size_t>& which) {
+    std::vector<SegmentReader*> in;
+    std::vector<std::vector<uint32_t> > docMaps;
+    std::set<std::string> fieldSet;
+    uint32_t live = 0;
+    std::vector<size_t>::const_iterator w;
+    for (w = which.begin(); w != which.end(); ++w) {
+        const SegmentInfo& info = next.segments[*w];
+        SegmentReader* r = reader(info);
+        DeletionBitmap bits;
+        if (r == 0 || !readDeletions(info, bits)) {
+            return false;
+        }
+        in.push_back(r);
+        docMaps.push_back(std::vector<uint32_t>(info.docCount));
+        std::vector<uint32_t>& docMap = docMaps.back();
+        for (uint32_t i = 0; i < info.docCount; ++i) {
+            docMap[i] = (bits.get(i)) ?~0u :live++;
+        }
+        fieldSet.insert(r->fieldNames().begin(), r->fieldNames().end());
+    }
+    const std::vector<std::string> fields(fieldSet.begin(), fieldSet.end());
+
+    SegmentInfo info;
+    info.name = next.newSegmentName();
+    SegmentWriter writer(dir, info.name, fields);
+    if (!writer.open()) {
+        return false;
+    }
+    // the numbers of the fields of each segment in the new segment
+    std::vector<std::vector<uint32_t> > fieldMaps(in.size());
+    for (size_t s = 0; s < in.size(); ++s) {
+        const std::vector<std::string>& names = in[s]->fieldNames();
+        for (size_t f = 0; f < names.size(); ++f) {
+            fieldMaps[s].push_back((uint32_t)(std::lower_bound(fields.begin(),
+                fields.end(), names[f]) - fields.begin()));
+        }
+        StoredDocument stored;
+        for (uint32_t d = 0; d < in[s]->docCount(); ++d) {
+            if (docMaps[s][d] == ~0u) {
+                continue;
+            }
+            if (!in[s]->document(d, stored)) {
+                return false;
+            }
+            StoredDocument::iterator v;
+            for (v = stored.begin(); v != stored.end(); ++v) {
+                v->first = fieldMaps[s][v->first];
+            }
+            writer.addDocument(stored);
+        }
+    }
+    std::vector<SegmentReader::TermIterator> terms(in.size());
+    std::vector<bool> valid(in.size());
+    std::vector<Posting> postings;
+    std::vector<Posting> merged;
+    std::vector<uint32_t> group;
+    std::vector<uint32_t> mergedPositions;
+    for (uint32_t f = 0; f < fields.size(); ++f) {
+        // the field has positions if all segments that have it do
+        bool withPositions = true;
+        for (size_t s = 0; s < in.size(); ++s) {
+            const int field = in[s]->fieldNumber(fields[f]);
+            valid[s] = terms[s].seek(*in[s], field, std::string());
+            withPositions = withPositions
+                && (field < 0 || in[s]->hasPositions(field));
+        }
+        for (;;) {
+            // the smallest term of all segments
+            const std::string* term = 0;
+            for (size_t s = 0; s < in.size(); ++s) {
+                if (valid[s] && (term == 0 || terms[s].term() < *term)) {
+                    term = &terms[s].term();
+                }
+            }
+            if (term == 0) {
+                break;
+            }
+            const std::string t(*term);
+            merged.clear();
+            mergedPositions.clear();
+            for (size_t s = 0; s < in.size(); ++s) {
+                if (valid[s] && terms[s].term() == t) {
+                    postings.clear();
+                    in[s]->postings(terms[s], postings);
+                    PositionReader positions;
+                    if (withPositions
+                            && !in[s]->positions(terms[s], positions)) {
+                        return false;
+                    }
+                    for (size_t p = 0; p < postings.size(); ++p) {
+                        if (docMaps[s][postings[p].doc] == ~0u) {
+                            continue;
+                        }
+                        merged.push_back(Posting(docMaps[s][postings[p].doc],
+                            postings[p].freq));
+                        if (withPositions) {
+                            if (!positions.read((uint32_t)p, group)
+                                    || group.size() != postings[p].freq) {
+                                return false;
+                            }
+                            mergedPositions.insert(mergedPositions.end(),
+                                group.begin(), group.end());
+                        }
+                    }
+                    valid[s] = terms[s].next();
+                }
+            }
+            writer.addTerm(f, t, merged,
+                (withPositions) ?&mergedPositions :0);
+        }
+    }
+    info.docCount = writer.docCount();
+    if (!writer.finish()) {
+        return false;
+    }
+    // the new segment takes the place of the first merged segment
+    std::vector<SegmentInfo> segments;
+    for (size_t s = 0; s < next.segments.size(); ++s) {
+        if (s == which[0]) {
+            segments.push_back(info);
+        } else if (std::find(which.begin(), which.end(), s) == which.end()) {
+            segments.push_back(next.segments[s]);
+        }
+    }
+    next.segments.swap(segments);
+    return true;
+}
+/**
+ * Merge segments when there are too many segments of the same size and
+ * drop segments in which all documents are deleted.
+ **/
+bool
+SegmentIndexWriter::Private::maybeMerge(SegmentInfos& next) {
+    std::vector<SegmentInfo>::iterator s = next.segments.begin();
+    while (s != next.segments.end()) {
+        if (s->delCount == s->docCount) {
+            s = next.segments.erase(s);
+        } else {
+            ++s;
+        }
+    }
+    bool merged;
+    do {
+        merged = false;
+        std::map<int, std::vector<size_t> > levels;
+        for (size_t i = 0; i < next.segments.size(); ++i) {
+            levels[mergeLevel(next.segments[i])].push_back(i);
+        }
+        std::map<int, std::vector<size_t> >::const_iterator l;
+        for (l = levels.begin(); !merged && l != levels.end(); ++l) {
+            if (l->second.size() >= mergeFactor) {
+                if (!merge(next, l->second)) {
+                    return false;
+                }
+                merged = true;
+            }
+        }
+    } while (merged);
+    return true;
+}
+/**
+ * Make @p next the current list of segments. Must be called with the write
+ * lock held.
+ * @return true if the list was written
+ **/
+bool
+SegmentIndexWriter::Private::publish(const SegmentInfos& next) {
+    if (!next.write(dir)) {
+        fprintf(stderr, "The segment index in %s cannot be written.\n",
+            dir.c_str());
+        return false;
+    }
+    infos = next;
+    std::map<std::string, SegmentReader*>::iterator i = readers.begin();
+    while (i != readers.end()) {
+        std::vector<SegmentInfo>::const_iterator s;
+        for (s = infos.segments.begin(); s != infos.segments.end()
+                && s->name != i->first; ++s) {}
+        if (s == infos.segments.end()) {
+            delete i->second;
+            readers.erase(i++);
+        } else {
+            ++i;
+        }
+    }
+    removeUnusedFiles();
+    return true;
+}
+/**
+ * Remove the files of segments that are not in the list of segments.
+ * Readers that still use them keep them open until they read the new list.
+ * Must be called with the write lock held, because the files of a commit
+ * of another writer are not in the list until it is published.
+ **/
+void
+SegmentIndexWriter::Private::removeUnusedFiles() {
+    if (lockFd == -1) {
+        return;
+    }
+    std::set<std::string> used;
+    std::vector<SegmentInfo>::const_iterator s;
+    for (s = infos.segments.begin(); s != infos.segments.end(); ++s) {
+        used.insert(s->fileName("tis"));
+        used.insert(s->fileName("pst"));
+        used.insert(s->fileName("fld"));
+        used.insert(s->fileName("dv"));
+        used.insert(s->fileName("tri"));
+        used.insert(s->fileName("pos"));
+        if (s->delGen) {
+            used.insert(s->delFileName());
+        }
+    }
+    DIR* d = opendir(dir.c_str());
+    if (d == 0) {
+        return;
+    }
+    while (struct dirent* e = readdir(d)) {
+        if (e->d_name[0] == '_' && used.find(e->d_name) == used.end()) {
+            unlink((dir + '/' + e->d_name).c_str());
+        }
+    }
+    closedir(d);
+}
+void
+SegmentIndexWriter::Private::clearBuffer() {
+    docs.clear();
+    postings.clear();
+    positions.clear();
+    pendingDeletes.clear();
+    bufferSize = 0;
+}
+void
+SegmentIndexWriter::Private::commit() {
+    if (docs.empty() && pendingDeletes.empty()) {
+        return;
+    }
+    // taking the lock reads the segments, so they are copied after it
+    bool written = lock();
+    SegmentInfos next(infos);
+    if (written && applyDeletes(next) && flush(next) && maybeMerge(next)
+            && publish(next)) {
+        clearBuffer();
+        commitSize = maxBufferSize;
+        return;
+    }
+    // the documents and deletions are kept for the next commit; the files
+    // that were written for this one are not in the list of segments
+    fprintf(stderr, "The changes to the segment index in %s cannot be "
+        "written yet.\n", dir.c_str());
+    removeUnusedFiles();
+    // do not try again for each new document
+    commitSize = bufferSize + maxBufferSize;
+}
+
+SegmentIndexWriter::SegmentIndexWriter(const std::string& dir)
+        :p(new Private(dir)) {
+}
+SegmentIndexWriter::~SegmentIndexWriter() {
+    delete p;
+}
+void
+SegmentIndexWriter::startAnalysis(const AnalysisResult* ar) {
+    ar->setWriterData(new Private::Document());
+}
+void
+SegmentIndexWriter::addText(const AnalysisResult* ar, const char* text,
+        int32_t length) {
+    Private::Document* doc = static_cast<Private::Document*>(ar->writerData());
+    if (doc->fragment.length() <= fragmentSize) {
+        doc->fragment.append(text, std::min((size_t)length,
+            fragmentSize + 1 - doc->fragment.length()));
+    }
+    doc->tokenizer.tokenize(text, length, doc->newWords);
+    doc->addWords();
+}
+void
+SegmentIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, const std::string& value) {
+    p->addValue(ar, field, value);
+}
+void
+SegmentIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, const unsigned char* data,
+        uint32_t size) {
+    if (!field->properties().binary()) {
+        p->addValue(ar, field, std::string((const char*)data, size));
+    }
+}
+void
+SegmentIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, int32_t value) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d", value);
+    p->addValue(ar, field, buf);
+}
+void
+SegmentIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, uint32_t value) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u", value);
+    p->addValue(ar, field, buf);
+}
+void
+SegmentIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, double value) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.15g", value);
+    p->addValue(ar, field, buf);
+}
+void
+SegmentIndexWriter::addValue(const AnalysisResult* ar,
+        const RegisteredField* field, const std::string& name,
+        const std::string& value) {
+    p->addValue(ar, field, name + '=' + value);
+}
+void
+SegmentIndexWriter::addTriplet(const std::string&, const std::string&,
+        const std::string&) {
+}
+void
+SegmentIndexWriter::finishAnalysis(const AnalysisResult* ar) {
+    Private::Document* doc = static_cast<Private::Document*>(ar->writerData());
+    doc->tokenizer.finish(doc->newWords);
+    doc->addWords();
+    p->addDocument(ar, doc);
+    delete doc;
+    ar->setWriterData(0);
+}
+void
+SegmentIndexWriter::commit() {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->commit();
+}
+void
+SegmentIndexWriter::deleteEntries(const std::vector<std::string>& entries) {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    // the documents in the buffer are deleted now, those in the segments
+    // during the next commit
+    std::vector<Private::BufferedDocument>::iterator d;
+    std::vector<std::string>::const_iterator i;
+    for (d = p->docs.begin(); d != p->docs.end(); ++d) {
+        for (i = entries.begin(); !d->deleted && i != entries.end(); ++i) {
+            d->deleted = d->path == *i || (d->path.length() > i->length()
+                && d->path[i->length()] == '/'
+                && d->path.compare(0, i->length(), *i) == 0);
+        }
+    }
+    p->pendingDeletes.insert(p->pendingDeletes.end(), entries.begin(),
+        entries.end());
+}
+void
+SegmentIndexWriter::deleteAllEntries() {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    if (!p->lock()) {
+        fprintf(stderr, "The segment index in %s cannot be cleared.\n",
+            p->dir.c_str());
+        return;
+    }
+    p->clearBuffer();
+    SegmentInfos next(p->infos);
+    next.segments.clear();
+    p->publish(next);
+}
+int
+SegmentIndexWriter::itemsInCache() {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    return (int)p->docs.size();
+}
+void
+SegmentIndexWriter::optimize() {
+    std::lock_guard<std::mutex> lock(p->mutex);
+    p->commit();
+    if (!p->lock()) {
+        return;
+    }
+    SegmentInfos next(p->infos);
+    if (next.segments.size() < 2 && (next.segments.empty()
+            || next.segments[0].delCount == 0)) {
+        return;
+    }
+    std::vector<size_t> all;
+    for (size_t i = 0; i < next.segments.size(); ++i) {
+        all.push_back(i);
+    }
+    if (p->merge(next, all)) {
+        p->publish(next);
+    }
+}
@@ -0,0 +1,82 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_SEGMENTINDEXWRITER_H
+#define STRIGI_SEGMENTINDEXWRITER_H
+
+#include <strigi/indexwriter.h>
+
+namespace Strigi {
+
+/**
+ * Writes documents to a segment index.
+ *
+ * Documents are collected in memory until commit() is called; then they
+ * are written to a new segment and the list of segments is replaced. When
+ * the buffer grows too large, it is committed before it is full. Entries
+ * are deleted by marking them in the deletion bitmaps of the segments.
+ * Small segments are merged into larger ones during a commit.
+ *
+ * All functions may be called from several threads at once. Only one
+ * SegmentIndexWriter may write to a directory at a time: it takes an
+ * exclusive lock on the file write.lock in the directory when it is made or,
+ * if another writer holds the lock then, at a later commit. Until it has
+ * the lock, the documents stay in memory
+ * and nothing is written or removed. When a commit fails, the documents
+ * and deletions stay in memory too, and the next commit tries again.
+ **/
+class SegmentIndexWriter : public IndexWriter {
+private:
+    class Private;
+    Private* const p;
+protected:
+    void startAnalysis(const AnalysisResult*);
+    void addText(const AnalysisResult*, const char* text, int32_t length);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        const std::string& value);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        const unsigned char* data, uint32_t size);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        int32_t value);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        uint32_t value);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        double value);
+    void addValue(const AnalysisResult*, const RegisteredField* field,
+        const std::string& name, const std::string& value);
+    void finishAnalysis(const AnalysisResult*);
+    void addTriplet(const std::string& subject,
+        const std::string& predicate, const std::string& object);
+public:
+    explicit SegmentIndexWriter(const std::string& dir);
+    ~SegmentIndexWriter();
+    void commit();
+    void deleteEntries(const std::vector<std::string>& entries);
+    void deleteAllEntries();
+    int itemsInCache();
+    /**
+     * Merge all segments into one.
+     **/
+    void optimize();
+};
+
+}
+
+#endif
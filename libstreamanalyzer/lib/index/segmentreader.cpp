@@ -0,0 +1,367 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "segmentreader.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace Strigi;
+
+class SegmentReader::Field {
+public:
+    uint32_t termCount;
+    Fst terms;
+    // the tables with the number of documents and the offsets of the
+    // postings and the positions of each term
+    const char* docFreqs;
+    const char* offsets;
+    const char* positionOffsets;
+    uint64_t postingsBase;
+    uint64_t positionsBase;
+    unsigned docFreqBits;
+    unsigned offsetBits;
+    unsigned positionBits;
+    bool hasPositions;
+    Column column;
+    bool hasColumn;
+    TrigramTable trigrams;
+    Field() :termCount(0), docFreqs(0), offsets(0), positionOffsets(0),
+        postingsBase(0), positionsBase(0), docFreqBits(0), offsetBits(0),
+        positionBits(0), hasPositions(false), hasColumn(false) {}
+};
+
+namespace {
+bool
+hasMagic(const MappedFile& f, const char* magic) {
+    return f.size() >= 2 * magicSize
+        && memcmp(f.data(), magic, magicSize) == 0
+        && memcmp(f.data() + f.size() - magicSize, magic, magicSize) == 0;
+}
+}
+
+SegmentReader::SegmentReader(const std::string& name)
+        :m_name(name), m_docCount(0), fieldTable(0) {
+}
+SegmentReader::~SegmentReader() {
+    std::vector<Field*>::const_iterator i;
+    for (i = fields.begin(); i != fields.end(); ++i) {
+        delete *i;
+    }
+}
+SegmentReader*
+SegmentReader::open(const std::string& dir, const SegmentInfo& info) {
+    SegmentReader* r = new SegmentReader(info.name);
+    if (!r->read(dir, info)) {
+        delete r;
+        r = 0;
+    }
+    return r;
+}
+bool
+SegmentReader::read(const std::string& dir, const SegmentInfo& info) {
+    if (!tis.open(dir + '/' + info.fileName("tis"))
+            || !pst.open(dir + '/' + info.fileName("pst"))
+            || !fld.open(dir + '/' + info.fileName("fld"))
+            || !dv.open(dir + '/' + info.fileName("dv"))
+            || !tri.open(dir + '/' + info.fileName("tri"))
+            || !pos.open(dir + '/' + info.fileName("pos"))
+            || !hasMagic(tis, tisMagic) || !hasMagic(fld, fldMagic)
+            || !hasMagic(dv, dvMagic) || !hasMagic(tri, triMagic)
+            || !hasMagic(pos, posMagic)
+            || pst.size() < magicSize
+            || memcmp(pst.data(), pstMagic, magicSize) != 0) {
+        return false;
+    }
+    // the table with the offsets of the stored documents
+    const char* end = fld.data() + fld.size() - magicSize;
+    if (fld.size() < 3 * magicSize + 4) {
+        return false;
+    }
+    m_docCount = getFixed32(end - 4);
+    fieldTable = getFixed64(end - 12);
+    if (m_docCount != info.docCount
+            || fieldTable + 8 * (uint64_t)m_docCount + 12 + magicSize
+                != fld.size()) {
+        return false;
+    }
+    return readIndex() && readColumns() && readTrigrams();
+}
+bool
+SegmentReader::readIndex() {
+    const char* end = tis.data() + tis.size() - magicSize;
+    if (tis.size() < 3 * magicSize) {
+        return false;
+    }
+    uint64_t offset = getFixed64(end - 8);
+    if (offset < magicSize || offset > tis.size() - 2 * magicSize) {
+        return false;
+    }
+    end -= 8;
+    const char* p = tis.data() + offset;
+    uint64_t n;
+    if (!getVarint(p, end, n) || n > (uint64_t)(end - p)) {
+        return false;
+    }
+    names.resize((size_t)n);
+    fields.reserve((size_t)n);
+    for (uint64_t i = 0; i < n; ++i) {
+        Field* field = new Field();
+        fields.push_back(field);
+        uint64_t count;
+        if (!getBytes(p, end, names[i]) || !getVarint(p, end, count)
+                || count > 0xffffffff) {
+            return false;
+        }
+        field->termCount = (uint32_t)count;
+        if (count == 0) {
+            continue;
+        }
+        uint64_t start, size, root, freqBits, offsetBits, positions;
+        uint64_t positionBits = 0;
+        if (!getVarint(p, end, start) || !getVarint(p, end, size)
+                || !getVarint(p, end, root)
+                || !getVarint(p, end, field->postingsBase)
+                || !getVarint(p, end, freqBits)
+                || !getVarint(p, end, offsetBits)
+                || !getVarint(p, end, positions) || positions > 1
+                || (positions && (!getVarint(p, end, field->positionsBase)
+                    || !getVarint(p, end, positionBits)))
+                || freqBits > 32 || offsetBits > 56 || positionBits > 56
+                || start < magicSize || start > offset
+                || size > offset - start
+                || packedSize(count, (unsigned)freqBits)
+                    + packedSize(count, (unsigned)offsetBits)
+                    + ((positions) ?packedSize(count, (unsigned)positionBits)
+                        :0) > offset - start - size
+                || !field->terms.init(tis.data() + start, (size_t)size, root)
+                || field->terms.size() != count) {
+            return false;
+        }
+        field->docFreqBits = (unsigned)freqBits;
+        field->offsetBits = (unsigned)offsetBits;
+        field->docFreqs = tis.data() + start + size;
+        field->offsets = field->docFreqs
+            + packedSize(count, field->docFreqBits);
+        field->hasPositions = positions != 0;
+        field->positionBits = (unsigned)positionBits;
+        field->positionOffsets = field->offsets
+            + packedSize(count, field->offsetBits);
+    }
+    return p == end;
+}
+bool
+SegmentReader::readColumns() {
+    const char* end = dv.data() + dv.size() - magicSize;
+    if (dv.size() < 2 * magicSize + 8) {
+        return false;
+    }
+    end -= 8;
+    const uint64_t offset = getFixed64(end);
+    if (offset < magicSize || offset > (uint64_t)(end - dv.data())) {
+        return false;
+    }
+    const char* p = dv.data() + offset;
+    uint64_t n;
+    if (!getVarint(p, end, n) || n > fields.size()) {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t field, start, size;
+        if (!getVarint(p, end, field) || !getVarint(p, end, start)
+                || !getVarint(p, end, size) || field >= fields.size()
+                || start < magicSize || start > offset
+                || size > offset - start) {
+            return false;
+        }
+        Field* f = fields[(size_t)field];
+        if (f->hasColumn || !f->column.init(dv.data() + start,
+                dv.data() + start + size, m_docCount)) {
+            return false;
+        }
+        f->hasColumn = true;
+    }
+    return p == end;
+}
+bool
+SegmentReader::readTrigrams() {
+    const char* end = tri.data() + tri.size() - magicSize;
+    if (tri.size() < 2 * magicSize + 8) {
+        return false;
+    }
+    end -= 8;
+    const uint64_t offset = getFixed64(end);
+    if (offset < magicSize || offset > (uint64_t)(end - tri.data())) {
+        return false;
+    }
+    const char* p = tri.data() + offset;
+    uint64_t n;
+    if (!getVarint(p, end, n) || n > fields.size()) {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t field, start, size, count, table, offsetBits;
+        if (!getVarint(p, end, field) || !getVarint(p, end, start)
+                || !getVarint(p, end, size) || !getVarint(p, end, count)
+                || !getVarint(p, end, table) || !getVarint(p, end, offsetBits)
+                || field >= fields.size() || start < magicSize
+                || start > offset || size > offset - start
+                || count > 0xffffff || offsetBits > 56) {
+            return false;
+        }
+        const char* data = tri.data() + start;
+        if (!fields[(size_t)field]->trigrams.init(data, data + size,
+                (uint32_t)count, table, (unsigned)offsetBits)) {
+            return false;
+        }
+    }
+    return p == end;
+}
+int
+SegmentReader::fieldNumber(const std::string& name) const {
+    std::vector<std::string>::const_iterator i
+        = std::lower_bound(names.begin(), names.end(), name);
+    return (i != names.end() && *i == name) ?(int)(i - names.begin()) :-1;
+}
+uint32_t
+SegmentReader::termCount(int field) const {
+    return (field >= 0 && field < (int)fields.size())
+        ?fields[field]->termCount :0;
+}
+uint32_t
+SegmentReader::countTerms(int field, const std::string& prefix,
+        uint32_t& first) const {
+    first = 0;
+    return (field >= 0 && field < (int)fields.size())
+        ?fields[field]->terms.countPrefix(prefix, first) :0;
+}
+bool
+SegmentReader::findTerm(int field, const std::string& term,
+        TermIterator& i) const {
+    return i.seek(*this, field, term) && i.term() == term;
+}
+void
+SegmentReader::postings(const TermIterator& i,
+        std::vector<Posting>& postings) const {
+    PostingIterator list;
+    if (!SegmentReader::postings(i, list)) {
+        return;
+    }
+    for (uint32_t doc = list.doc(); doc < m_docCount; doc = list.next()) {
+        postings.push_back(Posting(doc, list.freq()));
+    }
+}
+bool
+SegmentReader::postings(const TermIterator& i, PostingIterator& list) const {
+    return list.init(pst.data() + i.postingsOffset(), pst.data() + pst.size())
+        && list.size() == i.docFreq();
+}
+bool
+SegmentReader::hasPositions(int field) const {
+    return field >= 0 && field < (int)fields.size()
+        && fields[field]->hasPositions;
+}
+bool
+SegmentReader::positions(const TermIterator& i,
+        PositionReader& positions) const {
+    return i.field && i.field->hasPositions
+        && positions.init(pos.data() + i.m_positions,
+            pos.data() + pos.size() - magicSize, i.docFreq());
+}
+bool
+SegmentReader::document(uint32_t doc, StoredDocument& values) const {
+    values.clear();
+    if (doc >= m_docCount) {
+        return false;
+    }
+    const char* p = fld.data() + getFixed64(fld.data() + fieldTable + 8 * doc);
+    const char* end = fld.data() + fieldTable;
+    uint64_t n;
+    if (p < fld.data() + magicSize || p > end || !getVarint(p, end, n)
+            || n > (uint64_t)(end - p)) {
+        return false;
+    }
+    values.resize((size_t)n);
+    StoredDocument::iterator i;
+    for (i = values.begin(); i != values.end(); ++i) {
+        uint64_t field;
+        if (!getVarint(p, end, field) || field >= names.size()
+                || !getBytes(p, end, i->second)) {
+            values.clear();
+            return false;
+        }
+        i->first = (uint32_t)field;
+    }
+    return true;
+}
+
+const Column*
+SegmentReader::column(int field) const {
+    return (field >= 0 && field < (int)fields.size()
+        && fields[field]->hasColumn) ?&fields[field]->column :0;
+}
+bool
+SegmentReader::trigramCandidates(int field, const TrigramQuery& q,
+        std::vector<uint32_t>& ordinals) const {
+    if (field < 0 || field >= (int)fields.size()) {
+        ordinals.clear();
+        return q.op != TrigramQuery::All;
+    }
+    return fields[field]->trigrams.candidates(q, ordinals);
+}
+bool
+SegmentReader::TermIterator::seek(const SegmentReader& r, int f,
+        const std::string& term) {
+    reader = &r;
+    field = (f >= 0 && f < (int)r.fields.size()) ?r.fields[f] :0;
+    return readOutput(field && terms.seek(field->terms, term));
+}
+bool
+SegmentReader::TermIterator::seekOrdinal(const SegmentReader& r, int f,
+        uint32_t ordinal) {
+    reader = &r;
+    field = (f >= 0 && f < (int)r.fields.size()) ?r.fields[f] :0;
+    return readOutput(field && terms.seekOrdinal(field->terms, ordinal));
+}
+bool
+SegmentReader::TermIterator::next() {
+    return field && readOutput(terms.next());
+}
+/**
+ * Read the output for the term that was found if @p ok is true.
+ **/
+bool
+SegmentReader::TermIterator::readOutput(bool ok) {
+    ok = ok && terms.ordinal() < field->termCount;
+    if (ok) {
+        const uint32_t o = terms.ordinal();
+        m_docFreq = (uint32_t)getPacked(field->docFreqs, o,
+            field->docFreqBits);
+        m_postings = field->postingsBase + getPacked(field->offsets, o,
+            field->offsetBits);
+        ok = m_postings < reader->pst.size();
+        m_positions = (field->hasPositions) ?field->positionsBase
+            + getPacked(field->positionOffsets, o, field->positionBits) :0;
+        ok = ok && m_positions < reader->pos.size();
+    }
+    if (!ok) {
+        field = 0;
+    }
+    return ok;
+}
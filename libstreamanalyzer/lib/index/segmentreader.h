@@ -0,0 +1,168 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_SEGMENTREADER_H
+#define STRIGI_SEGMENTREADER_H
+
+#include "indexformat.h"
+#include "positions.h"
+#include "fst.h"
+#include "docvalues.h"
+#include "trigram.h"
+
+namespace Strigi {
+
+/**
+ * Reads the files of a segment that were written by SegmentWriter. The
+ * files are mapped into memory and the term dictionary is read in place;
+ * only the names of the fields are kept on the heap.
+ *
+ * A SegmentReader does not change after it has been opened, so it can be
+ * used from several threads at once.
+ **/
+class SegmentReader {
+public:
+    class Field;
+    /**
+     * Iterates over the terms of one field in byte order.
+     **/
+    class TermIterator {
+    friend class SegmentReader;
+    private:
+        const SegmentReader* reader;
+        const Field* field;
+        Fst::Iterator terms;
+        uint32_t m_docFreq;
+        uint64_t m_postings;
+        uint64_t m_positions;
+        bool readOutput(bool ok);
+    public:
+        TermIterator() :reader(0), field(0), m_positions(0) {}
+        /**
+         * Move to the first term of @p field that is not smaller than
+         * @p term.
+         * @return false if there is no such term
+         **/
+        bool seek(const SegmentReader& reader, int field,
+            const std::string& term);
+        /**
+         * Move to the term of @p field with the ordinal @p ordinal, the
+         * number of smaller terms in the field.
+         * @return false if there is no such term
+         **/
+        bool seekOrdinal(const SegmentReader& reader, int field,
+            uint32_t ordinal);
+        /**
+         * @return false if there are no more terms in the field
+         **/
+        bool next();
+        const std::string& term() const { return terms.term(); }
+        uint32_t ordinal() const { return terms.ordinal(); }
+        uint32_t docFreq() const { return m_docFreq; }
+        uint64_t postingsOffset() const { return m_postings; }
+    };
+
+    /**
+     * @return a reader for the segment or 0 if it cannot be read
+     **/
+    static SegmentReader* open(const std::string& dir,
+        const SegmentInfo& info);
+    ~SegmentReader();
+    const std::string& name() const { return m_name; }
+    uint32_t docCount() const { return m_docCount; }
+    const std::vector<std::string>& fieldNames() const { return names; }
+    /**
+     * @return the number of the field or -1 if the segment does not have it
+     **/
+    int fieldNumber(const std::string& name) const;
+    /**
+     * @return the number of terms of @p field
+     **/
+    uint32_t termCount(int field) const;
+    /**
+     * Count the terms of @p field that start with @p prefix and set
+     * @p first to the ordinal of the first of them.
+     **/
+    uint32_t countTerms(int field, const std::string& prefix,
+        uint32_t& first) const;
+    /**
+     * Find @p term in @p field.
+     * @return false if the segment does not contain the term
+     **/
+    bool findTerm(int field, const std::string& term,
+        TermIterator& i) const;
+    /**
+     * Append the postings of the current term of @p i to @p postings.
+     **/
+    void postings(const TermIterator& i, std::vector<Posting>& postings)
+        const;
+    /**
+     * Start reading the postings of the current term of @p i with @p list.
+     * @return false if the postings are damaged
+     **/
+    bool postings(const TermIterator& i, PostingIterator& list) const;
+    /**
+     * @return true if the terms of @p field have positions
+     **/
+    bool hasPositions(int field) const;
+    /**
+     * Start reading the positions of the current term of @p i with
+     * @p positions.
+     * @return false if the field has no positions or they are damaged
+     **/
+    bool positions(const TermIterator& i, PositionReader& positions) const;
+    /**
+     * Read the stored values of @p doc.
+     **/
+    bool document(uint32_t doc, StoredDocument& values) const;
+    /**
+     * @return the column with the values of @p field or 0 if the field has
+     * no column
+     **/
+    const Column* column(int field) const;
+    /**
+     * Find the ordinals of the terms of @p field that satisfy @p q.
+     * @return false if all terms satisfy @p q
+     **/
+    bool trigramCandidates(int field, const TrigramQuery& q,
+        std::vector<uint32_t>& ordinals) const;
+private:
+    const std::string m_name;
+    uint32_t m_docCount;
+    MappedFile tis;
+    MappedFile pst;
+    MappedFile fld;
+    MappedFile dv;
+    MappedFile tri;
+    MappedFile pos;
+    std::vector<std::string> names;
+    std::vector<Field*> fields;
+    uint64_t fieldTable;
+
+    SegmentReader(const std::string& name);
+    bool read(const std::string& dir, const SegmentInfo& info);
+    bool readIndex();
+    bool readColumns();
+    bool readTrigrams();
+};
+
+}
+
+#endif
@@ -0,0 +1,348 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "segmentwriter.h"
+#include "docvalues.h"
+#include "trigram.h"
+#include "fst.h"
+#include "positions.h"
+#include "indexformat.h"
+#include <strigi/fieldtypes.h>
+#include <algorithm>
+#include <unistd.h>
+
+using namespace Strigi;
+
+/**
+ * An output file that keeps track of its size.
+ **/
+class SegmentWriter::File {
+private:
+    FILE* f;
+    std::string buffer;
+    uint64_t written;
+    bool ok;
+public:
+    const std::string path;
+    explicit File(const std::string& p) :written(0), ok(true), path(p) {
+        f = fopen(p.c_str(), "wb");
+    }
+    ~File() {
+        if (f) {
+            fclose(f);
+        }
+    }
+    bool isOpen() const { return f != 0; }
+    uint64_t offset() const { return written + buffer.length(); }
+    std::string& out() { return buffer; }
+    void flush() {
+        ok = ok && fwrite(buffer.c_str(), 1, buffer.length(), f)
+            == buffer.length();
+        written += buffer.length();
+        buffer.clear();
+    }
+    void maybeFlush() {
+        if (buffer.length() >= 65536) {
+            flush();
+        }
+    }
+    bool close() {
+        flush();
+        ok = fflush(f) == 0 && ok;
+        ok = fdatasync(fileno(f)) == 0 && ok;
+        ok = fclose(f) == 0 && ok;
+        f = 0;
+        return ok;
+    }
+};
+
+SegmentWriter::SegmentWriter(const std::string& d, const std::string& n,
+        const std::vector<std::string>& f)
+        :dir(d), name(n), fields(f), tis(0), pst(0), fld(0), dv(0), tri(0),
+         pos(0), columns(f.size()), dictionary(0),
+         trigrams(new TrigramWriter()), trigramFields(0), field(0),
+         indexedFields(0), fieldTerms(0), failed(false) {
+}
+SegmentWriter::~SegmentWriter() {
+    delete dictionary;
+    delete trigrams;
+    if (tis) {
+        // finish() was not called or failed
+        delete tis;
+        delete pst;
+        delete fld;
+        delete dv;
+        delete tri;
+        delete pos;
+        unlink((dir + '/' + name + ".tis").c_str());
+        unlink((dir + '/' + name + ".pst").c_str());
+        unlink((dir + '/' + name + ".fld").c_str());
+        unlink((dir + '/' + name + ".dv").c_str());
+        unlink((dir + '/' + name + ".tri").c_str());
+        unlink((dir + '/' + name + ".pos").c_str());
+    }
+}
+bool
+SegmentWriter::open() {
+    tis = new File(dir + '/' + name + ".tis");
+    pst = new File(dir + '/' + name + ".pst");
+    fld = new File(dir + '/' + name + ".fld");
+    dv = new File(dir + '/' + name + ".dv");
+    tri = new File(dir + '/' + name + ".tri");
+    pos = new File(dir + '/' + name + ".pos");
+    if (!tis->isOpen() || !pst->isOpen() || !fld->isOpen()
+            || !dv->isOpen() || !tri->isOpen() || !pos->isOpen()) {
+        failed = true;
+        return false;
+    }
+    tis->out().append(tisMagic, magicSize);
+    pst->out().append(pstMagic, magicSize);
+    fld->out().append(fldMagic, magicSize);
+    dv->out().append(dvMagic, magicSize);
+    tri->out().append(triMagic, magicSize);
+    pos->out().append(posMagic, magicSize);
+    return true;
+}
+void
+SegmentWriter::addDocument(const StoredDocument& doc) {
+    const uint32_t n = (uint32_t)docOffsets.size();
+    docOffsets.push_back(fld->offset());
+    std::string& out = fld->out();
+    putVarint(out, doc.size());
+    StoredDocument::const_iterator i;
+    for (i = doc.begin(); i != doc.end(); ++i) {
+        putVarint(out, i->first);
+        putBytes(out, i->second);
+        // the fragments of the text are only needed with the other values
+        if (fields[i->first] != FieldRegister::contentFieldName) {
+            columns[i->first].add(n, i->second);
+        }
+    }
+    fld->maybeFlush();
+}
+/**
+ * Write the transducer of the field that is being written, followed by the
+ * document counts, the postings offsets and, if the field has positions,
+ * the positions offsets of its terms in tables with as many bits per value
+ * as the largest value needs.
+ **/
+void
+SegmentWriter::writeDictionary() {
+    const uint64_t root = dictionary->finish();
+    const uint64_t base = offsets[0];
+    uint64_t maxFreq = 0, maxOffset = 0;
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        offsets[i] -= base;
+        maxFreq = std::max(maxFreq, docFreqs[i]);
+        maxOffset = std::max(maxOffset, offsets[i]);
+    }
+    const unsigned freqBits = bitsNeeded(maxFreq);
+    const unsigned offsetBits = bitsNeeded(maxOffset);
+    putVarint(index, tis->offset());
+    putVarint(index, terms.length());
+    putVarint(index, root);
+    putVarint(index, base);
+    putVarint(index, freqBits);
+    putVarint(index, offsetBits);
+    uint64_t positionBits = 0;
+    if (positionOffsets.size()) {
+        const uint64_t positionBase = positionOffsets[0];
+        for (size_t i = 0; i < positionOffsets.size(); ++i) {
+            positionOffsets[i] -= positionBase;
+        }
+        positionBits = bitsNeeded(positionOffsets.back());
+        putVarint(index, 1);
+        putVarint(index, positionBase);
+        putVarint(index, positionBits);
+    } else {
+        putVarint(index, 0);
+    }
+    std::string& t = tis->out();
+    t.append(terms);
+    putPacked(t, docFreqs, freqBits);
+    putPacked(t, offsets, offsetBits);
+    if (positionOffsets.size()) {
+        putPacked(t, positionOffsets, (unsigned)positionBits);
+    }
+    tis->maybeFlush();
+}
+/**
+ * Write the trigrams of the terms of the field that is being written and
+ * add the field to the index of the trigrams.
+ **/
+void
+SegmentWriter::writeTrigrams() {
+    if (trigrams->empty()) {
+        return;
+    }
+    const uint64_t start = tri->offset();
+    uint32_t count;
+    uint64_t table;
+    unsigned offsetBits;
+    trigrams->write(tri->out(), count, table, offsetBits);
+    tri->maybeFlush();
+    putVarint(trigramIndex, field);
+    putVarint(trigramIndex, start);
+    putVarint(trigramIndex, tri->offset() - start);
+    putVarint(trigramIndex, count);
+    putVarint(trigramIndex, table);
+    putVarint(trigramIndex, offsetBits);
+    ++trigramFields;
+}
+/**
+ * Write the columns that have values, followed by an index with the field
+ * number, the offset and the size of each column.
+ **/
+void
+SegmentWriter::writeColumns() {
+    std::string index;
+    uint32_t n = 0;
+    for (size_t f = 0; f < columns.size(); ++f) {
+        if (columns[f].empty()) {
+            continue;
+        }
+        const uint64_t offset = dv->offset();
+        columns[f].write(docCount(), dv->out());
+        putVarint(index, f);
+        putVarint(index, offset);
+        putVarint(index, dv->offset() - offset);
+        dv->maybeFlush();
+        ++n;
+    }
+    const uint64_t indexOffset = dv->offset();
+    std::string& d = dv->out();
+    putVarint(d, n);
+    d.append(index);
+    putFixed64(d, indexOffset);
+    d.append(dvMagic, magicSize);
+}
+/**
+ * Write the dictionary of the field that is being written and add the
+ * entries for it and for the fields before @p next that have no terms to
+ * the index of the term dictionary.
+ **/
+void
+SegmentWriter::finishFields(uint32_t next) {
+    while (indexedFields < next) {
+        putBytes(index, fields[indexedFields]);
+        putVarint(index, (indexedFields == field) ?fieldTerms :0);
+        if (indexedFields == field && fieldTerms) {
+            writeDictionary();
+            writeTrigrams();
+        }
+        ++indexedFields;
+    }
+    delete dictionary;
+    dictionary = 0;
+    terms.clear();
+    docFreqs.clear();
+    offsets.clear();
+    positionOffsets.clear();
+    fieldTerms = 0;
+}
+void
+SegmentWriter::addTerm(uint32_t f, const std::string& term,
+        const std::vector<Posting>& postings,
+        const std::vector<uint32_t>* positions) {
+    if (postings.empty()) {
+        return;
+    }
+    if (f != field || fieldTerms == 0) {
+        finishFields(f);
+        field = f;
+        dictionary = new FstBuilder(terms);
+    }
+    // either all terms of a field have positions or none has
+    const bool mixed = fieldTerms
+        && (positions != 0) != (positionOffsets.size() != 0);
+    if (!dictionary->add(term) || mixed) {
+        failed = true;
+        return;
+    }
+    // the postings
+    const uint64_t offset = pst->offset();
+    encodePostings(postings, pst->out());
+    pst->maybeFlush();
+
+    if (positions) {
+        positionOffsets.push_back(pos->offset());
+        encodePositions(postings, *positions, pos->out());
+        pos->maybeFlush();
+    }
+
+    docFreqs.push_back(postings.size());
+    offsets.push_back(offset);
+    trigrams->add(fieldTerms, term);
+    ++fieldTerms;
+}
+bool
+SegmentWriter::finish() {
+    if (failed) {
+        return false;
+    }
+    finishFields((uint32_t)fields.size());
+
+    const uint64_t indexOffset = tis->offset();
+    std::string& t = tis->out();
+    putVarint(t, fields.size());
+    t.append(index);
+    putFixed64(t, indexOffset);
+    t.append(tisMagic, magicSize);
+
+    const uint64_t tableOffset = fld->offset();
+    std::string& f = fld->out();
+    std::vector<uint64_t>::const_iterator i;
+    for (i = docOffsets.begin(); i != docOffsets.end(); ++i) {
+        putFixed64(f, *i);
+        fld->maybeFlush();
+    }
+    putFixed64(f, tableOffset);
+    putFixed32(f, (uint32_t)docOffsets.size());
+    f.append(fldMagic, magicSize);
+
+    const uint64_t trigramOffset = tri->offset();
+    std::string& g = tri->out();
+    putVarint(g, trigramFields);
+    g.append(trigramIndex);
+    putFixed64(g, trigramOffset);
+    g.append(triMagic, magicSize);
+
+    pos->out().append(posMagic, magicSize);
+
+    writeColumns();
+
+    bool ok = tis->close();
+    ok = pst->close() && ok;
+    ok = fld->close() && ok;
+    ok = dv->close() && ok;
+    ok = tri->close() && ok;
+    ok = pos->close() && ok;
+    if (!ok) {
+        return false;
+    }
+    delete tis;
+    delete pst;
+    delete fld;
+    delete dv;
+    delete tri;
+    delete pos;
+    tis = pst = fld = dv = tri = pos = 0;
+    return true;
+}
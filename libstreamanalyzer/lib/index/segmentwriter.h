@@ -0,0 +1,123 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_SEGMENTWRITER_H
+#define STRIGI_SEGMENTWRITER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+
+namespace Strigi {
+
+class FstBuilder;
+class ColumnWriter;
+class TrigramWriter;
+
+/**
+ * A document that contains a term and the number of times it does so.
+ **/
+class Posting {
+public:
+    uint32_t doc;
+    uint32_t freq;
+    Posting() {}
+    Posting(uint32_t d, uint32_t f) :doc(d), freq(f) {}
+};
+
+/**
+ * The stored values of a document as pairs of field number and value.
+ **/
+typedef std::vector<std::pair<uint32_t, std::string> > StoredDocument;
+
+/**
+ * Writes the files of a new segment.
+ *
+ * The documents are added in the order of their numbers. The terms are
+ * added in the order of their field numbers and, within a field, in byte
+ * order. If anything fails, finish() returns false and no files are left
+ * behind.
+ **/
+class SegmentWriter {
+private:
+    class File;
+    const std::string dir;
+    const std::string name;
+    const std::vector<std::string> fields;
+    File* tis;
+    File* pst;
+    File* fld;
+    File* dv;
+    File* tri;
+    File* pos;
+    std::vector<uint64_t> docOffsets;
+    std::vector<ColumnWriter> columns;
+    // the index of the term dictionary
+    std::string index;
+    // the transducer, the document counts and the offsets of the postings
+    // and the positions of the terms of the field that is being written
+    FstBuilder* dictionary;
+    std::string terms;
+    std::vector<uint64_t> docFreqs;
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> positionOffsets;
+    TrigramWriter* trigrams;
+    // the index of the trigrams and the number of fields in it
+    std::string trigramIndex;
+    uint32_t trigramFields;
+    // the field that is being written
+    uint32_t field;
+    // the number of fields in the index
+    uint32_t indexedFields;
+    uint32_t fieldTerms;
+    bool failed;
+
+    void writeDictionary();
+    void writeTrigrams();
+    void writeColumns();
+    void finishFields(uint32_t next);
+public:
+    /**
+     * @param fields the names of the fields, sorted by name
+     **/
+    SegmentWriter(const std::string& dir, const std::string& name,
+        const std::vector<std::string>& fields);
+    ~SegmentWriter();
+    bool open();
+    void addDocument(const StoredDocument& doc);
+    /**
+     * Add a term with its postings and, for a field with positions, the
+     * positions of each posting after each other. Either all terms of a
+     * field have positions or none has.
+     **/
+    void addTerm(uint32_t field, const std::string& term,
+        const std::vector<Posting>& postings,
+        const std::vector<uint32_t>* positions = 0);
+    /**
+     * @return the number of documents that were added
+     **/
+    uint32_t docCount() const { return (uint32_t)docOffsets.size(); }
+    bool finish();
+};
+
+}
+
+#endif
@@ -0,0 +1,140 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "tokenizer.h"
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace Strigi;
+
+namespace {
+inline bool
+isWordChar(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+        || (c >= '0' && c <= '9') || c >= 0x80;
+}
+inline char
+toLower(unsigned char c) {
+    return (char)((c >= 'A' && c <= 'Z') ?c + 'a' - 'A' :c);
+}
+}
+
+/**
+ * Append lower case characters to the current word. Only one character
+ * more than maxWordLength is kept, which is enough to know that the word
+ * is too long.
+ **/
+void
+Tokenizer::append(const char* text, size_t length) {
+    if (word.length() <= maxWordLength) {
+        word.append(text, std::min(length, maxWordLength + 1
+            - word.length()));
+    }
+}
+void
+Tokenizer::tokenize(const char* text, int32_t length,
+        std::vector<Token>& words) {
+    const char* p = text;
+    const char* end = text + length;
+#if defined(__SSE2__)
+    // classify and lower 16 bytes at a time; bytes from 0x80 are negative
+    const __m128i a = _mm_set1_epi8('a' - 1);
+    const __m128i z = _mm_set1_epi8('z' + 1);
+    const __m128i A = _mm_set1_epi8('A' - 1);
+    const __m128i Z = _mm_set1_epi8('Z' + 1);
+    const __m128i zero = _mm_set1_epi8('0' - 1);
+    const __m128i nine = _mm_set1_epi8('9' + 1);
+    const __m128i caseBit = _mm_set1_epi8('a' - 'A');
+    char lower[16];
+    for (; end - p >= 16; p += 16) {
+        const __m128i v = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(p));
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, A),
+            _mm_cmplt_epi8(v, Z));
+        const __m128i letter = _mm_or_si128(upper, _mm_and_si128(
+            _mm_cmpgt_epi8(v, a), _mm_cmplt_epi8(v, z)));
+        const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, zero),
+            _mm_cmplt_epi8(v, nine));
+        const unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(
+            _mm_or_si128(letter, digit), _mm_cmplt_epi8(v,
+            _mm_setzero_si128())));
+        if (mask == 0) {
+            if (word.length()) {
+                finish(words);
+            }
+            continue;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lower),
+            _mm_add_epi8(v, _mm_and_si128(upper, caseBit)));
+        if (mask == 0xffff) {
+            append(lower, 16);
+            continue;
+        }
+        for (unsigned i = 0; i < 16; ) {
+            unsigned j = i;
+            while (j < 16 && ((mask >> j) & 1)) {
+                ++j;
+            }
+            if (j > i) {
+                append(lower + i, j - i);
+            }
+            if (j < 16 && word.length()) {
+                finish(words);
+            }
+            i = j + 1;
+        }
+    }
+#endif
+    for (; p < end; ++p) {
+        const unsigned char c = (unsigned char)*p;
+        if (isWordChar(c)) {
+            const char l = toLower(c);
+            append(&l, 1);
+        } else if (word.length()) {
+            finish(words);
+        }
+    }
+}
+void
+Tokenizer::finish(std::vector<Token>& words) {
+    if (word.length() && word.length() <= maxWordLength) {
+        words.push_back(Token(word, position));
+    }
+    if (word.length()) {
+        ++position;
+    }
+    word.clear();
+}
+std::vector<std::string>
+Tokenizer::words(const std::string& text) {
+    std::vector<Token> tokens;
+    Tokenizer tokenizer;
+    tokenizer.tokenize(text.c_str(), (int32_t)text.length(), tokens);
+    tokenizer.finish(tokens);
+    std::vector<std::string> words;
+    words.reserve(tokens.size());
+    std::vector<Token>::const_iterator i;
+    for (i = tokens.begin(); i != tokens.end(); ++i) {
+        words.push_back(i->word);
+    }
+    return words;
+}
@@ -0,0 +1,76 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_TOKENIZER_H
+#define STRIGI_TOKENIZER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace Strigi {
+
+/**
+ * A word and the number of words before it in the text.
+ **/
+class Token {
+public:
+    std::string word;
+    uint32_t position;
+    Token() :position(0) {}
+    Token(const std::string& w, uint32_t p) :word(w), position(p) {}
+};
+
+/**
+ * Splits text into lower case words. A word is a sequence of ASCII letters
+ * and digits and bytes of multibyte UTF-8 characters. Text may be passed in
+ * pieces; a word that is split over two pieces is returned once and the
+ * positions continue from one piece to the next.
+ **/
+class Tokenizer {
+private:
+    std::string word;
+    uint32_t position;
+    void append(const char* text, size_t length);
+public:
+    /**
+     * Words longer than this are not returned, but they are counted in the
+     * positions of the words after them.
+     **/
+    static const size_t maxWordLength = 64;
+    Tokenizer() :position(0) {}
+    /**
+     * Append the words that end in @p text to @p words.
+     **/
+    void tokenize(const char* text, int32_t length,
+        std::vector<Token>& words);
+    /**
+     * Append the last word to @p words.
+     **/
+    void finish(std::vector<Token>& words);
+    /**
+     * Split a complete string.
+     **/
+    static std::vector<std::string> words(const std::string& text);
+};
+
+}
+
+#endif
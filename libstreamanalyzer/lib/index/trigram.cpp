@@ -0,0 +1,753 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "trigram.h"
+#include "indexformat.h"
+#include <cstring>
+#include <set>
+#include <unordered_map>
+
+using namespace Strigi;
+
+namespace {
+// the largest sets of strings and character classes that are kept
+const size_t maxStrings = 16;
+const size_t maxClass = 8;
+
+typedef std::set<std::string> Strings;
+
+char
+lower(char c) {
+    return (c >= 'A' && c <= 'Z') ?(char)(c + 'a' - 'A') :c;
+}
+bool
+equal(const TrigramQuery& a, const TrigramQuery& b) {
+    return a.op == b.op && a.trigrams == b.trigrams
+        && a.subs.size() == b.subs.size()
+        && std::equal(a.subs.begin(), a.subs.end(), b.subs.begin(), equal);
+}
+void
+addSub(TrigramQuery& a, const TrigramQuery& q) {
+    std::vector<TrigramQuery>::const_iterator i;
+    for (i = a.subs.begin(); i != a.subs.end(); ++i) {
+        if (equal(*i, q)) {
+            return;
+        }
+    }
+    a.subs.push_back(q);
+}
+/**
+ * Add the conditions of @p q to the And query @p a.
+ **/
+void
+addTo(TrigramQuery& a, const TrigramQuery& q) {
+    if (q.op == TrigramQuery::And) {
+        a.trigrams.insert(a.trigrams.end(), q.trigrams.begin(),
+            q.trigrams.end());
+        std::vector<TrigramQuery>::const_iterator i;
+        for (i = q.subs.begin(); i != q.subs.end(); ++i) {
+            addSub(a, *i);
+        }
+    } else if (q.op == TrigramQuery::Or) {
+        addSub(a, q);
+    }
+}
+TrigramQuery
+andOf(const TrigramQuery& x, const TrigramQuery& y) {
+    if (x.op == TrigramQuery::All) {
+        return y;
+    } else if (y.op == TrigramQuery::All) {
+        return x;
+    }
+    TrigramQuery q;
+    q.op = TrigramQuery::And;
+    addTo(q, x);
+    addTo(q, y);
+    std::sort(q.trigrams.begin(), q.trigrams.end());
+    q.trigrams.erase(std::unique(q.trigrams.begin(), q.trigrams.end()),
+        q.trigrams.end());
+    return q;
+}
+TrigramQuery
+orOf(const TrigramQuery& x, const TrigramQuery& y) {
+    if (x.op == TrigramQuery::All || y.op == TrigramQuery::All) {
+        return TrigramQuery();
+    }
+    TrigramQuery q;
+    q.op = TrigramQuery::Or;
+    const TrigramQuery* both[] = { &x, &y };
+    for (int i = 0; i < 2; ++i) {
+        const TrigramQuery& a = *both[i];
+        if (a.op == TrigramQuery::Or) {
+            q.trigrams.insert(q.trigrams.end(), a.trigrams.begin(),
+                a.trigrams.end());
+            q.subs.insert(q.subs.end(), a.subs.begin(), a.subs.end());
+        } else if (a.trigrams.size() == 1 && a.subs.empty()) {
+            q.trigrams.push_back(a.trigrams[0]);
+        } else {
+            q.subs.push_back(a);
+        }
+    }
+    return q;
+}
+/**
+ * @return the query for terms that contain one of @p strings
+ **/
+TrigramQuery
+trigramsOf(const Strings& strings) {
+    TrigramQuery q;
+    Strings::const_iterator i;
+    for (i = strings.begin(); i != strings.end(); ++i) {
+        if (i->length() < 3) {
+            return TrigramQuery();
+        }
+        TrigramQuery s;
+        s.op = TrigramQuery::And;
+        for (size_t j = 0; j + 3 <= i->length(); ++j) {
+            s.trigrams.push_back(TrigramQuery::trigram(i->data() + j));
+        }
+        std::sort(s.trigrams.begin(), s.trigrams.end());
+        s.trigrams.erase(std::unique(s.trigrams.begin(), s.trigrams.end()),
+            s.trigrams.end());
+        q = (i == strings.begin()) ?s :orOf(q, s);
+    }
+    return q;
+}
+Strings
+cross(const Strings& a, const Strings& b) {
+    Strings s;
+    Strings::const_iterator i, j;
+    for (i = a.begin(); i != a.end(); ++i) {
+        for (j = b.begin(); j != b.end(); ++j) {
+            s.insert(*i + *j);
+        }
+    }
+    return s;
+}
+/**
+ * Shorten the strings of @p s until there are at most maxStrings of them.
+ **/
+void
+limit(Strings& s, bool prefix) {
+    while (s.size() > maxStrings) {
+        Strings shorter;
+        Strings::const_iterator i;
+        for (i = s.begin(); i != s.end(); ++i) {
+            if (i->empty()) {
+                shorter.insert(*i);
+            } else if (prefix) {
+                shorter.insert(i->substr(0, i->length() - 1));
+            } else {
+                shorter.insert(i->substr(1));
+            }
+        }
+        s.swap(shorter);
+    }
+}
+
+/**
+ * What is known about the strings that a part of a regular expression
+ * matches: either the set of the strings, or a set of strings with which
+ * each of them starts, a set with which each of them ends and a query
+ * that each of them satisfies. All strings are in lower case.
+ **/
+class Info {
+private:
+    Info() :exact(false) {}
+public:
+    bool exact;
+    Strings strings;
+    Strings prefix;
+    Strings suffix;
+    TrigramQuery match;
+
+    explicit Info(const std::string& s) :exact(true) { strings.insert(s); }
+    explicit Info(const Strings& s) :exact(true), strings(s) {}
+    /**
+     * @return the information about a part that matches any string
+     **/
+    static Info anything() {
+        Info i;
+        i.prefix.insert(std::string());
+        i.suffix.insert(std::string());
+        return i;
+    }
+    /**
+     * Move the trigrams of the prefixes and suffixes into the query and
+     * keep only the first two bytes of the prefixes and the last two of
+     * the suffixes.
+     **/
+    void simplify() {
+        match = andOf(match, andOf(trigramsOf(prefix), trigramsOf(suffix)));
+        Strings s;
+        Strings::const_iterator i;
+        for (i = prefix.begin(); i != prefix.end(); ++i) {
+            s.insert(i->substr(0, 2));
+        }
+        prefix.swap(s);
+        s.clear();
+        for (i = suffix.begin(); i != suffix.end(); ++i) {
+            s.insert(i->substr((i->length() > 2) ?i->length() - 2 :0));
+        }
+        suffix.swap(s);
+        limit(prefix, true);
+        limit(suffix, false);
+    }
+    void makeInexact() {
+        if (exact) {
+            exact = false;
+            prefix = suffix = strings;
+            strings.clear();
+            simplify();
+        }
+    }
+    /**
+     * @return the query that each string satisfies
+     **/
+    TrigramQuery query() const {
+        return (exact) ?trigramsOf(strings) :andOf(match,
+            andOf(trigramsOf(prefix), trigramsOf(suffix)));
+    }
+};
+
+Info
+concat(Info x, Info y) {
+    if (x.exact && y.exact
+            && x.strings.size() * y.strings.size() <= maxStrings) {
+        return Info(cross(x.strings, y.strings));
+    }
+    Info r(Info::anything());
+    r.match = andOf(x.query(), y.query());
+    // the strings around the border of x and y
+    const Strings& xs = (x.exact) ?x.strings :x.suffix;
+    const Strings& yp = (y.exact) ?y.strings :y.prefix;
+    if (xs.size() * yp.size() <= maxStrings) {
+        r.match = andOf(r.match, trigramsOf(cross(xs, yp)));
+    }
+    if (!x.exact) {
+        r.prefix = x.prefix;
+    } else if (x.strings.size() * yp.size() <= maxStrings) {
+        r.prefix = cross(x.strings, yp);
+    } else {
+        r.prefix = x.strings;
+    }
+    if (!y.exact) {
+        r.suffix = y.suffix;
+    } else if (xs.size() * y.strings.size() <= maxStrings) {
+        r.suffix = cross(xs, y.strings);
+    } else {
+        r.suffix = y.strings;
+    }
+    r.simplify();
+    return r;
+}
+Info
+alternate(Info x, Info y) {
+    if (x.exact && y.exact
+            && x.strings.size() + y.strings.size() <= maxStrings) {
+        x.strings.insert(y.strings.begin(), y.strings.end());
+        return x;
+    }
+    x.makeInexact();
+    y.makeInexact();
+    x.prefix.insert(y.prefix.begin(), y.prefix.end());
+    x.suffix.insert(y.suffix.begin(), y.suffix.end());
+    x.match = orOf(x.match, y.match);
+    limit(x.prefix, true);
+    limit(x.suffix, false);
+    return x;
+}
+/**
+ * @return the information about one or more repetitions of @p x
+ **/
+Info
+repeat(Info x) {
+    x.makeInexact();
+    return x;
+}
+
+/**
+ * Reads the parts of an ECMAScript regular expression that tell which
+ * strings it matches and treats the other parts as if they matched any
+ * string.
+ **/
+class RegExpParser {
+private:
+    const std::string& re;
+    size_t pos;
+    bool ok;
+
+    bool more() const { return pos < re.length(); }
+    char peek() const { return re[pos]; }
+    bool accept(char c) {
+        if (more() && peek() == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+    Info fail() {
+        ok = false;
+        pos = re.length();
+        return Info::anything();
+    }
+    bool hex(size_t n, int& value);
+    bool number(uint32_t& n);
+    Info concatenation();
+    Info repetition();
+    Info atom();
+    Info escape();
+    Info charClass();
+public:
+    explicit RegExpParser(const std::string& r) :re(r), pos(0), ok(true) {}
+    TrigramQuery parse() {
+        Info i(alternation());
+        return (ok && !more()) ?i.query() :TrigramQuery();
+    }
+    Info alternation();
+};
+
+Info
+RegExpParser::alternation() {
+    Info i(concatenation());
+    while (accept('|')) {
+        i = alternate(i, concatenation());
+    }
+    return i;
+}
+Info
+RegExpParser::concatenation() {
+    Info i((std::string()));
+    while (more() && peek() != '|' && peek() != ')') {
+        i = concat(i, repetition());
+    }
+    return i;
+}
+bool
+RegExpParser::number(uint32_t& n) {
+    const size_t start = pos;
+    n = 0;
+    while (more() && peek() >= '0' && peek() <= '9' && n < 100000) {
+        n = 10 * n + (uint32_t)(re[pos++] - '0');
+    }
+    return pos > start;
+}
+Info
+RegExpParser::repetition() {
+    Info i(atom());
+    for (;;) {
+        uint32_t min, max;
+        if (accept('*')) {
+            min = 0;
+            max = 2;
+        } else if (accept('+')) {
+            min = 1;
+            max = 2;
+        } else if (accept('?')) {
+            min = 0;
+            max = 1;
+        } else if (accept('{')) {
+            if (!number(min)) {
+                return fail();
+            }
+            max = min;
+            if (accept(',')) {
+                max = (number(max)) ?max :min + 2;
+            }
+            if (!accept('}') || max < min) {
+                return fail();
+            }
+        } else {
+            return i;
+        }
+        accept('?');
+        if (max == 0) {
+            i = Info(std::string());
+        } else if (min == 0) {
+            i = (max == 1) ?alternate(i, Info(std::string()))
+                :Info::anything();
+        } else if (min != 1 || max != 1) {
+            i = repeat(i);
+        }
+    }
+}
+Info
+RegExpParser::atom() {
+    const char c = re[pos++];
+    switch (c) {
+    case '(':
+        if (accept('?')) {
+            if (!more() || (peek() != ':' && peek() != '='
+                    && peek() != '!')) {
+                return fail();
+            }
+            const bool lookahead = re[pos++] != ':';
+            Info i(alternation());
+            if (!accept(')')) {
+                return fail();
+            }
+            return (lookahead) ?Info(std::string()) :i;
+        } else {
+            Info i(alternation());
+            return (accept(')')) ?i :fail();
+        }
+    case '[':
+        return charClass();
+    case '.':
+        return Info::anything();
+    case '^':
+    case '$':
+        return Info(std::string());
+    case '\\':
+        return escape();
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+    case '}':
+    case ']':
+        return fail();
+    default:
+        return Info(std::string(1, lower(c)));
+    }
+}
+bool
+RegExpParser::hex(size_t n, int& value) {
+    value = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!more()) {
+            return false;
+        }
+        const char c = lower(re[pos++]);
+        if (c >= '0' && c <= '9') {
+            value = 16 * value + (c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            value = 16 * value + (c - 'a' + 10);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+/**
+ * Read an escape outside of a character class.
+ **/
+Info
+RegExpParser::escape() {
+    if (!more()) {
+        return fail();
+    }
+    const char c = re[pos++];
+    int value;
+    switch (c) {
+    case 'b':
+    case 'B':
+        return Info(std::string());
+    case 'n': return Info(std::string(1, '\n'));
+    case 'r': return Info(std::string(1, '\r'));
+    case 't': return Info(std::string(1, '\t'));
+    case 'f': return Info(std::string(1, '\f'));
+    case 'v': return Info(std::string(1, '\v'));
+    case '0': return Info(std::string(1, '\0'));
+    case 'x':
+        return (hex(2, value)) ?Info(std::string(1, lower((char)value)))
+            :fail();
+    case 'u':
+        return (hex(4, value)) ?Info::anything() :fail();
+    case 'c':
+        if (!more()) {
+            return fail();
+        }
+        ++pos;
+        return Info::anything();
+    default:
+        // classes of characters and back references
+        if ((c >= '1' && c <= '9') || strchr("dDsSwW", c)) {
+            return Info::anything();
+        }
+        return Info(std::string(1, lower(c)));
+    }
+}
+/**
+ * Read a character class. Small classes are a set of strings of one
+ * character; the others match any character.
+ **/
+Info
+RegExpParser::charClass() {
+    const bool negated = accept('^');
+    std::set<char> chars;
+    bool large = negated;
+    bool first = true;
+    while (more() && (first || peek() != ']')) {
+        first = false;
+        int lo = (unsigned char)re[pos++];
+        if (lo == '[' && more()
+                && (peek() == ':' || peek() == '.' || peek() == '=')) {
+            // [:alpha:] and the like
+            const char kind = re[pos];
+            const size_t end = re.find(std::string(1, kind) + ']', pos + 1);
+            if (end == std::string::npos) {
+                return fail();
+            }
+            pos = end + 2;
+            large = true;
+            continue;
+        } else if (lo == '\\') {
+            if (!more()) {
+                return fail();
+            }
+            const char c = re[pos++];
+            int value;
+            switch (c) {
+            case 'b': lo = '\b'; break;
+            case 'n': lo = '\n'; break;
+            case 'r': lo = '\r'; break;
+            case 't': lo = '\t'; break;
+            case 'f': lo = '\f'; break;
+            case 'v': lo = '\v'; break;
+            case '0': lo = 0; break;
+            case 'x':
+                if (!hex(2, value)) {
+                    return fail();
+                }
+                lo = value;
+                break;
+            default:
+                if (strchr("dDsSwWuc", c)) {
+                    large = true;
+                    continue;
+                }
+                lo = (unsigned char)c;
+            }
+        }
+        int hi = lo;
+        if (pos + 1 < re.length() && peek() == '-' && re[pos + 1] != ']') {
+            ++pos;
+            hi = (unsigned char)re[pos++];
+            if (hi == '\\') {
+                // ranges that end in an escape are rare
+                large = true;
+                ++pos;
+                continue;
+            }
+        }
+        if (hi - lo >= (int)maxClass) {
+            large = true;
+        }
+        for (int c = lo; !large && c <= hi; ++c) {
+            chars.insert(lower((char)c));
+        }
+    }
+    if (!accept(']')) {
+        return fail();
+    }
+    if (large || chars.empty() || chars.size() > maxClass) {
+        return Info::anything();
+    }
+    Strings strings;
+    std::set<char>::const_iterator c;
+    for (c = chars.begin(); c != chars.end(); ++c) {
+        strings.insert(std::string(1, *c));
+    }
+    return Info(strings);
+}
+}
+
+uint32_t
+TrigramQuery::trigram(const char* p) {
+    return (uint32_t)(unsigned char)lower(p[0]) << 16
+        | (uint32_t)(unsigned char)lower(p[1]) << 8
+        | (uint32_t)(unsigned char)lower(p[2]);
+}
+TrigramQuery
+TrigramQuery::substring(const std::string& s) {
+    return Info(s).query();
+}
+TrigramQuery
+TrigramQuery::regExp(const std::string& pattern) {
+    return RegExpParser(pattern).parse();
+}
+
+void
+TrigramWriter::add(uint32_t ordinal, const std::string& term) {
+    grams.clear();
+    for (size_t i = 0; i + 3 <= term.length(); ++i) {
+        grams.push_back(TrigramQuery::trigram(term.data() + i));
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    std::vector<uint32_t>::const_iterator g;
+    for (g = grams.begin(); g != grams.end(); ++g) {
+        std::unordered_map<uint32_t, size_t>::const_iterator i
+            = slots.find(*g);
+        if (i == slots.end()) {
+            i = slots.insert(std::make_pair(*g, lists.size())).first;
+            lists.push_back(List());
+            lists.back().trigram = *g;
+            lists.back().last = 0;
+        }
+        List& l = lists[i->second];
+        putVarint(l.deltas, ordinal - l.last);
+        l.last = ordinal;
+    }
+}
+void
+TrigramWriter::write(std::string& out, uint32_t& count, uint64_t& table,
+        unsigned& offsetBits) {
+    std::sort(lists.begin(), lists.end(),
+        [](const List& a, const List& b) { return a.trigram < b.trigram; });
+    const size_t start = out.length();
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> offsets;
+    std::vector<Posting> postings;
+    std::vector<List>::const_iterator i;
+    for (i = lists.begin(); i != lists.end(); ++i) {
+        postings.clear();
+        uint64_t ordinal = 0, delta;
+        const char* p = i->deltas.data();
+        const char* end = p + i->deltas.length();
+        while (getVarint(p, end, delta)) {
+            ordinal += delta;
+            postings.push_back(Posting((uint32_t)ordinal, 1));
+        }
+        keys.push_back(i->trigram);
+        offsets.push_back(out.length() - start);
+        encodePostings(postings, out);
+    }
+    count = (uint32_t)keys.size();
+    table = out.length() - start;
+    offsetBits = bitsNeeded((offsets.empty()) ?0 :offsets.back());
+    putPacked(out, keys, 24);
+    putPacked(out, offsets, offsetBits);
+    std::vector<List>().swap(lists);
+    slots.clear();
+}
+
+bool
+TrigramTable::init(const char* d, const char* e, uint32_t n, uint64_t t,
+        unsigned bits) {
+    if (bits > 56 || t > (uint64_t)(e - d)
+            || packedSize(n, 24) + packedSize(n, bits)
+                > (uint64_t)(e - d) - t) {
+        return false;
+    }
+    data = d;
+    end = d + t;
+    keys = end;
+    offsets = keys + packedSize(n, 24);
+    count = n;
+    offsetBits = bits;
+    return true;
+}
+bool
+TrigramTable::find(uint32_t trigram, PostingIterator& list) const {
+    uint32_t lo = 0, hi = count;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        if (getPacked(keys, mid, 24) < trigram) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == count || getPacked(keys, lo, 24) != trigram) {
+        return false;
+    }
+    const uint64_t offset = getPacked(offsets, lo, offsetBits);
+    return offset < (uint64_t)(end - data) && list.init(data + offset, end);
+}
+bool
+TrigramTable::candidates(const TrigramQuery& q,
+        std::vector<uint32_t>& ordinals) const {
+    ordinals.clear();
+    if (q.op == TrigramQuery::All) {
+        return false;
+    }
+    evaluate(q, ordinals);
+    return true;
+}
+void
+TrigramTable::evaluate(const TrigramQuery& q,
+        std::vector<uint32_t>& ordinals) const {
+    ordinals.clear();
+    std::vector<PostingIterator> lists(q.trigrams.size());
+    std::vector<std::vector<uint32_t> > subs(q.subs.size());
+    if (q.op == TrigramQuery::Or) {
+        for (size_t i = 0; i < lists.size(); ++i) {
+            if (find(q.trigrams[i], lists[i])) {
+                for (uint32_t o = lists[i].doc();
+                        o != PostingIterator::noMoreDocs;
+                        o = lists[i].next()) {
+                    ordinals.push_back(o);
+                }
+            }
+        }
+        for (size_t i = 0; i < subs.size(); ++i) {
+            evaluate(q.subs[i], subs[i]);
+            ordinals.insert(ordinals.end(), subs[i].begin(), subs[i].end());
+        }
+        std::sort(ordinals.begin(), ordinals.end());
+        ordinals.erase(std::unique(ordinals.begin(), ordinals.end()),
+            ordinals.end());
+        return;
+    }
+    // all trigrams have to be there; the subqueries filter the ordinals
+    // that have them
+    std::vector<PostingIterator*> pointers;
+    for (size_t i = 0; i < lists.size(); ++i) {
+        if (!find(q.trigrams[i], lists[i])) {
+            return;
+        }
+        pointers.push_back(&lists[i]);
+    }
+    for (size_t i = 0; i < subs.size(); ++i) {
+        evaluate(q.subs[i], subs[i]);
+        if (subs[i].empty()) {
+            return;
+        }
+    }
+    std::vector<size_t> next(subs.size(), 0);
+    const auto f = [&](uint32_t o) {
+        for (size_t i = 0; i < subs.size(); ++i) {
+            next[i] = std::lower_bound(subs[i].begin() + next[i],
+                subs[i].end(), o) - subs[i].begin();
+            if (next[i] == subs[i].size() || subs[i][next[i]] != o) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (pointers.empty()) {
+        // the ordinals of the first subquery are filtered by the others
+        const std::vector<uint32_t> first((subs.empty())
+            ?std::vector<uint32_t>() :subs[0]);
+        for (size_t i = 0; i < first.size(); ++i) {
+            if (f(first[i])) {
+                ordinals.push_back(first[i]);
+            }
+        }
+        return;
+    }
+    intersectPostings(pointers, [&](uint32_t o) {
+        if (f(o)) {
+            ordinals.push_back(o);
+        }
+    });
+}
@@ -0,0 +1,138 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_TRIGRAM_H
+#define STRIGI_TRIGRAM_H
+
+#include "postinglist.h"
+#include <unordered_map>
+
+/*
+ * An index from the trigrams of the terms of a field to the ordinals of
+ * the terms that contain them. Regular expressions and substrings are
+ * turned into a query on trigrams that every matching term satisfies, so
+ * only the terms that satisfy the query have to be compared.
+ *
+ * The trigrams are taken from the terms after changing A-Z to a-z, so the
+ * same index serves searches that ignore case and ones that do not. The
+ * index of a field is the list of the ordinals of each trigram written by
+ * encodePostings() with frequencies of 1, followed by a packed table with
+ * the sorted trigrams of 24 bits and a packed table with the offset of the
+ * list of each trigram from the start of the index.
+ */
+namespace Strigi {
+
+/**
+ * A condition on the trigrams of a term. A term satisfies an And query if
+ * it contains all trigrams and satisfies all subqueries and an Or query if
+ * it contains one of the trigrams or satisfies one of the subqueries. All
+ * terms satisfy an All query.
+ **/
+class TrigramQuery {
+public:
+    enum Op { All, And, Or };
+    Op op;
+    std::vector<uint32_t> trigrams;
+    std::vector<TrigramQuery> subs;
+    TrigramQuery() :op(All) {}
+    /**
+     * @return the query for terms that contain @p s, ignoring case
+     **/
+    static TrigramQuery substring(const std::string& s);
+    /**
+     * @return a query that every term in which the ECMAScript regular
+     * expression @p pattern finds a match satisfies, with or without case
+     **/
+    static TrigramQuery regExp(const std::string& pattern);
+    /**
+     * @return the trigram of the three bytes at @p p
+     **/
+    static uint32_t trigram(const char* p);
+};
+
+/**
+ * Collects the trigrams of the terms of one field.
+ **/
+class TrigramWriter {
+private:
+    /**
+     * The ordinals of the terms with one trigram as varint differences.
+     **/
+    class List {
+    public:
+        uint32_t trigram;
+        uint32_t last;
+        std::string deltas;
+    };
+    std::vector<List> lists;
+    // the position of the list of each trigram
+    std::unordered_map<uint32_t, size_t> slots;
+    std::vector<uint32_t> grams;
+public:
+    /**
+     * Add the trigrams of the term with ordinal @p ordinal. The terms are
+     * added in the order of their ordinals.
+     **/
+    void add(uint32_t ordinal, const std::string& term);
+    bool empty() const { return lists.empty(); }
+    /**
+     * Append the index to @p out and forget the trigrams.
+     * @param count the number of trigrams
+     * @param table the offset of the tables from the start of the index
+     * @param offsetBits the number of bits of an offset
+     **/
+    void write(std::string& out, uint32_t& count, uint64_t& table,
+        unsigned& offsetBits);
+};
+
+/**
+ * Reads the index of the trigrams of one field in place.
+ **/
+class TrigramTable {
+private:
+    const char* data;
+    const char* end;
+    const char* keys;
+    const char* offsets;
+    uint32_t count;
+    unsigned offsetBits;
+
+    bool find(uint32_t trigram, PostingIterator& list) const;
+    void evaluate(const TrigramQuery& q, std::vector<uint32_t>& ordinals)
+        const;
+public:
+    TrigramTable() :data(0), end(0), keys(0), offsets(0), count(0),
+        offsetBits(0) {}
+    /**
+     * @return false if the tables do not fit between @p data and @p end
+     **/
+    bool init(const char* data, const char* end, uint32_t count,
+        uint64_t table, unsigned offsetBits);
+    /**
+     * Find the ordinals of the terms that satisfy @p q.
+     * @return false if all terms satisfy @p q
+     **/
+    bool candidates(const TrigramQuery& q, std::vector<uint32_t>& ordinals)
+        const;
+};
+
+}
+
+#endif
@@ -43,6 +43,14 @@ CppLineAnalyzerFactory::registerFields(FieldRegister& reg) {
 //    includesField = reg.registerField();
     typeField = reg.typeField;
 }
+bool
+CppLineAnalyzerFactory::checkHeader(const char* /*header*/,
+        int32_t /*headersize*/, const AnalysisResult& result) const {
+    // only use this analyzer if the file has been determined to be c/c++
+    const std::string& mimeType = result.mimeType();
+    return mimeType == "text/x-csrc" || mimeType == "text/x-chdr"
+        || mimeType == "text/x-c++src" || mimeType == "text/x-c++hdr";
+}
 
 // Analyzer
 void
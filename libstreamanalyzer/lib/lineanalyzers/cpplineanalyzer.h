@@ -69,6 +69,8 @@ private:
         return new CppLineAnalyzer(this);
     }
     void registerFields(Strigi::FieldRegister&);
+    bool checkHeader(const char* header, int32_t headersize,
+        const Strigi::AnalysisResult& result) const;
 };
 
 #endif
@@ -52,6 +52,14 @@ DebLineAnalyzerFactory::registerFields(FieldRegister& r) {
     addField(dependsField);
     addField(typeField);
 }
+bool
+DebLineAnalyzerFactory::checkHeader(const char* /*header*/,
+        int32_t /*headersize*/, const AnalysisResult& result) const {
+    // only the file 'control' in 'control.tar.gz' is of interest
+    const AnalysisResult* parent = result.parent();
+    return result.fileName() == "control" && parent
+        && parent->fileName() == "control.tar.gz";
+}
 
 void 
 DebLineAnalyzer::startAnalysis(AnalysisResult* res) {
@@ -58,6 +58,8 @@ public:
         return new DebLineAnalyzer(this);
     }
     void registerFields(Strigi::FieldRegister&);
+    bool checkHeader(const char* header, int32_t headersize,
+        const Strigi::AnalysisResult& result) const;
 };
 
 #endif
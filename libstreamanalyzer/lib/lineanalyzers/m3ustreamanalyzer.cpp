@@ -44,6 +44,13 @@ void M3uLineAnalyzerFactory::registerFields(Strigi::FieldRegister& reg)
     addField(typeField);
 }
 
+bool M3uLineAnalyzerFactory::checkHeader(const char* /*header*/,
+        int32_t /*headersize*/, const Strigi::AnalysisResult& result) const
+{
+    const std::string extension = result.extension();
+    return extension == "m3u" || extension == "M3U";
+}
+
 // Analyzer
 void M3uLineAnalyzer::startAnalysis(Strigi::AnalysisResult* i)
 {
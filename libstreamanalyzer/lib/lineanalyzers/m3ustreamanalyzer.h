@@ -73,6 +73,8 @@ private:
     }
 
     void registerFields(Strigi::FieldRegister&);
+    bool checkHeader(const char* header, int32_t headersize,
+        const Strigi::AnalysisResult& result) const;
 };
 
 class M3uFactoryFactory : public Strigi::AnalyzerFactoryFactory
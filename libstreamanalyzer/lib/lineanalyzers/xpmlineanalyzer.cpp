@@ -42,6 +42,11 @@ XpmLineAnalyzerFactory::registerFields(FieldRegister& reg) {
     addField(numberOfColorsField);
     addField(typeField);
 }
+bool
+XpmLineAnalyzerFactory::checkHeader(const char* header, int32_t headersize,
+        const AnalysisResult& /*result*/) const {
+    return headersize >= 9 && strncmp(header, "/* XPM */", 9) == 0;
+}
 
 // Analyzer
 void
@@ -63,6 +63,8 @@ private:
         return new XpmLineAnalyzer(this);
     }
     void registerFields(Strigi::FieldRegister&);
+    bool checkHeader(const char* header, int32_t headersize,
+        const Strigi::AnalysisResult& result) const;
 };
 
 #endif
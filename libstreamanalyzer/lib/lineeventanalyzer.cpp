@@ -41,11 +41,15 @@ using namespace Strigi;
 // end of line is \r, \n or \r\n
 #define CONVBUFSIZE 65536
 
-LineEventAnalyzer::LineEventAnalyzer(std::vector<StreamLineAnalyzer*>& l)
-        :line(l), converter((iconv_t)-1), numAnalyzers((uint)l.size()),
-         convBuffer(new char[CONVBUFSIZE]), ready(true), initialized(false) {
+LineEventAnalyzer::LineEventAnalyzer(std::vector<StreamLineAnalyzer*>& l,
+        const std::vector<StreamLineAnalyzerFactory*>& f)
+        :line(l), factories(f), converter((iconv_t)-1),
+         numAnalyzers((uint)l.size()), convBuffer(new char[CONVBUFSIZE]),
+         ready(true), initialized(false), checked(false) {
+    selected = new bool[l.size()];
     started = new bool[l.size()];
     for (uint i=0; i<numAnalyzers; ++i) {
+        selected[i] = false;
         started[i] = false;
     }
 }
@@ -58,6 +62,7 @@ LineEventAnalyzer::~LineEventAnalyzer() {
         iconv_close(converter);
     }
     delete [] convBuffer;
+    delete [] selected;
     delete [] started;
 }
 void
@@ -65,6 +70,7 @@ LineEventAnalyzer::startAnalysis(AnalysisResult* r) {
     result = r;
     ready = numAnalyzers == 0;
     initialized = false;
+    checked = false;
     sawCarriageReturn = false;
     missingBytes = 0;
     iMissingBytes = 0;
@@ -73,9 +79,20 @@ LineEventAnalyzer::startAnalysis(AnalysisResult* r) {
     ibyteBuffer.assign("");
     initEncoding(r->encoding());
     for (uint i=0; i < numAnalyzers; ++i) {
+        selected[i] = false;
         started[i] = false;
     }
 }
+bool
+LineEventAnalyzer::selectAnalyzers(const char* header, uint32_t headersize) {
+    bool any = false;
+    for (uint i=0; i < numAnalyzers; ++i) {
+        selected[i] = factories[i]->checkHeader(header, (int32_t)headersize,
+            *result);
+        any = any || selected[i];
+    }
+    return any;
+}
 void
 LineEventAnalyzer::initEncoding(std::string enc) {
     if (enc.size() == 0 || enc == "UTF-8") {
@@ -112,6 +129,15 @@ LineEventAnalyzer::endAnalysis(bool complete) {
 void
 LineEventAnalyzer::handleData(const char* data, uint32_t length) {
     if (ready) return;
+    if (!checked) {
+        // the first block of data is the header of the stream; if no line
+        // analyzer wants the stream, there is no need to split it into lines
+        checked = true;
+        if (!selectAnalyzers(data, length)) {
+            ready = true;
+            return;
+        }
+    }
     if (converter == (iconv_t)-1) {
         handleUtf8Data(data, length);
         return;
@@ -293,9 +319,9 @@ void
 LineEventAnalyzer::emitData(const char*data, uint32_t length) {
 //    fprintf(stderr, "%.*s\n", length, data);
     bool more = false;
-    std::vector<StreamLineAnalyzer*>::iterator i;
     if (!initialized) {
         for (uint j = 0; j < numAnalyzers; ++j) {
+            if (!selected[j]) continue;
             StreamLineAnalyzer* s = line[j];
             s->startAnalysis(result);
             started[j] = true;
@@ -308,11 +334,13 @@ LineEventAnalyzer::emitData(const char*data, uint32_t length) {
         }
         more = false;
     }
-    for (i = line.begin(); i != line.end(); ++i) {
-        if (!(*i)->isReadyWithStream()) {
-            (*i)->handleLine(data, length);
+    for (uint j = 0; j < numAnalyzers; ++j) {
+        if (!started[j]) continue;
+        StreamLineAnalyzer* s = line[j];
+        if (!s->isReadyWithStream()) {
+            s->handleLine(data, length);
         }
-        more = more || !(*i)->isReadyWithStream();
+        more = more || !s->isReadyWithStream();
     }
     ready = !more;
 }
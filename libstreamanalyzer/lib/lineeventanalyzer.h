@@ -29,9 +29,12 @@
 
 namespace Strigi {
 class StreamLineAnalyzer;
+class StreamLineAnalyzerFactory;
 class LineEventAnalyzer : public StreamEventAnalyzer {
 private:
     std::vector<StreamLineAnalyzer*> line;
+    const std::vector<StreamLineAnalyzerFactory*> factories;
+    bool* selected;
     bool* started;
     std::string byteBuffer;
     std::string ibyteBuffer;
@@ -45,6 +48,7 @@ private:
     char missingBytes;
     bool ready;
     bool initialized;
+    bool checked;
     bool sawCarriageReturn;
 
     const char* name() const { return "LineEventAnalyzer"; }
@@ -55,8 +59,10 @@ private:
     bool isReadyWithStream();
     void emitData(const char* data, uint32_t length);
     void initEncoding(std::string encoding);
+    bool selectAnalyzers(const char* header, uint32_t headersize);
 public:
-    LineEventAnalyzer(std::vector<StreamLineAnalyzer*>&s);
+    LineEventAnalyzer(std::vector<StreamLineAnalyzer*>&s,
+        const std::vector<StreamLineAnalyzerFactory*>& f);
     ~LineEventAnalyzer();
 };
 
@@ -42,6 +42,9 @@ static xmlCleaner xmlcleaner;
 
 class SaxEventAnalyzer::Private {
 public:
+    std::vector<StreamSaxAnalyzer*> analyzers;
+    const std::vector<StreamSaxAnalyzerFactory*> factories;
+    // the analyzers that accepted the header of the current stream
     std::vector<StreamSaxAnalyzer*> sax;
     xmlParserCtxtPtr ctxt;
     xmlSAXHandler handler;
@@ -57,7 +60,9 @@ public:
     static void endElementNsSAX2Func(void *ctx,
         const xmlChar *localname, const xmlChar *prefix, const xmlChar *URI);
 
-    Private(std::vector<StreamSaxAnalyzer*>& s) :sax(s) {
+    Private(std::vector<StreamSaxAnalyzer*>& s,
+            const std::vector<StreamSaxAnalyzerFactory*>& f)
+            :analyzers(s), factories(f) {
         ctxt = 0;
         memset(&handler, 0, sizeof(xmlSAXHandler));
         handler.initialized = XML_SAX2_MAGIC;
@@ -68,13 +73,22 @@ public:
     }
     ~Private() {
         std::vector<StreamSaxAnalyzer*>::iterator s;
-        for (s = sax.begin(); s != sax.end(); ++s) {
+        for (s = analyzers.begin(); s != analyzers.end(); ++s) {
             delete *s;
         }
         if (ctxt) {
             xmlFreeParserCtxt(ctxt);
         }
     }
+    void selectAnalyzers(const char* header, int32_t headersize) {
+        sax.clear();
+        for (uint i = 0; i < analyzers.size(); ++i) {
+            if (factories[i]->checkHeader(header, headersize, *result)) {
+                analyzers[i]->startAnalysis(result);
+                sax.push_back(analyzers[i]);
+            }
+        }
+    }
     void init(const char* data, int32_t len) {
         error = false;
         int initlen = (512 > len) ?len :512;
@@ -145,8 +159,9 @@ SaxEventAnalyzer::Private::endElementNsSAX2Func(void *ctx,
                          (const char *) URI);
     }
 }
-SaxEventAnalyzer::SaxEventAnalyzer(std::vector<StreamSaxAnalyzer*>& s)
-    :p(new Private(s)), ready(true) {
+SaxEventAnalyzer::SaxEventAnalyzer(std::vector<StreamSaxAnalyzer*>& s,
+        const std::vector<StreamSaxAnalyzerFactory*>& f)
+    :p(new Private(s, f)), ready(true) {
 }
 SaxEventAnalyzer::~SaxEventAnalyzer() {
     delete p;
@@ -154,13 +169,9 @@ SaxEventAnalyzer::~SaxEventAnalyzer() {
 void
 SaxEventAnalyzer::startAnalysis(AnalysisResult* result) {
     p->result = result;
-    ready = false;
+    p->sax.clear();
+    ready = p->analyzers.size() == 0;
     initialized = false;
-
-    std::vector<StreamSaxAnalyzer*>::iterator i;
-    for (i = p->sax.begin(); i != p->sax.end(); ++i) {
-        (*i)->startAnalysis(p->result);
-    }
 }
 void
 SaxEventAnalyzer::endAnalysis(bool complete) {
@@ -174,8 +185,14 @@ SaxEventAnalyzer::handleData(const char* data, uint32_t length) {
     if (ready) return;
     // push the data into the parser
     if (!initialized) {
-        p->init(data, length);
+        // only parse the stream if an analyzer is interested in it
         initialized = true;
+        p->selectAnalyzers(data, (int32_t)length);
+        if (p->sax.size() == 0) {
+            ready = true;
+            return;
+        }
+        p->init(data, length);
     } else {
         p->push(data, length);
     }
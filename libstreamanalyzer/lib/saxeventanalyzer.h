@@ -27,6 +27,7 @@
 
 namespace Strigi {
 class StreamSaxAnalyzer;
+class StreamSaxAnalyzerFactory;
 class SaxEventAnalyzer : public StreamEventAnalyzer {
 private:
     class Private;
@@ -40,7 +41,8 @@ private:
     void handleData(const char* data, uint32_t length);
     bool isReadyWithStream();
 public:
-    SaxEventAnalyzer(std::vector<StreamSaxAnalyzer*>&s);
+    SaxEventAnalyzer(std::vector<StreamSaxAnalyzer*>&s,
+        const std::vector<StreamSaxAnalyzerFactory*>& f);
     ~SaxEventAnalyzer();
 };
 
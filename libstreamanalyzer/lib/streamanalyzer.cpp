@@ -91,6 +91,63 @@ std::vector<std::string> getdirs(const std::string& direnv) {
 
 namespace Strigi {
 
+/**
+ * Keeps the idle analyzers that were created by one factory.
+ *
+ * Analyzers are only instantiated when they are first needed. Because the
+ * analysis of embedded streams is nested, an analyzer is in use by at most
+ * one depth at a time. When a depth is done with an analyzer, it is returned
+ * to the pool so that it can be reused at any depth. At most maxIdle
+ * analyzers are kept around; the surplus that is created while analyzing
+ * deeply nested archives is deleted again.
+ **/
+template <class A, class F>
+class AnalyzerPool {
+private:
+    static const size_t maxIdle = 2;
+    const F* factory;
+    std::vector<A*> idle;
+public:
+    explicit AnalyzerPool(const F* f) :factory(f) {}
+    ~AnalyzerPool() {
+        typename std::vector<A*>::iterator i;
+        for (i = idle.begin(); i != idle.end(); ++i) {
+            delete *i;
+        }
+    }
+    /**
+     * Return an idle analyzer without taking it out of the pool. This is
+     * useful for calling const functions such as checkHeader().
+     **/
+    A* peek() {
+        if (idle.empty()) {
+            idle.push_back(factory->newInstance());
+        }
+        return idle.back();
+    }
+    /**
+     * Take an analyzer out of the pool. It must be given back with release().
+     * The analyzer returned by peek() is the one that is returned by the
+     * next call to acquire().
+     **/
+    A* acquire() {
+        A* a = peek();
+        idle.pop_back();
+        return a;
+    }
+    void release(A* a) {
+        if (idle.size() < maxIdle) {
+            idle.push_back(a);
+        } else {
+            delete a;
+        }
+    }
+};
+typedef AnalyzerPool<StreamThroughAnalyzer, StreamThroughAnalyzerFactory>
+    ThroughAnalyzerPool;
+typedef AnalyzerPool<StreamEndAnalyzer, StreamEndAnalyzerFactory>
+    EndAnalyzerPool;
+
 class StreamAnalyzerPrivate {
 public:
     AnalyzerConfiguration& conf;
@@ -99,8 +156,8 @@ public:
     std::vector<StreamSaxAnalyzerFactory*> saxfactories;
     std::vector<StreamLineAnalyzerFactory*> linefactories;
     std::vector<StreamEventAnalyzerFactory*> eventfactories;
-    std::vector<std::vector<StreamEndAnalyzer*> > end;
-    std::vector<std::vector<StreamThroughAnalyzer*> > through;
+    std::vector<ThroughAnalyzerPool*> through;
+    std::vector<EndAnalyzerPool*> end;
     IndexWriter* writer;
 
     AnalyzerLoader* moduleLoader;
@@ -111,15 +168,20 @@ public:
     void initializeSaxFactories();
     void initializeLineFactories();
     void initializeEventFactories();
+    void initializePools();
     void addFactory(StreamThroughAnalyzerFactory* f);
     void addFactory(StreamEndAnalyzerFactory* f);
     void addFactory(StreamSaxAnalyzerFactory* f);
     void addFactory(StreamLineAnalyzerFactory* f);
     void addFactory(StreamEventAnalyzerFactory* f);
-    void addThroughAnalyzers();
-    void addEndAnalyzers();
-    void removeIndexable(unsigned depth);
+    void acquireThroughAnalyzers(std::vector<StreamThroughAnalyzer*>& ta);
+    void releaseThroughAnalyzers(std::vector<StreamThroughAnalyzer*>& ta);
+    InputStream* connectThroughAnalyzers(AnalysisResult& idx,
+        InputStream* input, const std::vector<StreamThroughAnalyzer*>& ta,
+        DataEventInputStream*& tee);
     signed char analyze(AnalysisResult& idx, StreamBase<char>* input);
+    signed char analyze(AnalysisResult& idx, StreamBase<char>* input,
+        const std::vector<StreamThroughAnalyzer*>& ta);
 
     StreamAnalyzerPrivate(AnalyzerConfiguration& c);
     ~StreamAnalyzerPrivate();
@@ -148,8 +210,18 @@ StreamAnalyzerPrivate::StreamAnalyzerPrivate(AnalyzerConfiguration& c)
     initializeEventFactories();
     initializeThroughFactories();
     initializeEndFactories();
+    initializePools();
 }
 StreamAnalyzerPrivate::~StreamAnalyzerPrivate() {
+    // delete the pooled analyzers before the factories that created them
+    std::vector<ThroughAnalyzerPool*>::iterator tp;
+    for (tp = through.begin(); tp != through.end(); ++tp) {
+        delete *tp;
+    }
+    std::vector<EndAnalyzerPool*>::iterator ep;
+    for (ep = end.begin(); ep != end.end(); ++ep) {
+        delete *ep;
+    }
     // delete all factories
     std::vector<StreamThroughAnalyzerFactory*>::iterator ta;
     for (ta = throughfactories.begin(); ta != throughfactories.end(); ++ta) {
@@ -171,21 +243,6 @@ StreamAnalyzerPrivate::~StreamAnalyzerPrivate() {
     for (da = eventfactories.begin(); da != eventfactories.end(); ++da) {
         delete *da;
     }
-    // delete the through analyzers and end analyzers
-    std::vector<std::vector<StreamThroughAnalyzer*> >::iterator tIter;
-    for (tIter = through.begin(); tIter != through.end(); ++tIter) {
-        std::vector<StreamThroughAnalyzer*>::iterator t;
-        for (t = tIter->begin(); t != tIter->end(); ++t) {
-            delete *t;
-        }
-    }
-    std::vector<std::vector<StreamEndAnalyzer*> >::iterator eIter;
-    for (eIter = end.begin(); eIter != end.end(); ++eIter) {
-        std::vector<StreamEndAnalyzer*>::iterator e;
-        for (e = eIter->begin(); e != eIter->end(); ++e) {
-            delete *e;
-        }
-    }
     delete moduleLoader;
     if (writer) {
         writer->releaseWriterData(conf.fieldRegister());
@@ -220,11 +277,16 @@ StreamAnalyzer::indexFile(const std::string& filepath) {
         return 1;
     }
     struct stat s;
-    stat(filepath.c_str(), &s);
-    // ensure a decent buffer size
-    std::string name;
-    AnalysisResult analysisresult(filepath, s.st_mtime, *p->writer, *this);
-    InputStream* file = FileInputStream::open(filepath.c_str());
+    time_t mtime = 0;
+    int64_t size = -1;
+    if (stat(filepath.c_str(), &s) == 0) {
+        mtime = s.st_mtime;
+        if (S_ISREG(s.st_mode)) {
+            size = s.st_size;
+        }
+    }
+    AnalysisResult analysisresult(filepath, mtime, *p->writer, *this);
+    InputStream* file = FileInputStream::open(filepath.c_str(), size);
     signed char r;
     if (file->status() == Ok) {
         r = analysisresult.index(file);
@@ -361,26 +423,43 @@ StreamAnalyzerPrivate::initializeEndFactories() {
     addFactory(new HelperEndAnalyzerFactory());
     addFactory(new TextEndAnalyzerFactory());
 }
+/**
+ * Create an empty pool for each factory. The analyzers themselves are created
+ * when they are needed for the first time.
+ **/
 void
-StreamAnalyzerPrivate::addThroughAnalyzers() {
-    through.resize(through.size()+1);
-    std::vector<std::vector<StreamThroughAnalyzer*> >::reverse_iterator tIter;
-    tIter = through.rbegin();
+StreamAnalyzerPrivate::initializePools() {
     std::vector<StreamThroughAnalyzerFactory*>::iterator ta;
     for (ta = throughfactories.begin(); ta != throughfactories.end(); ++ta) {
-        tIter->push_back((*ta)->newInstance());
+        through.push_back(new ThroughAnalyzerPool(*ta));
     }
-}
-void
-StreamAnalyzerPrivate::addEndAnalyzers() {
-    end.resize(end.size()+1);
-    std::vector<std::vector<StreamEndAnalyzer*> >::reverse_iterator eIter;
-    eIter = end.rbegin();
     std::vector<StreamEndAnalyzerFactory*>::iterator ea;
     for (ea = endfactories.begin(); ea != endfactories.end(); ++ea) {
-        eIter->push_back((*ea)->newInstance());
+        end.push_back(new EndAnalyzerPool(*ea));
     }
 }
+void
+StreamAnalyzerPrivate::acquireThroughAnalyzers(
+        std::vector<StreamThroughAnalyzer*>& ta) {
+    ta.reserve(through.size());
+    std::vector<ThroughAnalyzerPool*>::iterator tp;
+    for (tp = through.begin(); tp != through.end(); ++tp) {
+        ta.push_back((*tp)->acquire());
+    }
+}
+/**
+ * Remove references to the analysisresult before it goes out of scope and
+ * give the analyzers back to their pools.
+ **/
+void
+StreamAnalyzerPrivate::releaseThroughAnalyzers(
+        std::vector<StreamThroughAnalyzer*>& ta) {
+    for (size_t i = 0; i < ta.size(); ++i) {
+        ta[i]->setIndexable(0);
+        through[i]->release(ta[i]);
+    }
+    ta.clear();
+}
 signed char
 StreamAnalyzer::analyze(AnalysisResult& idx, StreamBase<char>* input) {
     return p->analyze(idx, input);
@@ -389,41 +468,59 @@ signed char
 StreamAnalyzerPrivate::analyze(AnalysisResult& idx, StreamBase<char>* input) {
     //std::cerr << "analyze " << idx.path().c_str() << std::endl;
 
-    // retrieve or construct the through analyzers and end analyzers
-    std::vector<std::vector<StreamThroughAnalyzer*> >::iterator tIter;
-    std::vector<std::vector<StreamEndAnalyzer*> >::iterator eIter;
-    while ((int)through.size() <= idx.depth()) {
-        addThroughAnalyzers();
-        addEndAnalyzers();
-    }
-    tIter = through.begin() + idx.depth();
-    eIter = end.begin() + idx.depth();
-
-    // read the headersize size before connecting the throughanalyzers
-    // This ensures that the first read is at least this size, even if the
-    // throughanalyzers read smaller chunks.
-    bool finished = false;
-    const char* header = 0;
-    int32_t headersize = 1024;
-    if (input) {
-        headersize = input->read(header, headersize, headersize);
-        input->reset(0);
-        if (headersize < 0) finished = true;
-    }
+    // take the through analyzers for this depth from the pools
+    std::vector<StreamThroughAnalyzer*> ta;
+    acquireThroughAnalyzers(ta);
 
-    // insert the through analyzers
-    std::vector<StreamThroughAnalyzer*>::iterator ts;
-    for (ts = tIter->begin(); (input == 0 || input->status() == Ok)
-            && ts != tIter->end(); ++ts) {
+    // the header is not read before connecting the throughanalyzers: the
+    // tee passes the size of the first read on, so the one header read in
+    // analyze() fills the buffer for the through and the end analyzers
+    DataEventInputStream* tee = 0;
+    input = connectThroughAnalyzers(idx, input, ta, tee);
+    signed char r = analyze(idx, input, ta);
+    delete tee;
+    releaseThroughAnalyzers(ta);
+    return r;
+}
+/**
+ * Let the through analyzers inspect the stream. The analyzers that want to
+ * see all of the data are served by one DataEventInputStream, @p tee, that
+ * reads each buffer once and passes it to all of them.
+ **/
+InputStream*
+StreamAnalyzerPrivate::connectThroughAnalyzers(AnalysisResult& idx,
+        InputStream* input, const std::vector<StreamThroughAnalyzer*>& ta,
+        DataEventInputStream*& tee) {
+    std::vector<DataEventHandler*> handlers;
+    std::vector<StreamThroughAnalyzer*>::const_iterator ts;
+    for (ts = ta.begin(); (input == 0 || input->status() == Ok)
+            && ts != ta.end(); ++ts) {
         (*ts)->setIndexable(&idx);
         input = (*ts)->connectInputStream(input);
         if (input && input->position() != 0) {
             std::cerr << "Analyzer " << (*ts)->name() << " has left the stream in a bad state." << std::endl;
         }
+        DataEventHandler* handler = (*ts)->dataEventHandler();
+        if (handler) {
+            handlers.push_back(handler);
+        }
+    }
+    if (input && handlers.size()) {
+        tee = new DataEventInputStream(input, handlers);
+        input = tee;
     }
+    return input;
+}
+signed char
+StreamAnalyzerPrivate::analyze(AnalysisResult& idx, StreamBase<char>* input,
+        const std::vector<StreamThroughAnalyzer*>& ta) {
+    bool finished = false;
+    const char* header = 0;
+    int32_t headersize = 1024;
 
-    // reread the header so we can use it for the endanalyzers
-    if (input && headersize > 0) {
+    // read the header through the connected stream so we can use it for the
+    // endanalyzers
+    if (input) {
         headersize = input->read(header, headersize, headersize);
         if (headersize <= 0) {
             finished = true;
@@ -437,18 +534,20 @@ StreamAnalyzerPrivate::analyze(AnalysisResult& idx, StreamBase<char>* input) {
         finished = true;
     }
     size_t es = 0;
-    size_t itersize = eIter->size();
+    size_t itersize = end.size();
     while (!finished && es != itersize) {
-        StreamEndAnalyzer* sea = (*eIter)[es];
-        if (sea->checkHeader(header, headersize)) {
+        // only create an end analyzer when it is needed
+        if (end[es]->peek()->checkHeader(header, headersize)) {
+            StreamEndAnalyzer* sea = end[es]->acquire();
             idx.setEndAnalyzer(sea);
             char ar = sea->analyze(idx, input);
+            idx.setEndAnalyzer(0);
             if (ar) {
 // FIXME: find either a NIE-compliant way to report errors or use some API for this
 //                idx.addValue(errorfield, sea->name() + string(": ")
 //                    + sea->error());
                 if (!idx.config().indexMore()) {
-                    removeIndexable(idx.depth());
+                    end[es]->release(sea);
                     return -1;
                 }
                 int64_t pos = input->reset(0);
@@ -471,18 +570,16 @@ StreamAnalyzerPrivate::analyze(AnalysisResult& idx, StreamBase<char>* input) {
             } else {
                 finished = true;
             }
-            eIter = end.begin() + idx.depth();
+            end[es]->release(sea);
         }
         if (!finished) {
             finished = !conf.indexMore();
         }
         es++;
     }
-    idx.setEndAnalyzer(0);
     if (input) {
         // make sure the entire stream is read if the size is not known
         bool ready;
-        tIter = through.begin() + idx.depth();
         uint32_t skipsize = 4096;
         do {
             // ask the analyzerconfiguration if we should continue
@@ -493,8 +590,8 @@ StreamAnalyzerPrivate::analyze(AnalysisResult& idx, StreamBase<char>* input) {
                 return 0;
             }
             ready = input->size() != -1;
-            std::vector<StreamThroughAnalyzer*>::iterator ts;
-            for (ts = tIter->begin(); ready && ts != tIter->end(); ++ts) {
+            std::vector<StreamThroughAnalyzer*>::const_iterator ts;
+            for (ts = ta.begin(); ready && ts != ta.end(); ++ts) {
                 ready = (*ts)->isReadyWithStream();
             }
             if (!ready) {
@@ -506,7 +603,6 @@ StreamAnalyzerPrivate::analyze(AnalysisResult& idx, StreamBase<char>* input) {
         } while (!ready && input->status() == Ok);
         if (input->status() == Error) {
             fprintf(stderr, "Error: %s\n", input->error());
-            removeIndexable(idx.depth());
             return -2;
         }
     }
@@ -517,23 +613,8 @@ StreamAnalyzerPrivate::analyze(AnalysisResult& idx, StreamBase<char>* input) {
         idx.addValue(sizefield, (uint32_t)input->size());
     }
 
-    // remove references to the analysisresult before it goes out of scope
-    removeIndexable(idx.depth());
     return 0;
 }
-/**
- * Remove references to the analysisresult before it goes out of scope.
- **/
-void
-StreamAnalyzerPrivate::removeIndexable(uint depth) {
-    std::vector<std::vector<StreamThroughAnalyzer*> >::iterator tIter;
-    std::vector<StreamThroughAnalyzer*>::iterator ts;
-    tIter = through.begin() + depth;
-    for (ts = tIter->begin(); ts != tIter->end(); ++ts) {
-        // remove references to the analysisresult before it goes out of scope
-        (*ts)->setIndexable(0);
-    }
-}
 AnalyzerConfiguration&
 StreamAnalyzer::configuration() const {
     return p->conf;
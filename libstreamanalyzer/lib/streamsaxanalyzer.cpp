@@ -67,3 +67,32 @@ StreamSaxAnalyzer::characters(const char* data, uint32_t length) {
     (void)data;
     (void)length;
 }
+
+bool
+StreamSaxAnalyzerFactory::checkHeader(const char* header, int32_t headersize,
+        const AnalysisResult& /*result*/) const {
+    const unsigned char* h = (const unsigned char*)header;
+    int32_t pos = 0;
+    if (headersize >= 2 && ((h[0] == 0xFE && h[1] == 0xFF)
+            || (h[0] == 0xFF && h[1] == 0xFE))) {
+        // UTF-16 or UTF-32 with byte order mark: leave it to the parser
+        return true;
+    }
+    if (headersize >= 4 && h[0] == 0 && h[1] == 0 && h[2] == 0xFE
+            && h[3] == 0xFF) {
+        return true;
+    }
+    if (headersize >= 2 && ((h[0] == '<' && h[1] == 0)
+            || (h[0] == 0 && h[1] == '<'))) {
+        // UTF-16 without byte order mark
+        return true;
+    }
+    if (headersize >= 3 && h[0] == 0xEF && h[1] == 0xBB && h[2] == 0xBF) {
+        pos = 3;
+    }
+    while (pos < headersize && (h[pos] == ' ' || h[pos] == '\t'
+            || h[pos] == '\r' || h[pos] == '\n')) {
+        pos++;
+    }
+    return pos < headersize && h[pos] == '<';
+}
@@ -0,0 +1,301 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "testutils.h"
+#include "../lib/analysisresultcache.h"
+#include <strigi/analysisresult.h>
+#include <strigi/analyzerconfiguration.h>
+#include <strigi/fieldtypes.h>
+#include <strigi/streamanalyzer.h>
+#include <strigi/strigi_thread.h>
+#include <atomic>
+#include <dirent.h>
+#include <utime.h>
+
+using namespace Strigi;
+
+namespace {
+
+/**
+ * An IndexWriter that writes the text and the string values of the
+ * top-level results as a line of text.
+ **/
+class TextWriter : public IndexWriter {
+public:
+    std::string text;
+
+    void startAnalysis(const AnalysisResult*) {}
+    void addText(const AnalysisResult* ar, const char* t, int32_t length) {
+        if (ar->depth() == 0) {
+            text.append("text=" + std::string(t, length) + "|");
+        }
+    }
+    void addValue(const AnalysisResult* ar, const RegisteredField* field,
+            const std::string& value) {
+        if (ar->depth() == 0) {
+            text.append(field->key() + "=" + value + "|");
+        }
+    }
+    void addValue(const AnalysisResult*, const RegisteredField*,
+        const unsigned char*, uint32_t) {}
+    void addValue(const AnalysisResult*, const RegisteredField*, int32_t) {}
+    void addValue(const AnalysisResult*, const RegisteredField*, uint32_t) {}
+    void addValue(const AnalysisResult*, const RegisteredField*, double) {}
+    void addValue(const AnalysisResult*, const RegisteredField*,
+        const std::string&, const std::string&) {}
+    void finishAnalysis(const AnalysisResult*) {}
+    void addTriplet(const std::string&, const std::string&,
+        const std::string&) {}
+    void deleteEntries(const std::vector<std::string>&) {}
+    void deleteAllEntries() {}
+};
+
+/**
+ * Record a result for @p path with @p text in it and store it under
+ * @p key.
+ **/
+void
+store(AnalysisResultCache& cache, AnalyzerConfiguration& config,
+        const std::string& key, const std::string& path, int64_t size,
+        const std::string& text) {
+    TextWriter writer;
+    StreamAnalyzer analyzer(config);
+    AnalysisResultCache::Recorder recorder(writer, config.fieldRegister(),
+        path);
+    {
+        AnalysisResult result(path, 1000, recorder, analyzer, "");
+        result.addValue(config.fieldRegister().parseErrorField, "error");
+        result.addText(text.c_str(), (int32_t)text.length());
+    }
+    cache.store(key, path, size, recorder);
+}
+
+/**
+ * @return the number of bytes in the files in the subdirectories of
+ * @p dir; @p temporary is set to the number of temporary files
+ **/
+int64_t
+countBytes(const std::string& dir, int& temporary) {
+    int64_t total = 0;
+    temporary = 0;
+    DIR* d = opendir(dir.c_str());
+    struct dirent* sub;
+    while (d && (sub = readdir(d)) != 0) {
+        if (sub->d_name[0] == '.') {
+            continue;
+        }
+        const std::string subdir(dir + "/" + sub->d_name);
+        DIR* sd = opendir(subdir.c_str());
+        struct dirent* e;
+        while (sd && (e = readdir(sd)) != 0) {
+            struct stat s;
+            if (e->d_name[0] != '.') {
+                if (stat((subdir + "/" + e->d_name).c_str(), &s) == 0) {
+                    total += s.st_size;
+                }
+            } else if (e->d_name[1] != '\0' && e->d_name[1] != '.') {
+                ++temporary;
+            }
+        }
+        if (sd) {
+            closedir(sd);
+        }
+    }
+    if (d) {
+        closedir(d);
+    }
+    return total;
+}
+
+/**
+ * Store a result, look it up and replay it for a file at another path.
+ **/
+void
+testStoreAndReplay(const std::string& dir, const std::string& file) {
+    AnalyzerConfiguration config;
+    AnalysisResultCache cache(dir + "/cache1", 1000000,
+        config.fieldRegister());
+    std::string key;
+    VERIFY(cache.fingerprint(file, 20000, key));
+    std::string entry;
+    VERIFY(!cache.lookup(key, file, 20000, entry));
+    store(cache, config, key, file, 20000, "some words");
+    VERIFY(cache.lookup(key, file, 20000, entry));
+    // an entry for a file of another size is not used
+    VERIFY(!cache.lookup(key, file, 20001, entry));
+
+    VERIFY(cache.lookup(key, file, 20000, entry));
+    TextWriter writer;
+    StreamAnalyzer analyzer(config);
+    {
+        AnalysisResult result(dir + "/copy.txt", 2000, writer, analyzer, "");
+        cache.replay(entry, result, writer);
+    }
+    // the result adds the values for its own path after the stored ones
+    const std::string stored(config.fieldRegister().parseErrorField->key()
+        + "=error|text=some words|");
+    VERIFY(writer.text.compare(0, stored.length(), stored) == 0);
+    VERIFY(writer.text.find("copy.txt") != std::string::npos);
+    VERIFY(writer.text.find("file.txt") == std::string::npos);
+}
+
+/**
+ * Store more results than fit in the cache. The results that were used
+ * least recently are removed.
+ **/
+void
+testEvict(const std::string& dir, const std::string& file) {
+    AnalyzerConfiguration config;
+    const std::string cachedir(dir + "/cache2");
+    AnalysisResultCache cache(cachedir, 10000, config.fieldRegister());
+    const std::string text(1000, 't');
+    std::string entry;
+    for (int i = 0; i < 30; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "%02x%04d", i, i);
+        store(cache, config, key, file, 20000, text);
+        // make the order in which the entries were used explicit
+        VERIFY(cache.lookup(key, file, 20000, entry));
+        struct utimbuf t = { 1000 + i, 1000 + i };
+        const std::string epath(cachedir + "/" + std::string(key, 2) + "/"
+            + std::string(key + 2));
+        VERIFY(utime(epath.c_str(), &t) == 0);
+    }
+    int temporary;
+    const int64_t total = countBytes(cachedir, temporary);
+    VERIFY(total > 5000);
+    VERIFY(total <= 10000);
+    VERIFY(temporary == 0);
+    VERIFY(!cache.lookup("000000", file, 20000, entry));
+    VERIFY(cache.lookup("1d0029", file, 20000, entry));
+}
+
+/**
+ * A file that is changed within the same second keeps its size and mtime
+ * in seconds, but gets a new stat key.
+ **/
+void
+testStatKey(const std::string& dir, const std::string& file) {
+    AnalyzerConfiguration config;
+    const std::string cachedir(dir + "/cache4");
+    AnalysisResultCache cache(cachedir, 1000000, config.fieldRegister());
+    struct stat s;
+    VERIFY(stat(file.c_str(), &s) == 0);
+    const std::string statkey(AnalysisResultCache::statKey(s));
+    struct stat changed(s);
+    changed.st_ctime += 1;
+    VERIFY(AnalysisResultCache::statKey(changed) != statkey);
+#ifdef HAVE_STAT_ST_MTIM
+    changed = s;
+    changed.st_mtim.tv_nsec = (s.st_mtim.tv_nsec + 1) % 1000000000;
+    VERIFY(AnalysisResultCache::statKey(changed) != statkey);
+#endif
+
+    // a stored result can be found under the stat key after linking
+    std::string key;
+    VERIFY(cache.fingerprint(file, s.st_size, key));
+    store(cache, config, key, file, s.st_size, "linked");
+    std::string entry;
+    VERIFY(!cache.lookupUnchanged(statkey, s.st_size, entry));
+    cache.link(key, statkey);
+    VERIFY(cache.lookupUnchanged(statkey, s.st_size, entry));
+    int temporary;
+    countBytes(cachedir, temporary);
+    VERIFY(temporary == 0);
+}
+
+struct Storer {
+    AnalysisResultCache* cache;
+    AnalyzerConfiguration* config;
+    std::string file;
+    std::atomic<int> failures;
+};
+
+extern "C" void*
+storeInThread(void* d) {
+    Storer* s = static_cast<Storer*>(d);
+    std::string entry;
+    for (int i = 0; i < 50; ++i) {
+        store(*s->cache, *s->config, "abcdef", s->file, 20000,
+            std::string(200000 + i, 'x'));
+        // there is always a complete entry, even while others store
+        if (!s->cache->lookup("abcdef", s->file, 20000, entry)) {
+            ++s->failures;
+        }
+    }
+    STRIGI_THREAD_EXIT(0);
+    return 0;
+}
+
+/**
+ * Store results under the same key from several threads at once. Each
+ * store must leave a complete entry.
+ **/
+void
+testConcurrentStore(const std::string& dir, const std::string& file) {
+    AnalyzerConfiguration config;
+    const std::string cachedir(dir + "/cache3");
+    AnalysisResultCache cache(cachedir, 1000000, config.fieldRegister());
+    Storer storer;
+    storer.cache = &cache;
+    storer.config = &config;
+    storer.file = file;
+    storer.failures = 0;
+    STRIGI_THREAD_TYPE threads[4];
+    for (int i = 0; i < 4; ++i) {
+        STRIGI_THREAD_CREATE(&threads[i], storeInThread, &storer);
+    }
+    for (int i = 0; i < 4; ++i) {
+        STRIGI_THREAD_JOIN(threads[i]);
+    }
+    VERIFY(storer.failures == 0);
+    std::string entry;
+    VERIFY(cache.lookup("abcdef", file, 20000, entry));
+    int temporary;
+    countBytes(cachedir, temporary);
+    VERIFY(temporary == 0);
+}
+
+}
+
+int
+AnalysisResultCacheTest(int argc, char* argv[]) {
+    if (argc < 2) return 1;
+    founderrors = 0;
+    const std::string dir(makeTestDir(argv[1]));
+    VERIFY(dir.length());
+    if (dir.empty()) {
+        return founderrors;
+    }
+    // files smaller than 16 kB are not cached
+    const std::string file(dir + "/file.txt");
+    VERIFY(writeTestFile(file, std::string(20000, 'f')));
+
+    testStoreAndReplay(dir, file);
+    testEvict(dir, file);
+    testConcurrentStore(dir, file);
+    testStatKey(dir, file);
+
+    removeTestDir(dir);
+    return founderrors;
+}
@@ -0,0 +1,268 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "testutils.h"
+#include <strigi/analysisresult.h>
+#include <strigi/analyzerconfiguration.h>
+#include <strigi/asyncindexwriter.h>
+#include <strigi/diranalyzer.h>
+#include <strigi/fieldtypes.h>
+#include <strigi/indexmanager.h>
+#include <strigi/stringstream.h>
+#include <strigi/strigi_thread.h>
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <set>
+#include <sys/stat.h>
+
+using namespace Strigi;
+
+namespace {
+
+/**
+ * Replace the anonymous uris in @p s, which differ between runs.
+ **/
+std::string
+normalize(const std::string& s) {
+    std::string n;
+    for (size_t i = 0; i < s.length(); ++i) {
+        size_t j = i + 1;
+        while (j < s.length() && j < i + 7 && s[j] >= 'a' && s[j] <= 'z') {
+            ++j;
+        }
+        if (s[i] == ':' && j == i + 6) {
+            n.append(":ANON");
+            i = j - 1;
+        } else {
+            n.append(1, s[i]);
+        }
+    }
+    return n;
+}
+
+/**
+ * An IndexWriter that writes each result as a line of text.
+ **/
+class LogWriter : public IndexWriter {
+public:
+    std::mutex mutex;
+    std::vector<std::string> log;
+    std::set<STRIGI_THREAD_TYPE> threads;
+    int commits;
+
+    LogWriter() :commits(0) {}
+    void append(const AnalysisResult* ar, const std::string& s) {
+        std::string* d = static_cast<std::string*>(ar->writerData());
+        d->append(s);
+        d->append(1, '|');
+    }
+    void append(const AnalysisResult* ar, const RegisteredField* field,
+            const std::string& value) {
+        append(ar, field->key() + "=" + value);
+    }
+    void startAnalysis(const AnalysisResult* ar) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "|%d|%ld|", (int)ar->depth(),
+            (long)ar->mTime());
+        ar->setWriterData(new std::string(ar->path() + buf
+            + ar->fileName() + "|"));
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.insert(STRIGI_THREAD_SELF());
+    }
+    void addText(const AnalysisResult* ar, const char* text,
+            int32_t length) {
+        append(ar, "text=" + std::string(text, length));
+    }
+    void addValue(const AnalysisResult* ar, const RegisteredField* field,
+            const std::string& value) {
+        append(ar, field, value);
+    }
+    void addValue(const AnalysisResult* ar, const RegisteredField* field,
+            const unsigned char* data, uint32_t size) {
+        append(ar, field, std::string((const char*)data, size));
+    }
+    void addValue(const AnalysisResult* ar, const RegisteredField* field,
+            int32_t value) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%d", value);
+        append(ar, field, buf);
+    }
+    void addValue(const AnalysisResult* ar, const RegisteredField* field,
+            uint32_t value) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%u", value);
+        append(ar, field, buf);
+    }
+    void addValue(const AnalysisResult* ar, const RegisteredField* field,
+            double value) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%g", value);
+        append(ar, field, buf);
+    }
+    void addValue(const AnalysisResult* ar, const RegisteredField* field,
+            const std::string& name, const std::string& value) {
+        append(ar, field, name + ":" + value);
+    }
+    void finishAnalysis(const AnalysisResult* ar) {
+        std::string* d = static_cast<std::string*>(ar->writerData());
+        append(ar, "encoding=" + ar->encoding());
+        std::lock_guard<std::mutex> lock(mutex);
+        log.push_back(normalize(*d));
+        delete d;
+    }
+    void addTriplet(const std::string& subject,
+            const std::string& predicate, const std::string& object) {
+        std::lock_guard<std::mutex> lock(mutex);
+        log.push_back(normalize("triplet|" + subject + "|" + predicate
+            + "|" + object));
+    }
+    void commit() {
+        ++commits;
+    }
+    void deleteEntries(const std::vector<std::string>& entries) {
+        log.push_back("delete|" + entries[0]);
+    }
+    void deleteAllEntries() {
+        log.push_back("delete all");
+    }
+    std::vector<std::string> sorted() const {
+        std::vector<std::string> s(log);
+        std::sort(s.begin(), s.end());
+        return s;
+    }
+};
+
+class Manager : public IndexManager {
+public:
+    IndexWriter& writer;
+    explicit Manager(IndexWriter& w) :writer(w) {}
+    IndexReader* indexReader() { return 0; }
+    IndexWriter* indexWriter() { return &writer; }
+};
+
+/**
+ * Make results with values, triplets and embedded results by hand.
+ **/
+void
+analyze(IndexWriter& writer, AnalyzerConfiguration& config) {
+    StreamAnalyzer analyzer(config);
+    analyzer.setIndexWriter(writer);
+    const FieldRegister& fr = config.fieldRegister();
+    for (int i = 0; i < 20; ++i) {
+        char path[32];
+        snprintf(path, sizeof(path), "/tmp/doc%d.txt", i);
+        AnalysisResult result(path, 1000 + i, writer, analyzer, "/tmp");
+        result.setEncoding((i % 2) ?"UTF-8" :"");
+        result.setMimeType("text/plain");
+        result.addValue(fr.sizeField, (uint32_t)(10 * i));
+        result.addValue(fr.parseErrorField, std::string(i, 'x'));
+        result.addText("some words", 10);
+        result.addTriplet(path, "p", result.newAnonymousUri());
+        if (i % 3 == 0) {
+            const std::string text(100 * i, 'a');
+            StringStream<char> child(text.c_str(), (int32_t)text.length());
+            result.indexChild("child.txt", 2000 + i, &child);
+            result.finishIndexChild();
+        }
+    }
+}
+
+void
+testDocuments() {
+    AnalyzerConfiguration config;
+    LogWriter direct;
+    analyze(direct, config);
+
+    // a small queue makes the analysis wait for the writer
+    LogWriter log;
+    {
+        AsyncIndexWriter writer(log, 64);
+        analyze(writer, config);
+        VERIFY(log.log.size() == direct.log.size());
+        // deleting waits for the documents that were finished before
+        writer.deleteEntries(std::vector<std::string>(1, "/tmp/doc3.txt"));
+        VERIFY(log.log.back() == "delete|/tmp/doc3.txt");
+        writer.commit();
+        VERIFY(log.commits == 1);
+    }
+    VERIFY(log.threads.size() == 1);
+    VERIFY(log.threads.count(STRIGI_THREAD_SELF()) == 0);
+    log.log.pop_back();
+    VERIFY(log.sorted() == direct.sorted());
+    // every third document has an embedded one
+    int children = 0;
+    int triplets = 0;
+    for (size_t i = 0; i < log.log.size(); ++i) {
+        children += log.log[i].find("/child.txt|1|") != std::string::npos;
+        triplets += log.log[i].compare(0, 16, "triplet|/tmp/doc") == 0;
+    }
+    VERIFY(children == 7);
+    VERIFY(triplets == 20);
+}
+
+void
+testThreads(const std::string& data) {
+    AnalyzerConfiguration config;
+    LogWriter direct;
+    {
+        Manager manager(direct);
+        DirAnalyzer analyzer(manager, config);
+        VERIFY(analyzer.analyzeDir(data, 1) == 0);
+    }
+    LogWriter log;
+    {
+        AsyncIndexWriter writer(log, 1024);
+        Manager manager(writer);
+        DirAnalyzer analyzer(manager, config);
+        VERIFY(analyzer.analyzeDir(data, 4) == 0);
+        // the crawl ends with a commit, so all documents are written
+        VERIFY(log.log.size() == direct.log.size());
+        VERIFY(writer.itemsInCache() == 0);
+    }
+    VERIFY(log.threads.size() == 1);
+    VERIFY(log.sorted() == direct.sorted());
+    VERIFY(log.log.size() > 50);
+}
+
+}
+
+int
+AsyncIndexWriterTest(int argc, char* argv[]) {
+    if (argc < 2) return 1;
+    founderrors = 0;
+    const std::string dir(makeTestDir(argv[1]));
+    VERIFY(dir.length());
+    if (dir.empty()) {
+        return founderrors;
+    }
+    for (int i = 0; i < 50; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "/file%d.txt", i);
+        VERIFY(writeTestFile(dir + name, std::string(i * 50, 'w')));
+    }
+    VERIFY(mkdir((dir + "/sub").c_str(), 0700) == 0);
+    VERIFY(writeTestFile(dir + "/sub/a.txt", "hello world"));
+
+    testDocuments();
+    testThreads(dir);
+
+    removeTestDir(dir);
+    return founderrors;
+}
@@ -0,0 +1,159 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "testutils.h"
+#include <strigi/analysisresult.h>
+#include <strigi/analyzerconfiguration.h>
+#include <strigi/diranalyzer.h>
+#include <strigi/indexmanager.h>
+#include <strigi/indexwriter.h>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Strigi;
+
+namespace {
+
+/**
+ * An IndexWriter that only remembers the paths of the analyzed files.
+ **/
+class PathWriter : public IndexWriter {
+public:
+    std::mutex mutex;
+    std::multiset<std::string> paths;
+
+    void startAnalysis(const AnalysisResult* ar) {
+        if (ar->depth() == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            paths.insert(ar->path());
+        }
+    }
+    void addText(const AnalysisResult*, const char*, int32_t) {}
+    void addValue(const AnalysisResult*, const RegisteredField*,
+        const std::string&) {}
+    void addValue(const AnalysisResult*, const RegisteredField*,
+        const unsigned char*, uint32_t) {}
+    void addValue(const AnalysisResult*, const RegisteredField*, int32_t) {}
+    void addValue(const AnalysisResult*, const RegisteredField*, uint32_t) {}
+    void addValue(const AnalysisResult*, const RegisteredField*, double) {}
+    void addValue(const AnalysisResult*, const RegisteredField*,
+        const std::string&, const std::string&) {}
+    void finishAnalysis(const AnalysisResult*) {}
+    void addTriplet(const std::string&, const std::string&,
+        const std::string&) {}
+    void deleteEntries(const std::vector<std::string>&) {}
+    void deleteAllEntries() {}
+};
+
+class Manager : public IndexManager {
+public:
+    IndexWriter& writer;
+    explicit Manager(IndexWriter& w) :writer(w) {}
+    IndexReader* indexReader() { return 0; }
+    IndexWriter* indexWriter() { return &writer; }
+};
+
+/**
+ * Stops the crawl after a number of batches.
+ **/
+class Stopper : public AnalysisCaller {
+public:
+    std::atomic<int> batches;
+    explicit Stopper(int n) :batches(n) {}
+    bool continueAnalysis() {
+        return batches-- > 0;
+    }
+};
+
+bool
+exists(const std::string& path) {
+    struct stat s;
+    return stat(path.c_str(), &s) == 0;
+}
+
+/**
+ * Stop a crawl after two batches and resume it from the checkpoint.
+ * Together, the two runs must analyze every file exactly once.
+ **/
+void
+testResume(const std::string& dir, int nthreads) {
+    const std::string checkpoint(dir + ".checkpoint");
+    AnalyzerConfiguration config;
+    PathWriter all;
+    {
+        Manager manager(all);
+        DirAnalyzer analyzer(manager, config);
+        VERIFY(analyzer.analyzeDir(dir, 1) == 0);
+    }
+    PathWriter first;
+    {
+        Manager manager(first);
+        DirAnalyzer analyzer(manager, config);
+        analyzer.setCheckpoint(checkpoint, 3600);
+        Stopper stopper(2);
+        VERIFY(analyzer.analyzeDir(dir, nthreads, &stopper) == 0);
+    }
+    VERIFY(first.paths.size() < all.paths.size());
+    VERIFY(exists(checkpoint));
+    PathWriter second;
+    {
+        Manager manager(second);
+        DirAnalyzer analyzer(manager, config);
+        analyzer.setCheckpoint(checkpoint, 3600);
+        VERIFY(analyzer.resumeDir(nthreads) == 0);
+    }
+    // the crawl is complete, so the checkpoint is gone
+    VERIFY(!exists(checkpoint));
+    std::multiset<std::string> both(first.paths);
+    both.insert(second.paths.begin(), second.paths.end());
+    VERIFY(both == all.paths);
+    unlink(checkpoint.c_str());
+}
+
+}
+
+int
+CheckpointTest(int argc, char* argv[]) {
+    if (argc < 2) return 1;
+    founderrors = 0;
+    const std::string dir(makeTestDir(argv[1]));
+    VERIFY(dir.length());
+    if (dir.empty()) {
+        return founderrors;
+    }
+    for (int i = 0; i < 6; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "/dir%d", i);
+        const std::string sub(dir + name);
+        VERIFY(mkdir(sub.c_str(), 0700) == 0);
+        for (int j = 0; j < 4; ++j) {
+            snprintf(name, sizeof(name), "/file%d.txt", j);
+            VERIFY(writeTestFile(sub + name, std::string(10 * j, 'c')));
+        }
+    }
+
+    testResume(dir, 1);
+    testResume(dir, 3);
+
+    removeTestDir(dir);
+    return founderrors;
+}
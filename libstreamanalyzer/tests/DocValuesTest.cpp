@@ -0,0 +1,185 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "testutils.h"
+#include "../lib/index/docvalues.h"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+using namespace Strigi;
+
+namespace {
+
+typedef std::vector<std::vector<std::string> > Values;
+typedef std::vector<std::pair<std::string, uint32_t> > Histogram;
+
+std::string
+number(long long n) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%lld", n);
+    return buf;
+}
+/**
+ * Write a column with @p values, read it back and compare it with
+ * @p values.
+ **/
+void
+check(const Values& values, Column::Kind kind) {
+    ColumnWriter writer;
+    for (uint32_t d = 0; d < values.size(); ++d) {
+        for (size_t i = 0; i < values[d].size(); ++i) {
+            writer.add(d, values[d][i]);
+        }
+    }
+    std::string data;
+    writer.write((uint32_t)values.size(), data);
+    Column column;
+    VERIFY(column.init(data.data(), data.data() + data.length(),
+        (uint32_t)values.size()));
+    VERIFY(column.type() == kind);
+
+    std::vector<uint32_t> docs;
+    std::map<std::string, uint32_t> counts;
+    std::vector<std::string> v;
+    for (uint32_t d = 0; d < values.size(); ++d) {
+        v.clear();
+        column.values(d, v);
+        VERIFY(v == values[d]);
+        if (rand() % 3) {
+            docs.push_back(d);
+            for (size_t i = 0; i < values[d].size(); ++i) {
+                ++counts[values[d][i]];
+            }
+        }
+    }
+    v.clear();
+    column.values((uint32_t)values.size(), v);
+    VERIFY(v.empty());
+
+    Histogram h;
+    column.histogram(docs, h);
+    if (kind == Column::Numeric) {
+        // numeric values come in numeric order
+        for (size_t i = 1; i < h.size(); ++i) {
+            VERIFY(atoll(h[i - 1].first.c_str())
+                < atoll(h[i].first.c_str()));
+        }
+        const std::map<std::string, uint32_t> m(h.begin(), h.end());
+        VERIFY(m == counts);
+    } else {
+        VERIFY(h == Histogram(counts.begin(), counts.end()));
+    }
+}
+
+void
+testNumeric() {
+    Values values(1000);
+    for (size_t d = 0; d < values.size(); ++d) {
+        if (rand() % 4) {
+            values[d].push_back(number(rand() % 200 - 100));
+        }
+    }
+    check(values, Column::Numeric);
+    values[7].assign(1, "-1000000000000000");
+    values[9].assign(1, "123456789012345");
+    check(values, Column::Numeric);
+    // values that are too far apart are strings
+    values[7].assign(1, "-9223372036854775808");
+    check(values, Column::Single);
+    check(Values(10, std::vector<std::string>(1, "5")), Column::Numeric);
+}
+
+void
+testSingle() {
+    const char* words[] = { "", "text/plain", "image/png", "application/pdf",
+        "007", "1.5" };
+    Values values(1000);
+    for (size_t d = 0; d < values.size(); ++d) {
+        if (rand() % 4) {
+            values[d].push_back(words[rand() % 6]);
+        }
+    }
+    check(values, Column::Single);
+    // numbers that are not written the same way are strings
+    values[3].assign(1, "+1");
+    check(values, Column::Single);
+    check(Values(5, std::vector<std::string>(1, "x")), Column::Single);
+}
+
+void
+testMultiple() {
+    Values values(500);
+    for (size_t d = 0; d < values.size(); ++d) {
+        const int n = rand() % 4;
+        for (int i = 0; i < n; ++i) {
+            values[d].push_back(number(rand() % 50));
+        }
+    }
+    check(values, Column::Multiple);
+}
+
+void
+testDamagedData() {
+    ColumnWriter writer;
+    for (uint32_t d = 0; d < 300; ++d) {
+        writer.add(d, number(rand() % 30) + "x");
+        if (d % 3 == 0) {
+            writer.add(d, "y");
+        }
+    }
+    std::string good;
+    writer.write(300, good);
+    std::vector<uint32_t> docs;
+    for (uint32_t d = 0; d < 320; d += 2) {
+        docs.push_back(d);
+    }
+    std::vector<std::string> v;
+    Histogram h;
+    for (int i = 0; i < 500; ++i) {
+        std::string data(good);
+        for (int j = 0; j < 3; ++j) {
+            data[rand() % data.length()] = (char)rand();
+        }
+        // reading damaged data may give wrong values but must stay in it
+        Column column;
+        const size_t size = data.length() - rand() % 3;
+        if (column.init(data.data(), data.data() + size, 300)) {
+            for (uint32_t d = 0; d < 310; ++d) {
+                v.clear();
+                column.values(d, v);
+            }
+            h.clear();
+            column.histogram(docs, h);
+        }
+    }
+}
+
+}
+
+int
+DocValuesTest(int, char*[]) {
+    founderrors = 0;
+    srand(5);
+    testNumeric();
+    testSingle();
+    testMultiple();
+    testDamagedData();
+    return founderrors;
+}
@@ -0,0 +1,211 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "testutils.h"
+#include "../lib/index/fst.h"
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+
+using namespace Strigi;
+
+namespace {
+
+/**
+ * Build a transducer for @p terms in @p data and open it with @p fst.
+ **/
+bool
+build(const std::set<std::string>& terms, std::string& data, Fst& fst) {
+    data.clear();
+    FstBuilder builder(data);
+    std::set<std::string>::const_iterator i;
+    for (i = terms.begin(); i != terms.end(); ++i) {
+        if (!builder.add(*i)) {
+            return false;
+        }
+    }
+    const uint64_t root = builder.finish();
+    return fst.init(data.data(), data.length(), root)
+        && fst.size() == terms.size();
+}
+std::string
+randomTerm(int alphabet) {
+    std::string term;
+    const int length = rand() % 8;
+    for (int i = 0; i < length; ++i) {
+        term += (char)(0x80 - alphabet / 2 + rand() % alphabet);
+    }
+    return term;
+}
+/**
+ * Compare all operations on the transducer for @p terms with the set.
+ **/
+void
+check(const std::set<std::string>& terms) {
+    std::string data;
+    Fst fst;
+    VERIFY(build(terms, data, fst));
+    const std::vector<std::string> sorted(terms.begin(), terms.end());
+
+    // iteration and lookup
+    Fst::Iterator it;
+    bool ok = it.seek(fst, std::string());
+    for (uint32_t i = 0; i < sorted.size(); ++i) {
+        VERIFY(ok && it.term() == sorted[i] && it.ordinal() == i);
+        uint32_t ordinal;
+        VERIFY(fst.find(sorted[i], ordinal) && ordinal == i);
+        ok = it.next();
+    }
+    VERIFY(!ok);
+
+    for (int i = 0; i < 300; ++i) {
+        const std::string probe(randomTerm(12));
+        std::vector<std::string>::const_iterator lower
+            = std::lower_bound(sorted.begin(), sorted.end(), probe);
+        uint32_t ordinal;
+        VERIFY(fst.find(probe, ordinal)
+            == (lower != sorted.end() && *lower == probe));
+        if (it.seek(fst, probe)) {
+            VERIFY(lower != sorted.end() && it.term() == *lower
+                && it.ordinal() == (uint32_t)(lower - sorted.begin()));
+        } else {
+            VERIFY(lower == sorted.end());
+        }
+
+        // prefixes
+        const std::string prefix(probe, 0, probe.length() / 2);
+        uint32_t n = 0, first = 0;
+        std::vector<std::string>::const_iterator j;
+        for (j = std::lower_bound(sorted.begin(), sorted.end(), prefix);
+                j != sorted.end() && j->compare(0, prefix.length(), prefix)
+                    == 0; ++j) {
+            if (n++ == 0) {
+                first = (uint32_t)(j - sorted.begin());
+            }
+        }
+        uint32_t f;
+        VERIFY(fst.countPrefix(prefix, f) == n && (n == 0 || f == first));
+
+        if (sorted.size()) {
+            const uint32_t o = rand() % sorted.size();
+            VERIFY(it.seekOrdinal(fst, o) && it.term() == sorted[o]
+                && it.ordinal() == o);
+        }
+    }
+    VERIFY(!it.seekOrdinal(fst, (uint32_t)sorted.size()));
+}
+
+void
+testSmall() {
+    std::set<std::string> terms;
+    check(terms);
+    terms.insert(std::string());
+    check(terms);
+    const char* words[] = { "a", "ab", "abc", "b", "bcd", "\xff", "\xff\x01" };
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+        terms.insert(words[i]);
+    }
+    check(terms);
+
+    std::string data;
+    FstBuilder builder(data);
+    VERIFY(builder.add("b"));
+    VERIFY(!builder.add("b"));
+    VERIFY(!builder.add("a"));
+    VERIFY(builder.add("ba") && builder.size() == 2);
+}
+
+void
+testRandom() {
+    // small alphabets give nodes with few arcs, large ones nodes with arcs
+    // of a fixed size
+    const int alphabets[] = { 3, 12, 200 };
+    for (size_t a = 0; a < sizeof(alphabets) / sizeof(alphabets[0]); ++a) {
+        std::set<std::string> terms;
+        for (int i = 0; i < 3000; ++i) {
+            terms.insert(randomTerm(alphabets[a]));
+        }
+        check(terms);
+    }
+}
+
+void
+testSharedSuffixes() {
+    // all terms of three letters from ten letters need one node per length
+    std::set<std::string> terms;
+    for (char a = 'a'; a < 'k'; ++a) {
+        for (char b = 'a'; b < 'k'; ++b) {
+            for (char c = 'a'; c < 'k'; ++c) {
+                terms.insert(std::string() + a + b + c);
+            }
+        }
+    }
+    std::string data;
+    Fst fst;
+    VERIFY(build(terms, data, fst));
+    VERIFY(data.length() < 500);
+    uint32_t first;
+    VERIFY(fst.countPrefix("c", first) == 100 && first == 200);
+    Fst::Iterator it;
+    VERIFY(it.seekOrdinal(fst, 456) && it.term() == "efg");
+}
+
+void
+testDamagedData() {
+    std::set<std::string> terms;
+    for (int i = 0; i < 500; ++i) {
+        terms.insert(randomTerm(20));
+    }
+    std::string data;
+    Fst fst;
+    VERIFY(build(terms, data, fst));
+    const std::string good(data);
+    for (int i = 0; i < 200; ++i) {
+        data = good;
+        for (int j = 0; j < 4; ++j) {
+            data[rand() % data.length()] = (char)rand();
+        }
+        // reading damaged data may fail, but it must stop
+        const size_t root = rand() % data.length();
+        if (fst.init(data.data(), data.length() - rand() % 3, root)) {
+            Fst::Iterator it;
+            int n = 0;
+            for (bool ok = it.seek(fst, std::string()); ok && n < 100000;
+                    ok = it.next()) {
+                ++n;
+            }
+            uint32_t first;
+            fst.countPrefix(randomTerm(20), first);
+            it.seekOrdinal(fst, rand() % 600);
+        }
+    }
+}
+
+}
+
+int
+FstTest(int, char*[]) {
+    founderrors = 0;
+    srand(3);
+    testSmall();
+    testRandom();
+    testSharedSuffixes();
+    testDamagedData();
+    return founderrors;
+}
@@ -0,0 +1,161 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "testutils.h"
+#include "../lib/index/levenshtein.h"
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+using namespace Strigi;
+
+namespace {
+
+/**
+ * A sorted list of terms that counts how often it is searched.
+ **/
+class Terms {
+public:
+    std::vector<std::string> terms;
+    std::vector<std::string>::const_iterator i;
+    size_t seeks;
+    explicit Terms(const std::set<std::string>& t)
+        :terms(t.begin(), t.end()), seeks(0) {}
+    bool seek(const std::string& s) {
+        ++seeks;
+        i = std::lower_bound(terms.begin(), terms.end(), s);
+        return i != terms.end();
+    }
+    const std::string& term() const { return *i; }
+};
+
+unsigned
+simpleDistance(const std::string& a, const std::string& b) {
+    std::vector<unsigned> row(b.length() + 1);
+    for (size_t j = 0; j <= b.length(); ++j) {
+        row[j] = (unsigned)j;
+    }
+    for (size_t i = 0; i < a.length(); ++i) {
+        unsigned diagonal = row[0];
+        row[0] = (unsigned)i + 1;
+        for (size_t j = 1; j <= b.length(); ++j) {
+            const unsigned d = std::min(diagonal + (a[i] != b[j - 1]),
+                std::min(row[j], row[j - 1]) + 1);
+            diagonal = row[j];
+            row[j] = d;
+        }
+    }
+    return row[b.length()];
+}
+std::string
+randomTerm(const char* alphabet, int maxLength) {
+    std::string term;
+    const int length = rand() % maxLength;
+    const size_t n = strlen(alphabet);
+    for (int i = 0; i < length; ++i) {
+        term += alphabet[rand() % n];
+    }
+    return term;
+}
+
+void
+testDistance() {
+    for (int i = 0; i < 2000; ++i) {
+        const std::string a(randomTerm("abc\xff", 8));
+        const std::string b(randomTerm("abc\xff", 8));
+        const unsigned n = rand() % 3;
+        const LevenshteinAutomaton automaton(a, n);
+        VERIFY(automaton.distance(b) == std::min(simpleDistance(a, b), n + 1));
+    }
+}
+
+void
+testNext() {
+    std::set<std::string> set;
+    for (int i = 0; i < 500; ++i) {
+        set.insert(randomTerm("abcd", 7));
+    }
+    const std::vector<std::string> terms(set.begin(), set.end());
+    for (int i = 0; i < 300; ++i) {
+        const std::string term(randomTerm("abce", 6));
+        const LevenshteinAutomaton automaton(term, rand() % 3);
+        const std::string s(randomTerm("abcd\xff", 7));
+        std::string match;
+        const bool found = automaton.next(s, match);
+        // no term from s up to the match is accepted
+        std::vector<std::string>::const_iterator j;
+        for (j = std::lower_bound(terms.begin(), terms.end(), s);
+                j != terms.end() && (!found || *j < match); ++j) {
+            VERIFY(automaton.distance(*j) > automaton.maxEdits());
+        }
+        if (found) {
+            VERIFY(match >= s);
+            VERIFY(automaton.distance(match) <= automaton.maxEdits());
+        }
+    }
+}
+
+void
+testExpansion() {
+    std::set<std::string> set;
+    for (int i = 0; i < 3000; ++i) {
+        set.insert(randomTerm("abcdefgh", 8));
+    }
+    Terms terms(set);
+    size_t seeks = 0;
+    for (int i = 0; i < 200; ++i) {
+        const std::string term(randomTerm("abcdefgh", 8));
+        const unsigned n = rand() % 3;
+        const size_t max = (rand() % 2) ?1 + rand() % 5 :1000;
+        std::vector<FuzzyTerm> expected;
+        std::vector<std::string>::const_iterator j;
+        for (j = terms.terms.begin(); j != terms.terms.end(); ++j) {
+            const unsigned d = simpleDistance(term, *j);
+            if (d <= n) {
+                expected.push_back(FuzzyTerm(*j, d));
+            }
+        }
+        std::sort(expected.begin(), expected.end());
+        expected.resize(std::min(expected.size(), max));
+
+        std::vector<FuzzyTerm> found;
+        terms.seeks = 0;
+        expandFuzzy(terms, term, n, max, found);
+        seeks += terms.seeks;
+        VERIFY(found.size() == expected.size());
+        for (size_t k = 0; k < found.size() && k < expected.size(); ++k) {
+            VERIFY(found[k].term == expected[k].term);
+            VERIFY(found[k].distance == expected[k].distance);
+        }
+    }
+    // the terms are looked up, not scanned
+    VERIFY(seeks / 200 < terms.terms.size() / 10);
+}
+
+}
+
+int
+LevenshteinTest(int, char*[]) {
+    founderrors = 0;
+    srand(9);
+    testDistance();
+    testNext();
+    testExpansion();
+    return founderrors;
+}
@@ -0,0 +1,236 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "testutils.h"
+#include "../lib/index/positions.h"
+#include "../lib/index/tokenizer.h"
+#include "../lib/index/indexformat.h"
+#include <cstdlib>
+
+using namespace Strigi;
+
+namespace {
+
+typedef std::vector<const std::vector<uint32_t>*> Lists;
+
+/**
+ * Split @p text one byte at a time.
+ **/
+std::vector<Token>
+simpleTokens(const std::string& text) {
+    std::vector<Token> tokens;
+    std::string word;
+    uint32_t position = 0;
+    for (size_t i = 0; i <= text.length(); ++i) {
+        const unsigned char c = (i < text.length()) ?text[i] :' ';
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80) {
+            word += (char)c;
+        } else if (c >= 'A' && c <= 'Z') {
+            word += (char)(c + 'a' - 'A');
+        } else if (word.length()) {
+            if (word.length() <= Tokenizer::maxWordLength) {
+                tokens.push_back(Token(word, position));
+            }
+            ++position;
+            word.clear();
+        }
+    }
+    return tokens;
+}
+void
+testTokenizer() {
+    const char* pieces[] = { "a", "B", "z", "Z", "0", "9", " ", ".", "-",
+        "\xc3\xa9", "\xe2\x82\xac", "@", "[", "`", "{", "/", ":", "\n" };
+    const size_t n = sizeof(pieces) / sizeof(pieces[0]);
+    for (int i = 0; i < 300; ++i) {
+        std::string text;
+        const int length = rand() % 200;
+        for (int j = 0; j < length; ++j) {
+            // long runs of word characters and of separators
+            const int run = (rand() % 4) ?1 :rand() % 40;
+            const char* piece = pieces[rand() % n];
+            for (int k = 0; k < run; ++k) {
+                text += piece;
+            }
+        }
+        const std::vector<Token> expected(simpleTokens(text));
+        // the text is passed in random pieces
+        std::vector<Token> tokens;
+        Tokenizer tokenizer;
+        for (size_t p = 0; p < text.length(); ) {
+            const size_t size = std::min(text.length() - p,
+                (size_t)(rand() % 50));
+            tokenizer.tokenize(text.data() + p, (int32_t)size, tokens);
+            p += size;
+        }
+        tokenizer.finish(tokens);
+        VERIFY(tokens.size() == expected.size());
+        for (size_t k = 0; k < tokens.size() && k < expected.size(); ++k) {
+            VERIFY(tokens[k].word == expected[k].word);
+            VERIFY(tokens[k].position == expected[k].position);
+        }
+    }
+}
+
+void
+testEncoding() {
+    for (int i = 0; i < 50; ++i) {
+        const uint32_t count = (i < 5) ?i :1 + rand() % 1000;
+        std::vector<Posting> postings;
+        std::vector<std::vector<uint32_t> > groups(count);
+        std::vector<uint32_t> positions;
+        for (uint32_t d = 0; d < count; ++d) {
+            uint32_t p = rand() % 5;
+            const uint32_t freq = 1 + rand() % ((rand() % 10) ?3 :300);
+            for (uint32_t f = 0; f < freq; ++f) {
+                groups[d].push_back(p);
+                positions.push_back(p);
+                p += 1 + rand() % ((rand() % 10) ?10 :100000);
+            }
+            postings.push_back(Posting(2 * d, freq));
+        }
+        std::string data("x");
+        encodePositions(postings, positions, data);
+        PositionReader reader;
+        VERIFY(reader.init(data.data() + 1, data.data() + data.length(),
+            count));
+        std::vector<uint32_t> group;
+        // read every posting in order, then skip through the list
+        for (uint32_t d = 0; d < count; ++d) {
+            VERIFY(reader.read(d, group));
+            VERIFY(group == groups[d]);
+        }
+        VERIFY(!reader.read(count, group));
+        for (uint32_t d = 0; d < count; d += 1 + rand() % 300) {
+            VERIFY(reader.read(d, group));
+            VERIFY(group == groups[d]);
+        }
+        if (count) {
+            const uint32_t d = rand() % count;
+            VERIFY(reader.read(d, group));
+            VERIFY(group == groups[d]);
+        }
+    }
+}
+
+/**
+ * Try all choices of one position from each list.
+ **/
+bool
+simpleMatch(const Lists& lists, size_t i, std::vector<uint32_t>& chosen,
+        uint32_t maxGaps, bool ordered) {
+    if (i == lists.size()) {
+        const uint32_t min = *std::min_element(chosen.begin(), chosen.end());
+        const uint32_t max = *std::max_element(chosen.begin(), chosen.end());
+        return max - min + 1 - chosen.size() <= maxGaps;
+    }
+    std::vector<uint32_t>::const_iterator j;
+    for (j = lists[i]->begin(); j != lists[i]->end(); ++j) {
+        if ((ordered && i && *j <= chosen.back())
+                || std::find(chosen.begin(), chosen.end(), *j)
+                    != chosen.end()) {
+            continue;
+        }
+        chosen.push_back(*j);
+        const bool ok = simpleMatch(lists, i + 1, chosen, maxGaps, ordered);
+        chosen.pop_back();
+        if (ok) {
+            return true;
+        }
+    }
+    return false;
+}
+void
+testMatching() {
+    for (int i = 0; i < 3000; ++i) {
+        // the positions of a few words in a short text
+        const int words = 1 + rand() % 3;
+        std::vector<std::vector<uint32_t> > text(words);
+        for (uint32_t p = 0; p < 20; ++p) {
+            if (rand() % 3 == 0) {
+                text[rand() % words].push_back(p);
+            }
+        }
+        Lists lists;
+        const int n = 1 + rand() % 4;
+        for (int j = 0; j < n; ++j) {
+            lists.push_back(&text[rand() % words]);
+        }
+        const uint32_t maxGaps = rand() % 4;
+        const bool ordered = rand() % 2;
+        std::vector<uint32_t> chosen;
+        VERIFY(matchPositions(lists, maxGaps, ordered)
+            == simpleMatch(lists, 0, chosen, maxGaps, ordered));
+    }
+    const std::vector<uint32_t> a(1, 3), b(1, 4), c(1, 6);
+    Lists lists;
+    lists.push_back(&a);
+    lists.push_back(&b);
+    VERIFY(matchPositions(lists, 0, true));
+    VERIFY(!matchPositions(Lists(lists.rbegin(), lists.rend()), 0, true));
+    VERIFY(matchPositions(Lists(lists.rbegin(), lists.rend()), 0, false));
+    lists.push_back(&c);
+    VERIFY(!matchPositions(lists, 0, true));
+    VERIFY(matchPositions(lists, 1, true));
+    // a word that occurs twice needs two positions
+    lists.push_back(&c);
+    VERIFY(!matchPositions(lists, 10, false));
+}
+
+void
+testDamagedData() {
+    std::vector<Posting> postings;
+    std::vector<uint32_t> positions;
+    for (uint32_t d = 0; d < 500; ++d) {
+        postings.push_back(Posting(d, 1 + d % 3));
+        for (uint32_t f = 0; f <= d % 3; ++f) {
+            positions.push_back(d + 10 * f);
+        }
+    }
+    std::string good;
+    encodePositions(postings, positions, good);
+    std::vector<uint32_t> group;
+    for (int i = 0; i < 300; ++i) {
+        std::string data(good);
+        for (int j = 0; j < 3; ++j) {
+            data[rand() % data.length()] = (char)rand();
+        }
+        // reading damaged data may give wrong positions, but it must stop
+        PositionReader reader;
+        const size_t size = data.length() - rand() % 3;
+        if (reader.init(data.data(), data.data() + size, 500)) {
+            for (uint32_t d = 0; d < 500; d += 1 + rand() % 100) {
+                reader.read(d, group);
+            }
+        }
+    }
+}
+
+}
+
+int
+PositionsTest(int, char*[]) {
+    founderrors = 0;
+    srand(8);
+    testTokenizer();
+    testEncoding();
+    testMatching();
+    testDamagedData();
+    return founderrors;
+}
@@ -0,0 +1,166 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Measures how fast posting lists are encoded, decoded, intersected and
+ * united. The varint format that the segment index used before is
+ * measured for comparison.
+ *
+ * Usage: postinglistbenchmark [NUMBER OF POSTINGS]
+ */
+#include "../lib/index/indexformat.h"
+#include "../lib/index/postinglist.h"
+#include <chrono>
+#include <cstdlib>
+
+using namespace Strigi;
+
+namespace {
+
+std::vector<Posting>
+makePostings(uint32_t n, uint32_t gap) {
+    std::vector<Posting> postings;
+    uint32_t doc = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        postings.push_back(Posting(doc, (rand() % 4) ?1 :2 + rand() % 10));
+        doc += 1 + rand() % gap;
+    }
+    return postings;
+}
+void
+encodeVarints(const std::vector<Posting>& postings, std::string& out) {
+    uint32_t last = 0;
+    std::vector<Posting>::const_iterator i;
+    for (i = postings.begin(); i != postings.end(); ++i) {
+        putVarint(out, (uint64_t)(i->doc - last) << 1 | (i->freq == 1));
+        if (i->freq != 1) {
+            putVarint(out, i->freq);
+        }
+        last = i->doc;
+    }
+}
+uint64_t
+decodeVarints(const std::string& data, uint32_t count) {
+    const char* p = data.data();
+    const char* end = p + data.length();
+    uint64_t sum = 0;
+    uint32_t doc = 0;
+    for (uint32_t n = 0; n < count; ++n) {
+        uint64_t v, freq = 1;
+        if (!getVarint(p, end, v) || (!(v & 1) && !getVarint(p, end, freq))) {
+            break;
+        }
+        doc += (uint32_t)(v >> 1);
+        sum += doc + freq;
+    }
+    return sum;
+}
+
+class Timer {
+private:
+    std::chrono::steady_clock::time_point start;
+public:
+    Timer() :start(std::chrono::steady_clock::now()) {}
+    double nanoseconds() const {
+        return std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+};
+void
+report(const char* name, double ns, uint64_t postings, uint64_t check) {
+    printf("%-28s %8.2f ns/posting %10.1f Mpostings/s  (%llu)\n", name,
+        ns / (double)postings, (double)postings * 1000.0 / ns,
+        (unsigned long long)check);
+}
+
+}
+
+int
+main(int argc, char** argv) {
+    const uint32_t n = (argc > 1) ?(uint32_t)atoi(argv[1]) :1000000;
+    const int runs = 20;
+    srand(1);
+    const std::vector<Posting> dense = makePostings(n, 4);
+    const std::vector<Posting> sparse = makePostings(n / 100, 400);
+
+    std::string blocks, varints;
+    Timer encodeTimer;
+    for (int r = 0; r < runs; ++r) {
+        blocks.clear();
+        encodePostings(dense, blocks);
+    }
+    report("encode blocks", encodeTimer.nanoseconds(), (uint64_t)n * runs,
+        blocks.length());
+    encodeVarints(dense, varints);
+    printf("%-28s %8.2f bytes/posting (varints: %.2f)\n", "size",
+        (double)blocks.length() / n, (double)varints.length() / n);
+
+    uint64_t sum = 0;
+    Timer varintTimer;
+    for (int r = 0; r < runs; ++r) {
+        sum += decodeVarints(varints, n);
+    }
+    report("decode varints", varintTimer.nanoseconds(), (uint64_t)n * runs,
+        sum);
+
+    sum = 0;
+    Timer decodeTimer;
+    for (int r = 0; r < runs; ++r) {
+        PostingIterator list;
+        list.init(blocks.data(), blocks.data() + blocks.length());
+        for (uint32_t d = list.doc(); d != PostingIterator::noMoreDocs;
+                d = list.next()) {
+            sum += d + list.freq();
+        }
+    }
+    report("decode blocks", decodeTimer.nanoseconds(), (uint64_t)n * runs,
+        sum);
+
+    std::string rare;
+    encodePostings(sparse, rare);
+    sum = 0;
+    Timer andTimer;
+    for (int r = 0; r < runs; ++r) {
+        PostingIterator a, b;
+        a.init(blocks.data(), blocks.data() + blocks.length());
+        b.init(rare.data(), rare.data() + rare.length());
+        std::vector<PostingIterator*> lists;
+        lists.push_back(&a);
+        lists.push_back(&b);
+        intersectPostings(lists, [&sum](uint32_t doc) { sum += doc; });
+    }
+    report("intersect dense and sparse", andTimer.nanoseconds(),
+        (uint64_t)(dense.size() + sparse.size()) * runs, sum);
+
+    sum = 0;
+    Timer orTimer;
+    for (int r = 0; r < runs; ++r) {
+        PostingIterator a, b;
+        a.init(blocks.data(), blocks.data() + blocks.length());
+        b.init(rare.data(), rare.data() + rare.length());
+        std::vector<PostingIterator*> lists;
+        lists.push_back(&a);
+        lists.push_back(&b);
+        unitePostings(lists, [&sum](uint32_t doc) { sum += doc; });
+    }
+    report("unite dense and sparse", orTimer.nanoseconds(),
+        (uint64_t)(dense.size() + sparse.size()) * runs, sum);
+    return 0;
+}
@@ -0,0 +1,265 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "testutils.h"
+#include "../lib/index/indexformat.h"
+#include "../lib/index/postinglist.h"
+#include <cstdlib>
+
+using namespace Strigi;
+
+namespace {
+
+/**
+ * Make a list of @p n postings with gaps of at most @p gap.
+ **/
+std::vector<Posting>
+makePostings(uint32_t n, uint32_t gap, uint32_t first = 0) {
+    std::vector<Posting> postings;
+    uint32_t doc = first;
+    for (uint32_t i = 0; i < n; ++i) {
+        const uint32_t freq = (rand() % 4) ?1 :1 + rand() % 1000;
+        postings.push_back(Posting(doc, freq));
+        doc += 1 + rand() % gap;
+    }
+    return postings;
+}
+bool
+equal(const std::vector<Posting>& a, const std::vector<Posting>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].doc != b[i].doc || a[i].freq != b[i].freq) {
+            return false;
+        }
+    }
+    return true;
+}
+std::vector<Posting>
+decode(const std::string& data) {
+    std::vector<Posting> postings;
+    PostingIterator list;
+    VERIFY(list.init(data.data(), data.data() + data.length()));
+    for (uint32_t d = list.doc(); d != PostingIterator::noMoreDocs;
+            d = list.next()) {
+        postings.push_back(Posting(d, list.freq()));
+    }
+    VERIFY(postings.size() == list.size());
+    return postings;
+}
+
+void
+testRoundTrip() {
+    const uint32_t sizes[] = { 0, 1, 127, 128, 129, 256, 1000, 5000 };
+    const uint32_t gaps[] = { 1, 2, 100, 70000, 0x7fffff };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        for (size_t j = 0; j < sizeof(gaps) / sizeof(gaps[0]); ++j) {
+            if ((uint64_t)sizes[i] * gaps[j] > 0xf0000000) {
+                continue;
+            }
+            const std::vector<Posting> postings
+                = makePostings(sizes[i], gaps[j]);
+            std::string data;
+            encodePostings(postings, data);
+            VERIFY(equal(postings, decode(data)));
+        }
+    }
+    // the largest document numbers and frequencies
+    std::vector<Posting> postings;
+    for (uint32_t i = 0; i < 300; ++i) {
+        postings.push_back(Posting(0xfffffff0 - 300 + i, 0xffffffff - i));
+    }
+    postings[0].doc = 0;
+    std::string data;
+    encodePostings(postings, data);
+    VERIFY(equal(postings, decode(data)));
+}
+
+void
+testAdvance() {
+    const std::vector<Posting> postings = makePostings(3000, 50, 7);
+    std::vector<uint32_t> docs;
+    for (size_t i = 0; i < postings.size(); ++i) {
+        docs.push_back(postings[i].doc);
+    }
+    std::string data;
+    encodePostings(postings, data);
+    for (int run = 0; run < 50; ++run) {
+        PostingIterator list;
+        VERIFY(list.init(data.data(), data.data() + data.length()));
+        uint32_t target = 0;
+        while (target < docs.back() + 10) {
+            target += rand() % ((run % 2) ?20 :2000);
+            std::vector<uint32_t>::const_iterator i
+                = std::lower_bound(docs.begin(), docs.end(), target);
+            const uint32_t expected = (i == docs.end())
+                ?PostingIterator::noMoreDocs :*i;
+            const uint32_t d = list.advance(target);
+            VERIFY(d == expected && list.doc() == expected);
+            if (d != expected) {
+                return;
+            }
+            if (d != PostingIterator::noMoreDocs) {
+                VERIFY(list.freq() == postings[i - docs.begin()].freq);
+            }
+        }
+    }
+}
+
+void
+testBlockBounds() {
+    std::vector<Posting> postings;
+    for (uint32_t i = 0; i < 3 * postingBlockSize + 10; ++i) {
+        postings.push_back(Posting(2 * i, 1 + i / postingBlockSize));
+    }
+    postings[postingBlockSize + 5].freq = 50;
+    postings.back().freq = 70;
+    std::string data;
+    encodePostings(postings, data);
+    PostingIterator list;
+    VERIFY(list.init(data.data(), data.data() + data.length()));
+    VERIFY(list.maxFreq() == 70);
+    VERIFY(list.shallowAdvance(0) == 2 * (postingBlockSize - 1));
+    VERIFY(list.maxFreq(10) == 1);
+    VERIFY(list.maxFreq(2 * postingBlockSize) == 50);
+    // finding a block does not move the list
+    VERIFY(list.shallowAdvance(2 * postingBlockSize + 1)
+        == 2 * (2 * postingBlockSize - 1));
+    VERIFY(list.doc() == 0);
+    VERIFY(list.maxFreq(2 * (2 * postingBlockSize)) == 50);
+    VERIFY(list.shallowAdvance(6 * postingBlockSize)
+        == PostingIterator::noMoreDocs);
+    VERIFY(list.maxFreq(PostingIterator::noMoreDocs) == 70);
+}
+
+void
+testSetOperations() {
+    std::vector<std::vector<Posting> > postings;
+    postings.push_back(makePostings(20000, 3));
+    postings.push_back(makePostings(5000, 10, 3));
+    postings.push_back(makePostings(300, 200, 11));
+    std::vector<std::string> data(postings.size());
+    std::vector<uint32_t> all, common;
+    for (size_t i = 0; i < postings.size(); ++i) {
+        encodePostings(postings[i], data[i]);
+        std::vector<uint32_t> docs;
+        for (size_t j = 0; j < postings[i].size(); ++j) {
+            docs.push_back(postings[i][j].doc);
+        }
+        std::vector<uint32_t> tmp;
+        if (i == 0) {
+            common = docs;
+        } else {
+            std::set_intersection(common.begin(), common.end(),
+                docs.begin(), docs.end(), std::back_inserter(tmp));
+            common.swap(tmp);
+            tmp.clear();
+        }
+        std::set_union(all.begin(), all.end(), docs.begin(), docs.end(),
+            std::back_inserter(tmp));
+        all.swap(tmp);
+    }
+    VERIFY(common.size() > 0);
+
+    std::vector<PostingIterator> lists(postings.size());
+    std::vector<PostingIterator*> pointers;
+    for (size_t i = 0; i < lists.size(); ++i) {
+        lists[i].init(data[i].data(), data[i].data() + data[i].length());
+        pointers.push_back(&lists[i]);
+    }
+    std::vector<uint32_t> docs;
+    bool positioned = true;
+    intersectPostings(pointers, [&](uint32_t doc) {
+        docs.push_back(doc);
+        for (size_t i = 0; i < lists.size(); ++i) {
+            positioned = positioned && lists[i].doc() == doc;
+        }
+    });
+    VERIFY(docs == common);
+    VERIFY(positioned);
+
+    for (size_t i = 0; i < lists.size(); ++i) {
+        lists[i].init(data[i].data(), data[i].data() + data[i].length());
+    }
+    docs.clear();
+    unitePostings(pointers, [&](uint32_t doc) { docs.push_back(doc); });
+    VERIFY(docs == all);
+
+    // an empty list has no documents in common with the others
+    std::string empty;
+    encodePostings(std::vector<Posting>(), empty);
+    PostingIterator none;
+    VERIFY(none.init(empty.data(), empty.data() + empty.length()));
+    VERIFY(none.doc() == PostingIterator::noMoreDocs);
+    pointers.push_back(&none);
+    docs.clear();
+    intersectPostings(pointers, [&](uint32_t doc) { docs.push_back(doc); });
+    VERIFY(docs.empty());
+}
+
+void
+testDamagedData() {
+    const std::vector<Posting> postings = makePostings(1000, 100);
+    std::string data;
+    encodePostings(postings, data);
+    PostingIterator list;
+    // the skip table does not fit
+    VERIFY(!list.init(data.data(), data.data() + 20));
+    // a block is cut off
+    VERIFY(!list.init(data.data(), data.data() + data.length() / 2));
+    // the bit width of a block is damaged
+    std::string header;
+    uint32_t maxFreq = 0;
+    for (size_t i = 0; i < postings.size(); ++i) {
+        maxFreq = std::max(maxFreq, postings[i].freq);
+    }
+    putVarint(header, postings.size());
+    putVarint(header, maxFreq);
+    std::string damaged(data);
+    damaged[header.length() + 12 * (1000 / postingBlockSize)] = 40;
+    VERIFY(list.init(damaged.data(), damaged.data() + damaged.length()));
+    VERIFY(list.doc() == PostingIterator::noMoreDocs);
+    // the data may end anywhere without reading past the end
+    for (size_t n = 0; n < data.length(); n += 7) {
+        std::string part(data, 0, n);
+        if (list.init(part.data(), part.data() + part.length())) {
+            uint32_t count = 0;
+            while (list.doc() != PostingIterator::noMoreDocs) {
+                list.next();
+                ++count;
+            }
+            VERIFY(count <= postings.size());
+        }
+    }
+}
+
+}
+
+int
+PostingListTest(int, char*[]) {
+    founderrors = 0;
+    srand(42);
+    testRoundTrip();
+    testAdvance();
+    testBlockBounds();
+    testSetOperations();
+    testDamagedData();
+    return founderrors;
+}
@@ -0,0 +1,334 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "testutils.h"
+#include "../lib/index/queryexecutor.h"
+#include <strigi/query.h>
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <iostream>
+
+using namespace Strigi;
+
+namespace {
+
+typedef std::map<uint32_t, float> Scores;
+
+/**
+ * A set of documents with terms in memory. The scores are small whole
+ * numbers, so sums do not depend on the order of the additions and the
+ * results can be compared exactly.
+ **/
+class MemorySource : public DocIteratorSource {
+public:
+    uint32_t docCount;
+    std::map<std::string, Scores> terms;
+    std::vector<bool> deleted;
+
+    MemorySource(uint32_t n) :docCount(n), deleted(n) {}
+    void addTerm(const std::string& term, uint32_t gap) {
+        Scores& scores = terms[term];
+        for (uint32_t d = rand() % gap; d < docCount; d += 1 + rand() % gap) {
+            scores[d] = (float)(1 + rand() % 8);
+        }
+    }
+    DocIterator* leaf(const Query& q) {
+        std::map<std::string, Scores>::const_iterator i
+            = terms.find(q.term().string());
+        if (i == terms.end() || i->second.empty()) {
+            return 0;
+        }
+        std::vector<std::pair<uint32_t, float> > hits;
+        Scores::const_iterator j;
+        for (j = i->second.begin(); j != i->second.end(); ++j) {
+            hits.push_back(std::make_pair(j->first, q.boost() * j->second));
+        }
+        return new ListDocIterator(hits, 16);
+    }
+    DocIterator* allDocuments() {
+        std::vector<std::pair<uint32_t, float> > hits;
+        for (uint32_t d = 0; d < docCount; ++d) {
+            hits.push_back(std::make_pair(d, 0.0f));
+        }
+        return new ListDocIterator(hits, 16);
+    }
+    bool isLive(uint32_t doc) const { return !deleted[doc]; }
+
+    /**
+     * Evaluate @p q without iterators.
+     **/
+    Scores evaluate(const Query& q) const;
+    Scores evaluatePositive(const Query& q) const;
+    Scores complement(const Scores& s) const {
+        Scores all;
+        for (uint32_t d = 0; d < docCount; ++d) {
+            if (s.find(d) == s.end()) {
+                all[d] = 0;
+            }
+        }
+        return all;
+    }
+};
+Scores
+MemorySource::evaluate(const Query& q) const {
+    const Scores s(evaluatePositive(q));
+    return (q.negate()) ?complement(s) :s;
+}
+Scores
+MemorySource::evaluatePositive(const Query& q) const {
+    Scores result;
+    const std::vector<Query>& subs = q.subQueries();
+    if (q.type() == Query::And) {
+        bool first = true;
+        for (size_t i = 0; i < subs.size(); ++i) {
+            if (subs[i].negate()) {
+                continue;
+            }
+            const Scores s(evaluatePositive(subs[i]));
+            Scores both;
+            for (Scores::const_iterator j = s.begin(); j != s.end(); ++j) {
+                Scores::const_iterator k = result.find(j->first);
+                if (first) {
+                    both[j->first] = j->second;
+                } else if (k != result.end()) {
+                    both[j->first] = k->second + j->second;
+                }
+            }
+            result.swap(both);
+            first = false;
+        }
+        if (first && subs.size()) {
+            result = complement(Scores());
+        }
+        for (size_t i = 0; i < subs.size(); ++i) {
+            if (subs[i].negate()) {
+                const Scores s(evaluatePositive(subs[i]));
+                for (Scores::const_iterator j = s.begin(); j != s.end(); ++j) {
+                    result.erase(j->first);
+                }
+            }
+        }
+    } else if (q.type() == Query::Or) {
+        for (size_t i = 0; i < subs.size(); ++i) {
+            const Scores s(evaluate(subs[i]));
+            for (Scores::const_iterator j = s.begin(); j != s.end(); ++j) {
+                result[j->first] += j->second;
+            }
+        }
+    } else {
+        std::map<std::string, Scores>::const_iterator i
+            = terms.find(q.term().string());
+        if (i != terms.end()) {
+            result = i->second;
+            for (Scores::iterator j = result.begin(); j != result.end(); ++j) {
+                j->second *= q.boost();
+            }
+        }
+        return result;
+    }
+    for (Scores::iterator j = result.begin(); j != result.end(); ++j) {
+        j->second *= q.boost();
+    }
+    return result;
+}
+
+Query
+term(const std::string& t) {
+    Query q;
+    q.setType(Query::Keyword);
+    q.term().setValue(t);
+    return q;
+}
+Query
+randomQuery(int depth) {
+    if (depth == 0 || rand() % 3 == 0) {
+        char name[8];
+        snprintf(name, sizeof(name), "t%d", rand() % 7);
+        Query q(term(name));
+        if (rand() % 5 == 0) {
+            q.setBoost(2);
+        }
+        return q;
+    }
+    Query q;
+    q.setType((rand() % 2) ?Query::And :Query::Or);
+    const int n = 1 + rand() % 4;
+    for (int i = 0; i < n; ++i) {
+        q.subQueries().push_back(randomQuery(depth - 1));
+        if (rand() % 5 == 0) {
+            q.subQueries().back().setNegate(true);
+        }
+    }
+    if (rand() % 6 == 0) {
+        q.setBoost(0.5);
+    }
+    return q;
+}
+
+/**
+ * @return all hits of @p q in @p sources, found without iterators
+ **/
+std::vector<TopDocs::Hit>
+expectedHits(const std::vector<MemorySource*>& sources, const Query& q) {
+    std::vector<TopDocs::Hit> expected;
+    for (size_t s = 0; s < sources.size(); ++s) {
+        const Scores scores(sources[s]->evaluate(q));
+        for (Scores::const_iterator i = scores.begin(); i != scores.end();
+                ++i) {
+            if (sources[s]->isLive(i->first)) {
+                TopDocs::Hit h;
+                h.score = i->second;
+                h.segment = (uint32_t)s;
+                h.doc = i->first;
+                expected.push_back(h);
+            }
+        }
+    }
+    std::sort(expected.begin(), expected.end());
+    return expected;
+}
+/**
+ * Compare the best @p k hits of @p q in @p sources with @p expected.
+ **/
+bool
+checkTopDocs(std::vector<MemorySource*>& sources, const Query& q, size_t k,
+        std::vector<TopDocs::Hit> expected) {
+    if (k && expected.size() > k) {
+        expected.resize(k);
+    }
+    TopDocs top(k);
+    for (size_t s = 0; s < sources.size(); ++s) {
+        DocIterator* it = compileQuery(q, *sources[s]);
+        if (it) {
+            top.collect(*it, (uint32_t)s, *sources[s]);
+            delete it;
+        }
+    }
+    std::vector<TopDocs::Hit> hits;
+    top.hits(hits);
+    if (hits.size() != expected.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < hits.size(); ++i) {
+        if (hits[i].score != expected[i].score
+                || hits[i].segment != expected[i].segment
+                || hits[i].doc != expected[i].doc) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+testListIterator() {
+    std::vector<std::pair<uint32_t, float> > hits;
+    for (uint32_t d = 0; d < 100; ++d) {
+        hits.push_back(std::make_pair(3 * d, (float)(d % 10)));
+    }
+    ListDocIterator it(hits, 8);
+    VERIFY(it.doc() == 0 && it.cost() == 100 && it.maxScore() == 9);
+    VERIFY(it.advance(7) == 9 && it.score() == 3);
+    VERIFY(it.next() == 12);
+    // the block of 8 documents that contains 30 ends with 45
+    VERIFY(it.shallowAdvance(30) == 45 && it.doc() == 12);
+    VERIFY(it.blockMaxScore(45) == 9);
+    it.setMinScore(8);
+    VERIFY(it.next() == 27 && it.score() == 9);
+    VERIFY(it.advance(290) == 297);
+    VERIFY(it.next() == DocIterator::noMoreDocs);
+}
+
+void
+testCompile() {
+    MemorySource source(100);
+    source.terms["a"][3] = 1;
+    source.terms["a"][5] = 2;
+    source.terms["b"][5] = 4;
+    source.terms["b"][7] = 8;
+    Query q;
+    q.setType(Query::And);
+    q.subQueries().push_back(term("a"));
+    q.subQueries().push_back(term("b"));
+    DocIterator* it = compileQuery(q, source);
+    VERIFY(it && it->doc() == 5 && it->score() == 6);
+    VERIFY(it && it->next() == DocIterator::noMoreDocs);
+    delete it;
+
+    // a query that cannot match has no iterator
+    q.subQueries().push_back(term("c"));
+    VERIFY(compileQuery(q, source) == 0);
+
+    q.setType(Query::Or);
+    it = compileQuery(q, source);
+    VERIFY(it && countMatches(*it, source) == 3);
+    delete it;
+
+    q.setNegate(true);
+    source.deleted[50] = true;
+    it = compileQuery(q, source);
+    VERIFY(it && countMatches(*it, source) == 96);
+    delete it;
+}
+
+void
+testRandomQueries() {
+    std::vector<MemorySource*> sources;
+    for (int s = 0; s < 3; ++s) {
+        MemorySource* source = new MemorySource(2000 + 500 * s);
+        const uint32_t gaps[] = { 2, 3, 10, 40, 200, 1000, 3 };
+        for (int t = 0; t < 7; ++t) {
+            char name[8];
+            snprintf(name, sizeof(name), "t%d", t);
+            source->addTerm(name, gaps[t]);
+        }
+        for (int d = 0; d < 50; ++d) {
+            source->deleted[rand() % source->docCount] = true;
+        }
+        sources.push_back(source);
+    }
+    const size_t ks[] = { 0, 1, 10, 100 };
+    bool ok = true;
+    for (int i = 0; ok && i < 150; ++i) {
+        const Query q(randomQuery(3));
+        const std::vector<TopDocs::Hit> expected(expectedHits(sources, q));
+        for (size_t k = 0; ok && k < sizeof(ks) / sizeof(ks[0]); ++k) {
+            ok = checkTopDocs(sources, q, ks[k], expected);
+            VERIFY(ok);
+            if (!ok) {
+                std::cerr << "k = " << ks[k] << ", query:\n" << q << std::endl;
+            }
+        }
+    }
+    for (size_t s = 0; s < sources.size(); ++s) {
+        delete sources[s];
+    }
+}
+
+}
+
+int
+QueryExecutorTest(int, char*[]) {
+    founderrors = 0;
+    srand(7);
+    testListIterator();
+    testCompile();
+    testRandomQueries();
+    return founderrors;
+}
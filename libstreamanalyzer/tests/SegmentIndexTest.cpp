@@ -0,0 +1,357 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "testutils.h"
+#include <strigi/analyzerconfiguration.h>
+#include <strigi/diranalyzer.h>
+#include <strigi/fieldtypes.h>
+#include <strigi/indexreader.h>
+#include <strigi/indexwriter.h>
+#include <strigi/query.h>
+#include <strigi/segmentindexmanager.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Strigi;
+
+namespace {
+
+Query
+wordQuery(const std::string& word) {
+    Query q;
+    q.setType(Query::FullText);
+    q.term().setValue(word);
+    return q;
+}
+int32_t
+count(IndexReader* reader, const std::string& word) {
+    return reader->countHits(wordQuery(word));
+}
+void
+update(SegmentIndexManager& manager, const std::string& dir) {
+    AnalyzerConfiguration config;
+    DirAnalyzer analyzer(manager, config);
+    VERIFY(analyzer.updateDir(dir, 1) == 0);
+}
+
+void
+testIndex(const std::string& index, const std::string& data) {
+    SegmentIndexManager manager(index);
+    IndexReader* reader = manager.indexReader();
+    VERIFY(reader->countDocuments() == 0);
+    update(manager, data);
+
+    // three files and a subdirectory
+    VERIFY(reader->countDocuments() == 4);
+    VERIFY(count(reader, "world") == 2);
+    VERIFY(count(reader, "HELLO") == 2);
+    VERIFY(count(reader, "strigi") == 1);
+    VERIFY(count(reader, "absent") == 0);
+    // the words of a phrase have to be next to each other
+    VERIFY(count(reader, "hello world") == 1);
+    VERIFY(count(reader, "world hello") == 0);
+
+    Query q;
+    q.setType(Query::Proximity);
+    q.term().setValue("world hello");
+    VERIFY(reader->countHits(q) == 0);
+    q.term().setOrdered(false);
+    VERIFY(reader->countHits(q) == 1);
+
+    // fuzzy terms match terms that are a few edits away
+    q = wordQuery("wrld");
+    VERIFY(reader->countHits(q) == 0);
+    q.term().setFuzzy(0.5);
+    VERIFY(reader->countHits(q) == 2);
+    q = wordQuery("strigy hallo");
+    q.term().setFuzzy(1);
+    VERIFY(reader->countHits(q) == 1);
+
+    q = Query();
+    q.setType(Query::And);
+    q.subQueries().push_back(wordQuery("world"));
+    q.subQueries().push_back(wordQuery("hello"));
+    q.subQueries().back().setNegate(true);
+    std::vector<IndexedDocument> docs = reader->query(q, 0, 10);
+    VERIFY(docs.size() == 1);
+    if (docs.size() == 1) {
+        VERIFY(docs[0].uri == data + "/sub/c.txt");
+        VERIFY(docs[0].fragment == "another world");
+    }
+
+    q = Query();
+    q.setType(Query::Equals);
+    q.fields().push_back(FieldRegister::filenameFieldName);
+    q.term().setValue("a.txt");
+    std::vector<std::string> fields(1, FieldRegister::pathFieldName);
+    fields.push_back(FieldRegister::sizeFieldName);
+    std::vector<Variant::Type> types(1, Variant::s_val);
+    types.push_back(Variant::i_val);
+    std::vector<std::vector<Variant> > hits;
+    reader->getHits(q, fields, types, hits, 0, 10);
+    VERIFY(hits.size() == 1);
+    if (hits.size() == 1) {
+        VERIFY(hits[0][0].s() == data + "/a.txt");
+        VERIFY(hits[0][1].i() == 11);
+    }
+
+    // regular expressions and substrings are looked up by their trigrams
+    q = Query();
+    q.setType(Query::RegExp);
+    q.fields().push_back(FieldRegister::pathFieldName);
+    q.term().setValue("/[ab]\\.txt$");
+    VERIFY(reader->countHits(q) == 2);
+    q.setType(Query::Contains);
+    q.term().setValue("sub/c");
+    VERIFY(reader->countHits(q) == 1);
+    q.fields().clear();
+    q.term().setValue("ORL");
+    VERIFY(reader->countHits(q) == 2);
+
+    struct stat s;
+    VERIFY(stat((data + "/a.txt").c_str(), &s) == 0);
+    VERIFY(reader->mTime(data + "/a.txt") == s.st_mtime);
+    VERIFY(reader->mTime(data + "/none.txt") == -1);
+
+    std::map<std::string, time_t> children;
+    reader->getChildren(data, children);
+    VERIFY(children.size() == 3);
+    VERIFY(children.find(data + "/sub") != children.end());
+
+    std::vector<std::string> words = reader->keywords("wor",
+        std::vector<std::string>(), 10, 0);
+    VERIFY(words.size() == 1 && words[0] == "world");
+    VERIFY(reader->countKeywords("", std::vector<std::string>()) == 4);
+    words = reader->keywords("", std::vector<std::string>(), 2, 1);
+    VERIFY(words.size() == 2 && words[0] == "hello" && words[1] == "strigi");
+
+    // an entry is deleted together with the entries below it
+    std::vector<std::string> entries(1, data + "/sub");
+    manager.indexWriter()->deleteEntries(entries);
+    VERIFY(count(reader, "another") == 1);
+    manager.indexWriter()->commit();
+    VERIFY(count(reader, "another") == 0);
+    VERIFY(reader->countDocuments() == 2);
+}
+
+void
+testUpdate(const std::string& index, const std::string& data) {
+    SegmentIndexManager manager(index);
+    IndexReader* reader = manager.indexReader();
+    // the index on disk is read again
+    VERIFY(reader->countDocuments() == 2);
+    update(manager, data);
+    VERIFY(reader->countDocuments() == 4);
+
+    VERIFY(unlink((data + "/b.txt").c_str()) == 0);
+    VERIFY(writeTestFile(data + "/d.txt", "new words"));
+    update(manager, data);
+    VERIFY(reader->countDocuments() == 4);
+    VERIFY(count(reader, "strigi") == 0);
+    VERIFY(count(reader, "new") == 1);
+    VERIFY(count(reader, "hello") == 1);
+
+    // each update writes a segment; the segments are merged
+    for (int i = 0; i < 25; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "/e%d.txt", i);
+        VERIFY(writeTestFile(data + name, "many files"));
+        update(manager, data);
+    }
+    VERIFY(count(reader, "many") == 25);
+    VERIFY(reader->countDocuments() == 29);
+    // a term in several segments is listed once
+    const std::vector<std::string> content;
+    VERIFY(reader->countKeywords("ma", content) == 1);
+    std::vector<std::string> words = reader->keywords("f", content, 10, 0);
+    VERIFY(words.size() == 1 && words[0] == "files");
+    // the counts of the segments are added up
+    std::vector<std::pair<std::string, uint32_t> > h
+        = reader->histogram("many", FieldRegister::sizeFieldName, "");
+    VERIFY(h.size() == 1 && h[0].first == "10" && h[0].second == 25);
+    manager.indexWriter()->optimize();
+    h = reader->histogram("world", FieldRegister::sizeFieldName, "");
+    VERIFY(h.size() == 2 && h[0].first == "11" && h[1].first == "13");
+    VERIFY(reader->countKeywords("ma", content) == 1);
+    words = reader->keywords("", content, 10, 0);
+    VERIFY(words.size() >= 2 && words[0] < words[1]);
+    VERIFY(count(reader, "many") == 25);
+    VERIFY(count(reader, "world") == 2);
+    VERIFY(count(reader, "many files") == 25);
+    VERIFY(count(reader, "files many") == 0);
+    VERIFY(reader->countDocuments() == 29);
+
+    manager.indexWriter()->deleteAllEntries();
+    VERIFY(reader->countDocuments() == 0);
+}
+
+/**
+ * Counts the documents that can be found after each commit.
+ **/
+class CommitCounter : public CommitListener {
+public:
+    IndexReader* reader;
+    std::vector<int32_t> counts;
+    explicit CommitCounter(IndexReader* r) :reader(r) {}
+    void committed() { counts.push_back(reader->countDocuments()); }
+};
+
+void
+testCommitPolicy(const std::string& index, const std::string& data) {
+    SegmentIndexManager manager(index);
+    CommitCounter counter(manager.indexReader());
+    AnalyzerConfiguration config;
+    DirAnalyzer analyzer(manager, config);
+    analyzer.setCommitListener(&counter);
+    // the documents can be found while the directory is analyzed
+    analyzer.setCommitPolicy(2);
+    VERIFY(analyzer.analyzeDir(data, 1) == 0);
+    VERIFY(counter.counts.size() >= 3);
+    if (counter.counts.size() >= 3) {
+        VERIFY(counter.counts[0] == 2);
+        VERIFY(counter.counts[1] == 4);
+        VERIFY(counter.counts.back() == manager.indexReader()
+            ->countDocuments());
+    }
+    // a large number of bytes is not reached before the end
+    counter.counts.clear();
+    analyzer.setCommitPolicy(0, 1 << 30);
+    VERIFY(analyzer.analyzeDir(data, 2) == 0);
+    VERIFY(counter.counts.size() == 1);
+}
+
+
+bool
+exists(const std::string& path) {
+    struct stat s;
+    return stat(path.c_str(), &s) == 0;
+}
+
+/**
+ * Only one writer may change the index. The files that another writer has
+ * not published yet are not removed by readers or by a second writer, and
+ * the changes of the second writer wait until it gets the lock.
+ **/
+void
+testLock(const std::string& index, const std::string& data) {
+    SegmentIndexManager* first = new SegmentIndexManager(index);
+    update(*first, data);
+    const int32_t n = first->indexReader()->countDocuments();
+    VERIFY(n > 2);
+    // a file of a commit that is not finished yet
+    const std::string unpublished(index + "/_99.tis");
+    VERIFY(writeTestFile(unpublished, "segment"));
+    {
+        SegmentIndexManager query(index);
+        VERIFY(query.indexReader()->countDocuments() == n);
+    }
+    VERIFY(exists(unpublished));
+
+    SegmentIndexManager second(index);
+    IndexReader* reader = second.indexReader();
+    IndexWriter* writer = second.indexWriter();
+    VERIFY(exists(unpublished));
+    std::vector<std::string> entries(1, data + "/sub");
+    writer->deleteEntries(entries);
+    writer->commit();
+    VERIFY(count(reader, "another") == 1);
+    VERIFY(exists(unpublished));
+
+    // the lock is free now, so the deletion that was kept is committed
+    delete first;
+    writer->commit();
+    VERIFY(count(reader, "another") == 0);
+    // the directory and the file in it
+    VERIFY(reader->countDocuments() == n - 2);
+    VERIFY(!exists(unpublished));
+}
+
+/**
+ * Writes a new version of a file each time the previous one can be found
+ * and stops when the last one can be found.
+ **/
+class Rewriter : public AnalysisCaller {
+public:
+    IndexReader* reader;
+    const std::string path;
+    int version;
+    int calls;
+    Rewriter(IndexReader* r, const std::string& p) :reader(r), path(p),
+        version(0), calls(0) {}
+    bool continueAnalysis() {
+        const char* words[] = { "first", "second", "third" };
+        if (version < 3 && count(reader, words[version]) == 1) {
+            if (++version < 3) {
+                VERIFY(writeTestFile(path,
+                    std::string("hello ") + words[version]));
+            }
+        }
+        // a file is rewritten only when its last version is in the index,
+        // so the change is waiting for the watcher; the limit on the calls
+        // is a safety net for when the change is never handled
+        return version < 3 && ++calls <= 20;
+    }
+};
+
+void
+testWatch(const std::string& index, const std::string& data) {
+    VERIFY(mkdir(data.c_str(), 0700) == 0);
+    VERIFY(writeTestFile(data + "/a.txt", "hello first"));
+    SegmentIndexManager manager(index);
+    IndexReader* reader = manager.indexReader();
+    Rewriter rewriter(reader, data + "/a.txt");
+    AnalyzerConfiguration config;
+    DirAnalyzer analyzer(manager, config);
+    const std::vector<std::string> dirs(1, data);
+    VERIFY(analyzer.watchDirs(dirs, 1, &rewriter) == 0);
+    // the versions usually have the same mtime; each replaces the last
+    VERIFY(rewriter.version == 3);
+    VERIFY(count(reader, "hello") == 1);
+    VERIFY(count(reader, "second") == 0);
+    VERIFY(reader->countDocuments() == 1);
+}
+
+}
+
+int
+SegmentIndexTest(int argc, char* argv[]) {
+    if (argc < 2) return 1;
+    founderrors = 0;
+    const std::string dir(makeTestDir(argv[1]));
+    VERIFY(dir.length());
+    if (dir.empty()) {
+        return founderrors;
+    }
+    const std::string index(dir + "/index");
+    const std::string data(dir + "/data");
+    VERIFY(mkdir(data.c_str(), 0700) == 0);
+    VERIFY(mkdir((data + "/sub").c_str(), 0700) == 0);
+    VERIFY(writeTestFile(data + "/a.txt", "hello world"));
+    VERIFY(writeTestFile(data + "/b.txt", "Hello strigi"));
+    VERIFY(writeTestFile(data + "/sub/c.txt", "another world"));
+
+    testIndex(index, data);
+    testUpdate(index, data);
+    testCommitPolicy(dir + "/index2", data);
+    testWatch(dir + "/index3", dir + "/watch");
+    testLock(dir + "/index4", data);
+
+    removeTestDir(dir);
+    return founderrors;
+}
@@ -0,0 +1,213 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "testutils.h"
+#include "../lib/index/trigram.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <regex>
+#include <set>
+
+using namespace Strigi;
+
+namespace {
+
+/**
+ * A set of sorted terms with the index of their trigrams.
+ **/
+class Terms {
+public:
+    std::vector<std::string> terms;
+    std::string data;
+    uint32_t count;
+    uint64_t tables;
+    unsigned offsetBits;
+    TrigramTable table;
+
+    explicit Terms(const std::set<std::string>& t)
+            :terms(t.begin(), t.end()) {
+        TrigramWriter writer;
+        for (uint32_t i = 0; i < terms.size(); ++i) {
+            writer.add(i, terms[i]);
+        }
+        writer.write(data, count, tables, offsetBits);
+        VERIFY(writer.empty());
+        VERIFY(table.init(data.data(), data.data() + data.length(), count,
+            tables, offsetBits));
+    }
+    /**
+     * @return the number of candidates for @p q or the number of terms
+     **/
+    size_t check(const TrigramQuery& q,
+            const std::function<bool (const std::string&)>& matches) {
+        std::vector<uint32_t> candidates;
+        const bool narrowed = table.candidates(q, candidates);
+        VERIFY(std::is_sorted(candidates.begin(), candidates.end()));
+        for (uint32_t i = 0; i < terms.size(); ++i) {
+            if (narrowed && matches(terms[i])) {
+                VERIFY(std::binary_search(candidates.begin(),
+                    candidates.end(), i));
+            }
+        }
+        return (narrowed) ?candidates.size() :terms.size();
+    }
+    size_t checkRegExp(const std::string& pattern) {
+        const std::regex re(pattern, std::regex::ECMAScript);
+        const std::regex icase(pattern,
+            std::regex::ECMAScript | std::regex::icase);
+        return check(TrigramQuery::regExp(pattern),
+            [&](const std::string& term) {
+                return std::regex_search(term, re)
+                    || std::regex_search(term, icase);
+            });
+    }
+};
+
+std::string
+randomTerm(const char* alphabet, int maxLength) {
+    std::string term;
+    const int length = rand() % maxLength;
+    const size_t n = strlen(alphabet);
+    for (int i = 0; i < length; ++i) {
+        term += alphabet[rand() % n];
+    }
+    return term;
+}
+/**
+ * @return a random regular expression over a few letters
+ **/
+std::string
+randomRegExp(int depth) {
+    const char* atoms[] = { "a", "b", "c", "A", "B", ".", "[ab]", "[^a]",
+        "\\w", "^", "$", "\\b", "[a-c]", "x" };
+    const char* quantifiers[] = { "", "", "", "*", "+", "?", "{2}",
+        "{1,2}", "{0,1}", "*?" };
+    std::string re;
+    const int n = 1 + rand() % 5;
+    for (int i = 0; i < n; ++i) {
+        if (depth && rand() % 5 == 0) {
+            re += "(" + randomRegExp(depth - 1);
+            if (rand() % 2) {
+                re += "|" + randomRegExp(depth - 1);
+            }
+            re += ")";
+        } else {
+            re += atoms[rand() % (sizeof(atoms) / sizeof(atoms[0]))];
+        }
+        if (re[re.length() - 1] != '^' && re[re.length() - 1] != '$'
+                && (re.length() < 2
+                    || re.compare(re.length() - 2, 2, "\\b"))) {
+            re += quantifiers[rand()
+                % (sizeof(quantifiers) / sizeof(quantifiers[0]))];
+        }
+    }
+    return re;
+}
+
+void
+testSubstrings() {
+    std::set<std::string> set;
+    for (int i = 0; i < 2000; ++i) {
+        set.insert(randomTerm("abcABd", 10));
+    }
+    Terms terms(set);
+    for (int i = 0; i < 300; ++i) {
+        const std::string s(randomTerm("abcAd", 6));
+        std::string lower(s);
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        size_t n = 0;
+        std::vector<std::string>::const_iterator j;
+        for (j = terms.terms.begin(); j != terms.terms.end(); ++j) {
+            std::string t(*j);
+            std::transform(t.begin(), t.end(), t.begin(), ::tolower);
+            n += t.find(lower) != std::string::npos;
+        }
+        const size_t c = terms.check(TrigramQuery::substring(s),
+            [&](const std::string& term) {
+                std::string t(term);
+                std::transform(t.begin(), t.end(), t.begin(), ::tolower);
+                return t.find(lower) != std::string::npos;
+            });
+        // a substring of three letters has exactly one trigram
+        VERIFY(s.length() != 3 || c == n);
+    }
+}
+
+void
+testRegExps() {
+    std::set<std::string> set;
+    for (int i = 0; i < 1000; ++i) {
+        set.insert(randomTerm("abcABx", 9));
+    }
+    Terms terms(set);
+    for (int i = 0; i < 1000; ++i) {
+        terms.checkRegExp(randomRegExp(2));
+    }
+    // expressions with literal parts use the trigrams
+    const char* selective[] = { "abc", "abc.*cab", "(abc|bca)", "[ab]bc",
+        "x(ab)+c", "ab?cx", "^abc$", "a\\x62c", "(?:ab)cab",
+        "abc(?=x)", "abc\\d*" };
+    for (size_t i = 0; i < sizeof(selective) / sizeof(selective[0]); ++i) {
+        VERIFY(terms.checkRegExp(selective[i]) < terms.terms.size() / 4);
+    }
+    // expressions without literal parts or that cannot be read do not
+    const char* open[] = { "a.c", "ab|c", "(abc)*", "[a-z]+", "a{",
+        "(ab", "a\\", "\\u0061bc" };
+    for (size_t i = 0; i < sizeof(open) / sizeof(open[0]); ++i) {
+        VERIFY(TrigramQuery::regExp(open[i]).op == TrigramQuery::All);
+    }
+}
+
+void
+testDamagedData() {
+    std::set<std::string> set;
+    for (int i = 0; i < 300; ++i) {
+        set.insert(randomTerm("abcdef", 12));
+    }
+    Terms terms(set);
+    const std::string good(terms.data);
+    const TrigramQuery q(TrigramQuery::regExp("(abc|def).*(ace|bdf)"));
+    std::vector<uint32_t> candidates;
+    for (int i = 0; i < 300; ++i) {
+        std::string data(good);
+        for (int j = 0; j < 3; ++j) {
+            data[rand() % data.length()] = (char)rand();
+        }
+        // reading damaged data may give wrong ordinals, but it must stop
+        TrigramTable table;
+        if (table.init(data.data(), data.data() + data.length(),
+                terms.count, terms.tables, terms.offsetBits)) {
+            table.candidates(q, candidates);
+        }
+    }
+}
+
+}
+
+int
+TrigramTest(int, char*[]) {
+    founderrors = 0;
+    srand(7);
+    testSubstrings();
+    testRegExps();
+    testDamagedData();
+    return founderrors;
+}
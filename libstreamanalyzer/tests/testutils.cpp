@@ -0,0 +1,61 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "testutils.h"
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+int founderrors = 0;
+
+std::string
+makeTestDir(const std::string& parent) {
+    std::string templ(parent + "/testdirXXXXXX");
+    std::vector<char> buf(templ.begin(), templ.end());
+    buf.push_back('\0');
+    return (mkdtemp(&buf[0])) ?std::string(&buf[0]) :std::string();
+}
+void
+removeTestDir(const std::string& path) {
+    DIR* dir = opendir(path.c_str());
+    if (dir) {
+        while (struct dirent* e = readdir(dir)) {
+            if (strcmp(e->d_name, ".") && strcmp(e->d_name, "..")) {
+                removeTestDir(path + '/' + e->d_name);
+            }
+        }
+        closedir(dir);
+        rmdir(path.c_str());
+    } else {
+        unlink(path.c_str());
+    }
+}
+bool
+writeTestFile(const std::string& path, const std::string& content) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f == 0) {
+        return false;
+    }
+    bool ok = fwrite(content.c_str(), 1, content.length(), f)
+        == content.length();
+    return fclose(f) == 0 && ok;
+}
@@ -0,0 +1,48 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_TESTUTILS_H
+#define STRIGI_TESTUTILS_H
+
+#include <string>
+#include <stdio.h>
+
+extern int founderrors;
+#define VERIFY(TESTBOOL) if (!(TESTBOOL)) {\
+	fprintf(stderr, "test '%s' failed at\n\t%s:%i\n", \
+		#TESTBOOL, __FILE__, __LINE__); \
+	founderrors++; \
+}
+
+/**
+ * Create a new empty directory in @p parent.
+ * @return the path of the directory or an empty string on failure
+ **/
+std::string makeTestDir(const std::string& parent);
+/**
+ * Remove @p path and everything below it.
+ **/
+void removeTestDir(const std::string& path);
+/**
+ * Write @p content to the file @p path.
+ **/
+bool writeTestFile(const std::string& path, const std::string& content);
+
+#endif
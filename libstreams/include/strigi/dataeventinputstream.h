@@ -23,6 +23,7 @@
 
 #include <strigi/strigiconfig.h>
 #include <strigi/streambase.h>
+#include <vector>
 
 namespace Strigi {
 
@@ -82,24 +83,34 @@ public:
  * one event only. Rewinding this stream and rereading parts of it will not send
  * a new event for the same data.
  *
- * Multiple DataEventInputStreams can be linked in series to send events to
- * several handlers:
+ * To send events to several handlers, pass all of them to one
+ * DataEventInputStream. Each buffer is then read once from the underlying
+ * stream and handed to every handler in turn:
  * @code
  * DataEventHandler handler1, handler2, handler3;
  * InputStream inputStream;
- * DataEventInputStream handlerStream1(inputStream, handler1);
- * DataEventInputStream handlerStream2(handlerStream1, handler1);
- * DataEventInputStream handlerStream3(handlerStream2, handler1);
- * int nRead = handlerStream3.read(start, min, max);
+ * std::vector<DataEventHandler*> handlers;
+ * handlers.push_back(&handler1);
+ * handlers.push_back(&handler2);
+ * handlers.push_back(&handler3);
+ * DataEventInputStream handlerStream(inputStream, handlers);
+ * int nRead = handlerStream.read(start, min, max);
  * @endcode
+ * A handler that returns @c false from DataEventHandler::handleData() does
+ * not receive any more data. When no handler wants more data, skipping is
+ * passed on to the underlying stream.
  */
 class STRIGI_EXPORT DataEventInputStream : public InputStream {
 private:
     int64_t totalread;
+    int64_t sourceread;
     InputStream* input;
-    DataEventHandler& handler;
+    std::vector<DataEventHandler*> handlers;
+    std::vector<DataEventHandler*> active;
     bool finished;
 
+    void init();
+
     void finish();
 public:
     /**
@@ -115,9 +126,31 @@ public:
      */
     explicit DataEventInputStream(InputStream *input,
         DataEventHandler& handler);
+    /**
+     * @brief Creates a DataEventInputStream that sends the data events
+     * to several handlers.
+     *
+     * The handlers receive the events in the order in which they occur in
+     * @p handlers.
+     *
+     * @param input the InputStream to use as the data source
+     * @param handlers the DataEventHandlers that should be sent the
+     * data events
+     */
+    DataEventInputStream(InputStream *input,
+        const std::vector<DataEventHandler*>& handlers);
+    /**
+     * @brief The number of bytes that were obtained from the underlying
+     * stream.
+     *
+     * Data that is read again after a call to reset() is counted again,
+     * data that is skipped in the underlying stream is not counted.
+     */
+    int64_t sourceBytesRead() const { return sourceread; }
     int32_t read(const char*& start, int32_t min, int32_t max);
     int64_t skip(int64_t ntoskip);
     int64_t reset(int64_t pos);
+    int32_t readAt(int64_t offset, char* data, int32_t n);
 };
 
 } // end namespace Strigi
@@ -77,6 +77,23 @@ public:
     static InputStream* open(const char* filepath,
         StreamTypeHint hint = Automatic,
         int32_t buffersize = defaultBufferSize);
+    /**
+     * @brief Create an InputStream to access a file of which the size is
+     *        already known
+     *
+     * Passing the size, e.g. from a call to stat() done while listing a
+     * directory, saves the system calls that are needed to determine it.
+     *
+     * @param filepath the name of the file to open
+     * @param size the size of the file or -1 if it is not known
+     * @param hint preferred type of stream
+     * @param buffersize the size of the buffer to use, if applicable
+     * @return opened input stream to the file, caller has responsibility to
+     *         delete it
+     */
+    static InputStream* open(const char* filepath, int64_t size,
+        StreamTypeHint hint = Automatic,
+        int32_t buffersize = defaultBufferSize);
 };
 
 } // end namespace Strigi
@@ -97,6 +97,13 @@ public:
      * of the stream is unknown
      **/
     int64_t size() const { return m_size; }
+    /**
+     * @brief Check if the size of the stream is known.
+     *
+     * When the size is known, the end of the stream can be found without
+     * reading the stream, e.g. with StreamBase::readAt.
+     **/
+    bool sizeKnown() const { return m_size != -1; }
 };
 
 /**
@@ -190,6 +197,29 @@ public:
      * @return the new position in the stream
      **/
     virtual int64_t reset(int64_t pos) = 0;
+    /**
+     * @brief Copy @p n items that start at position @p offset to @p data,
+     * without changing the position of the stream.
+     *
+     * This allows reading data at the end of a stream, like the trailer of
+     * a file format, without reading or skipping all the data before it.
+     * Only streams that have direct access to their data, such as files,
+     * support this. The data pointer that was obtained from
+     * StreamBase::read remains valid.
+     *
+     * @param offset the position of the first item, relative to the start
+     *               of the stream
+     * @param data the array that receives the items
+     * @param n the number of items to read
+     * @return the number of items that were read. This is smaller than
+     *         @p n only if the end of the stream was reached. @c -1 is
+     *         returned if @p offset lies at or beyond the end of the
+     *         stream, @c -2 if an error occurred and @c -3 if the stream
+     *         does not support reading at a position
+     **/
+    virtual int32_t readAt(int64_t /*offset*/, T* /*data*/, int32_t /*n*/) {
+        return -3;
+    }
 };
 
 
@@ -69,6 +69,7 @@ public:
     int32_t read(const T*& start, int32_t min, int32_t max);
     int64_t skip(int64_t ntoskip);
     int64_t reset(int64_t pos);
+    int32_t readAt(int64_t offset, T* data, int32_t n);
 };
 
 /** An InputStream to read from in-memory data. */
@@ -141,6 +142,17 @@ StringStream<T>::reset(int64_t newpos) {
     return StreamBase<T>::m_position;
 }
 
+template <class T>
+int32_t
+StringStream<T>::readAt(int64_t offset, T* d, int32_t n) {
+    if (offset < 0) return -2;
+    const int64_t left = StreamBase<T>::m_size - offset;
+    if (left <= 0) return -1;
+    if (n > left) n = (int32_t)left;
+    memcpy(d, data + offset, (size_t)n * sizeof(T));
+    return n;
+}
+
 } // end namespace Strigi
 
 #endif
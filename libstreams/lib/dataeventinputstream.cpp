@@ -25,10 +25,20 @@
 using namespace Strigi;
 
 DataEventInputStream::DataEventInputStream(InputStream *i,
-        DataEventHandler& h) :input(i), handler(h) {
+        DataEventHandler& h) :input(i), handlers(1, &h) {
+    init();
+}
+DataEventInputStream::DataEventInputStream(InputStream *i,
+        const std::vector<DataEventHandler*>& h) :input(i), handlers(h) {
+    init();
+}
+void
+DataEventInputStream::init() {
     assert(input->position() == 0);
+    active = handlers;
     m_size = input->size();
     totalread = 0;
+    sourceread = 0;
     m_status = Ok;
     finished = false;
 }
@@ -43,6 +53,7 @@ DataEventInputStream::read(const char*& start, int32_t min, int32_t max) {
         return -2;
     }
     if (nread > 0) {
+        sourceread += nread;
         // ignore bytes that might have been added since the file size was
         // determined
         if (m_size != -1 && m_position + nread > m_size) {
@@ -52,12 +63,16 @@ DataEventInputStream::read(const char*& start, int32_t min, int32_t max) {
         // value of -1 for totalread means data should not be reported anymore
         if (totalread != -1 && totalread < m_position) {
             int32_t amount = (int32_t)(m_position - totalread);
-            bool wantMore = handler.handleData(start + nread - amount, amount);
-            if (wantMore) {
-                totalread = m_position;
-            } else {
-                totalread = -1;
+            const char* data = start + nread - amount;
+            std::vector<DataEventHandler*>::iterator h = active.begin();
+            while (h != active.end()) {
+                if ((*h)->handleData(data, amount)) {
+                    ++h;
+                } else {
+                    h = active.erase(h);
+                }
             }
+            totalread = (active.empty()) ?-1 :m_position;
         }
     }
     if (nread < min) {
@@ -118,7 +133,22 @@ DataEventInputStream::reset(int64_t np) {
     m_position = newpos;
     return newpos;
 }
+int32_t
+DataEventInputStream::readAt(int64_t offset, char* data, int32_t n) {
+    // the handlers see the data when it is read in order, so reading at a
+    // position does not need to report anything
+    if (offset < 0) return -2;
+    if (m_size != -1) {
+        const int64_t left = m_size - offset;
+        if (left <= 0) return -1;
+        if (n > left) n = (int32_t)left;
+    }
+    return input->readAt(offset, data, n);
+}
 void
 DataEventInputStream::finish() {
-    handler.handleEnd();
+    std::vector<DataEventHandler*>::iterator h;
+    for (h = handlers.begin(); h != handlers.end(); ++h) {
+        (*h)->handleEnd();
+    }
 }
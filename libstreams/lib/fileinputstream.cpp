@@ -127,3 +127,19 @@ FileInputStream::open(const char* filepath, StreamTypeHint hint,
         return new SkippingFileInputStream(filepath);
     }
 }
+InputStream*
+FileInputStream::open(const char* filepath, int64_t size, StreamTypeHint hint,
+        int32_t buffersize) {
+    switch (hint) {
+    case Buffered:
+        return new FileInputStream(filepath, buffersize);
+    case MMap:
+        // the mapping is sized with fstat() on the opened file: a size that
+        // is out of date would map past the end of the file
+        return new MMapFileInputStream(filepath);
+    case Unbuffered:
+    case Automatic:
+    default:
+        return new SkippingFileInputStream(filepath, size);
+    }
+}
@@ -103,3 +103,12 @@ MMapFileInputStream::reset(int64_t pos) {
     }
     return m_position;
 }
+int32_t
+MMapFileInputStream::readAt(int64_t offset, char* data, int32_t n) {
+    if (m_status == Error || offset < 0) return -2;
+    const int64_t left = m_size - offset;
+    if (left <= 0) return -1;
+    if (n > left) n = (int32_t)left;
+    memcpy(data, buffer + offset, n);
+    return n;
+}
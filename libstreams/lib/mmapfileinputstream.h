@@ -37,6 +37,7 @@ private:
     int32_t read(const char*& start, int32_t min, int32_t max);
     int64_t skip(int64_t ntoskip);
     int64_t reset(int64_t pos);
+    int32_t readAt(int64_t offset, char* data, int32_t n);
 public:
     /**
      * @brief Create an InputStream to access a file
@@ -25,10 +25,12 @@
 #include <cerrno>
 #include <cstring>
 #include <cstdlib>
+#include <unistd.h>
 
 using namespace Strigi;
 
-SkippingFileInputStream::SkippingFileInputStream(const char* filepath) {
+SkippingFileInputStream::SkippingFileInputStream(const char* filepath,
+        int64_t size) {
     buffer = 0;
     buffersize = 0;
     if (filepath == 0) {
@@ -38,10 +40,10 @@ SkippingFileInputStream::SkippingFileInputStream(const char* filepath) {
         return;
     }
     FILE* f = fopen(filepath, "rb");
-    open(f, filepath);
+    open(f, filepath, size);
 }
 void
-SkippingFileInputStream::open(FILE* f, const char* path) {
+SkippingFileInputStream::open(FILE* f, const char* path, int64_t size) {
     // try to open the file for reading
     file = f;
     filepath.assign(path);
@@ -55,8 +57,13 @@ SkippingFileInputStream::open(FILE* f, const char* path) {
         m_status = Error;
         return;
     }
+    // all reads go into our own buffer, so the FILE does not need one
+    setvbuf(file, 0, _IONBF, 0);
     // determine file size. if the stream is not seekable, the size will be -1
-    if (fseeko(file, 0, SEEK_END) == -1) {
+    if (size > 0) {
+        // the size is known already, no need to seek around to find it
+        m_size = size;
+    } else if (fseeko(file, 0, SEEK_END) == -1) {
         m_size = -1;
     } else {
         m_size = ftello(file);
@@ -73,6 +80,8 @@ SkippingFileInputStream::open(FILE* f, const char* path) {
             }
         }
     }
+    // with the size from the caller, small files need no fstat()
+    reader.init(file, m_size);
 }
 SkippingFileInputStream::~SkippingFileInputStream() {
     if (file) {
@@ -89,6 +98,10 @@ SkippingFileInputStream::read(const char*& start, int32_t _min, int32_t _max) {
          m_status = Error;
          return -2; // error
     }
+    if (m_size != -1 && m_position >= m_size) {
+        // the file grew after its size was determined
+        m_size = -1;
+    }
     // take a decent buffersize that can hold the request
     int32_t n = std::max(_min, _max);
     if (_max <= 0) {
@@ -104,17 +117,19 @@ SkippingFileInputStream::read(const char*& start, int32_t _min, int32_t _max) {
         buffer = (char*)realloc(buffer, n);
         buffersize = n;
     }
-    int32_t nr = (int32_t)fread(buffer, 1, n, file);
-    m_position = ftell(file);
+    int32_t nr = (int32_t)reader.read(file, buffer, n);
+    m_position += nr;
     if (nr != n) {
         if (ferror(file)) {
             m_status = Error;
         } else {
             m_status = Eof;
-            if (m_size == -1) {
-                m_size = m_position;
-            }
+            // the size may have been unknown or out of date
+            m_size = m_position;
         }
+    } else if (m_size != -1 && m_position > m_size) {
+        // the size was out of date, the end of the file is not known yet
+        m_size = -1;
     }
     start = buffer;
     return nr;
@@ -132,11 +147,35 @@ SkippingFileInputStream::reset(int64_t pos) {
          return -2; // error
     }
     if (m_size >= 0 && pos > m_size) pos = m_size;
-    if (fseek(file, pos, SEEK_SET)) {
+    if (fseeko(file, pos, SEEK_SET)) {
         m_status = Error;
         return -2;
     }
-    m_position = ftell(file);
+    m_position = pos;
     m_status = (m_position == m_size) ?Eof :Ok;
     return m_position;
 }
+int32_t
+SkippingFileInputStream::readAt(int64_t offset, char* data, int32_t n) {
+    if (!file || offset < 0) {
+        return -2;
+    }
+    if (m_size != -1) {
+        const int64_t left = m_size - offset;
+        if (left <= 0) return -1;
+        if (n > left) n = (int32_t)left;
+    }
+    // the FILE has no buffer, so the file descriptor can be read directly
+    const int fd = fileno(file);
+    int32_t nr = 0;
+    while (nr < n) {
+        ssize_t r = pread(fd, data + nr, n - nr, offset + nr);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -2;
+        }
+        if (r == 0) break;
+        nr += (int32_t)r;
+    }
+    return (nr == 0 && n > 0) ?-1 :nr;
+}
@@ -22,6 +22,7 @@
 #define STRIGI_SKIPPINGFILEINPUTSTREAM_H
 
 #include <strigi/streambase.h>
+#include "sparsefilereader.h"
 
 namespace Strigi {
 
@@ -34,19 +35,23 @@ private:
     char *buffer;
     std::string filepath;
     int32_t buffersize;
+    SparseFileReader reader;
 
-    void open(FILE* f, const char* path);
+    void open(FILE* f, const char* path, int64_t size);
 
     int32_t read(const char*& start, int32_t min, int32_t max);
     int64_t skip(int64_t ntoskip);
     int64_t reset(int64_t pos);
+    int32_t readAt(int64_t offset, char* data, int32_t n);
 public:
     /**
      * @brief Create an InputStream to access a file
      *
      * @param filepath the name of the file to open
+     * @param size the size of the file if it is known already, e.g. from a
+     *             call to stat(), or -1 if it is not known
      */
-    explicit SkippingFileInputStream(const char* filepath);
+    explicit SkippingFileInputStream(const char* filepath, int64_t size = -1);
     ~SkippingFileInputStream();
 };
 
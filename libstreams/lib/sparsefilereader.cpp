@@ -0,0 +1,124 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include "sparsefilereader.h"
+#include <config.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace Strigi;
+
+namespace {
+/**
+ * Files smaller than this are read completely, holes and all.
+ **/
+const int64_t minSparseSize = 65536;
+}
+
+void
+SparseFileReader::init(FILE* file, int64_t size) {
+    start = end = 0;
+    sparse = false;
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    if (size >= 0 && size < minSparseSize) {
+        return;
+    }
+    // a file that occupies fewer blocks than its size has holes
+    struct stat s;
+    sparse = fstat(fileno(file), &s) == 0 && S_ISREG(s.st_mode)
+        && (int64_t)s.st_blocks * 512 < (int64_t)s.st_size;
+#else
+    (void)file;
+    (void)size;
+#endif
+}
+/**
+ * Find out if @p pos lies in data or in a hole, and where that ends.
+ **/
+void
+SparseFileReader::findSegment(FILE* file, int64_t pos) {
+    start = pos;
+    end = std::numeric_limits<int64_t>::max();
+    hole = false;
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    const int fd = fileno(file);
+    off_t data = lseek(fd, pos, SEEK_DATA);
+    if (data == -1) {
+        if (errno == ENXIO) {
+            // the file ends in a hole
+            hole = true;
+            end = std::max(pos, (int64_t)lseek(fd, 0, SEEK_END));
+        } else {
+            // the file system cannot tell
+            sparse = false;
+        }
+    } else if (data > pos) {
+        hole = true;
+        end = data;
+    } else {
+        off_t h = lseek(fd, pos, SEEK_HOLE);
+        if (h > pos) {
+            end = h;
+        }
+    }
+    // lseek() moved the descriptor under the FILE
+    fseeko(file, pos, SEEK_SET);
+#else
+    (void)file;
+#endif
+}
+size_t
+SparseFileReader::read(FILE* file, char* buffer, size_t n) {
+    if (!sparse) {
+        return fread(buffer, 1, n, file);
+    }
+    int64_t pos = ftello(file);
+    if (pos < 0) {
+        return fread(buffer, 1, n, file);
+    }
+    size_t nr = 0;
+    while (nr < n) {
+        if (pos < start || pos >= end) {
+            findSegment(file, pos);
+        }
+        if (!sparse || pos >= end) {
+            // at the end of the file, let fread() set the end-of-file flag
+            return nr + fread(buffer + nr, 1, n - nr, file);
+        }
+        const size_t step = (size_t)std::min((int64_t)(n - nr), end - pos);
+        if (hole) {
+            memset(buffer + nr, 0, step);
+            if (fseeko(file, pos + step, SEEK_SET) != 0) {
+                return nr;
+            }
+        } else {
+            const size_t r = fread(buffer + nr, 1, step, file);
+            if (r != step) {
+                return nr + r;
+            }
+        }
+        nr += step;
+        pos += step;
+    }
+    return nr;
+}
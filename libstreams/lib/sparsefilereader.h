@@ -0,0 +1,64 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef STRIGI_SPARSEFILEREADER_H
+#define STRIGI_SPARSEFILEREADER_H
+
+#include <strigi/strigiconfig.h>
+#include <stdio.h>
+
+namespace Strigi {
+
+/**
+ * Reads from a FILE without reading the holes of sparse files from disk.
+ *
+ * The holes are found with lseek(SEEK_DATA) and lseek(SEEK_HOLE) and are
+ * returned as zeros. Files without holes, and systems that cannot find
+ * them, are read with fread().
+ **/
+class SparseFileReader {
+private:
+    // the range [start, end) of the file that is known to be data or a hole
+    int64_t start;
+    int64_t end;
+    bool hole;
+    bool sparse;
+
+    void findSegment(FILE* file, int64_t pos);
+public:
+    SparseFileReader() :start(0), end(0), hole(false), sparse(false) {}
+    /**
+     * Check if @p file has holes. If it has none, read() calls fread().
+     * Files that are known to be smaller than 64 kB are not checked,
+     * because their holes cost little to read.
+     * @param size the size of @p file, or -1 if it is not known
+     **/
+    void init(FILE* file, int64_t size = -1);
+    /**
+     * Read @p n bytes from the current position of @p file into @p buffer,
+     * like fread(). Fewer bytes are read only at the end of the file or on
+     * an error.
+     **/
+    size_t read(FILE* file, char* buffer, size_t n);
+};
+
+} // end namespace Strigi
+
+#endif
@@ -122,3 +122,13 @@ SubInputStream::skip(int64_t ntoskip) {
     }
     return skipped;
 }
+int32_t
+SubInputStream::readAt(int64_t offset, char* data, int32_t n) {
+    if (offset < 0) return -2;
+    if (m_size != -1) {
+        const int64_t left = m_size - offset;
+        if (left <= 0) return -1;
+        if (n > left) n = (int32_t)left;
+    }
+    return m_input->readAt(m_offset + offset, data, n);
+}
@@ -30,6 +30,45 @@ public:
     bool handleData(const char* data, uint32_t size) { return done; }
 };
 
+class CountingEventHandler : public DataEventHandler {
+public:
+    int64_t count;
+    bool ended;
+    CountingEventHandler() :count(0), ended(false) {}
+    bool handleData(const char* data, uint32_t size) {
+        count += size;
+        return true;
+    }
+    void handleEnd() { ended = true; }
+};
+
+/**
+ * Check that every handler of a fan-out stream sees each byte exactly once,
+ * also when one of the other handlers has stopped listening.
+ **/
+void
+fanOutTest(const char* file) {
+    CountingEventHandler c1, c2;
+    TestEventHandler stop(false);
+    std::vector<DataEventHandler*> handlers;
+    handlers.push_back(&c1);
+    handlers.push_back(&stop);
+    handlers.push_back(&c2);
+    InputStream* f = FileInputStream::open(file);
+    DataEventInputStream s(f, handlers);
+    const char* start;
+    int32_t nread = s.read(start, 100, 100);
+    VERIFY(nread == 100);
+    VERIFY(s.reset(0) == 0);
+    while (s.read(start, 1, 0) > 0) {}
+    VERIFY(s.status() == Eof);
+    VERIFY(c1.count == s.size());
+    VERIFY(c2.count == s.size());
+    VERIFY(c1.ended && c2.ended);
+    VERIFY(s.sourceBytesRead() >= s.size());
+    delete f;
+}
+
 int
 EventInputStreamTest(int argc, char* argv[]) {
     if (argc < 2) return 1;
@@ -40,6 +79,11 @@ EventInputStreamTest(int argc, char* argv[]) {
     TESTONFILE2(DataEventInputStream, de1, "a.zip");
     TestEventHandler de2(false);
     TESTONFILE2(DataEventInputStream, de2, "a.zip");
+    std::vector<DataEventHandler*> handlers;
+    handlers.push_back(&de1);
+    handlers.push_back(&de2);
+    TESTONFILE2(DataEventInputStream, handlers, "a.zip");
+    fanOutTest("a.zip");
 
     return founderrors;
 }
@@ -19,9 +19,98 @@
  */
 #include "skippingfileinputstream.h"
 #include "../sharedtestcode/inputstreamtests.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
 
 using namespace Strigi;
 
+namespace {
+
+/**
+ * Read a file that is larger than the size that was passed to the stream,
+ * as happens when a file grows after it was listed. The file is made in
+ * the current directory, which is the test data directory.
+ **/
+void
+testStaleSize() {
+    char path[] = "skippingfileinputstreamXXXXXX";
+    int fd = mkstemp(path);
+    VERIFY(fd != -1);
+    if (fd == -1) return;
+    const std::string data(3000, 'x');
+    VERIFY(write(fd, data.c_str(), data.length()) == (ssize_t)data.length());
+    close(fd);
+
+    SkippingFileInputStream stream(path, 1000);
+    InputStream& file = stream;
+    const char* start;
+    int64_t total = 0;
+    int32_t nread = 0;
+    for (int i = 0; i < 100 && file.status() == Ok; ++i) {
+        nread = file.read(start, 1, 0);
+        if (nread > 0) total += nread;
+    }
+    VERIFY(file.status() == Eof);
+    VERIFY(total == 3000);
+    VERIFY(file.position() == 3000);
+    VERIFY(file.size() == 3000);
+    unlink(path);
+}
+
+/**
+ * Read a sparse file: data, a hole, data and a hole at the end. The holes
+ * must read as zeros. On file systems without holes, the file is read as
+ * an ordinary one.
+ **/
+void
+testSparse() {
+    char path[] = "sparsefileXXXXXX";
+    int fd = mkstemp(path);
+    VERIFY(fd != -1);
+    if (fd == -1) return;
+    const int64_t size = 3 * 1024 * 1024;
+    const int64_t second = 2 * 1024 * 1024;
+    const std::string a(4096, 'a');
+    const std::string b(4096, 'b');
+    VERIFY(write(fd, a.c_str(), a.length()) == (ssize_t)a.length());
+    VERIFY(pwrite(fd, b.c_str(), b.length(), second) == (ssize_t)b.length());
+    VERIFY(ftruncate(fd, size) == 0);
+    close(fd);
+
+    std::string expected(size, '\0');
+    expected.replace(0, a.length(), a);
+    expected.replace(second, b.length(), b);
+
+    // read in blocks that do not line up with the data and the holes
+    SkippingFileInputStream stream(path);
+    InputStream& file = stream;
+    VERIFY(file.size() == size);
+    std::string data;
+    const char* start;
+    int32_t nread;
+    for (int i = 0; i < 2000 && file.status() == Ok; ++i) {
+        nread = file.read(start, 3000, 3000);
+        if (nread > 0) data.append(start, nread);
+    }
+    VERIFY(file.status() == Eof);
+    VERIFY(file.size() == size);
+    VERIFY(data.length() == (size_t)size);
+    VERIFY(data == expected);
+
+    // go back into the first hole and read across the second block of data
+    VERIFY(file.reset(second - 100) == second - 100);
+    nread = file.read(start, 200, 200);
+    VERIFY(nread == 200);
+    if (nread == 200) {
+        VERIFY(std::string(start, 200) == expected.substr(second - 100, 200));
+    }
+    unlink(path);
+}
+
+}
+
 int
 SkippingFileInputStreamTest(int argc, char* argv[]) {
     if (argc < 2) return 1;
@@ -32,6 +121,8 @@ SkippingFileInputStreamTest(int argc, char* argv[]) {
         SkippingFileInputStream file("a.zip");
         charinputstreamtests[i](&file);
     }
+    testStaleSize();
+    testSparse();
     return founderrors;
 }
 
@@ -20,7 +20,9 @@
 #include <strigi/strigiconfig.h>
 #include "inputstreamtests.h"
 #include <strigi/substreamprovider.h>
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 using namespace Strigi;
 
@@ -92,6 +94,38 @@ inputStreamTest3(StreamBase<T>* s) {
     VERIFY(n2 == s->size());
 }
 
+template <class T>
+void
+inputStreamTest4(StreamBase<T>* s) {
+    // reading at a position gives the same data as reading in order and
+    // does not move the stream
+    T first;
+    int32_t n = s->readAt(0, &first, 1);
+    if (n == -3) return; // the stream does not support it
+    VERIFY(s->position() == 0);
+    std::vector<T> all;
+    const T* ptr;
+    int32_t n2 = s->read(ptr, 1, 0);
+    while (n2 > 0) {
+        all.insert(all.end(), ptr, ptr + n2);
+        n2 = s->read(ptr, 1, 0);
+    }
+    VERIFY(n2 > -2);
+    const int64_t size = (int64_t)all.size();
+    VERIFY(n == ((size) ?1 :-1));
+    VERIFY(s->readAt(size, &first, 1) == -1);
+    const int64_t offsets[] = {0, size / 3, size / 2, size - 100, size - 1};
+    for (size_t i = 0; i < sizeof(offsets)/sizeof(offsets[0]); ++i) {
+        const int64_t offset = offsets[i];
+        if (offset < 0 || offset >= size) continue;
+        T buf[200];
+        n = s->readAt(offset, buf, 200);
+        VERIFY(n == (int32_t)std::min((int64_t)200, size - offset));
+        VERIFY(n > 0 && std::equal(buf, buf + n, all.begin() + offset));
+    }
+    VERIFY(s->position() == size);
+}
+
 void
 subStreamProviderTest1(SubStreamProvider* ssp) {
     StreamBase<char>* s = ssp->nextEntry();
@@ -124,9 +158,9 @@ subStreamProviderTest2(SubStreamProvider* ssp) {
     VERIFY(ssp->status() == Strigi::Eof);
 }
 
-int ninputstreamtests = 3;
+int ninputstreamtests = 4;
 void (*charinputstreamtests[])(StreamBase<char>*) = {
-    inputStreamTest1, inputStreamTest2, inputStreamTest3 };
+    inputStreamTest1, inputStreamTest2, inputStreamTest3, inputStreamTest4 };
 
 int nstreamprovidertests = 2;
 void (*streamprovidertests[])(SubStreamProvider*) = {
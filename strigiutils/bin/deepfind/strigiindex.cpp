@@ -0,0 +1,67 @@
+/* This file is part of Strigi Desktop Search
+ *
+ * Copyright (C) 2026 The Strigi developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <strigi/strigiconfig.h>
+#include <strigi/analyzerconfiguration.h>
+#include <strigi/diranalyzer.h>
+#include <strigi/indexreader.h>
+#include <strigi/indexwriter.h>
+#include <strigi/queryparser.h>
+#include <strigi/segmentindexmanager.h>
+
+#include <cstdio>
+#include <cstring>
+#include <stdlib.h>
+
+using namespace Strigi;
+
+void
+printUsage(char** argv) {
+    fprintf(stderr, "Usage: %s INDEXDIR update DIR...\n"
+        "       %s INDEXDIR query QUERY [MAX]\n", argv[0], argv[0]);
+}
+
+int
+main(int argc, char **argv) {
+    if (argc < 4) {
+        printUsage(argv);
+        return -1;
+    }
+    SegmentIndexManager manager(argv[1]);
+    if (strcmp(argv[2], "update") == 0) {
+        AnalyzerConfiguration ic;
+        DirAnalyzer analyzer(manager, ic);
+        std::vector<std::string> dirs(argv + 3, argv + argc);
+        return analyzer.updateDirs(dirs);
+    }
+    if (strcmp(argv[2], "query") != 0 || argc > 5) {
+        printUsage(argv);
+        return -1;
+    }
+    const int max = (argc == 5) ?atoi(argv[4]) :10;
+    const Query q = QueryParser::buildQuery(argv[3]);
+    IndexReader* reader = manager.indexReader();
+    printf("%d hits\n", reader->countHits(q));
+    const std::vector<IndexedDocument> hits = reader->query(q, 0, max);
+    std::vector<IndexedDocument>::const_iterator i;
+    for (i = hits.begin(); i != hits.end(); ++i) {
+        printf("%8.3f %s\n", i->score, i->uri.c_str());
+    }
+    return 0;
+}
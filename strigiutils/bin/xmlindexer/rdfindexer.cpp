@@ -38,6 +38,7 @@ int
 usage(int /*argc*/, char** argv) {
     fprintf(stderr, "Usage: %s\n    [--mappingfile <mappingfile>]\n"
         "    [--lastfiletoskip FILE]\n"
+        "    [--resultcache DIR]\n"
         "    [--stdinmtime mtime]\n    [--stdinfilename filename]\n"
         "    [dirs-or-files-to-index]\n"
         "    [-j nthreads]\n",
@@ -68,6 +69,7 @@ main(int argc, char **argv) {
     int nthreads = 2;
     const char* mappingfile = 0;
     std::string lastFileToSkip;
+    std::string resultCache;
     time_t stdinMTime = time(0);
     std::string stdinFilename = "-";
     int i = 0;
@@ -95,6 +97,11 @@ main(int argc, char **argv) {
                 return usage(argc, argv);
             }
             lastFileToSkip = argv[i];
+        } else if (!strcmp("--resultcache", arg)) {
+            if (++i == argc) {
+                return usage(argc, argv);
+            }
+            resultCache = argv[i];
         } else if (!strcmp("--stdinmtime", arg)) {
             if (++i == argc) {
                 return usage(argc, argv);
@@ -147,8 +154,12 @@ main(int argc, char **argv) {
 */
     rdfset rdf;
 
-    RdfIndexManager manager(std::cout, mapping, rdf);
+    // with several analyzing threads, the output is written by another one
+    RdfIndexManager manager(std::cout, mapping, rdf, nthreads > 1);
     DirAnalyzer analyzer(manager, ic);
+    if (resultCache.size()) {
+        analyzer.setResultCache(resultCache, 1024*1024*1024);
+    }
     for (unsigned i = 0; i < dirs.size(); ++i) {
         if (dirs[i] == "-") {
             analyzeFromStdin(manager, ic, stdinFilename, stdinMTime);
@@ -156,6 +167,8 @@ main(int argc, char **argv) {
             analyzer.analyzeDir(dirs[i], nthreads, 0, lastFileToSkip);
         }
     }
+    // write the documents that are still queued
+    manager.indexWriter()->commit();
 //    std::cout << "</" << mapping.map("metadata") << ">\n";
 
     for(rdfset::const_iterator subj = rdf.begin(); subj != rdf.end(); subj++) {
@@ -21,6 +21,7 @@
 #ifndef STRIGI_RDFINDEXWRITER_H
 #define STRIGI_RDFINDEXWRITER_H
 
+#include <strigi/asyncindexwriter.h>
 #include <strigi/indexwriter.h>
 #include <strigi/indexmanager.h>
 #include <strigi/analysisresult.h>
@@ -273,24 +274,21 @@ protected:
     void addValue(const Strigi::AnalysisResult* ar,
             const Strigi::RegisteredField* field, uint32_t value) {
         Data* d = static_cast<Data*>(ar->writerData());
-        static std::ostringstream v;
-        v.str("");
+        std::ostringstream v;
         v << value;
         d->values.insert(std::make_pair(field, v.str()));
     }
     void addValue(const Strigi::AnalysisResult* ar,
             const Strigi::RegisteredField* field, int32_t value) {
         Data* d = static_cast<Data*>(ar->writerData());
-        static std::ostringstream v;
-        v.str("");
+        std::ostringstream v;
         v << value;
         d->values.insert(std::make_pair(field, v.str()));
     }
     void addValue(const Strigi::AnalysisResult* ar,
             const Strigi::RegisteredField* field, double value) {
         Data* d = static_cast<Data*>(ar->writerData());
-        static std::ostringstream v;
-        v.str("");
+        std::ostringstream v;
         v << value;
         d->values.insert(std::make_pair(field, v.str()));
     }
@@ -325,9 +323,24 @@ public:
 class RdfIndexManager : public Strigi::IndexManager {
 private:
     RdfIndexWriter writer;
+    Strigi::AsyncIndexWriter* async;
 public:
-    RdfIndexManager(std::ostream& o, const TagMapping& m, rdfset& r) :writer(o, m, r) {}
+    /**
+     * With @p threaded, the documents are written from a thread of their
+     * own, so the analyzing threads do not wait for the output.
+     **/
+    RdfIndexManager(std::ostream& o, const TagMapping& m, rdfset& r,
+            bool threaded = false)
+            :writer(o, m, r),
+             async((threaded) ?new Strigi::AsyncIndexWriter(writer) :0) {
+    }
+    ~RdfIndexManager() {
+        delete async;
+    }
     Strigi::IndexWriter* indexWriter() {
+        if (async) {
+            return async;
+        }
         return &writer;
     }
     Strigi::IndexReader* indexReader() {
@@ -38,6 +38,8 @@ int
 usage(int /*argc*/, char** argv) {
     fprintf(stderr, "Usage: %s\n    [--mappingfile <mappingfile>]\n"
         "    [--lastfiletoskip FILE]\n"
+        "    [--checkpoint FILE [--checkpointinterval seconds] [--resume]]\n"
+        "    [--resultcache DIR]\n"
         "    [--stdinmtime mtime]\n    [--stdinfilename filename]\n"
         "    [dirs-or-files-to-index]\n"
         "    [-j nthreads]\n",
@@ -68,6 +70,10 @@ main(int argc, char **argv) {
     int nthreads = 2;
     const char* mappingfile = 0;
     std::string lastFileToSkip;
+    std::string checkpoint;
+    int checkpointInterval = 60;
+    bool resume = false;
+    std::string resultCache;
     time_t stdinMTime = time(0);
     std::string stdinFilename = "-";
     int i = 0;
@@ -95,6 +101,27 @@ main(int argc, char **argv) {
                 return usage(argc, argv);
             }
             lastFileToSkip = argv[i];
+        } else if (!strcmp("--checkpoint", arg)) {
+            if (++i == argc) {
+                return usage(argc, argv);
+            }
+            checkpoint = argv[i];
+        } else if (!strcmp("--checkpointinterval", arg)) {
+            if (++i == argc) {
+                return usage(argc, argv);
+            }
+            char* end;
+            checkpointInterval = (int)strtol(argv[i], &end, 10);
+            if (end == argv[i] || checkpointInterval < 0) {
+                return usage(argc, argv);
+            }
+        } else if (!strcmp("--resume", arg)) {
+            resume = true;
+        } else if (!strcmp("--resultcache", arg)) {
+            if (++i == argc) {
+                return usage(argc, argv);
+            }
+            resultCache = argv[i];
         } else if (!strcmp("--stdinmtime", arg)) {
             if (++i == argc) {
                 return usage(argc, argv);
@@ -121,7 +148,10 @@ main(int argc, char **argv) {
         }
     }
 
-    if (dirs.size() == 0) {
+    if (resume && checkpoint.empty()) {
+        return usage(argc, argv);
+    }
+    if (dirs.size() == 0 && !resume) {
         char buf[1024];
         if (getcwd(buf, 1023) == NULL) {
             return -1;
@@ -145,8 +175,18 @@ main(int argc, char **argv) {
     }
     std::cout << ">\n";
 
-    XmlIndexManager manager(std::cout, mapping);
+    // with several analyzing threads, the output is written by another one
+    XmlIndexManager manager(std::cout, mapping, nthreads > 1);
     DirAnalyzer analyzer(manager, ic);
+    if (checkpoint.size()) {
+        analyzer.setCheckpoint(checkpoint, checkpointInterval);
+    }
+    if (resultCache.size()) {
+        analyzer.setResultCache(resultCache, 1024*1024*1024);
+    }
+    if (resume && analyzer.resumeDir(nthreads) != 0) {
+        fprintf(stderr, "Cannot resume from '%s'.\n", checkpoint.c_str());
+    }
     for (unsigned i = 0; i < dirs.size(); ++i) {
         if (dirs[i] == "-") {
             analyzeFromStdin(manager, ic, stdinFilename, stdinMTime);
@@ -154,6 +194,8 @@ main(int argc, char **argv) {
             analyzer.analyzeDir(dirs[i], nthreads, 0, lastFileToSkip);
         }
     }
+    // write the documents that are still queued
+    manager.indexWriter()->commit();
     std::cout << "</" << mapping.map("metadata") << ">\n";
 
     return 0;
@@ -22,6 +22,7 @@
 #define STRIGI_XMLINDEXWRITER_H
 
 #include "tagmapping.h"
+#include <strigi/asyncindexwriter.h>
 #include <strigi/indexwriter.h>
 #include <strigi/indexmanager.h>
 #include <strigi/analysisresult.h>
@@ -256,24 +257,21 @@ protected:
     void addValue(const Strigi::AnalysisResult* ar,
             const Strigi::RegisteredField* field, uint32_t value) {
         Data* d = static_cast<Data*>(ar->writerData());
-        static std::ostringstream v;
-        v.str("");
+        std::ostringstream v;
         v << value;
         d->values.insert(std::make_pair(field, v.str()));
     }
     void addValue(const Strigi::AnalysisResult* ar,
             const Strigi::RegisteredField* field, int32_t value) {
         Data* d = static_cast<Data*>(ar->writerData());
-        static std::ostringstream v;
-        v.str("");
+        std::ostringstream v;
         v << value;
         d->values.insert(std::make_pair(field, v.str()));
     }
     void addValue(const Strigi::AnalysisResult* ar,
             const Strigi::RegisteredField* field, double value) {
         Data* d = static_cast<Data*>(ar->writerData());
-        static std::ostringstream v;
-        v.str("");
+        std::ostringstream v;
         v << value;
         d->values.insert(std::make_pair(field, v.str()));
     }
@@ -297,7 +295,10 @@ public:
              }
          }
     }
-    void commit() {}
+    void commit() {
+        std::lock_guard<std::mutex> lock(mutex);
+        out.flush();
+    }
     void deleteEntries(const std::vector<std::string>& entries) {}
     void deleteAllEntries() {}
 };
@@ -305,9 +306,24 @@ public:
 class XmlIndexManager : public Strigi::IndexManager {
 private:
     XmlIndexWriter writer;
+    Strigi::AsyncIndexWriter* async;
 public:
-    XmlIndexManager(std::ostream& o, const TagMapping& m) :writer(o, m) {}
+    /**
+     * With @p threaded, the documents are written from a thread of their
+     * own, so the analyzing threads do not wait for the output.
+     **/
+    XmlIndexManager(std::ostream& o, const TagMapping& m,
+            bool threaded = false)
+            :writer(o, m),
+             async((threaded) ?new Strigi::AsyncIndexWriter(writer) :0) {
+    }
+    ~XmlIndexManager() {
+        delete async;
+    }
     Strigi::IndexWriter* indexWriter() {
+        if (async) {
+            return async;
+        }
         return &writer;
     }
     Strigi::IndexReader* indexReader() {